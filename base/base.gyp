@@ -200,6 +200,7 @@
         'file_version_info_unittest.cc',
         'gmock_unittest.cc',
         'id_map_unittest.cc',
+        'incoming_task_queue_unittest.cc',
         'i18n/break_iterator_unittest.cc',
         'i18n/char_iterator_unittest.cc',
         'i18n/case_conversion_unittest.cc',
@@ -399,6 +400,20 @@
         }],
       ],
     },
+    {
+      'target_name': 'base_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'base',
+        'test_support_base',
+        'test_support_perf',
+        '../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        'message_loop_perftest.cc',
+        'threading/sequenced_worker_pool_perftest.cc',
+      ],
+    },
     {
       'target_name': 'check_example',
       'type': 'executable',
@@ -0,0 +1,98 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/incoming_task_queue.h"
+
+namespace base {
+
+IncomingTaskQueue::IncomingTaskQueue()
+    : head_(reinterpret_cast<subtle::AtomicWord>(&stub_)),
+      tail_(&stub_),
+      wakeup_flag_(new WakeupFlag) {
+}
+
+IncomingTaskQueue::~IncomingTaskQueue() {
+  while (Node* node = PopNode())
+    delete node;
+}
+
+bool IncomingTaskQueue::Push(const PendingTask& pending_task) {
+  // Once PushLink() returns, the task may already have run and destroyed
+  // |this|, so nothing but this reference may be touched after it.
+  scoped_refptr<WakeupFlag> wakeup_flag(wakeup_flag_);
+  PushLink(new Node(pending_task));
+
+  // The task must be visible to the consumer before we look at the wake-up
+  // flag; ReloadInto() clears the flag before it looks at the list.  Between
+  // the two, at least one side sees the other's write.
+  subtle::MemoryBarrier();
+  return wakeup_flag->TryClaim();
+}
+
+bool IncomingTaskQueue::ReloadInto(TaskQueue* work_queue) {
+  wakeup_flag_->Clear();
+  subtle::MemoryBarrier();
+
+  bool did_work = false;
+  while (Node* node = PopNode()) {
+    work_queue->push(node->task);
+    delete node;
+    did_work = true;
+  }
+  return did_work;
+}
+
+bool IncomingTaskQueue::IsEmpty() const {
+  // |stub_| is re-inserted whenever the last node is consumed, so an empty
+  // queue is one whose most recent link is the stub.
+  return reinterpret_cast<const Link*>(subtle::Acquire_Load(&head_)) == &stub_;
+}
+
+void IncomingTaskQueue::PushLink(Link* link) {
+  subtle::NoBarrier_Store(&link->next, 0);
+  // Make |link| (and the task it carries) visible before it can be reached
+  // through |head_|.
+  subtle::MemoryBarrier();
+  Link* prev = reinterpret_cast<Link*>(subtle::NoBarrier_AtomicExchange(
+      &head_, reinterpret_cast<subtle::AtomicWord>(link)));
+  // Between the exchange above and this store the list is briefly
+  // disconnected; PopNode() treats that as "nothing more for now".
+  subtle::Release_Store(&prev->next,
+                        reinterpret_cast<subtle::AtomicWord>(link));
+}
+
+IncomingTaskQueue::Node* IncomingTaskQueue::PopNode() {
+  Link* tail = tail_;
+  Link* next = reinterpret_cast<Link*>(subtle::Acquire_Load(&tail->next));
+  if (tail == &stub_) {
+    if (!next)
+      return NULL;
+    tail_ = next;
+    tail = next;
+    next = reinterpret_cast<Link*>(subtle::Acquire_Load(&tail->next));
+  }
+  if (next) {
+    tail_ = next;
+    return static_cast<Node*>(tail);
+  }
+
+  // |tail| is the last published link.  If a producer has already swapped in
+  // a newer head but not yet linked it, stop here; that producer will
+  // schedule another wake-up.
+  Link* head = reinterpret_cast<Link*>(subtle::Acquire_Load(&head_));
+  if (tail != head)
+    return NULL;
+
+  // Put the stub back behind |tail| so that |tail| can be handed out without
+  // leaving the list empty.
+  PushLink(&stub_);
+  next = reinterpret_cast<Link*>(subtle::Acquire_Load(&tail->next));
+  if (next) {
+    tail_ = next;
+    return static_cast<Node*>(tail);
+  }
+  return NULL;
+}
+
+}  // namespace base
@@ -0,0 +1,115 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_INCOMING_TASK_QUEUE_H_
+#define BASE_INCOMING_TASK_QUEUE_H_
+#pragma once
+
+#include "base/atomicops.h"
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/pending_task.h"
+
+namespace base {
+
+// IncomingTaskQueue is the inter-thread queue that feeds a MessageLoop.  It is
+// an intrusive multi-producer/single-consumer queue (Dmitry Vyukov's design):
+// any thread may Push() without taking a lock, while only the thread owning
+// the MessageLoop may call ReloadInto().
+//
+// The queue also implements the wake-up protocol between producers and the
+// consumer.  A producer is told to wake the consumer only when no wake-up is
+// already outstanding, so a burst of posts from many threads costs at most one
+// MessagePump::ScheduleWork() until the consumer drains the queue again.
+//
+// Once a task is published the consumer may run it, and the task may destroy
+// the queue along with its MessageLoop.  Push() therefore keeps the wake-up
+// flag in a reference counted object that it holds on to until it is done.
+class BASE_EXPORT IncomingTaskQueue {
+ public:
+  IncomingTaskQueue();
+  // Deletes any tasks that were never reloaded.  No producer may be running.
+  ~IncomingTaskQueue();
+
+  // Appends a copy of |pending_task|.  Safe to call from any thread.  Returns
+  // true if the caller is responsible for waking the consumer (i.e. calling
+  // ScheduleWork() on the pump), and false if a wake-up is already pending.
+  bool Push(const PendingTask& pending_task);
+
+  // Moves every task that is fully published into |work_queue|, in FIFO
+  // order, and re-arms the wake-up protocol.  Must only be called by the
+  // consumer thread.  Returns true if any task was moved.
+  //
+  // A producer that is in the middle of a Push() may hide tasks queued behind
+  // it; in that case ReloadInto() stops early.  That producer is guaranteed to
+  // observe the re-armed wake-up flag and schedule more work, so nothing is
+  // lost.
+  bool ReloadInto(TaskQueue* work_queue);
+
+  // Returns true if there are no queued tasks.  The answer is only exact when
+  // no producer is running concurrently.
+  bool IsEmpty() const;
+
+ private:
+  struct Link {
+    Link() : next(0) {}
+    subtle::AtomicWord next;
+  };
+
+  struct Node : public Link {
+    explicit Node(const PendingTask& pending_task) : task(pending_task) {}
+    PendingTask task;
+  };
+
+  // Publishes |link| at the head of the list.  Called by producers, and by
+  // the consumer to re-insert |stub_|.
+  void PushLink(Link* link);
+
+  // Returns the next published node or NULL.  Consumer only.
+  Node* PopNode();
+
+  // Most recently pushed link.  Written by producers.
+  subtle::AtomicWord head_;
+
+  // Oldest link not yet consumed.  Only touched by the consumer.
+  Link* tail_;
+
+  // Sentinel that keeps the list non-empty so that producers never have to
+  // touch |tail_|.
+  Link stub_;
+
+  // Shared with the producers that are in Push(), so that it outlives the
+  // queue.
+  class WakeupFlag : public RefCountedThreadSafe<WakeupFlag> {
+   public:
+    WakeupFlag() : pending_(0) {}
+
+    // Returns true if no wake-up was outstanding, in which case the caller
+    // now owns it.
+    bool TryClaim() {
+      return subtle::Acquire_CompareAndSwap(&pending_, 0, 1) == 0;
+    }
+
+    void Clear() { subtle::NoBarrier_Store(&pending_, 0); }
+
+   private:
+    friend class RefCountedThreadSafe<WakeupFlag>;
+
+    ~WakeupFlag() {}
+
+    // Non-zero while a ScheduleWork() is outstanding.
+    subtle::Atomic32 pending_;
+
+    DISALLOW_COPY_AND_ASSIGN(WakeupFlag);
+  };
+
+  scoped_refptr<WakeupFlag> wakeup_flag_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncomingTaskQueue);
+};
+
+}  // namespace base
+
+#endif  // BASE_INCOMING_TASK_QUEUE_H_
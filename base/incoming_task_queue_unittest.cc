@@ -0,0 +1,93 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/incoming_task_queue.h"
+
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/stringprintf.h"
+#include "base/threading/thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+void RecordOrder(int value, std::vector<int>* order) {
+  order->push_back(value);
+}
+
+// Posts |count| tasks to |target|.  The last producer to finish posts the
+// task that quits |target|, which is then deleted while that producer may
+// still be inside PostTask().
+void PostTasks(MessageLoop* target, int count,
+               subtle::Atomic32* producers_left) {
+  for (int i = 0; i < count; ++i)
+    target->PostTask(FROM_HERE, Bind(&DoNothing));
+  if (subtle::Barrier_AtomicIncrement(producers_left, -1) == 0)
+    target->PostTask(FROM_HERE, MessageLoop::QuitClosure());
+}
+
+}  // namespace
+
+TEST(IncomingTaskQueueTest, ReloadsInOrder) {
+  IncomingTaskQueue queue;
+  std::vector<int> order;
+  EXPECT_TRUE(queue.IsEmpty());
+
+  // Only the first push owes a wake-up until the queue is reloaded.
+  EXPECT_TRUE(queue.Push(PendingTask(FROM_HERE,
+                                     Bind(&RecordOrder, 1, &order))));
+  EXPECT_FALSE(queue.Push(PendingTask(FROM_HERE,
+                                      Bind(&RecordOrder, 2, &order))));
+  EXPECT_FALSE(queue.IsEmpty());
+
+  TaskQueue work_queue;
+  EXPECT_TRUE(queue.ReloadInto(&work_queue));
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_FALSE(queue.ReloadInto(&work_queue));
+  while (!work_queue.empty()) {
+    work_queue.front().task.Run();
+    work_queue.pop();
+  }
+  ASSERT_EQ(2u, order.size());
+  EXPECT_EQ(1, order[0]);
+  EXPECT_EQ(2, order[1]);
+
+  EXPECT_TRUE(queue.Push(PendingTask(FROM_HERE, Bind(&DoNothing))));
+}
+
+// Tests that a producer is done with the queue by the time its task can run
+// and delete the loop.  Memory tools flag the race when it is not.
+TEST(IncomingTaskQueueTest, LoopDeletedByPostedTaskUnderContention) {
+  const int kProducers = 4;
+  const int kTasksPerProducer = 100;
+  const int kIterations = 50;
+
+  ScopedVector<Thread> producers;
+  for (int i = 0; i < kProducers; ++i) {
+    producers.push_back(new Thread(StringPrintf("Producer%d", i).c_str()));
+    ASSERT_TRUE(producers[i]->Start());
+  }
+
+  for (int iteration = 0; iteration < kIterations; ++iteration) {
+    scoped_ptr<MessageLoop> loop(new MessageLoop);
+    subtle::Atomic32 producers_left = kProducers;
+    for (int i = 0; i < kProducers; ++i) {
+      producers[i]->message_loop()->PostTask(
+          FROM_HERE,
+          Bind(&PostTasks, loop.get(), kTasksPerProducer, &producers_left));
+    }
+    loop->Run();
+    loop.reset();
+  }
+}
+
+}  // namespace base
@@ -362,9 +362,9 @@ void MessageLoop::RemoveTaskObserver(TaskObserver* task_observer) {
 }
 
 void MessageLoop::AssertIdle() const {
-  // We only check |incoming_queue_|, since we don't want to lock |work_queue_|.
-  base::AutoLock lock(incoming_queue_lock_);
-  DCHECK(incoming_queue_.empty());
+  // We only check |incoming_queue_|, since |work_queue_| is owned by the
+  // loop's thread.
+  DCHECK(incoming_queue_.IsEmpty());
 }
 
 bool MessageLoop::is_running() const {
@@ -492,19 +492,14 @@ void MessageLoop::AddToDelayedWorkQueue(const PendingTask& pending_task) {
 void MessageLoop::ReloadWorkQueue() {
   // We can improve performance of our loading tasks from incoming_queue_ to
   // work_queue_ by waiting until the last minute (work_queue_ is empty) to
-  // load.  That reduces the number of locks-per-task significantly when our
-  // queues get large.
+  // load.  That also keeps producers from having to wake us up again until we
+  // have caught up with everything they posted.
   if (!work_queue_.empty())
-    return;  // Wait till we *really* need to lock and load.
+    return;  // Wait till we *really* need to load.
 
-  // Acquire all we can from the inter-thread queue with one lock acquisition.
-  {
-    base::AutoLock lock(incoming_queue_lock_);
-    if (incoming_queue_.empty())
-      return;
-    incoming_queue_.Swap(&work_queue_);  // Constant time
-    DCHECK(incoming_queue_.empty());
-  }
+  // Take everything that has been published so far.  This re-arms the
+  // wake-up protocol, so the next AddToIncomingQueue() will ScheduleWork().
+  incoming_queue_.ReloadInto(&work_queue_);
 }
 
 bool MessageLoop::DeletePendingTasks() {
@@ -594,22 +589,15 @@ void MessageLoop::AddToIncomingQueue(PendingTask* pending_task) {
   // directly, as it could starve handling of foreign threads.  Put every task
   // into this queue.
 
-  scoped_refptr<base::MessagePump> pump;
-  {
-    base::AutoLock locked(incoming_queue_lock_);
+  // Once the task is pushed it may run and destroy this message loop, so we
+  // must be done with |this| before that point.  Take a stack-based reference
+  // to the message pump so that we can still call ScheduleWork afterwards.
+  scoped_refptr<base::MessagePump> pump(pump_);
 
-    bool was_empty = incoming_queue_.empty();
-    incoming_queue_.push(*pending_task);
-    pending_task->task.Reset();
-    if (!was_empty)
-      return;  // Someone else should have started the sub-pump.
-
-    pump = pump_;
-  }
-  // Since the incoming_queue_ may contain a task that destroys this message
-  // loop, we cannot exit incoming_queue_lock_ until we are done with |this|.
-  // We use a stack-based reference to the message pump so that we can call
-  // ScheduleWork outside of incoming_queue_lock_.
+  bool needs_wakeup = incoming_queue_.Push(*pending_task);
+  pending_task->task.Reset();
+  if (!needs_wakeup)
+    return;  // Someone else should have started the sub-pump.
 
   pump->ScheduleWork();
 }
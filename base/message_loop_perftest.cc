@@ -0,0 +1,154 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kTasksPerProducer = 100000;
+const int kMaxProducers = 16;
+const int kWakeUpIterations = 1000;
+
+const char* LoopTypeName(MessageLoop::Type type) {
+  switch (type) {
+    case MessageLoop::TYPE_DEFAULT:
+      return "default";
+    case MessageLoop::TYPE_IO:
+      return "io";
+    case MessageLoop::TYPE_UI:
+      return "ui";
+  }
+  return "unknown";
+}
+
+// Counts tasks run on the consumer thread and signals |done| once the
+// expected number has been reached.
+class Counter {
+ public:
+  Counter(int expected, base::WaitableEvent* done)
+      : remaining_(expected),
+        done_(done) {
+  }
+
+  void Run() {
+    if (--remaining_ == 0)
+      done_->Signal();
+  }
+
+ private:
+  // Only touched on the consumer thread.
+  int remaining_;
+  base::WaitableEvent* done_;
+};
+
+void PostBurst(base::WaitableEvent* start,
+               MessageLoop* target,
+               Counter* counter,
+               int count) {
+  start->Wait();
+  for (int i = 0; i < count; ++i)
+    target->PostTask(FROM_HERE,
+                     base::Bind(&Counter::Run, base::Unretained(counter)));
+}
+
+void RecordWakeUp(base::TimeTicks posted,
+                  base::TimeDelta* latency,
+                  base::WaitableEvent* ran) {
+  *latency = base::TimeTicks::Now() - posted;
+  ran->Signal();
+}
+
+void RunThroughputTest(MessageLoop::Type type, int producers) {
+  base::Thread consumer("consumer");
+  ASSERT_TRUE(consumer.StartWithOptions(base::Thread::Options(type, 0)));
+
+  base::WaitableEvent start(true, false);
+  base::WaitableEvent done(false, false);
+  int total = producers * kTasksPerProducer;
+  Counter counter(total, &done);
+
+  ScopedVector<base::Thread> threads;
+  for (int i = 0; i < producers; ++i) {
+    base::Thread* thread = new base::Thread("producer");
+    threads.push_back(thread);
+    ASSERT_TRUE(thread->Start());
+    thread->message_loop()->PostTask(
+        FROM_HERE, base::Bind(&PostBurst, &start, consumer.message_loop(),
+                              &counter, kTasksPerProducer));
+  }
+
+  PerfTimer timer;
+  start.Signal();
+  done.Wait();
+  base::TimeDelta elapsed = timer.Elapsed();
+
+  std::string name = base::StringPrintf("MessageLoop_PostTask_%s_%dproducers",
+                                        LoopTypeName(type), producers);
+  LogPerfResult(name.c_str(), total / elapsed.InSecondsF(), "tasks/s");
+}
+
+// Measures how long it takes an idle loop to run a task posted from another
+// thread.  The producer sleeps between posts so that the consumer has gone
+// back to waiting in its pump each time.
+void RunWakeUpTest(MessageLoop::Type type) {
+  base::Thread consumer("consumer");
+  ASSERT_TRUE(consumer.StartWithOptions(base::Thread::Options(type, 0)));
+
+  base::WaitableEvent ran(false, false);
+  std::vector<base::TimeDelta> latencies(kWakeUpIterations);
+  for (int i = 0; i < kWakeUpIterations; ++i) {
+    base::PlatformThread::Sleep(1);
+    consumer.message_loop()->PostTask(
+        FROM_HERE, base::Bind(&RecordWakeUp, base::TimeTicks::Now(),
+                              &latencies[i], &ran));
+    ran.Wait();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  base::TimeDelta sum;
+  for (size_t i = 0; i < latencies.size(); ++i)
+    sum += latencies[i];
+
+  std::string name = base::StringPrintf("MessageLoop_WakeUp_%s",
+                                        LoopTypeName(type));
+  LogPerfResult((name + "_mean").c_str(),
+                sum.InMicroseconds() / static_cast<double>(kWakeUpIterations),
+                "us");
+  LogPerfResult((name + "_p99").c_str(),
+                latencies[kWakeUpIterations * 99 / 100].InMicroseconds(),
+                "us");
+}
+
+}  // namespace
+
+TEST(MessageLoopPerfTest, PostTaskThroughputDefault) {
+  for (int producers = 1; producers <= kMaxProducers; producers *= 2)
+    RunThroughputTest(MessageLoop::TYPE_DEFAULT, producers);
+}
+
+TEST(MessageLoopPerfTest, PostTaskThroughputIO) {
+  for (int producers = 1; producers <= kMaxProducers; producers *= 2)
+    RunThroughputTest(MessageLoop::TYPE_IO, producers);
+}
+
+TEST(MessageLoopPerfTest, WakeUpLatencyDefault) {
+  RunWakeUpTest(MessageLoop::TYPE_DEFAULT);
+}
+
+TEST(MessageLoopPerfTest, WakeUpLatencyIO) {
+  RunWakeUpTest(MessageLoop::TYPE_IO);
+}
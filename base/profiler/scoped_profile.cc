@@ -12,7 +12,8 @@ namespace tracked_objects {
 
 
 ScopedProfile::ScopedProfile(const Location& location)
-    : birth_(ThreadData::TallyABirthIfActive(location)),
+    : birth_weight_(1),
+      birth_(ThreadData::TallyABirthIfActive(location, &birth_weight_)),
       start_of_run_(ThreadData::NowForStartOfRun(birth_)) {
 }
 
@@ -23,7 +24,8 @@ ScopedProfile::~ScopedProfile() {
 void ScopedProfile::StopClockAndTally() {
   if (!birth_)
     return;
-  ThreadData::TallyRunInAScopedRegionIfTracking(birth_, start_of_run_,
+  ThreadData::TallyRunInAScopedRegionIfTracking(birth_, birth_weight_,
+                                                start_of_run_,
                                                 ThreadData::NowForEndOfRun());
   birth_ = NULL;
 }
@@ -56,6 +56,7 @@ class BASE_EXPORT ScopedProfile {
   void StopClockAndTally();
 
  private:
+  int birth_weight_;  // Number of births |birth_| was tallied for.
   Births* birth_;  // Place in code where tracking started.
   const TrackedTime start_of_run_;
 
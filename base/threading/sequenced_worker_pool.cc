@@ -4,17 +4,20 @@
 
 #include "base/threading/sequenced_worker_pool.h"
 
+#include <algorithm>
 #include <deque>
-#include <set>
+#include <map>
 
 #include "base/atomicops.h"
 #include "base/bind.h"
+#include "base/lazy_instance.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/metrics/histogram.h"
 #include "base/stringprintf.h"
 #include "base/synchronization/condition_variable.h"
 #include "base/threading/simple_thread.h"
 #include "base/threading/thread.h"
+#include "base/threading/thread_local.h"
 
 namespace base {
 
@@ -27,6 +30,17 @@ struct SequencedTask {
   base::Closure task;
 };
 
+// An entry in a worker's run queue. Unsequenced tasks are queued directly.
+// Sequenced tasks are kept in their sequence's own queue, and the run queue
+// only holds a single ticket for the whole sequence, identified by a nonzero
+// |sequence_token_id| and a null |task|.
+typedef SequencedTask WorkItem;
+
+// The number of tasks from one sequence a worker runs back-to-back before it
+// puts the sequence at the end of its run queue so that other work gets a
+// turn.
+const int kMaxPinnedSequenceTasks = 32;
+
 }  // namespace
 
 // Worker ---------------------------------------------------------------------
@@ -41,9 +55,34 @@ class SequencedWorkerPool::Worker : public base::SimpleThread {
   // SimpleThread implementation. This actually runs the background thread.
   virtual void Run();
 
+  // Returns the worker running on the current thread, or NULL if the current
+  // thread is not a pool worker.
+  static Worker* GetForCurrentThread();
+
+  SequencedWorkerPool::Inner* inner() const { return inner_; }
+
+  // Index of this worker's run queue in the pool. Fixed for the lifetime of
+  // the worker.
+  size_t queue_index() const { return queue_index_; }
+
+  // The sequence this worker keeps running while it has tasks, 0 if none.
+  // Only accessed with the pool lock held.
+  int pinned_sequence_token_id() const { return pinned_sequence_token_id_; }
+  int pinned_task_count() const { return pinned_task_count_; }
+  void set_pinned_sequence(int sequence_token_id, int task_count) {
+    pinned_sequence_token_id_ = sequence_token_id;
+    pinned_task_count_ = task_count;
+  }
+
  private:
   SequencedWorkerPool::Inner* inner_;
   SequencedWorkerPool::WorkerShutdown current_shutdown_mode_;
+  size_t queue_index_;
+  int pinned_sequence_token_id_;
+  int pinned_task_count_;
+
+  // Lets GetForCurrentThread() find the worker running on this thread.
+  static base::LazyInstance<base::ThreadLocalPointer<Worker> > lazy_tls_ptr_;
 
   DISALLOW_COPY_AND_ASSIGN(Worker);
 };
@@ -84,22 +123,42 @@ class SequencedWorkerPool::Inner
   // token ID, creating a new one if necessary.
   int LockedGetNamedTokenID(const std::string& name);
 
+  // Chooses the run queue a newly runnable work item goes to. Work posted
+  // from one of our own workers stays on that worker's queue for locality;
+  // other posts are spread round-robin over the queues of live workers.
+  size_t LockedChooseRunQueue();
+
+  // Appends |item| to the given run queue. Must be called inside the lock.
+  void LockedEnqueueWorkItem(size_t queue_index, const WorkItem& item);
+
+  // Finds the next task for |worker|: first the worker's pinned sequence,
+  // then the front of its own run queue, and finally the oldest item stolen
+  // from another worker's run queue.
+  //
   // The calling code should clear the given delete_these_oustide_lock
   // vector the next time the lock is released. See the implementation for
   // a more detailed description.
-  bool GetWork(SequencedTask* task,
+  bool GetWork(Worker* worker,
+               SequencedTask* task,
                std::vector<base::Closure>* delete_these_outside_lock);
 
+  // Pops the next task of the given active sequence into |task|, discarding
+  // tasks that should not run during shutdown. Returns false and retires the
+  // sequence if nothing in it should run.
+  bool TakeSequenceTask(int sequence_token_id,
+                        SequencedTask* task,
+                        std::vector<base::Closure>* delete_these_outside_lock);
+
+  // Pops the next work item from the given run queue. Returns false if the
+  // queue is empty.
+  bool PopWorkItem(size_t queue_index, WorkItem* item);
+
   // Peforms init and cleanup around running the given task. WillRun...
   // returns the value from PrepareToStartAdditionalThreadIfNecessary.
   // The calling code should call FinishStartingAdditionalThread once the
   // lock is released if the return values is nonzero.
   int WillRunWorkerTask(const SequencedTask& task);
-  void DidRunWorkerTask(const SequencedTask& task);
-
-  // Returns true if there are no threads currently running the given
-  // sequence token.
-  bool IsSequenceTokenRunnable(int sequence_token_id) const;
+  void DidRunWorkerTask(Worker* worker, const SequencedTask& task);
 
   // Checks if all threads are busy and the addition of one more could run an
   // additional task waiting in the queue. This must be called from within
@@ -162,21 +221,32 @@ class SequencedWorkerPool::Inner
   // flag set.
   size_t blocking_shutdown_thread_count_;
 
-  // In-order list of all pending tasks. These are tasks waiting for a thread
-  // to run on or that are blocked on a previous task in their sequence.
-  //
-  // We maintain the pending_task_count_ separately for metrics because
-  // list.size() can be linear time.
-  std::list<SequencedTask> pending_tasks_;
+  // One run queue per potential worker, indexed by Worker::queue_index().
+  // Each holds runnable work items: unsequenced tasks and tickets for
+  // sequences that are not currently running. A worker drains its own queue
+  // and steals from the others when it runs dry, so there is no scan over
+  // tasks that cannot run yet.
+  std::vector<std::deque<WorkItem> > run_queues_;
+
+  // Total number of items in |run_queues_|.
+  size_t runnable_item_count_;
+
+  // Next run queue for posts from threads that are not our workers.
+  size_t next_run_queue_;
+
+  // Pending tasks of every active sequence, in posting order. A sequence is
+  // active from the time its first task is posted until it runs out of
+  // tasks; while active it either has one ticket in a run queue or is pinned
+  // to the worker running it, which is what keeps its tasks serialized.
+  std::map<int, std::deque<SequencedTask> > sequences_;
+
+  // Number of tasks posted but not yet started, whether they are in a run
+  // queue or waiting in |sequences_|.
   size_t pending_task_count_;
 
-  // Number of tasks in the pending_tasks_ list that are marked as blocking
-  // shutdown.
+  // Number of pending tasks that are marked as blocking shutdown.
   size_t blocking_shutdown_pending_task_count_;
 
-  // Lists all sequence tokens currently executing.
-  std::set<int> current_sequences_;
-
   // Set when the app is terminating and no further tasks should be allowed,
   // though we may still be running existing tasks.
   bool terminating_;
@@ -187,20 +257,35 @@ class SequencedWorkerPool::Inner
   SequencedWorkerPool::TestingObserver* testing_observer_;
 };
 
+// static
+base::LazyInstance<base::ThreadLocalPointer<SequencedWorkerPool::Worker> >
+    SequencedWorkerPool::Worker::lazy_tls_ptr_ = LAZY_INSTANCE_INITIALIZER;
+
 SequencedWorkerPool::Worker::Worker(SequencedWorkerPool::Inner* inner,
                                     int thread_number,
                                     const std::string& prefix)
     : base::SimpleThread(
           prefix + StringPrintf("Worker%d", thread_number).c_str()),
       inner_(inner),
-      current_shutdown_mode_(SequencedWorkerPool::CONTINUE_ON_SHUTDOWN) {
+      current_shutdown_mode_(SequencedWorkerPool::CONTINUE_ON_SHUTDOWN),
+      queue_index_(thread_number - 1),
+      pinned_sequence_token_id_(0),
+      pinned_task_count_(0) {
   Start();
 }
 
 SequencedWorkerPool::Worker::~Worker() {
 }
 
+// static
+SequencedWorkerPool::Worker*
+SequencedWorkerPool::Worker::GetForCurrentThread() {
+  return lazy_tls_ptr_.Get().Get();
+}
+
 void SequencedWorkerPool::Worker::Run() {
+  lazy_tls_ptr_.Get().Set(this);
+
   // Just jump back to the Inner object to run the thread, since it has all the
   // tracking information and queues. It might be more natural to implement
   // using DelegateSimpleThread and have Inner implement the Delegate to avoid
@@ -219,6 +304,9 @@ SequencedWorkerPool::Inner::Inner(size_t max_threads,
       thread_being_created_(false),
       waiting_thread_count_(0),
       blocking_shutdown_thread_count_(0),
+      run_queues_(std::max<size_t>(max_threads, 1)),
+      runnable_item_count_(0),
+      next_run_queue_(0),
       pending_task_count_(0),
       blocking_shutdown_pending_task_count_(0),
       terminating_(false),
@@ -273,11 +361,26 @@ bool SequencedWorkerPool::Inner::PostTask(
     if (optional_token_name)
       sequenced.sequence_token_id = LockedGetNamedTokenID(*optional_token_name);
 
-    pending_tasks_.push_back(sequenced);
     pending_task_count_++;
     if (shutdown_behavior == BLOCK_SHUTDOWN)
       blocking_shutdown_pending_task_count_++;
 
+    if (!sequenced.sequence_token_id) {
+      LockedEnqueueWorkItem(LockedChooseRunQueue(), sequenced);
+    } else {
+      // If the sequence is already active, whoever holds it will get to this
+      // task in order. Otherwise activate it with a ticket in a run queue.
+      bool was_active =
+          sequences_.find(sequenced.sequence_token_id) != sequences_.end();
+      sequences_[sequenced.sequence_token_id].push_back(sequenced);
+      if (!was_active) {
+        WorkItem ticket;
+        ticket.sequence_token_id = sequenced.sequence_token_id;
+        ticket.shutdown_behavior = shutdown_behavior;
+        LockedEnqueueWorkItem(LockedChooseRunQueue(), ticket);
+      }
+    }
+
     create_thread_id = PrepareToStartAdditionalThreadIfHelpful();
   }
 
@@ -359,7 +462,7 @@ void SequencedWorkerPool::Inner::ThreadLoop(Worker* this_worker) {
       // See GetWork for what delete_these_outside_lock is doing.
       SequencedTask task;
       std::vector<base::Closure> delete_these_outside_lock;
-      if (GetWork(&task, &delete_these_outside_lock)) {
+      if (GetWork(this_worker, &task, &delete_these_outside_lock)) {
         int new_thread_id = WillRunWorkerTask(task);
         {
           base::AutoUnlock unlock(lock_);
@@ -376,7 +479,8 @@ void SequencedWorkerPool::Inner::ThreadLoop(Worker* this_worker) {
           // we do this with delete_these_oustide_lock.
           task.task = base::Closure();
         }
-        DidRunWorkerTask(task);  // Must be done inside the lock.
+        // Must be done inside the lock.
+        DidRunWorkerTask(this_worker, task);
       } else {
         // When we're terminating and there's no more work, we can shut down.
         // You can't get more tasks posted once terminating_ is set. There may
@@ -414,56 +518,93 @@ int SequencedWorkerPool::Inner::LockedGetNamedTokenID(
   return result.id_;
 }
 
+size_t SequencedWorkerPool::Inner::LockedChooseRunQueue() {
+  lock_.AssertAcquired();
+
+  Worker* current = Worker::GetForCurrentThread();
+  if (current && current->inner() == this)
+    return current->queue_index();
+
+  // Queues of workers that have not been started yet are still picked up by
+  // stealing, but keep new work on live workers when we have some.
+  size_t live_queues = std::max<size_t>(threads_.size(), 1);
+  size_t result = next_run_queue_ % live_queues;
+  next_run_queue_ = result + 1;
+  return result;
+}
+
+void SequencedWorkerPool::Inner::LockedEnqueueWorkItem(size_t queue_index,
+                                                       const WorkItem& item) {
+  lock_.AssertAcquired();
+  DCHECK_LT(queue_index, run_queues_.size());
+  run_queues_[queue_index].push_back(item);
+  runnable_item_count_++;
+}
+
+bool SequencedWorkerPool::Inner::PopWorkItem(size_t queue_index,
+                                             WorkItem* item) {
+  lock_.AssertAcquired();
+  std::deque<WorkItem>& queue = run_queues_[queue_index];
+  if (queue.empty())
+    return false;
+  *item = queue.front();
+  queue.pop_front();
+  runnable_item_count_--;
+  return true;
+}
+
 bool SequencedWorkerPool::Inner::GetWork(
+    Worker* worker,
     SequencedTask* task,
     std::vector<base::Closure>* delete_these_outside_lock) {
   lock_.AssertAcquired();
 
-  DCHECK_EQ(pending_tasks_.size(), pending_task_count_);
   UMA_HISTOGRAM_COUNTS_100("SequencedWorkerPool.TaskCount",
                            static_cast<int>(pending_task_count_));
 
-  // Find the next task with a sequence token that's not currently in use.
-  // If the token is in use, that means another thread is running something
-  // in that sequence, and we can't run it without going out-of-order.
-  //
-  // This algorithm is simple and fair, but inefficient in some cases. For
-  // example, say somebody schedules 1000 slow tasks with the same sequence
-  // number. We'll have to go through all those tasks each time we feel like
-  // there might be work to schedule. If this proves to be a problem, we
-  // should make this more efficient.
-  //
-  // One possible enhancement would be to keep a map from sequence ID to a
-  // list of pending but currently blocked SequencedTasks for that ID.
-  // When a worker finishes a task of one sequence token, it can pick up the
-  // next one from that token right away.
-  //
-  // This may lead to starvation if there are sufficient numbers of sequences
-  // in use. To alleviate this, we could add an incrementing priority counter
-  // to each SequencedTask. Then maintain a priority_queue of all runnable
-  // tasks, sorted by priority counter. When a sequenced task is completed
-  // we would pop the head element off of that tasks pending list and add it
-  // to the priority queue. Then we would run the first item in the priority
-  // queue.
-  bool found_task = false;
-  int unrunnable_tasks = 0;
-  std::list<SequencedTask>::iterator i = pending_tasks_.begin();
-  while (i != pending_tasks_.end()) {
-    if (!IsSequenceTokenRunnable(i->sequence_token_id)) {
-      unrunnable_tasks++;
-      ++i;
+  // A sequence pinned to this worker by DidRunWorkerTask() continues here
+  // without going through a run queue, so it never migrates while it is
+  // busy and its tasks stay serialized.
+  int pinned_id = worker->pinned_sequence_token_id();
+  if (pinned_id &&
+      TakeSequenceTask(pinned_id, task, delete_these_outside_lock))
+    return true;
+  worker->set_pinned_sequence(0, 0);
+
+  // Our own queue first, oldest item first. When it is empty, steal the
+  // oldest item from the other workers' queues, starting with our neighbor
+  // so that thieves spread out. Thieves take from the front rather than the
+  // back since nothing else contends for the queue under the lock, and it
+  // keeps the latency of stolen work bounded.
+  size_t queue_count = run_queues_.size();
+  size_t own_queue = worker->queue_index();
+  int stolen = 0;
+  for (size_t offset = 0; runnable_item_count_ > 0 && offset < queue_count;) {
+    WorkItem item;
+    if (!PopWorkItem((own_queue + offset) % queue_count, &item)) {
+      ++offset;
+      continue;
+    }
+    if (offset)
+      stolen++;
+
+    if (item.sequence_token_id) {
+      // A sequence ticket. The sequence now belongs to this worker.
+      if (TakeSequenceTask(item.sequence_token_id, task,
+                           delete_these_outside_lock)) {
+        worker->set_pinned_sequence(item.sequence_token_id, 0);
+        UMA_HISTOGRAM_COUNTS_100("SequencedWorkerPool.StolenItemCount",
+                                 stolen);
+        return true;
+      }
       continue;
     }
 
-    if (terminating_ && i->shutdown_behavior != BLOCK_SHUTDOWN) {
+    pending_task_count_--;
+    if (terminating_ && item.shutdown_behavior != BLOCK_SHUTDOWN) {
       // We're shutting down and the task we just found isn't blocking
       // shutdown. Delete it and get more work.
       //
-      // Note that we do not want to delete unrunnable tasks. Deleting a task
-      // can have side effects (like freeing some objects) and deleting a
-      // task that's supposed to run after one that's currently running could
-      // cause an obscure crash.
-      //
       // We really want to delete these tasks outside the lock in case the
       // closures are holding refs to objects that want to post work from
       // their destructorss (which would deadlock). The closures are
@@ -471,36 +612,61 @@ bool SequencedWorkerPool::Inner::GetWork(
       // until the lock is exited. The calling code can just clear() the
       // vector they passed to us once the lock is exited to make this
       // happen.
-      delete_these_outside_lock->push_back(i->task);
-      i = pending_tasks_.erase(i);
-      pending_task_count_--;
-    } else {
-      // Found a runnable task.
-      *task = *i;
-      i = pending_tasks_.erase(i);
-      pending_task_count_--;
-      if (task->shutdown_behavior == BLOCK_SHUTDOWN)
-        blocking_shutdown_pending_task_count_--;
-
-      found_task = true;
-      break;
+      delete_these_outside_lock->push_back(item.task);
+      continue;
     }
+
+    if (item.shutdown_behavior == BLOCK_SHUTDOWN)
+      blocking_shutdown_pending_task_count_--;
+    *task = item;
+    UMA_HISTOGRAM_COUNTS_100("SequencedWorkerPool.StolenItemCount", stolen);
+    return true;
   }
 
-  // Track the number of tasks we had to skip over to see if we should be
-  // making this more efficient. If this number ever becomes large or is
-  // frequently "some", we should consider the optimization above.
-  UMA_HISTOGRAM_COUNTS_100("SequencedWorkerPool.UnrunnableTaskCount",
-                           unrunnable_tasks);
-  return found_task;
+  UMA_HISTOGRAM_COUNTS_100("SequencedWorkerPool.StolenItemCount", stolen);
+  return false;
 }
 
-int SequencedWorkerPool::Inner::WillRunWorkerTask(const SequencedTask& task) {
+bool SequencedWorkerPool::Inner::TakeSequenceTask(
+    int sequence_token_id,
+    SequencedTask* task,
+    std::vector<base::Closure>* delete_these_outside_lock) {
   lock_.AssertAcquired();
 
-  // Mark the task's sequence number as in use.
-  if (task.sequence_token_id)
-    current_sequences_.insert(task.sequence_token_id);
+  std::map<int, std::deque<SequencedTask> >::iterator found =
+      sequences_.find(sequence_token_id);
+  DCHECK(found != sequences_.end());
+  std::deque<SequencedTask>& sequence = found->second;
+
+  while (!sequence.empty()) {
+    SequencedTask next = sequence.front();
+    sequence.pop_front();
+    pending_task_count_--;
+
+    // The previous task in this sequence has completed, so the front task is
+    // runnable. If we're shutting down and it doesn't block shutdown, delete
+    // it (outside the lock, see GetWork) and look at the one after it. Tasks
+    // further back are never deleted before the ones ahead of them, since
+    // deleting a task can have side effects that the running task does not
+    // expect.
+    if (terminating_ && next.shutdown_behavior != BLOCK_SHUTDOWN) {
+      delete_these_outside_lock->push_back(next.task);
+      continue;
+    }
+
+    if (next.shutdown_behavior == BLOCK_SHUTDOWN)
+      blocking_shutdown_pending_task_count_--;
+    *task = next;
+    return true;
+  }
+
+  // Nothing left to run; the sequence is no longer active.
+  sequences_.erase(found);
+  return false;
+}
+
+int SequencedWorkerPool::Inner::WillRunWorkerTask(const SequencedTask& task) {
+  lock_.AssertAcquired();
 
   if (task.shutdown_behavior == SequencedWorkerPool::BLOCK_SHUTDOWN)
     blocking_shutdown_thread_count_++;
@@ -523,7 +689,8 @@ int SequencedWorkerPool::Inner::WillRunWorkerTask(const SequencedTask& task) {
   return PrepareToStartAdditionalThreadIfHelpful();
 }
 
-void SequencedWorkerPool::Inner::DidRunWorkerTask(const SequencedTask& task) {
+void SequencedWorkerPool::Inner::DidRunWorkerTask(Worker* worker,
+                                                  const SequencedTask& task) {
   lock_.AssertAcquired();
 
   if (task.shutdown_behavior == SequencedWorkerPool::BLOCK_SHUTDOWN) {
@@ -531,16 +698,33 @@ void SequencedWorkerPool::Inner::DidRunWorkerTask(const SequencedTask& task) {
     blocking_shutdown_thread_count_--;
   }
 
-  if (task.sequence_token_id)
-    current_sequences_.erase(task.sequence_token_id);
-}
+  if (!task.sequence_token_id)
+    return;
 
-bool SequencedWorkerPool::Inner::IsSequenceTokenRunnable(
-    int sequence_token_id) const {
-  lock_.AssertAcquired();
-  return !sequence_token_id ||
-      current_sequences_.find(sequence_token_id) ==
-          current_sequences_.end();
+  DCHECK_EQ(task.sequence_token_id, worker->pinned_sequence_token_id());
+  std::map<int, std::deque<SequencedTask> >::iterator found =
+      sequences_.find(task.sequence_token_id);
+  DCHECK(found != sequences_.end());
+  if (found->second.empty()) {
+    // The sequence ran dry; it is no longer active.
+    sequences_.erase(found);
+    worker->set_pinned_sequence(0, 0);
+    return;
+  }
+
+  // Keep running the sequence on this worker, but don't let one busy
+  // sequence starve the rest of our run queue: after a burst, requeue its
+  // ticket behind the other work.
+  int pinned_count = worker->pinned_task_count() + 1;
+  if (pinned_count < kMaxPinnedSequenceTasks) {
+    worker->set_pinned_sequence(task.sequence_token_id, pinned_count);
+    return;
+  }
+  WorkItem ticket;
+  ticket.sequence_token_id = task.sequence_token_id;
+  ticket.shutdown_behavior = task.shutdown_behavior;
+  LockedEnqueueWorkItem(worker->queue_index(), ticket);
+  worker->set_pinned_sequence(0, 0);
 }
 
 int SequencedWorkerPool::Inner::PrepareToStartAdditionalThreadIfHelpful() {
@@ -573,19 +757,17 @@ int SequencedWorkerPool::Inner::PrepareToStartAdditionalThreadIfHelpful() {
   // given the workload, but in reality fewer may be created because the
   // sequence of thread creation on the background threads is racing with the
   // shutdown call.
+  //
+  // Tasks stuck behind a running task of the same sequence are not in a run
+  // queue, so any queued item is something another thread could start now.
   if (!terminating_ &&
       !thread_being_created_ &&
       threads_.size() < max_threads_ &&
-      waiting_thread_count_ == 0) {
-    // We could use an additional thread if there's work to be done.
-    for (std::list<SequencedTask>::iterator i = pending_tasks_.begin();
-         i != pending_tasks_.end(); ++i) {
-      if (IsSequenceTokenRunnable(i->sequence_token_id)) {
-        // Found a runnable task, mark the thread as being started.
-        thread_being_created_ = true;
-        return static_cast<int>(threads_.size() + 1);
-      }
-    }
+      waiting_thread_count_ == 0 &&
+      runnable_item_count_ > 0) {
+    // Mark the thread as being started.
+    thread_being_created_ = true;
+    return static_cast<int>(threads_.size() + 1);
   }
   return 0;
 }
@@ -46,6 +46,11 @@ namespace base {
 // not enforce shutdown semantics or allow us to specify how many worker
 // threads to run. For the typical use case of random background work, we don't
 // necessarily want to be super aggressive about creating threads.
+//
+// Each worker has its own run queue and steals from the others when it runs
+// out of work. A sequence is pinned to the worker running it for as long as
+// it has tasks queued, which is how sequence ordering is kept without
+// scanning for runnable tasks.
 class BASE_EXPORT SequencedWorkerPool {
  public:
   // Defines what should happen to a task posted to the worker pool on shutdown.
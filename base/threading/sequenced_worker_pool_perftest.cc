@@ -0,0 +1,131 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kTaskCount = 20000;
+
+// Roughly how much work each task does, to keep tasks short but non-empty.
+const int kSpinIterations = 200;
+
+class TaskRecorder {
+ public:
+  TaskRecorder(int task_count, WaitableEvent* done)
+      : latencies_(task_count),
+        remaining_(task_count),
+        done_(done) {
+  }
+
+  void Run(int index, TimeTicks posted) {
+    latencies_[index] = TimeTicks::Now() - posted;
+    volatile int sink = 0;
+    for (int i = 0; i < kSpinIterations; ++i)
+      sink += i;
+    if (subtle::Barrier_AtomicIncrement(&remaining_, -1) == 0)
+      done_->Signal();
+  }
+
+  // Sorts the recorded latencies and returns the given percentile.
+  TimeDelta Percentile(int percent) {
+    std::sort(latencies_.begin(), latencies_.end());
+    return latencies_[latencies_.size() * percent / 100];
+  }
+
+ private:
+  // Each task writes only its own slot.
+  std::vector<TimeDelta> latencies_;
+  volatile subtle::Atomic32 remaining_;
+  WaitableEvent* done_;
+};
+
+// Blocks until |thread_count| of these tasks have started, so that each of
+// them has a worker of its own.
+void WaitForAllStarted(subtle::Atomic32* started, int thread_count,
+                       WaitableEvent* all_started) {
+  if (subtle::Barrier_AtomicIncrement(started, 1) == thread_count)
+    all_started->Signal();
+  all_started->Wait();
+}
+
+// Posts kTaskCount tasks spread over |sequence_count| sequences (0 means
+// unsequenced) to a pool of |thread_count| threads and logs throughput and
+// start latency.
+void RunPoolTest(size_t thread_count, int sequence_count) {
+  SequencedWorkerPool pool(thread_count, "perftest");
+  std::vector<SequencedWorkerPool::SequenceToken> tokens;
+  for (int i = 0; i < sequence_count; ++i)
+    tokens.push_back(pool.GetSequenceToken());
+
+  // Start every worker so that thread creation is not part of the
+  // measurement. The pool only creates a worker when the others are busy.
+  subtle::Atomic32 started = 0;
+  WaitableEvent all_started(true, false);
+  for (size_t i = 0; i < thread_count; ++i) {
+    pool.PostWorkerTask(FROM_HERE,
+                        Bind(&WaitForAllStarted, &started,
+                             static_cast<int>(thread_count), &all_started));
+  }
+  pool.FlushForTesting();
+
+  WaitableEvent done(false, false);
+  TaskRecorder recorder(kTaskCount, &done);
+
+  PerfTimer timer;
+  for (int i = 0; i < kTaskCount; ++i) {
+    Closure task = Bind(&TaskRecorder::Run, Unretained(&recorder), i,
+                        TimeTicks::Now());
+    if (tokens.empty()) {
+      pool.PostWorkerTask(FROM_HERE, task);
+    } else {
+      pool.PostSequencedWorkerTask(tokens[i % tokens.size()], FROM_HERE,
+                                   task);
+    }
+  }
+  done.Wait();
+  TimeDelta elapsed = timer.Elapsed();
+  pool.Shutdown();
+
+  std::string name = StringPrintf("SequencedWorkerPool_%dthreads_%dsequences",
+                                  static_cast<int>(thread_count),
+                                  sequence_count);
+  LogPerfResult((name + "_throughput").c_str(),
+                kTaskCount / elapsed.InSecondsF(), "tasks/s");
+  LogPerfResult((name + "_p50").c_str(),
+                recorder.Percentile(50).InMicroseconds(), "us");
+  LogPerfResult((name + "_p99").c_str(),
+                recorder.Percentile(99).InMicroseconds(), "us");
+}
+
+}  // namespace
+
+TEST(SequencedWorkerPoolPerfTest, Unsequenced) {
+  for (size_t threads = 8; threads <= 32; threads *= 2)
+    RunPoolTest(threads, 0);
+}
+
+TEST(SequencedWorkerPoolPerfTest, FewSequences) {
+  for (size_t threads = 8; threads <= 32; threads *= 2)
+    RunPoolTest(threads, 4);
+}
+
+TEST(SequencedWorkerPoolPerfTest, ManySequences) {
+  for (size_t threads = 8; threads <= 32; threads *= 2)
+    RunPoolTest(threads, 1000);
+}
+
+}  // namespace base
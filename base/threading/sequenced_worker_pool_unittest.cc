@@ -0,0 +1,206 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/threading/sequenced_worker_pool.h"
+
+#include <map>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Records the order in which the tasks of each sequence run, and whether two
+// tasks of a sequence ever ran at the same time.
+class SequenceTracker : public RefCountedThreadSafe<SequenceTracker> {
+ public:
+  SequenceTracker(int task_count, WaitableEvent* done)
+      : remaining_(task_count),
+        overlapped_(false),
+        done_(done) {
+  }
+
+  void Run(int sequence, int index) {
+    {
+      AutoLock lock(lock_);
+      if (running_[sequence])
+        overlapped_ = true;
+      running_[sequence] = true;
+      order_[sequence].push_back(index);
+    }
+    // Give another worker the chance to run the sequence if it can.
+    PlatformThread::YieldCurrentThread();
+    {
+      AutoLock lock(lock_);
+      running_[sequence] = false;
+    }
+    if (subtle::Barrier_AtomicIncrement(&remaining_, -1) == 0)
+      done_->Signal();
+  }
+
+  std::vector<int> order(int sequence) {
+    AutoLock lock(lock_);
+    return order_[sequence];
+  }
+
+  bool overlapped() {
+    AutoLock lock(lock_);
+    return overlapped_;
+  }
+
+ private:
+  friend class RefCountedThreadSafe<SequenceTracker>;
+  ~SequenceTracker() {}
+
+  Lock lock_;
+  std::map<int, std::vector<int> > order_;
+  std::map<int, bool> running_;
+  volatile subtle::Atomic32 remaining_;
+  bool overlapped_;
+  WaitableEvent* done_;
+
+  DISALLOW_COPY_AND_ASSIGN(SequenceTracker);
+};
+
+// Posts |task_count| tasks to each of |tokens| from a worker, so that they all
+// land in that worker's run queue, then keeps the worker busy until they have
+// all run on the workers that stole them.
+void PostSequencesAndBlock(SequencedWorkerPool* pool,
+                           std::vector<SequencedWorkerPool::SequenceToken>
+                               tokens,
+                           int task_count,
+                           scoped_refptr<SequenceTracker> tracker,
+                           WaitableEvent* done) {
+  for (int i = 0; i < task_count; ++i) {
+    for (size_t sequence = 0; sequence < tokens.size(); ++sequence) {
+      pool->PostSequencedWorkerTask(
+          tokens[sequence], FROM_HERE,
+          Bind(&SequenceTracker::Run, tracker, static_cast<int>(sequence), i));
+    }
+  }
+  done->Wait();
+}
+
+// Signals |started|, then blocks until |release| is signaled.
+void Block(WaitableEvent* started, WaitableEvent* release) {
+  started->Signal();
+  release->Wait();
+}
+
+// Counts the task, and signals |done| when |count| reaches |task_count|.
+void CountTask(subtle::Atomic32* count, int task_count, WaitableEvent* done) {
+  if (subtle::Barrier_AtomicIncrement(count, 1) == task_count)
+    done->Signal();
+}
+
+// Signals |event| when the pool starts waiting for shutdown.
+class SignalOnShutdownWait : public SequencedWorkerPool::TestingObserver {
+ public:
+  explicit SignalOnShutdownWait(WaitableEvent* event) : event_(event) {}
+
+  virtual void WillWaitForShutdown() OVERRIDE {
+    event_->Signal();
+  }
+
+ private:
+  WaitableEvent* event_;
+
+  DISALLOW_COPY_AND_ASSIGN(SignalOnShutdownWait);
+};
+
+}  // namespace
+
+// Tests that sequences that are stolen from a busy worker's run queue, and
+// requeued as they run long, still run one task at a time and in order.
+TEST(SequencedWorkerPoolTest, SequenceOrderUnderStealing) {
+  const int kSequenceCount = 6;
+  // Long enough that each sequence is requeued several times.
+  const int kTasksPerSequence = 100;
+
+  SequencedWorkerPool pool(4, "SequenceOrderUnderStealing");
+  std::vector<SequencedWorkerPool::SequenceToken> tokens;
+  for (int i = 0; i < kSequenceCount; ++i)
+    tokens.push_back(pool.GetSequenceToken());
+
+  WaitableEvent done(true, false);
+  scoped_refptr<SequenceTracker> tracker(
+      new SequenceTracker(kSequenceCount * kTasksPerSequence, &done));
+  pool.PostWorkerTask(FROM_HERE,
+                      Bind(&PostSequencesAndBlock, &pool, tokens,
+                           kTasksPerSequence, tracker, &done));
+  done.Wait();
+  pool.FlushForTesting();
+
+  EXPECT_FALSE(tracker->overlapped());
+  for (int sequence = 0; sequence < kSequenceCount; ++sequence) {
+    std::vector<int> order = tracker->order(sequence);
+    ASSERT_EQ(static_cast<size_t>(kTasksPerSequence), order.size());
+    for (int i = 0; i < kTasksPerSequence; ++i)
+      EXPECT_EQ(i, order[i]) << "sequence " << sequence;
+  }
+  pool.Shutdown();
+}
+
+// Tests that shutdown runs the BLOCK_SHUTDOWN tasks queued on a worker that
+// is still busy, by stealing them, and drops the SKIP_ON_SHUTDOWN ones.
+TEST(SequencedWorkerPoolTest, ShutdownWithTasksQueuedOnOtherWorkers) {
+  const int kThreadCount = 2;
+  const int kTasksPerBehavior = 4;
+
+  SequencedWorkerPool pool(kThreadCount, "ShutdownWithTasksQueued");
+  WaitableEvent shutdown_waiting(true, false);
+  SignalOnShutdownWait observer(&shutdown_waiting);
+  pool.SetTestingObserver(&observer);
+
+  // Keep both workers busy: one until shutdown starts, and the other until
+  // every BLOCK_SHUTDOWN task has run, which only the first can do.
+  WaitableEvent all_blocking_ran(true, false);
+  WaitableEvent first_started(true, false);
+  WaitableEvent second_started(true, false);
+  pool.PostWorkerTask(FROM_HERE,
+                      Bind(&Block, &first_started, &shutdown_waiting));
+  pool.PostWorkerTask(FROM_HERE,
+                      Bind(&Block, &second_started, &all_blocking_ran));
+  first_started.Wait();
+  second_started.Wait();
+
+  // Posts alternate between the run queues of the two workers, so each queue
+  // gets tasks of both kinds.
+  subtle::Atomic32 blocking_ran = 0;
+  subtle::Atomic32 skipped_ran = 0;
+  WaitableEvent all_skipped_ran(true, false);
+  for (int i = 0; i < kTasksPerBehavior / kThreadCount; ++i) {
+    for (int j = 0; j < kThreadCount; ++j) {
+      pool.PostWorkerTaskWithShutdownBehavior(
+          FROM_HERE,
+          Bind(&CountTask, &blocking_ran, kTasksPerBehavior,
+               &all_blocking_ran),
+          SequencedWorkerPool::BLOCK_SHUTDOWN);
+    }
+    for (int j = 0; j < kThreadCount; ++j) {
+      pool.PostWorkerTaskWithShutdownBehavior(
+          FROM_HERE,
+          Bind(&CountTask, &skipped_ran, kTasksPerBehavior,
+               &all_skipped_ran),
+          SequencedWorkerPool::SKIP_ON_SHUTDOWN);
+    }
+  }
+
+  pool.Shutdown();
+  EXPECT_TRUE(shutdown_waiting.IsSignaled());
+  EXPECT_TRUE(all_blocking_ran.IsSignaled());
+  EXPECT_EQ(kTasksPerBehavior, subtle::NoBarrier_Load(&blocking_ran));
+  EXPECT_EQ(0, subtle::NoBarrier_Load(&skipped_ran));
+}
+
+}  // namespace base
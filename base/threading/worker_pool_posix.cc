@@ -91,7 +91,8 @@ void WorkerThread::ThreadMain() {
     pending_task.task.Run();
 
     tracked_objects::ThreadData::TallyRunOnWorkerThreadIfTracking(
-        pending_task.birth_tally, TrackedTime(pending_task.time_posted),
+        pending_task.birth_tally, pending_task.birth_weight,
+        TrackedTime(pending_task.time_posted),
         start_time, tracked_objects::ThreadData::NowForEndOfRun());
   }
 
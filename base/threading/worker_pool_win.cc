@@ -27,7 +27,7 @@ DWORD CALLBACK WorkItemCallback(void* param) {
   pending_task->task.Run();
 
   tracked_objects::ThreadData::TallyRunOnWorkerThreadIfTracking(
-      pending_task->birth_tally,
+      pending_task->birth_tally, pending_task->birth_weight,
       tracked_objects::TrackedTime(pending_task->time_posted), start_time,
       tracked_objects::ThreadData::NowForEndOfRun());
 
@@ -5,6 +5,9 @@
 #include "base/tracked_objects.h"
 
 #include <math.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "base/format_macros.h"
 #include "base/message_loop.h"
@@ -35,6 +38,23 @@ const bool kTrackParentChildLinks = false;
 const ThreadData::Status kInitialStartupState =
     ThreadData::PROFILING_CHILDREN_ACTIVE;
 
+// Hashes for the per-thread tables.  As with Location::operator<, the strings
+// in a Location are atoms, so their addresses are all we need.
+size_t HashLocation(const Location& location) {
+  uintptr_t file = reinterpret_cast<uintptr_t>(location.file_name());
+  return static_cast<size_t>((file >> 3) ^ (location.line_number() * 31));
+}
+
+size_t HashBirths(const Births* birth) {
+  return static_cast<size_t>(reinterpret_cast<uintptr_t>(birth) >> 4);
+}
+
+bool SameLocation(const Location& a, const Location& b) {
+  return a.line_number() == b.line_number() &&
+         a.file_name() == b.file_name() &&
+         a.function_name() == b.function_name();
+}
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -61,10 +81,11 @@ DeathData::DeathData(int count) {
 
 void DeathData::RecordDeath(const DurationInt queue_duration,
                             const DurationInt run_duration,
-                            int32 random_number) {
-  ++count_;
-  queue_duration_sum_ += queue_duration;
-  run_duration_sum_ += run_duration;
+                            int32 random_number,
+                            int weight) {
+  count_ += weight;
+  queue_duration_sum_ += queue_duration * weight;
+  run_duration_sum_ += run_duration * weight;
 
   if (queue_duration_max_ < queue_duration)
     queue_duration_max_ = queue_duration;
@@ -156,15 +177,13 @@ void BirthOnThread::ToValue(const std::string& prefix,
 }
 
 //------------------------------------------------------------------------------
-Births::Births(const Location& location, const ThreadData& current)
+Births::Births(const Location& location, const ThreadData& current, int weight)
     : BirthOnThread(location, current),
-      birth_count_(1) { }
+      birth_count_(weight) { }
 
 int Births::birth_count() const { return birth_count_; }
 
-void Births::RecordBirth() { ++birth_count_; }
-
-void Births::ForgetBirth() { --birth_count_; }
+void Births::RecordBirth(int weight) { birth_count_ += weight; }
 
 void Births::Clear() { birth_count_ = 0; }
 
@@ -204,13 +223,18 @@ base::LazyInstance<base::Lock>::Leaky
 // static
 ThreadData::Status ThreadData::status_ = ThreadData::UNINITIALIZED;
 
+// static
+int ThreadData::sampling_interval_ = 1;
+
 ThreadData::ThreadData(const std::string& suggested_name)
     : next_(NULL),
       next_retired_worker_(NULL),
       worker_thread_number_(0),
+      births_until_sample_(0),
       incarnation_count_for_pool_(-1) {
   DCHECK_GE(suggested_name.size(), 0u);
   thread_name_ = suggested_name;
+  InitializeTables();
   PushToHeadOfList();  // Which sets real incarnation_count_for_pool_.
 }
 
@@ -218,14 +242,22 @@ ThreadData::ThreadData(int thread_number)
     : next_(NULL),
       next_retired_worker_(NULL),
       worker_thread_number_(thread_number),
+      births_until_sample_(0),
       incarnation_count_for_pool_(-1)  {
   CHECK_GT(thread_number, 0);
   base::StringAppendF(&thread_name_, "WorkerThread-%d", thread_number);
+  InitializeTables();
   PushToHeadOfList();  // Which sets real incarnation_count_for_pool_.
 }
 
 ThreadData::~ThreadData() {}
 
+void ThreadData::InitializeTables() {
+  memset(birth_table_, 0, sizeof(birth_table_));
+  for (int i = 0; i < kTableSize; ++i)
+    death_table_[i].birth = 0;
+}
+
 void ThreadData::PushToHeadOfList() {
   // Toss in a hint of randomness (atop the uniniitalized value).
   (void)VALGRIND_MAKE_MEM_DEFINED_IF_ADDRESSABLE(&random_number_,
@@ -332,18 +364,48 @@ base::DictionaryValue* ThreadData::ToValue(bool reset_max) {
   return dictionary;
 }
 
-Births* ThreadData::TallyABirth(const Location& location) {
-  BirthMap::iterator it = birth_map_.find(location);
-  Births* child;
-  if (it != birth_map_.end()) {
-    child =  it->second;
-    child->RecordBirth();
-  } else {
-    child = new Births(location, *this);  // Leak this.
-    // Lock since the map may get relocated now, and other threads sometimes
-    // snapshot it (but they lock before copying it).
-    base::AutoLock lock(map_lock_);
-    birth_map_[location] = child;
+bool ThreadData::ShouldSampleBirth() {
+  if (--births_until_sample_ > 0)
+    return false;
+  births_until_sample_ = sampling_interval_;
+  return true;
+}
+
+Births* ThreadData::TallyABirth(const Location& location, int weight) {
+  Births* child = NULL;
+  size_t index = HashLocation(location);
+  for (int probe = 0; probe < kMaxProbes; ++probe, ++index) {
+    base::subtle::AtomicWord* slot = &birth_table_[index & (kTableSize - 1)];
+    // Only this thread writes the table, so we need no barrier to read it.
+    Births* entry =
+        reinterpret_cast<Births*>(base::subtle::NoBarrier_Load(slot));
+    if (!entry) {
+      child = new Births(location, *this, weight);  // Leak this.
+      // Publish the fully constructed instance to snapshotting threads.
+      base::subtle::Release_Store(
+          slot, reinterpret_cast<base::subtle::AtomicWord>(child));
+      break;
+    }
+    if (SameLocation(entry->location(), location)) {
+      child = entry;
+      child->RecordBirth(weight);
+      break;
+    }
+  }
+
+  if (!child) {
+    // The table is too crowded around this location; use the overflow map.
+    BirthMap::iterator it = birth_map_.find(location);
+    if (it != birth_map_.end()) {
+      child =  it->second;
+      child->RecordBirth(weight);
+    } else {
+      child = new Births(location, *this, weight);  // Leak this.
+      // Lock since the map may get relocated now, and other threads sometimes
+      // snapshot it (but they lock before copying it).
+      base::AutoLock lock(map_lock_);
+      birth_map_[location] = child;
+    }
   }
 
   if (kTrackParentChildLinks && status_ > PROFILING_ACTIVE &&
@@ -362,6 +424,7 @@ Births* ThreadData::TallyABirth(const Location& location) {
 }
 
 void ThreadData::TallyADeath(const Births& birth,
+                             int weight,
                              DurationInt queue_duration,
                              DurationInt run_duration) {
   // Stir in some randomness, plus add constant in case durations are zero.
@@ -370,15 +433,8 @@ void ThreadData::TallyADeath(const Births& birth,
   // An address is going to have some randomness to it as well ;-).
   random_number_ ^= static_cast<int32>(&birth - reinterpret_cast<Births*>(0));
 
-  DeathMap::iterator it = death_map_.find(&birth);
-  DeathData* death_data;
-  if (it != death_map_.end()) {
-    death_data = &it->second;
-  } else {
-    base::AutoLock lock(map_lock_);  // Lock as the map may get relocated now.
-    death_data = &death_map_[&birth];
-  }  // Release lock ASAP.
-  death_data->RecordDeath(queue_duration, run_duration, random_number_);
+  FindOrAddDeathData(birth)->RecordDeath(queue_duration, run_duration,
+                                         random_number_, weight);
 
   if (!kTrackParentChildLinks)
     return;
@@ -388,8 +444,35 @@ void ThreadData::TallyADeath(const Births& birth,
   }
 }
 
+DeathData* ThreadData::FindOrAddDeathData(const Births& birth) {
+  size_t index = HashBirths(&birth);
+  for (int probe = 0; probe < kMaxProbes; ++probe, ++index) {
+    DeathSlot* slot = &death_table_[index & (kTableSize - 1)];
+    const Births* entry =
+        reinterpret_cast<const Births*>(base::subtle::NoBarrier_Load(
+            &slot->birth));
+    if (entry == &birth)
+      return &slot->death_data;
+    if (!entry) {
+      slot->death_data.Clear();
+      // Publish the slot only once its data is ready to be snapshotted.
+      base::subtle::Release_Store(
+          &slot->birth, reinterpret_cast<base::subtle::AtomicWord>(&birth));
+      return &slot->death_data;
+    }
+  }
+
+  // The table is too crowded around this birth; use the overflow map.
+  DeathMap::iterator it = death_map_.find(&birth);
+  if (it != death_map_.end())
+    return &it->second;
+  base::AutoLock lock(map_lock_);  // Lock as the map may get relocated now.
+  return &death_map_[&birth];
+}
+
 // static
-Births* ThreadData::TallyABirthIfActive(const Location& location) {
+Births* ThreadData::TallyABirthIfActive(const Location& location,
+                                        int* birth_weight) {
   if (!kTrackAllTaskObjects)
     return NULL;  // Not compiled in.
 
@@ -398,7 +481,13 @@ Births* ThreadData::TallyABirthIfActive(const Location& location) {
   ThreadData* current_thread_data = Get();
   if (!current_thread_data)
     return NULL;
-  return current_thread_data->TallyABirth(location);
+  // When sampling, untallied births return NULL, so their deaths are skipped
+  // as well.
+  int weight = sampling_interval_;
+  if (weight > 1 && !current_thread_data->ShouldSampleBirth())
+    return NULL;
+  *birth_weight = weight;
+  return current_thread_data->TallyABirth(location, weight);
 }
 
 // static
@@ -441,12 +530,14 @@ void ThreadData::TallyRunOnNamedThreadIfTracking(
     if (!end_of_run.is_null())
       run_duration = (end_of_run - start_of_run).InMilliseconds();
   }
-  current_thread_data->TallyADeath(*birth, queue_duration, run_duration);
+  current_thread_data->TallyADeath(*birth, completed_task.birth_weight,
+                                   queue_duration, run_duration);
 }
 
 // static
 void ThreadData::TallyRunOnWorkerThreadIfTracking(
     const Births* birth,
+    int birth_weight,
     const TrackedTime& time_posted,
     const TrackedTime& start_of_run,
     const TrackedTime& end_of_run) {
@@ -479,12 +570,14 @@ void ThreadData::TallyRunOnWorkerThreadIfTracking(
     if (!end_of_run.is_null())
       run_duration = (end_of_run - start_of_run).InMilliseconds();
   }
-  current_thread_data->TallyADeath(*birth, queue_duration, run_duration);
+  current_thread_data->TallyADeath(*birth, birth_weight, queue_duration,
+                                   run_duration);
 }
 
 // static
 void ThreadData::TallyRunInAScopedRegionIfTracking(
     const Births* birth,
+    int birth_weight,
     const TrackedTime& start_of_run,
     const TrackedTime& end_of_run) {
   if (!kTrackAllTaskObjects)
@@ -504,7 +597,8 @@ void ThreadData::TallyRunInAScopedRegionIfTracking(
   DurationInt run_duration = 0;
   if (!start_of_run.is_null() && !end_of_run.is_null())
     run_duration = (end_of_run - start_of_run).InMilliseconds();
-  current_thread_data->TallyADeath(*birth, queue_duration, run_duration);
+  current_thread_data->TallyADeath(*birth, birth_weight, queue_duration,
+                                   run_duration);
 }
 
 const std::string ThreadData::thread_name() const { return thread_name_; }
@@ -514,6 +608,25 @@ void ThreadData::SnapshotMaps(bool reset_max,
                               BirthMap* birth_map,
                               DeathMap* death_map,
                               ParentChildSet* parent_child_set) {
+  // The tables are insert-only, and every slot is published only once it is
+  // initialized, so we can copy them while this thread keeps tallying.
+  for (int i = 0; i < kTableSize; ++i) {
+    Births* birth = reinterpret_cast<Births*>(
+        base::subtle::Acquire_Load(&birth_table_[i]));
+    if (birth)
+      (*birth_map)[birth->location()] = birth;
+  }
+  for (int i = 0; i < kTableSize; ++i) {
+    DeathSlot* slot = &death_table_[i];
+    const Births* birth = reinterpret_cast<const Births*>(
+        base::subtle::Acquire_Load(&slot->birth));
+    if (!birth)
+      continue;
+    (*death_map)[birth] = slot->death_data;
+    if (reset_max)
+      slot->death_data.ResetMax();
+  }
+
   base::AutoLock lock(map_lock_);
   for (BirthMap::const_iterator it = birth_map_.begin();
        it != birth_map_.end(); ++it)
@@ -570,6 +683,15 @@ void ThreadData::ResetAllThreadData() {
 }
 
 void ThreadData::Reset() {
+  for (int i = 0; i < kTableSize; ++i) {
+    Births* birth = reinterpret_cast<Births*>(
+        base::subtle::Acquire_Load(&birth_table_[i]));
+    if (birth)
+      birth->Clear();
+    if (base::subtle::Acquire_Load(&death_table_[i].birth))
+      death_table_[i].death_data.Clear();
+  }
+
   base::AutoLock lock(map_lock_);
   for (DeathMap::iterator it = death_map_.begin();
        it != death_map_.end(); ++it)
@@ -647,8 +769,23 @@ bool ThreadData::tracking_parent_child_status() {
   return status_ >= PROFILING_CHILDREN_ACTIVE;
 }
 
+// static
+void ThreadData::SetSamplingInterval(int interval) {
+  DCHECK_GE(interval, 1);
+  sampling_interval_ = std::max(interval, 1);
+}
+
+// static
+int ThreadData::sampling_interval() {
+  return sampling_interval_;
+}
+
 // static
 TrackedTime ThreadData::NowForStartOfRun(const Births* parent) {
+  // When sampling, a task without a birth tally was not sampled, and its run
+  // will not be tallied, so don't bother reading the clock.
+  if (!parent && sampling_interval_ > 1)
+    return TrackedTime();
   if (kTrackParentChildLinks && parent && status_ > PROFILING_ACTIVE) {
     ThreadData* current_thread_data = Get();
     if (current_thread_data)
@@ -705,6 +842,7 @@ void ThreadData::ShutdownSingleThreadedCleanup(bool leak) {
 
   // Put most global static back in pristine shape.
   worker_thread_data_creation_count_ = 0;
+  sampling_interval_ = 1;
   cleanup_count_ = 0;
   tls_index_.Set(NULL);
   status_ = DORMANT_DURING_TESTS;  // Almost UNINITIALIZED.
@@ -722,6 +860,8 @@ void ThreadData::ShutdownSingleThreadedCleanup(bool leak) {
     ThreadData* next_thread_data = thread_data_list;
     thread_data_list = thread_data_list->next();
 
+    for (int i = 0; i < kTableSize; ++i)
+      delete reinterpret_cast<Births*>(next_thread_data->birth_table_[i]);
     for (BirthMap::iterator it = next_thread_data->birth_map_.begin();
          next_thread_data->birth_map_.end() != it; ++it)
       delete it->second;  // Delete the Birth Records.
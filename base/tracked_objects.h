@@ -13,6 +13,7 @@
 #include <utility>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/base_export.h"
 #include "base/gtest_prod_util.h"
 #include "base/lazy_instance.h"
@@ -102,10 +103,21 @@
 // Each thread maintains a list of data items specific to that thread in a
 // ThreadData instance (for that specific thread only).  The two critical items
 // are lists of DeathData and Births instances.  These lists are maintained in
-// STL maps, which are indexed by Location. As noted earlier, we can compare
+// fixed-size, insert-only hash tables, which are indexed by Location (for
+// Births) and by Births (for DeathData). As noted earlier, we can compare
 // locations very efficiently as we consider the underlying data (file,
 // function, line) to be atoms, and hence pointer comparison is used rather than
-// (slow) string comparisons.
+// (slow) string comparisons.  Since the tables never move or remove entries,
+// other threads can snapshot them without a lock.  Only if a table overflows
+// do we fall back to STL maps, which are protected by a per-thread lock.
+//
+// To keep profiling cheap enough to leave on in production, tracking can also
+// be sampled (see ThreadData::SetSamplingInterval()).  With an interval of N,
+// each thread tallies only every Nth birth, and every tally (of a birth, or of
+// the matching death) is weighted by N.  Counts and duration sums are thus
+// scaled back up as they are recorded, and unsampled tasks skip the tables
+// (and the clock) entirely.  The weight travels with the task, so that its
+// death is weighted like its birth even if the interval changes meanwhile.
 //
 // To provide a mechanism for iterating over all "known threads," which means
 // threads that have recorded a birth or a death, we create a singly linked list
@@ -224,16 +236,13 @@ class BASE_EXPORT BirthOnThread {
 
 class BASE_EXPORT Births: public BirthOnThread {
  public:
-  Births(const Location& location, const ThreadData& current);
+  Births(const Location& location, const ThreadData& current, int weight);
 
   int birth_count() const;
 
-  // When we have a birth we update the count for this BirhPLace.
-  void RecordBirth();
-
-  // When a birthplace is changed (updated), we need to decrement the counter
-  // for the old instance.
-  void ForgetBirth();
+  // When we have a birth we update the count for this BirhPLace.  The
+  // |weight| is the number of births this one stands for when sampling.
+  void RecordBirth(int weight);
 
   // Hack to quickly reset all counts to zero.
   void Clear();
@@ -261,10 +270,13 @@ class BASE_EXPORT DeathData {
   explicit DeathData(int count);
 
   // Update stats for a task destruction (death) that had a Run() time of
-  // |duration|, and has had a queueing delay of |queue_duration|.
+  // |duration|, and has had a queueing delay of |queue_duration|.  When
+  // sampling, |weight| is the number of deaths this one stands for, and is
+  // applied to the count and to the duration sums.
   void RecordDeath(const DurationInt queue_duration,
                    const DurationInt run_duration,
-                   int random_number);
+                   int random_number,
+                   int weight);
 
   // Metrics accessors, used only in tests.
   int count() const;
@@ -379,10 +391,14 @@ class BASE_EXPORT ThreadData {
   // Finds (or creates) a place to count births from the given location in this
   // thread, and increment that tally.
   // TallyABirthIfActive will returns NULL if the birth cannot be tallied.
-  static Births* TallyABirthIfActive(const Location& location);
+  // Otherwise |birth_weight| is set to the number of births this one stands
+  // for, which must be passed back when its death is tallied.
+  static Births* TallyABirthIfActive(const Location& location,
+                                     int* birth_weight);
 
   // Records the end of a timed run of an object.  The |completed_task| contains
-  // a pointer to a Births, the time_posted, and a delayed_start_time if any.
+  // a pointer to a Births and its weight, the time_posted, and a
+  // delayed_start_time if any.
   // The |start_of_run| indicates when we started to perform the run of the
   // task.  The delayed_start_time is non-null for tasks that were posted as
   // delayed tasks, and it indicates when the task should have run (i.e., when
@@ -395,14 +411,16 @@ class BASE_EXPORT ThreadData {
       const TrackedTime& end_of_run);
 
   // Record the end of a timed run of an object.  The |birth| is the record for
-  // the instance, the |time_posted| records that instant, which is presumed to
-  // be when the task was posted into a queue to run on a worker thread.
+  // the instance, tallied with |birth_weight|, the |time_posted| records that
+  // instant, which is presumed to be when the task was posted into a queue to
+  // run on a worker thread.
   // The |start_of_run| is when the worker thread started to perform the run of
   // the task.
   // The |end_of_run| was just obtained by a call to Now() (just after the task
   // finished).
   static void TallyRunOnWorkerThreadIfTracking(
       const Births* birth,
+      int birth_weight,
       const TrackedTime& time_posted,
       const TrackedTime& start_of_run,
       const TrackedTime& end_of_run);
@@ -411,6 +429,7 @@ class BASE_EXPORT ThreadData {
   // being exited.
   static void TallyRunInAScopedRegionIfTracking(
       const Births* birth,
+      int birth_weight,
       const TrackedTime& start_of_run,
       const TrackedTime& end_of_run);
 
@@ -452,6 +471,13 @@ class BASE_EXPORT ThreadData {
   // on.  This is currently a compiled option, atop tracking_status().
   static bool tracking_parent_child_status();
 
+  // Sets how many births each thread sees per tallied birth.  An |interval|
+  // of 1 (the default) tallies every birth; larger values record one in
+  // |interval| tasks and weight its birth and death tallies by |interval|.
+  // Tasks in flight when the interval changes keep the weight of their birth.
+  static void SetSamplingInterval(int interval);
+  static int sampling_interval();
+
   // Special versions of Now() for getting times at start and end of a tracked
   // run.  They are super fast when tracking is disabled, and have some internal
   // side effects when we are tracking, so that we can deduce the amount of time
@@ -503,14 +529,41 @@ class BASE_EXPORT ThreadData {
   ThreadData* next() const;
 
 
-  // In this thread's data, record a new birth.
-  Births* TallyABirth(const Location& location);
+  // Number of slots in each of the per-thread tables, and the number of slots
+  // we probe before giving up and using the overflow maps.
+  enum {
+    kTableSize = 256,  // Must be a power of two.
+    kMaxProbes = 8,
+  };
+
+  // An entry in |death_table_|.  |birth| is published (with release
+  // semantics) only after |death_data| has been initialized.
+  struct DeathSlot {
+    base::subtle::AtomicWord birth;  // A const Births*, NULL if unused.
+    DeathData death_data;
+  };
+
+  // Clears both per-thread tables.  Called at construction.
+  void InitializeTables();
+
+  // Returns true if the next birth on this thread should be tallied, given
+  // the current sampling interval.
+  bool ShouldSampleBirth();
+
+  // In this thread's data, record a new birth that stands for |weight|
+  // births.
+  Births* TallyABirth(const Location& location, int weight);
 
-  // Find a place to record a death on this thread.
+  // Find a place to record a death on this thread, which stands for
+  // |weight| deaths like its birth did.
   void TallyADeath(const Births& birth,
+                   int weight,
                    DurationInt queue_duration,
                    DurationInt duration);
 
+  // Returns the DeathData for |birth|, creating it if needed.
+  DeathData* FindOrAddDeathData(const Births& birth);
+
   // Using our lock, make a copy of the specified maps.  This call may be made
   // on  non-local threads, which necessitate the use of the lock to prevent
   // the map(s) from being reallocaed while they are copied. If |reset_max| is
@@ -580,6 +633,10 @@ class BASE_EXPORT ThreadData {
   // We set status_ to SHUTDOWN when we shut down the tracking service.
   static Status status_;
 
+  // See SetSamplingInterval().  Read without a lock on every birth; a stale
+  // value only affects the weight of a few tallies.
+  static int sampling_interval_;
+
   // Link to next instance (null terminated list). Used to globally track all
   // registered instances (corresponds to all registered threads where we keep
   // data).
@@ -600,16 +657,25 @@ class BASE_EXPORT ThreadData {
   // corresponding to the created thread name if it is a worker thread.
   int worker_thread_number_;
 
-  // A map used on each thread to keep track of Births on this thread.
-  // This map should only be accessed on the thread it was constructed on.
-  // When a snapshot is needed, this structure can be locked in place for the
-  // duration of the snapshotting activity.
+  // Open-addressed table of the Births on this thread, hashed by Location.
+  // Slots hold Births pointers, are written only on this thread, and are never
+  // changed once set, so other threads may scan the table without a lock.
+  base::subtle::AtomicWord birth_table_[kTableSize];
+
+  // Open-addressed table recording deaths of tracked instances on this thread
+  // (i.e., when a tracked instance was destroyed on this thread), hashed by
+  // Births.  Like birth_table_, slots are claimed once and never moved.
+  DeathSlot death_table_[kTableSize];
+
+  // Overflow for Births that did not fit in birth_table_.  This map should
+  // only be accessed on the thread it was constructed on.  When a snapshot is
+  // needed, this structure can be locked in place for the duration of the
+  // snapshotting activity.
   BirthMap birth_map_;
 
-  // Similar to birth_map_, this records informations about death of tracked
-  // instances (i.e., when a tracked instance was destroyed on this thread).
-  // It is locked before changing, and hence other threads may access it by
-  // locking before reading it.
+  // Overflow for deaths that did not fit in death_table_.  It is locked
+  // before changing, and hence other threads may access it by locking before
+  // reading it.
   DeathMap death_map_;
 
   // A set of parents that created children tasks on this thread. Each pair
@@ -617,12 +683,12 @@ class BASE_EXPORT ThreadData {
   // local Births (that took place on this thread).
   ParentChildSet parent_child_set_;
 
-  // Lock to protect *some* access to BirthMap and DeathMap.  The maps are
-  // regularly read and written on this thread, but may only be read from other
-  // threads.  To support this, we acquire this lock if we are writing from this
-  // thread, or reading from another thread.  For reading from this thread we
-  // don't need a lock, as there is no potential for a conflict since the
-  // writing is only done from this thread.
+  // Lock to protect *some* access to the overflow BirthMap and DeathMap.  The
+  // maps are regularly read and written on this thread, but may only be read
+  // from other threads.  To support this, we acquire this lock if we are
+  // writing from this thread, or reading from another thread.  For reading
+  // from this thread we don't need a lock, as there is no potential for a
+  // conflict since the writing is only done from this thread.
   mutable base::Lock map_lock_;
 
   // The stack of parents that are currently being profiled. This includes only
@@ -641,6 +707,10 @@ class BASE_EXPORT ThreadData {
   // we stir in more and more as we go.
   int32 random_number_;
 
+  // Number of births left on this thread before the next one is tallied when
+  // sampling.
+  int births_until_sample_;
+
   // Record of what the incarnation_counter_ was when this instance was created.
   // If the incarnation_counter_ has changed, then we avoid pushing into the
   // pool (this is only critical in tests which go through multiple
@@ -0,0 +1,243 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Test of classes in the tracked_objects.h classes.
+
+#include "base/tracked_objects.h"
+
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tracked_objects {
+
+class TrackedObjectsTest : public testing::Test {
+ protected:
+  TrackedObjectsTest() {
+    // On entry, leak any database structures in case they are still in use by
+    // prior threads.
+    ThreadData::ShutdownSingleThreadedCleanup(true);
+  }
+
+  virtual ~TrackedObjectsTest() {
+    // We should not need to leak any structures we create, since we are
+    // single threaded, and carefully accounting for items.
+    ThreadData::ShutdownSingleThreadedCleanup(false);
+  }
+
+  // Copies the tables and overflow maps of the current thread.
+  void SnapshotCurrentThread(ThreadData::BirthMap* birth_map,
+                             ThreadData::DeathMap* death_map) {
+    ThreadData::ParentChildSet parent_child_set;
+    ThreadData::Get()->SnapshotMaps(false, birth_map, death_map,
+                                    &parent_child_set);
+  }
+
+  static int TableSize() { return ThreadData::kTableSize; }
+
+  size_t OverflowBirthCount() {
+    return ThreadData::Get()->birth_map_.size();
+  }
+
+  size_t OverflowDeathCount() {
+    return ThreadData::Get()->death_map_.size();
+  }
+
+  // Tallies the death of a task born as |birth| with |birth_weight|, which
+  // waited |queue_ms| and ran for |run_ms|.
+  void TallyDeath(const Births* birth, int birth_weight, int queue_ms,
+                  int run_ms) {
+    TrackedTime time_posted(base::TimeTicks::Now());
+    TrackedTime start_of_run =
+        time_posted + Duration::FromMilliseconds(queue_ms);
+    TrackedTime end_of_run = start_of_run + Duration::FromMilliseconds(run_ms);
+    ThreadData::TallyRunOnWorkerThreadIfTracking(birth, birth_weight,
+                                                 time_posted, start_of_run,
+                                                 end_of_run);
+  }
+};
+
+TEST_F(TrackedObjectsTest, BirthsAndDeathsAreTallied) {
+  if (!ThreadData::InitializeAndSetTrackingStatus(true))
+    return;  // Not compiled in.
+
+  ThreadData::InitializeThreadContext("SomeMainThreadName");
+  Location location("SomeFunction", "SomeFile", 123, NULL);
+
+  int weight = 0;
+  Births* birth = ThreadData::TallyABirthIfActive(location, &weight);
+  ASSERT_TRUE(birth);
+  EXPECT_EQ(1, weight);
+  EXPECT_EQ(birth, ThreadData::TallyABirthIfActive(location, &weight));
+  EXPECT_EQ(2, birth->birth_count());
+
+  TallyDeath(birth, weight, 3, 5);
+  ThreadData::BirthMap birth_map;
+  ThreadData::DeathMap death_map;
+  SnapshotCurrentThread(&birth_map, &death_map);
+  ASSERT_EQ(1u, birth_map.size());
+  EXPECT_EQ(birth, birth_map.begin()->second);
+  ASSERT_EQ(1u, death_map.size());
+  const DeathData& death_data = death_map[birth];
+  EXPECT_EQ(1, death_data.count());
+  EXPECT_EQ(3, death_data.queue_duration_sum());
+  EXPECT_EQ(5, death_data.run_duration_sum());
+  EXPECT_EQ(5, death_data.run_duration_max());
+}
+
+TEST_F(TrackedObjectsTest, SampledBirthsAndDeathsAreWeighted) {
+  if (!ThreadData::InitializeAndSetTrackingStatus(true))
+    return;  // Not compiled in.
+
+  const int kInterval = 4;
+  ThreadData::SetSamplingInterval(kInterval);
+  ThreadData::InitializeThreadContext("SomeMainThreadName");
+  Location location("SomeFunction", "SomeFile", 123, NULL);
+
+  // One birth in kInterval is tallied, and stands for kInterval births.
+  Births* birth = NULL;
+  int tallied = 0;
+  for (int i = 0; i < 2 * kInterval; ++i) {
+    int weight = 0;
+    Births* tally = ThreadData::TallyABirthIfActive(location, &weight);
+    if (!tally)
+      continue;
+    EXPECT_TRUE(!birth || birth == tally);
+    EXPECT_EQ(kInterval, weight);
+    birth = tally;
+    ++tallied;
+    TallyDeath(birth, weight, 1, 10);
+  }
+  EXPECT_EQ(2, tallied);
+  ASSERT_TRUE(birth);
+  EXPECT_EQ(2 * kInterval, birth->birth_count());
+
+  ThreadData::BirthMap birth_map;
+  ThreadData::DeathMap death_map;
+  SnapshotCurrentThread(&birth_map, &death_map);
+  const DeathData& death_data = death_map[birth];
+  EXPECT_EQ(2 * kInterval, death_data.count());
+  EXPECT_EQ(2 * kInterval * 1, death_data.queue_duration_sum());
+  EXPECT_EQ(2 * kInterval * 10, death_data.run_duration_sum());
+  EXPECT_EQ(10, death_data.run_duration_max());
+}
+
+// Tests that a task that is in flight when the sampling interval changes dies
+// with the weight it was born with.
+TEST_F(TrackedObjectsTest, DeathKeepsBirthWeightAcrossIntervalChange) {
+  if (!ThreadData::InitializeAndSetTrackingStatus(true))
+    return;  // Not compiled in.
+
+  const int kInterval = 4;
+  ThreadData::SetSamplingInterval(kInterval);
+  ThreadData::InitializeThreadContext("SomeMainThreadName");
+  Location location("SomeFunction", "SomeFile", 123, NULL);
+
+  int sampled_weight = 0;
+  Births* birth = ThreadData::TallyABirthIfActive(location, &sampled_weight);
+  ASSERT_TRUE(birth);
+  EXPECT_EQ(kInterval, sampled_weight);
+
+  ThreadData::SetSamplingInterval(1);
+  int weight = 0;
+  EXPECT_EQ(birth, ThreadData::TallyABirthIfActive(location, &weight));
+  EXPECT_EQ(1, weight);
+  EXPECT_EQ(kInterval + 1, birth->birth_count());
+
+  TallyDeath(birth, sampled_weight, 0, 0);
+  TallyDeath(birth, weight, 0, 0);
+  ThreadData::BirthMap birth_map;
+  ThreadData::DeathMap death_map;
+  SnapshotCurrentThread(&birth_map, &death_map);
+  EXPECT_EQ(birth->birth_count(), death_map[birth].count());
+}
+
+// Tests that births and deaths that don't fit in the per-thread tables go to
+// the overflow maps, and that snapshots include both.
+TEST_F(TrackedObjectsTest, TablesOverflowIntoMaps) {
+  if (!ThreadData::InitializeAndSetTrackingStatus(true))
+    return;  // Not compiled in.
+
+  ThreadData::InitializeThreadContext("SomeMainThreadName");
+  const int kLocations = 2 * TableSize();
+  std::vector<Births*> births;
+  for (int line = 0; line < kLocations; ++line) {
+    Location location("SomeFunction", "SomeFile", line, NULL);
+    int weight = 0;
+    Births* birth = ThreadData::TallyABirthIfActive(location, &weight);
+    ASSERT_TRUE(birth);
+    births.push_back(birth);
+    TallyDeath(birth, weight, 0, line);
+  }
+  EXPECT_GE(OverflowBirthCount(), static_cast<size_t>(TableSize()));
+  EXPECT_GE(OverflowDeathCount(), static_cast<size_t>(TableSize()));
+
+  ThreadData::BirthMap birth_map;
+  ThreadData::DeathMap death_map;
+  SnapshotCurrentThread(&birth_map, &death_map);
+  EXPECT_EQ(static_cast<size_t>(kLocations), birth_map.size());
+  ASSERT_EQ(static_cast<size_t>(kLocations), death_map.size());
+  for (int line = 0; line < kLocations; ++line) {
+    EXPECT_EQ(1, births[line]->birth_count());
+    EXPECT_EQ(1, death_map[births[line]].count());
+    EXPECT_EQ(line, death_map[births[line]].run_duration_sum());
+  }
+}
+
+// Tests that the process-wide snapshot reports weighted deaths, and weighted
+// births that have not died yet.
+TEST_F(TrackedObjectsTest, SnapshotReportsWeightedCounts) {
+  if (!ThreadData::InitializeAndSetTrackingStatus(true))
+    return;  // Not compiled in.
+
+  const int kInterval = 3;
+  ThreadData::SetSamplingInterval(kInterval);
+  ThreadData::InitializeThreadContext("SomeMainThreadName");
+  Location dead_location("DeadFunction", "SomeFile", 1, NULL);
+  Location alive_location("AliveFunction", "SomeFile", 2, NULL);
+
+  int weight = 0;
+  Births* dead = ThreadData::TallyABirthIfActive(dead_location, &weight);
+  ASSERT_TRUE(dead);
+  TallyDeath(dead, weight, 0, 0);
+  // Skip to the next sampled birth.
+  for (int i = 1; i < kInterval; ++i)
+    EXPECT_FALSE(ThreadData::TallyABirthIfActive(alive_location, &weight));
+  ASSERT_TRUE(ThreadData::TallyABirthIfActive(alive_location, &weight));
+
+  scoped_ptr<base::DictionaryValue> value(ThreadData::ToValue(false));
+  base::ListValue* list = NULL;
+  ASSERT_TRUE(value->GetList("list", &list));
+  ASSERT_EQ(2u, list->GetSize());
+  bool saw_dead = false;
+  bool saw_alive = false;
+  for (size_t i = 0; i < list->GetSize(); ++i) {
+    base::DictionaryValue* snapshot = NULL;
+    ASSERT_TRUE(list->GetDictionary(i, &snapshot));
+    std::string function_name;
+    std::string death_thread;
+    int count = 0;
+    EXPECT_TRUE(snapshot->GetString("location.function_name",
+                                    &function_name));
+    EXPECT_TRUE(snapshot->GetString("death_thread", &death_thread));
+    EXPECT_TRUE(snapshot->GetInteger("death_data.count", &count));
+    EXPECT_EQ(kInterval, count);
+    if (function_name == "DeadFunction") {
+      EXPECT_EQ("SomeMainThreadName", death_thread);
+      saw_dead = true;
+    } else {
+      EXPECT_EQ("AliveFunction", function_name);
+      EXPECT_EQ("Still_Alive", death_thread);
+      saw_alive = true;
+    }
+  }
+  EXPECT_TRUE(saw_dead);
+  EXPECT_TRUE(saw_alive);
+}
+
+}  // namespace tracked_objects
@@ -11,10 +11,11 @@ namespace base {
 TrackingInfo::TrackingInfo(
     const tracked_objects::Location& posted_from,
     base::TimeTicks delayed_run_time)
-    : birth_tally(
-          tracked_objects::ThreadData::TallyABirthIfActive(posted_from)),
+    : birth_weight(1),
       time_posted(TimeTicks::Now()),
       delayed_run_time(delayed_run_time) {
+  birth_tally = tracked_objects::ThreadData::TallyABirthIfActive(posted_from,
+                                                                 &birth_weight);
 }
 
 TrackingInfo::~TrackingInfo() {}
@@ -29,6 +29,10 @@ struct BASE_EXPORT TrackingInfo {
   // Record of location and thread that the task came from.
   tracked_objects::Births* birth_tally;
 
+  // The number of births |birth_tally| was incremented by, when sampling.
+  // The task's death is weighted the same.
+  int birth_weight;
+
   // Time when the related task was posted.
   base::TimeTicks time_posted;
 
@@ -1160,6 +1160,15 @@ int ChromeBrowserMainParts::PreCreateThreadsImpl() {
     tracked_objects::ThreadData::InitializeAndSetTrackingStatus(enabled);
   }
 
+  if (parsed_command_line().HasSwitch(switches::kProfilerSamplingInterval)) {
+    int interval = 0;
+    if (base::StringToInt(parsed_command_line().GetSwitchValueASCII(
+            switches::kProfilerSamplingInterval), &interval) &&
+        interval > 0) {
+      tracked_objects::ThreadData::SetSamplingInterval(interval);
+    }
+  }
+
   // This forces the TabCloseableStateWatcher to be created and, on chromeos,
   // register for the notifications it needs to track the closeable state of
   // tabs.
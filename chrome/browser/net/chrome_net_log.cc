@@ -10,11 +10,21 @@
 #include "base/logging.h"
 #include "base/string_number_conversions.h"
 #include "base/string_util.h"
+#include "base/threading/thread_restrictions.h"
 #include "base/values.h"
 #include "chrome/browser/net/load_timing_observer.h"
 #include "chrome/browser/net/net_log_logger.h"
 #include "chrome/browser/net/passive_log_collector.h"
 #include "chrome/common/chrome_switches.h"
+#include "net/base/net_log_binary_capture.h"
+
+namespace {
+
+// Events kept per thread by --log-net-log-binary, unless
+// --log-net-log-binary-events says otherwise.
+const size_t kDefaultBinaryCaptureEventsPerThread = 10000;
+
+}  // namespace
 
 ChromeNetLog::ThreadSafeObserverImpl::ThreadSafeObserverImpl(LogLevel log_level)
     : net_log_(NULL),
@@ -127,6 +137,24 @@ ChromeNetLog::ChromeNetLog()
         command_line->GetSwitchValuePath(switches::kLogNetLog)));
     net_log_logger_->AddAsObserver(this);
   }
+
+  if (command_line->HasSwitch(switches::kLogNetLogBinary)) {
+    binary_capture_path_ =
+        command_line->GetSwitchValuePath(switches::kLogNetLogBinary);
+    size_t events_per_thread = kDefaultBinaryCaptureEventsPerThread;
+    if (command_line->HasSwitch(switches::kLogNetLogBinaryEvents)) {
+      std::string events_string =
+          command_line->GetSwitchValueASCII(switches::kLogNetLogBinaryEvents);
+      int command_line_events;
+      if (base::StringToInt(events_string, &command_line_events) &&
+          command_line_events > 0) {
+        events_per_thread = static_cast<size_t>(command_line_events);
+      }
+    }
+    binary_capture_.reset(new net::NetLogBinaryCapture(
+        LOG_ALL, events_per_thread));
+    AddThreadSafeObserver(binary_capture_.get());
+  }
 }
 
 ChromeNetLog::~ChromeNetLog() {
@@ -135,6 +163,12 @@ ChromeNetLog::~ChromeNetLog() {
   if (net_log_logger_.get()) {
     net_log_logger_->RemoveAsObserver();
   }
+  if (binary_capture_.get()) {
+    RemoveThreadSafeObserver(binary_capture_.get());
+    base::ThreadRestrictions::ScopedAllowIO allow_io;
+    if (!binary_capture_->WriteToFile(binary_capture_path_))
+      LOG(ERROR) << "Failed to write " << binary_capture_path_.value();
+  }
 }
 
 void ChromeNetLog::AddEntry(EventType type,
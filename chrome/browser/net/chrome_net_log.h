@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "base/atomicops.h"
+#include "base/file_path.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/observer_list.h"
 #include "base/synchronization/lock.h"
@@ -19,6 +20,10 @@ class LoadTimingObserver;
 class NetLogLogger;
 class PassiveLogCollector;
 
+namespace net {
+class NetLogBinaryCapture;
+}
+
 // ChromeNetLog is an implementation of NetLog that dispatches network log
 // messages to a list of observers.
 //
@@ -182,6 +187,11 @@ class ChromeNetLog : public net::NetLog {
   scoped_ptr<LoadTimingObserver> load_timing_observer_;
   scoped_ptr<NetLogLogger> net_log_logger_;
 
+  // Set when --log-net-log-binary is given; written to |binary_capture_path_|
+  // on destruction.
+  scoped_ptr<net::NetLogBinaryCapture> binary_capture_;
+  FilePath binary_capture_path_;
+
   // |lock_| must be acquired whenever reading or writing to this.
   ObserverList<ThreadSafeObserver, true> observers_;
 
@@ -798,6 +798,14 @@ const char kLoadOpencryptoki[]              = "load-opencryptoki";
 // to a separate file if a file name is given.
 const char kLogNetLog[]                     = "log-net-log";
 
+// Keeps the most recent net log events of each thread, at full detail, in
+// memory and writes them to the given file in a compact binary format on
+// shutdown.  net_log_binary_to_json converts the file for net-internals.
+const char kLogNetLogBinary[]               = "log-net-log-binary";
+
+// Sets how many events of each thread --log-net-log-binary keeps.
+const char kLogNetLogBinaryEvents[]         = "log-net-log-binary-events";
+
 // Uninstalls an extension with the specified extension id.
 const char kUninstallExtension[]            = "uninstall-extension";
 
@@ -972,6 +980,11 @@ const char kProductVersion[]                = "product-version";
 // Selects directory of profile to associate with the first browser launched.
 const char kProfileDirectory[]              = "profile-directory";
 
+// Makes the task profiler (about:profiler) tally only one in N tasks on each
+// thread, scaling up the recorded counts and durations by N, so that profiling
+// can stay enabled at a lower cost. The default of 1 tallies every task.
+const char kProfilerSamplingInterval[]      = "profiler-sampling-interval";
+
 // Starts the sampling based profiler for the browser process at startup. This
 // will only work if chrome has been built with the gyp variable profiling=1.
 // The output will go to the value of kProfilingFile.
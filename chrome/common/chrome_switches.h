@@ -219,6 +219,8 @@ extern const char kLoadExtension[];
 extern const char kLoadOpencryptoki[];
 extern const char kUninstallExtension[];
 extern const char kLogNetLog[];
+extern const char kLogNetLogBinary[];
+extern const char kLogNetLogBinaryEvents[];
 extern const char kMakeDefaultBrowser[];
 extern const char kMediaCacheSize[];
 extern const char kMemoryProfiling[];
@@ -267,6 +269,7 @@ extern const char kPrerenderModeSwitchValuePrefetchOnly[];
 extern const char kPrint[];
 extern const char kProductVersion[];
 extern const char kProfileDirectory[];
+extern const char kProfilerSamplingInterval[];
 extern const char kProfilingAtStart[];
 extern const char kProfilingFile[];
 extern const char kProfilingFlush[];
@@ -488,7 +488,10 @@ void DevToolsHttpHandlerImpl::OnResponseStarted(net::URLRequest* request) {
                                      "\r\n",
                                      content_type.c_str()));
   } else {
+    // Send404() ends the response, so there is no body to terminate.
     server_->Send404(connection_id);
+    RequestCompleted(request);
+    return;
   }
 
   int bytes_read = 0;
@@ -524,6 +527,7 @@ void DevToolsHttpHandlerImpl::OnReadCompleted(net::URLRequest* request,
   // See comments re: HEAD requests in OnResponseStarted().
   if (!request->status().is_io_pending()) {
     server_->Send(connection_id, "0\r\n\r\n");
+    server_->FinishResponse(connection_id);
     RequestCompleted(request);
   }
 }
@@ -12,6 +12,7 @@
 #include "content/browser/renderer_host/media/media_observer.h"
 #include "content/browser/resource_context.h"
 #include "content/common/media/audio_messages.h"
+#include "media/audio/audio_packet_ring.h"
 #include "media/audio/audio_util.h"
 #include "ipc/ipc_logging.h"
 
@@ -147,7 +148,7 @@ void AudioRendererHost::DoCompleteCreation(
         entry->stream_id,
         foreign_memory_handle,
         foreign_socket_handle,
-        media::PacketSizeSizeInBytes(entry->shared_memory.created_size())));
+        reader->packet_size()));
     return;
   }
 
@@ -230,10 +231,18 @@ bool AudioRendererHost::OnMessageReceived(const IPC::Message& message,
 }
 
 void AudioRendererHost::OnCreateStream(
-    int stream_id, const AudioParameters& params, bool low_latency) {
+    int stream_id, const AudioParameters& params, bool low_latency,
+    int ring_packets) {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   DCHECK(LookupById(stream_id) == NULL);
 
+  if (ring_packets < 0 ||
+      ring_packets > media::AudioPacketRing::kMaxPackets ||
+      (ring_packets && !low_latency)) {
+    SendErrorMessage(stream_id);
+    return;
+  }
+
   AudioParameters audio_params(params);
 
   // Select the hardware packet size if not specified.
@@ -246,7 +255,10 @@ void AudioRendererHost::OnCreateStream(
   scoped_ptr<AudioEntry> entry(new AudioEntry());
   // Create the shared memory and share with the renderer process.
   uint32 shared_memory_size = packet_size;
-  if (low_latency) {
+  if (ring_packets) {
+    shared_memory_size =
+        media::AudioPacketRing::RequiredMemorySize(packet_size, ring_packets);
+  } else if (low_latency) {
     shared_memory_size =
         media::TotalSharedMemorySizeInBytes(shared_memory_size);
   }
@@ -258,7 +270,9 @@ void AudioRendererHost::OnCreateStream(
 
   if (low_latency) {
     // If this is the low latency mode, we need to construct a SyncReader first.
-    scoped_ptr<AudioSyncReader> reader(
+    scoped_ptr<AudioSyncReader> reader(ring_packets ?
+        new AudioSyncReader(&entry->shared_memory, packet_size,
+                            ring_packets) :
         new AudioSyncReader(&entry->shared_memory));
 
     // Then try to initialize the sync reader.
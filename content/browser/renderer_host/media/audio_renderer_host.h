@@ -138,10 +138,12 @@ class CONTENT_EXPORT AudioRendererHost
   // Audio related IPC message handlers.
   // Creates an audio output stream with the specified format. If this call is
   // successful this object would keep an internal entry of the stream for the
-  // required properties.
+  // required properties. A low latency stream shares a ring of
+  // |ring_packets| packets with the renderer, or a single packet if it is 0.
   void OnCreateStream(int stream_id,
                       const AudioParameters& params,
-                      bool low_latency);
+                      bool low_latency,
+                      int ring_packets);
 
   // Play the audio stream referenced by |stream_id|.
   void OnPlayStream(int stream_id);
@@ -6,22 +6,43 @@
 
 #include <algorithm>
 
+#include "base/logging.h"
 #include "base/process_util.h"
 #include "base/shared_memory.h"
 #include "base/threading/platform_thread.h"
 #include "media/audio/audio_buffers_state.h"
+#include "media/audio/audio_packet_ring.h"
 #include "media/audio/audio_util.h"
 
 const int kMinIntervalBetweenReadCallsInMs = 10;
 
 AudioSyncReader::AudioSyncReader(base::SharedMemory* shared_memory)
-    : shared_memory_(shared_memory) {
+    : shared_memory_(shared_memory),
+      packet_size_(media::PacketSizeSizeInBytes(
+          shared_memory->created_size())),
+      paused_(false) {
+}
+
+AudioSyncReader::AudioSyncReader(base::SharedMemory* shared_memory,
+                                 uint32 packet_size, int ring_packets)
+    : shared_memory_(shared_memory),
+      ring_(new media::AudioPacketRing(shared_memory->memory(), packet_size,
+                                       ring_packets)),
+      packet_size_(packet_size),
+      paused_(false) {
+  DCHECK_GE(shared_memory->created_size(),
+            media::AudioPacketRing::RequiredMemorySize(packet_size,
+                                                       ring_packets));
+  ring_->Initialize();
 }
 
 AudioSyncReader::~AudioSyncReader() {
 }
 
 bool AudioSyncReader::DataReady() {
+  if (ring_.get())
+    return ring_->GetReadablePackets() > 0;
+
   return !media::IsUnknownDataSize(
       shared_memory_,
       media::PacketSizeSizeInBytes(shared_memory_->created_size()));
@@ -29,6 +50,34 @@ bool AudioSyncReader::DataReady() {
 
 // media::AudioOutputController::SyncReader implementations.
 void AudioSyncReader::UpdatePendingBytes(uint32 bytes) {
+  if (ring_.get()) {
+    // AudioOutputController stops the stream before pausing and starts it
+    // only after asking for the first packet, so nothing reads the ring
+    // concurrently here. The flush that follows a pause for a seek does not
+    // reach us, so stale packets are dropped both when pausing and when
+    // resuming, in case the renderer was filling the ring in between. The
+    // renderer is then woken below to render fresh audio.
+    if (bytes ==
+        static_cast<uint32>(media::AudioOutputController::kPauseMark)) {
+      ring_->DropUnreadPackets();
+      paused_ = true;
+      return;
+    }
+    if (paused_) {
+      ring_->DropUnreadPackets();
+      paused_ = false;
+    }
+
+    ring_->SetPendingBytes(bytes);
+    if (!ring_->ShouldWakeProducer())
+      return;
+
+    base::AutoLock auto_lock(lock_);
+    if (socket_.get())
+      socket_->Send(&bytes, sizeof(bytes));
+    return;
+  }
+
   if (bytes != static_cast<uint32>(media::AudioOutputController::kPauseMark)) {
     // Store unknown length of data into buffer, so we later
     // can find out if data became available.
@@ -43,6 +92,9 @@ void AudioSyncReader::UpdatePendingBytes(uint32 bytes) {
 }
 
 uint32 AudioSyncReader::Read(void* data, uint32 size) {
+  if (ring_.get())
+    return ring_->Read(data, size);
+
   uint32 max_size = media::PacketSizeSizeInBytes(
       shared_memory_->created_size());
 
@@ -84,6 +136,9 @@ uint32 AudioSyncReader::Read(void* data, uint32 size) {
 }
 
 void AudioSyncReader::Close() {
+  if (ring_.get())
+    DVLOG(1) << "Audio ring underruns: " << ring_->underruns();
+
   base::AutoLock auto_lock(lock_);
   if (socket_.get()) {
     socket_->Close();
@@ -91,6 +146,10 @@ void AudioSyncReader::Close() {
   }
 }
 
+uint32 AudioSyncReader::packet_size() const {
+  return packet_size_;
+}
+
 bool AudioSyncReader::Init() {
   socket_.reset(new base::CancelableSyncSocket());
   foreign_socket_.reset(new base::CancelableSyncSocket());
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "base/file_descriptor_posix.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/process.h"
 #include "base/sync_socket.h"
 #include "base/synchronization/lock.h"
@@ -17,13 +18,23 @@ namespace base {
 class SharedMemory;
 }
 
+namespace media {
+class AudioPacketRing;
+}
+
 // A AudioOutputController::SyncReader implementation using SyncSocket. This
 // is used by AudioOutputController to provide a low latency data source for
 // transmitting audio packets between the browser process and the renderer
 // process.
+//
+// The renderer either fills a single packet each time it is asked to, or
+// keeps a media::AudioPacketRing of |ring_packets| packets filled, in which
+// case it is only woken when the ring has drained to half its size.
 class AudioSyncReader : public media::AudioOutputController::SyncReader {
  public:
   explicit AudioSyncReader(base::SharedMemory* shared_memory);
+  AudioSyncReader(base::SharedMemory* shared_memory, uint32 packet_size,
+                  int ring_packets);
 
   virtual ~AudioSyncReader();
 
@@ -34,6 +45,10 @@ class AudioSyncReader : public media::AudioOutputController::SyncReader {
   virtual bool DataReady() OVERRIDE;
 
   bool Init();
+
+  // Size of the packets the renderer writes.
+  uint32 packet_size() const;
+
   bool PrepareForeignSocketHandle(base::ProcessHandle process_handle,
 #if defined(OS_WIN)
                                   base::SyncSocket::Handle* foreign_handle);
@@ -45,6 +60,14 @@ class AudioSyncReader : public media::AudioOutputController::SyncReader {
   base::SharedMemory* shared_memory_;
   base::Time previous_call_time_;
 
+  // The ring in |shared_memory_|, if the renderer uses one.
+  scoped_ptr<media::AudioPacketRing> ring_;
+  uint32 packet_size_;
+
+  // True from the pause mark until playback is resumed. The packets in the
+  // ring are dropped at both ends, since they may be from before a seek.
+  bool paused_;
+
   // Socket for transmitting audio data.
   scoped_ptr<base::CancelableSyncSocket> socket_;
 
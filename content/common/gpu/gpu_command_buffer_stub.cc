@@ -155,6 +155,8 @@ void GpuCommandBufferStub::Destroy() {
   scheduler_.reset();
 
   if (decoder_.get()) {
+    if (decoder_->collect_command_stats())
+      decoder_->LogCommandStats();
     decoder_->Destroy();
     decoder_.reset();
   }
@@ -252,6 +254,11 @@ void GpuCommandBufferStub::OnInitialize(
     decoder_->set_log_commands(true);
   }
 
+  if (CommandLine::ForCurrentProcess()->HasSwitch(
+      switches::kEnableGPUCommandStats)) {
+    decoder_->set_collect_command_stats(true);
+  }
+
   decoder_->SetMsgCallback(
       base::Bind(&GpuCommandBufferStub::SendConsoleMessage,
                  base::Unretained(this)));
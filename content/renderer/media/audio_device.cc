@@ -13,9 +13,14 @@
 #include "content/common/media/audio_messages.h"
 #include "content/common/view_messages.h"
 #include "content/renderer/render_thread_impl.h"
-#include "media/audio/audio_output_controller.h"
+#include "media/audio/audio_packet_ring.h"
 #include "media/audio/audio_util.h"
 
+// GCC requires these declarations, but MSVC requires they not be present
+#ifndef _MSC_VER
+const int AudioDevice::kRingPackets;
+#endif
+
 AudioDevice::AudioDevice()
     : buffer_size_(0),
       channels_(0),
@@ -174,7 +179,7 @@ void AudioDevice::InitializeOnIOThread(const AudioParameters& params) {
     return;
 
   stream_id_ = filter_->AddDelegate(this);
-  Send(new AudioHostMsg_CreateStream(stream_id_, params, true));
+  Send(new AudioHostMsg_CreateStream(stream_id_, params, true, kRingPackets));
 }
 
 void AudioDevice::PlayOnIOThread() {
@@ -287,12 +292,16 @@ void AudioDevice::Run() {
   audio_thread_->SetThreadPriority(base::kThreadPriority_RealtimeAudio);
 
   base::SharedMemory shared_memory(shared_memory_handle_, false);
-  shared_memory.Map(media::TotalSharedMemorySizeInBytes(memory_length_));
+  shared_memory.Map(media::AudioPacketRing::RequiredMemorySize(memory_length_,
+                                                               kRingPackets));
+  media::AudioPacketRing ring(shared_memory.memory(), memory_length_,
+                              kRingPackets);
   base::CancelableSyncSocket* audio_socket = audio_socket_.get();
 
   const int samples_per_ms = static_cast<int>(sample_rate_) / 1000;
   const int bytes_per_ms = channels_ * (bits_per_sample_ / 8) * samples_per_ms;
 
+  // Wait for the browser to ask for audio, then fill the ring.
   while (true) {
     int pending_data = 0;
     size_t bytes_read = audio_socket->Receive(&pending_data,
@@ -302,22 +311,16 @@ void AudioDevice::Run() {
       break;
     }
 
-    if (pending_data == media::AudioOutputController::kPauseMark) {
-      memset(shared_memory.memory(), 0, memory_length_);
-      media::SetActualDataSizeInBytes(&shared_memory, memory_length_, 0);
-      continue;
-    }
-
-    // Convert the number of pending bytes in the render buffer
-    // into milliseconds.
-    audio_delay_milliseconds_ = pending_data / bytes_per_ms;
-    size_t num_frames = FireRenderCallback(
-        reinterpret_cast<int16*>(shared_memory.memory()));
-
-    // Let the host know we are done.
-    media::SetActualDataSizeInBytes(&shared_memory,
-                                    memory_length_,
-                                    num_frames * channels_ * sizeof(int16));
+    do {
+      while (uint8* packet = ring.GetWriteBuffer()) {
+        // Convert the number of bytes queued in the ring and the browser
+        // into milliseconds.
+        audio_delay_milliseconds_ = ring.GetDelayBytes() / bytes_per_ms;
+        size_t num_frames = FireRenderCallback(
+            reinterpret_cast<int16*>(packet));
+        ring.CommitWrite(num_frames * channels_ * sizeof(int16));
+      }
+    } while (!ring.PrepareToWait());
   }
 }
 
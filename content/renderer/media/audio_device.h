@@ -18,6 +18,9 @@
 // to generate a low latency transport. The AudioDevice user registers an
 // AudioDevice::RenderCallback at construction and will be polled by the
 // AudioDevice for audio to be played out by the underlying audio layers.
+// The shared memory holds a media::AudioPacketRing, which the audio thread
+// keeps filled ahead of the browser. The browser only wakes it through the
+// socket when the ring has drained to half its size.
 //
 // State sequences.
 //
@@ -162,11 +165,14 @@ class CONTENT_EXPORT AudioDevice
   // Method called on the audio thread ----------------------------------------
   // Calls the client's callback for rendering audio.
   // Returns actual number of filled frames that callback returned. This length
-  // is passed to host at the end of the shared memory (i.e. buffer). In case of
-  // continuous stream host just ignores it and assumes buffer is always filled
-  // to its capacity.
+  // is passed to host along with the packet in the shared memory ring.
   size_t FireRenderCallback(int16* data);
 
+  // Number of packets in the ring shared with the browser. Each packet adds
+  // to the output latency, but lets the audio thread run late by as much
+  // without a glitch.
+  static const int kRingPackets = 3;
+
   // DelegateSimpleThread::Delegate implementation.
   virtual void Run() OVERRIDE;
 
@@ -286,7 +286,8 @@ void PlatformAudioImpl::ShutDown() {
 
 void PlatformAudioImpl::InitializeOnIOThread(const AudioParameters& params) {
   stream_id_ = filter_->AddDelegate(this);
-  filter_->Send(new AudioHostMsg_CreateStream(stream_id_, params, true));
+  // Plugins write to the shared memory themselves, one packet at a time.
+  filter_->Send(new AudioHostMsg_CreateStream(stream_id_, params, true, 0));
 }
 
 void PlatformAudioImpl::StartPlaybackOnIOThread() {
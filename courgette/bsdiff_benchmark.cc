@@ -0,0 +1,168 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Times bsdiff patch generation on large synthetic inputs and reports the
+// process's peak memory.  Peak memory is a high-water mark for the whole
+// process, so each run uses a single suffix sort and sizes are processed in
+// increasing order; run once with and once without -qsufsort to compare.
+//
+//   courgette_bsdiff_benchmark [-qsufsort] [-sizes=50,100,200]
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/basictypes.h"
+#include "base/command_line.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/process_util.h"
+#include "base/string_number_conversions.h"
+#include "base/string_split.h"
+#include "base/time.h"
+#include "courgette/streams.h"
+#include "courgette/third_party/bsdiff.h"
+
+namespace {
+
+const size_t kMegabyte = 1024 * 1024;
+
+// Deterministic generator so that runs are comparable.
+class Random {
+ public:
+  explicit Random(uint32 seed) : state_(seed) {}
+  uint32 Next() {
+    state_ = state_ * 1103515245 + 12345;
+    return state_ >> 8;
+  }
+ private:
+  uint32 state_;
+};
+
+// Builds an 'old' file that looks roughly like an executable: runs of random
+// bytes over a small alphabet, interleaved with copies of earlier regions so
+// that there are many long repeats for the suffix sort to work through.
+std::string MakeOldFile(size_t size, Random* random) {
+  std::string old_file;
+  old_file.reserve(size);
+  while (old_file.size() < size) {
+    size_t run = 64 + random->Next() % 4096;
+    if (old_file.size() > kMegabyte && random->Next() % 3 == 0) {
+      size_t from = random->Next() % (old_file.size() - run);
+      for (size_t i = 0; i < run; ++i)
+        old_file.push_back(old_file[from + i]);
+    } else {
+      for (size_t i = 0; i < run; ++i)
+        old_file.push_back(static_cast<char>(random->Next() % 48));
+    }
+  }
+  old_file.resize(size);
+  return old_file;
+}
+
+// Derives a 'new' file by applying scattered small edits, as a recompile
+// would.
+std::string MakeNewFile(const std::string& old_file, Random* random) {
+  std::string new_file;
+  new_file.reserve(old_file.size() + old_file.size() / 64);
+  size_t pos = 0;
+  while (pos < old_file.size()) {
+    size_t keep = std::min(old_file.size() - pos,
+                           static_cast<size_t>(1024 + random->Next() % 8192));
+    new_file.append(old_file, pos, keep);
+    pos += keep;
+    switch (random->Next() % 3) {
+      case 0:  // Insert.
+        for (size_t i = random->Next() % 32; i > 0; --i)
+          new_file.push_back(static_cast<char>(random->Next()));
+        break;
+      case 1:  // Delete.
+        pos += random->Next() % 32;
+        break;
+      case 2:  // Overwrite.
+        for (size_t i = random->Next() % 8; i > 0 && pos < old_file.size();
+             --i, ++pos) {
+          new_file.push_back(static_cast<char>(random->Next()));
+        }
+        break;
+    }
+  }
+  return new_file;
+}
+
+size_t PeakMemory() {
+#if defined(OS_MACOSX)
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle(), NULL));
+#else
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle()));
+#endif
+  return metrics->GetPeakWorkingSetSize();
+}
+
+bool RunBenchmark(size_t megabytes, courgette::SuffixSortAlgorithm algorithm) {
+  Random random(static_cast<uint32>(megabytes));
+  std::string old_file = MakeOldFile(megabytes * kMegabyte, &random);
+  std::string new_file = MakeNewFile(old_file, &random);
+
+  courgette::SourceStream old_stream;
+  courgette::SourceStream new_stream;
+  old_stream.Init(old_file);
+  new_stream.Init(new_file);
+  courgette::SinkStream patch_stream;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  courgette::BSDiffStatus status =
+      courgette::CreateBinaryPatch(&old_stream, &new_stream, &patch_stream,
+                                   algorithm);
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  if (status != courgette::OK) {
+    fprintf(stderr, "%uMB: bsdiff failed with status %d\n",
+            static_cast<unsigned>(megabytes), status);
+    return false;
+  }
+
+  // The inputs account for roughly twice |megabytes| of the peak.
+  printf("%s %4uMB: %8.2fs  patch %9u bytes  peak memory %6uMB\n",
+         algorithm == courgette::SUFFIX_SORT_SAIS ? "sais    " : "qsufsort",
+         static_cast<unsigned>(megabytes), elapsed.InSecondsF(),
+         static_cast<unsigned>(patch_stream.Length()),
+         static_cast<unsigned>(PeakMemory() / kMegabyte));
+  fflush(stdout);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  base::AtExitManager at_exit_manager;
+  CommandLine::Init(argc, argv);
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+
+  courgette::SuffixSortAlgorithm algorithm =
+      command_line.HasSwitch("qsufsort") ? courgette::SUFFIX_SORT_QSUFSORT
+                                         : courgette::SUFFIX_SORT_SAIS;
+
+  std::string sizes_switch = command_line.GetSwitchValueASCII("sizes");
+  if (sizes_switch.empty())
+    sizes_switch = "50,100,200";
+  std::vector<std::string> size_strings;
+  base::SplitString(sizes_switch, ',', &size_strings);
+
+  for (size_t i = 0; i < size_strings.size(); ++i) {
+    int megabytes = 0;
+    if (!base::StringToInt(size_strings[i], &megabytes) || megabytes <= 0) {
+      fprintf(stderr, "Bad -sizes value: %s\n", size_strings[i].c_str());
+      return 1;
+    }
+    if (!RunBenchmark(megabytes, algorithm))
+      return 1;
+  }
+  return 0;
+}
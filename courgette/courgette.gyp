@@ -39,6 +39,8 @@
       'simple_delta.h',
       'streams.cc',
       'streams.h',
+      'suffix_array.cc',
+      'suffix_array.h',
       'types_elf.h',
       'types_win_pe.h',
       'patch_generator_x86_32.h',
@@ -73,6 +75,38 @@
         },
       },
     },
+    {
+      'target_name': 'courgette_bsdiff_benchmark',
+      'type': 'executable',
+      'sources': [
+        'bsdiff_benchmark.cc',
+      ],
+      'dependencies': [
+        'courgette_lib',
+        '../base/base.gyp:base',
+      ],
+      'msvs_settings': {
+        'VCLinkerTool': {
+          'LargeAddressAware': 2,
+        },
+      },
+    },
+    {
+      'target_name': 'courgette_ensemble_benchmark',
+      'type': 'executable',
+      'sources': [
+        'ensemble_benchmark.cc',
+      ],
+      'dependencies': [
+        'courgette_lib',
+        '../base/base.gyp:base',
+      ],
+      'msvs_settings': {
+        'VCLinkerTool': {
+          'LargeAddressAware': 2,
+        },
+      },
+    },
     {
       'target_name': 'courgette_minimal_tool',
       'type': 'executable',
@@ -97,6 +131,7 @@
         'disassembler_win32_x86_unittest.cc',
         'encoded_program_unittest.cc',
         'encode_decode_unittest.cc',
+        'ensemble_create_unittest.cc',
         'ensemble_unittest.cc',
         'run_all_unittests.cc',
         'streams_unittest.cc',
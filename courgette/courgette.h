@@ -87,6 +87,12 @@ Status ApplyEnsemblePatch(const FilePath::CharType* old_file_name,
 Status GenerateEnsemblePatch(SourceStream* old, SourceStream* target,
                              SinkStream* patch);
 
+// As above, but transforms up to |thread_count| matched elements concurrently.
+// The patch is byte-identical to the one produced with a single thread; peak
+// memory grows with the number of elements being transformed at once.
+Status GenerateEnsemblePatch(SourceStream* old, SourceStream* target,
+                             SinkStream* patch, int thread_count);
+
 // Detects the type of an executable file, and it's length. The length
 // may be slightly smaller than some executables (like ELF), but will include
 // all bytes the courgette algorithm has special benefit for.
@@ -26,7 +26,7 @@ void PrintHelp() {
     "  courgette -dis <executable_file> <binary_assembly_file>\n"
     "  courgette -asm <binary_assembly_file> <executable_file>\n"
     "  courgette -disadj <executable_file> <reference> <binary_assembly_file>\n"
-    "  courgette -gen <v1> <v2> <patch>\n"
+    "  courgette -gen [-threads=N] <v1> <v2> <patch>\n"
     "  courgette -apply <v1> <patch> <v2>\n"
     "\n");
 }
@@ -299,7 +299,8 @@ void Assemble(const FilePath& input_file,
 
 void GenerateEnsemblePatch(const FilePath& old_file,
                            const FilePath& new_file,
-                           const FilePath& patch_file) {
+                           const FilePath& patch_file,
+                           int thread_count) {
   std::string old_buffer = ReadOrFail(old_file, "'old' input");
   std::string new_buffer = ReadOrFail(new_file, "'new' input");
 
@@ -310,7 +311,8 @@ void GenerateEnsemblePatch(const FilePath& old_file,
 
   courgette::SinkStream patch_stream;
   courgette::Status status =
-      courgette::GenerateEnsemblePatch(&old_stream, &new_stream, &patch_stream);
+      courgette::GenerateEnsemblePatch(&old_stream, &new_stream, &patch_stream,
+                                       thread_count);
 
   if (status != courgette::C_OK) Problem("-gen failed.");
 
@@ -376,7 +378,8 @@ void ApplyEnsemblePatch(const FilePath& old_file,
 
 void GenerateBSDiffPatch(const FilePath& old_file,
                          const FilePath& new_file,
-                         const FilePath& patch_file) {
+                         const FilePath& patch_file,
+                         courgette::SuffixSortAlgorithm algorithm) {
   std::string old_buffer = ReadOrFail(old_file, "'old' input");
   std::string new_buffer = ReadOrFail(new_file, "'new' input");
 
@@ -387,7 +390,8 @@ void GenerateBSDiffPatch(const FilePath& old_file,
 
   courgette::SinkStream patch_stream;
   courgette::BSDiffStatus status =
-      courgette::CreateBinaryPatch(&old_stream, &new_stream, &patch_stream);
+      courgette::CreateBinaryPatch(&old_stream, &new_stream, &patch_stream,
+                                   algorithm);
 
   if (status != courgette::OK) Problem("-genbsdiff failed.");
 
@@ -452,6 +456,18 @@ int main(int argc, const char* argv[]) {
     if (!base::StringToInt(repeat_switch, &repeat_count))
       repeat_count = 1;
 
+  // '-threads=N' lets -gen transform up to N elements at once.
+  int thread_count = 1;
+  std::string threads_switch = command_line.GetSwitchValueASCII("threads");
+  if (!threads_switch.empty())
+    if (!base::StringToInt(threads_switch, &thread_count) || thread_count < 1)
+      thread_count = 1;
+
+  // '-qsufsort' makes -genbsdiff use the older suffix sort, for comparison.
+  courgette::SuffixSortAlgorithm suffix_sort =
+      command_line.HasSwitch("qsufsort") ? courgette::SUFFIX_SORT_QSUFSORT
+                                         : courgette::SUFFIX_SORT_SAIS;
+
   if (cmd_sup + cmd_dis + cmd_asm + cmd_disadj + cmd_make_patch +
       cmd_apply_patch + cmd_make_bsdiff_patch + cmd_apply_bsdiff_patch +
       cmd_spread_1_adjusted + cmd_spread_1_unadjusted
@@ -481,7 +497,7 @@ int main(int argc, const char* argv[]) {
     } else if (cmd_make_patch) {
       if (values.size() != 3)
         UsageProblem("-gen <old_file> <new_file> <patch_file>");
-      GenerateEnsemblePatch(values[0], values[1], values[2]);
+      GenerateEnsemblePatch(values[0], values[1], values[2], thread_count);
     } else if (cmd_apply_patch) {
       if (values.size() != 3)
         UsageProblem("-apply <old_file> <patch_file> <new_file>");
@@ -489,7 +505,7 @@ int main(int argc, const char* argv[]) {
     } else if (cmd_make_bsdiff_patch) {
       if (values.size() != 3)
         UsageProblem("-genbsdiff <old_file> <new_file> <patch_file>");
-      GenerateBSDiffPatch(values[0], values[1], values[2]);
+      GenerateBSDiffPatch(values[0], values[1], values[2], suffix_sort);
     } else if (cmd_apply_bsdiff_patch) {
       if (values.size() != 3)
         UsageProblem("-applybsdiff <old_file> <patch_file> <new_file>");
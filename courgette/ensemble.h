@@ -226,6 +226,9 @@ class TransformationPatchGenerator {
   // The output written to |old_transformed_element| must match exactly the
   // output written by the Transform method of the corresponding subclass of
   // TransformationPatcher.
+  //
+  // Transform may be called for several generators concurrently, so it must
+  // only touch this generator's state and the streams it is given.
   virtual Status Transform(SourceStreamSet* old_corrected_parameters,
                            SinkStreamSet* old_transformed_element,
                            SinkStreamSet* new_transformed_element) = 0;
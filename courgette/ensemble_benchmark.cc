@@ -0,0 +1,113 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Times ensemble patch generation between two archives for several thread
+// counts, and checks that every thread count generates the same patch.
+// Archives holding many executables show the speedup of transforming their
+// elements in parallel.
+//
+//   courgette_ensemble_benchmark [-threads=1,2,4,8] <old_file> <new_file>
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/basictypes.h"
+#include "base/command_line.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/string_number_conversions.h"
+#include "base/string_split.h"
+#include "base/time.h"
+#include "courgette/courgette.h"
+#include "courgette/streams.h"
+
+namespace {
+
+bool ReadFile(const FilePath& file_name, const char* kind,
+              std::string* contents) {
+  if (!file_util::ReadFileToString(file_name, contents)) {
+    fprintf(stderr, "Can't read %s file.\n", kind);
+    return false;
+  }
+  return true;
+}
+
+// Generates the patch from |old_file| to |new_file| with |thread_count|
+// threads into |patch|, and prints how long it took.
+bool RunBenchmark(const std::string& old_file, const std::string& new_file,
+                  int thread_count, std::string* patch) {
+  courgette::SourceStream old_stream;
+  courgette::SourceStream new_stream;
+  old_stream.Init(old_file);
+  new_stream.Init(new_file);
+  courgette::SinkStream patch_stream;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  courgette::Status status = courgette::GenerateEnsemblePatch(
+      &old_stream, &new_stream, &patch_stream, thread_count);
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  if (status != courgette::C_OK) {
+    fprintf(stderr, "%d threads: patch generation failed with status %d\n",
+            thread_count, status);
+    return false;
+  }
+
+  patch->assign(reinterpret_cast<const char*>(patch_stream.Buffer()),
+                patch_stream.Length());
+  printf("%2d threads: %8.2fs  patch %9u bytes\n", thread_count,
+         elapsed.InSecondsF(), static_cast<unsigned>(patch->size()));
+  fflush(stdout);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  base::AtExitManager at_exit_manager;
+  CommandLine::Init(argc, argv);
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+
+  const CommandLine::StringVector& args = command_line.GetArgs();
+  if (args.size() != 2) {
+    fprintf(stderr, "Usage: courgette_ensemble_benchmark [-threads=1,2,4,8] "
+                    "<old_file> <new_file>\n");
+    return 1;
+  }
+  std::string old_file;
+  std::string new_file;
+  if (!ReadFile(FilePath(args[0]), "'old' input", &old_file) ||
+      !ReadFile(FilePath(args[1]), "'new' input", &new_file)) {
+    return 1;
+  }
+
+  std::string threads_switch = command_line.GetSwitchValueASCII("threads");
+  if (threads_switch.empty())
+    threads_switch = "1,2,4,8";
+  std::vector<std::string> thread_strings;
+  base::SplitString(threads_switch, ',', &thread_strings);
+
+  std::string first_patch;
+  for (size_t i = 0; i < thread_strings.size(); ++i) {
+    int thread_count = 0;
+    if (!base::StringToInt(thread_strings[i], &thread_count) ||
+        thread_count <= 0) {
+      fprintf(stderr, "Bad -threads value: %s\n", thread_strings[i].c_str());
+      return 1;
+    }
+    std::string patch;
+    if (!RunBenchmark(old_file, new_file, thread_count, &patch))
+      return 1;
+    if (i == 0) {
+      first_patch.swap(patch);
+    } else if (patch != first_patch) {
+      fprintf(stderr, "%d threads: patch differs from %s threads\n",
+              thread_count, thread_strings[0].c_str());
+      return 1;
+    }
+  }
+  return 0;
+}
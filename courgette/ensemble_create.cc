@@ -14,11 +14,17 @@
 
 #include "courgette/ensemble.h"
 
+#include <algorithm>
 #include <vector>
 #include <limits>
 
 #include "base/basictypes.h"
+#include "base/compiler_specific.h"
 #include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
 #include "base/time.h"
 
 #include "courgette/third_party/bsdiff.h"
@@ -220,11 +226,152 @@ void FreeGenerators(std::vector<TransformationPatchGenerator*>* generators) {
   generators->clear();
 }
 
+// A TransformJob runs one generator's Transform step.  Each job reads and
+// writes only its own streams, which are appended to the patch in generator
+// order, so the patch does not depend on how jobs are scheduled.
+class TransformJob : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit TransformJob(TransformationPatchGenerator* generator)
+      : generator_(generator),
+        status_(C_OK) {
+  }
+
+  virtual void Run() OVERRIDE {
+    status_ = generator_->Transform(&parameters_,
+                                    &predicted_transformed_element_,
+                                    &corrected_transformed_element_);
+  }
+
+  SourceStreamSet* parameters() { return &parameters_; }
+  SinkStreamSet* predicted_transformed_element() {
+    return &predicted_transformed_element_;
+  }
+  SinkStreamSet* corrected_transformed_element() {
+    return &corrected_transformed_element_;
+  }
+  Status status() const { return status_; }
+
+ private:
+  TransformationPatchGenerator* generator_;
+  SourceStreamSet parameters_;
+  SinkStreamSet predicted_transformed_element_;
+  SinkStreamSet corrected_transformed_element_;
+  Status status_;
+
+  DISALLOW_COPY_AND_ASSIGN(TransformJob);
+};
+
+// Runs TransformJobs on up to |thread_count| threads and hands them back in
+// order, so that each job's output can be written and freed as soon as it and
+// all earlier jobs are done.  A worker only starts a job while fewer than
+// twice as many jobs as there are threads have been started and not handed
+// back, which bounds the outputs held in memory behind a slow job.
+class TransformJobRunner : public base::DelegateSimpleThread::Delegate {
+ public:
+  TransformJobRunner(const std::vector<TransformJob*>& jobs, int thread_count);
+
+  // Stops starting jobs and waits for the ones that are running.
+  virtual ~TransformJobRunner();
+
+  // Returns jobs[|index|] once it has run.  Jobs must be taken in order, and
+  // taking a job releases the one before it from the bound.
+  TransformJob* Take(size_t index);
+
+  int thread_count() const { return static_cast<int>(threads_.size()); }
+
+  virtual void Run() OVERRIDE;
+
+ private:
+  const std::vector<TransformJob*> jobs_;
+  size_t max_outstanding_;
+  ScopedVector<base::DelegateSimpleThread> threads_;
+
+  base::Lock lock_;
+  base::ConditionVariable changed_;  // Signaled when any of the below change.
+  size_t next_to_start_;
+  size_t first_outstanding_;  // Jobs before this one have been handed back.
+  std::vector<bool> done_;
+  bool stopping_;
+
+  DISALLOW_COPY_AND_ASSIGN(TransformJobRunner);
+};
+
+TransformJobRunner::TransformJobRunner(const std::vector<TransformJob*>& jobs,
+                                       int thread_count)
+    : jobs_(jobs),
+      max_outstanding_(0),
+      changed_(&lock_),
+      next_to_start_(0),
+      first_outstanding_(0),
+      done_(jobs.size(), false),
+      stopping_(false) {
+  int threads = std::min(thread_count, static_cast<int>(jobs.size()));
+  if (threads <= 1)
+    return;  // Take() runs each job on the calling thread.
+  max_outstanding_ = 2 * threads;
+  for (int i = 0;  i < threads;  ++i) {
+    base::DelegateSimpleThread* thread =
+        new base::DelegateSimpleThread(this, "courgette_transform");
+    threads_.push_back(thread);
+    thread->Start();
+  }
+}
+
+TransformJobRunner::~TransformJobRunner() {
+  {
+    base::AutoLock auto_lock(lock_);
+    stopping_ = true;
+    changed_.Broadcast();
+  }
+  for (size_t i = 0;  i < threads_.size();  ++i)
+    threads_[i]->Join();
+}
+
+TransformJob* TransformJobRunner::Take(size_t index) {
+  if (threads_.empty()) {
+    jobs_[index]->Run();
+    return jobs_[index];
+  }
+  base::AutoLock auto_lock(lock_);
+  DCHECK_LE(first_outstanding_, index);
+  first_outstanding_ = index;
+  changed_.Broadcast();
+  while (!done_[index])
+    changed_.Wait();
+  return jobs_[index];
+}
+
+void TransformJobRunner::Run() {
+  base::AutoLock auto_lock(lock_);
+  while (true) {
+    while (!stopping_ && next_to_start_ < jobs_.size() &&
+           next_to_start_ >= first_outstanding_ + max_outstanding_) {
+      changed_.Wait();
+    }
+    if (stopping_ || next_to_start_ == jobs_.size())
+      return;
+    size_t index = next_to_start_++;
+    {
+      base::AutoUnlock auto_unlock(lock_);
+      jobs_[index]->Run();
+    }
+    done_[index] = true;
+    changed_.Broadcast();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 Status GenerateEnsemblePatch(SourceStream* base,
                              SourceStream* update,
                              SinkStream* final_patch) {
+  return GenerateEnsemblePatch(base, update, final_patch, 1);
+}
+
+Status GenerateEnsemblePatch(SourceStream* base,
+                             SourceStream* update,
+                             SinkStream* final_patch,
+                             int thread_count) {
   VLOG(1) << "start GenerateEnsemblePatch";
   base::Time start_time = base::Time::Now();
 
@@ -314,34 +461,46 @@ Status GenerateEnsemblePatch(SourceStream* base,
   if (!corrected_parameters_source_set.Init(&corrected_parameters_source))
     return C_STREAM_ERROR;
 
-  SinkStreamSet predicted_transformed_elements;
-  SinkStreamSet corrected_transformed_elements;
-
+  ScopedVector<TransformJob> transform_jobs;
   for (size_t i = 0;  i < number_of_transformations;  ++i) {
-    SourceStreamSet single_parameters;
-    if (!corrected_parameters_source_set.ReadSet(&single_parameters))
-      return C_STREAM_ERROR;
-    SinkStreamSet single_predicted_transformed_element;
-    SinkStreamSet single_corrected_transformed_element;
-    Status status = generators[i]->Transform(
-        &single_parameters,
-        &single_predicted_transformed_element,
-        &single_corrected_transformed_element);
-    if (status != C_OK)
-      return status;
-    if (!single_parameters.Empty())
-      return C_STREAM_NOT_CONSUMED;
-    if (!predicted_transformed_elements.WriteSet(
-            &single_predicted_transformed_element))
-      return C_STREAM_ERROR;
-    if (!corrected_transformed_elements.WriteSet(
-            &single_corrected_transformed_element))
+    TransformJob* job = new TransformJob(generators[i]);
+    transform_jobs.push_back(job);
+    if (!corrected_parameters_source_set.ReadSet(job->parameters()))
       return C_STREAM_ERROR;
   }
 
   if (!corrected_parameters_source_set.Empty())
     return C_STREAM_NOT_CONSUMED;
 
+  // The transforms are independent of each other and are the bulk of the
+  // work, so this is the step that runs in parallel.  Each job's output is
+  // appended as soon as the jobs before it have been, then freed.
+  base::Time start_transform_time = base::Time::Now();
+  SinkStreamSet predicted_transformed_elements;
+  SinkStreamSet corrected_transformed_elements;
+  {
+    TransformJobRunner runner(transform_jobs.get(), thread_count);
+    for (size_t i = 0;  i < number_of_transformations;  ++i) {
+      TransformJob* job = runner.Take(i);
+      if (job->status() != C_OK)
+        return job->status();
+      if (!job->parameters()->Empty())
+        return C_STREAM_NOT_CONSUMED;
+      if (!predicted_transformed_elements.WriteSet(
+              job->predicted_transformed_element()))
+        return C_STREAM_ERROR;
+      if (!corrected_transformed_elements.WriteSet(
+              job->corrected_transformed_element()))
+        return C_STREAM_ERROR;
+      delete job;
+      transform_jobs[i] = NULL;
+    }
+    VLOG(1) << "done Transform of " << number_of_transformations
+            << " elements on " << std::max(runner.thread_count(), 1)
+            << " threads "
+            << (base::Time::Now() - start_transform_time).InSecondsF() << "s";
+  }
+
   SinkStream linearized_predicted_transformed_elements;
   SinkStream linearized_corrected_transformed_elements;
 
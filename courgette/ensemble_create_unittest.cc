@@ -0,0 +1,78 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "courgette/base_test_unittest.h"
+#include "courgette/courgette.h"
+#include "courgette/streams.h"
+
+class EnsembleCreateTest : public BaseTest {
+ public:
+  // Returns the patch from |old_bytes| to |new_bytes| generated with
+  // |thread_count| threads.
+  std::string GeneratePatch(const std::string& old_bytes,
+                            const std::string& new_bytes,
+                            int thread_count) const;
+};
+
+std::string EnsembleCreateTest::GeneratePatch(const std::string& old_bytes,
+                                              const std::string& new_bytes,
+                                              int thread_count) const {
+  courgette::SourceStream old_stream;
+  courgette::SourceStream new_stream;
+  old_stream.Init(old_bytes);
+  new_stream.Init(new_bytes);
+
+  courgette::SinkStream patch_stream;
+  EXPECT_EQ(courgette::C_OK,
+            courgette::GenerateEnsemblePatch(&old_stream, &new_stream,
+                                             &patch_stream, thread_count));
+  return std::string(reinterpret_cast<const char*>(patch_stream.Buffer()),
+                     patch_stream.Length());
+}
+
+// Tests that transforming the elements on several threads generates the same
+// patch as a single thread does.
+TEST_F(EnsembleCreateTest, ParallelPatchMatchesSingleThreaded) {
+  std::string old_bytes = FileContents("setup1.exe") +
+                          FileContents("elf-32-1") +
+                          FileContents("setup1.exe");
+  std::string new_bytes = FileContents("setup2.exe") +
+                          FileContents("elf-32-1") +
+                          FileContents("setup2.exe");
+
+  std::string patch = GeneratePatch(old_bytes, new_bytes, 1);
+  ASSERT_FALSE(patch.empty());
+  EXPECT_TRUE(patch == GeneratePatch(old_bytes, new_bytes, 2));
+  EXPECT_TRUE(patch == GeneratePatch(old_bytes, new_bytes, 4));
+
+  courgette::SourceStream old_stream;
+  courgette::SourceStream patch_stream;
+  old_stream.Init(old_bytes);
+  patch_stream.Init(patch);
+  courgette::SinkStream new_stream;
+  EXPECT_EQ(courgette::C_OK,
+            courgette::ApplyEnsemblePatch(&old_stream, &patch_stream,
+                                          &new_stream));
+  EXPECT_TRUE(new_bytes ==
+              std::string(reinterpret_cast<const char*>(new_stream.Buffer()),
+                          new_stream.Length()));
+}
+
+// Tests that the patch is unchanged when there are more elements than the
+// transforms that may run ahead of the one being written.
+TEST_F(EnsembleCreateTest, ManyElementPatchMatchesSingleThreaded) {
+  std::string old_bytes;
+  std::string new_bytes;
+  for (int i = 0; i < 4; ++i) {
+    old_bytes += FileContents("setup1.exe") + FileContents("elf-32-1");
+    new_bytes += FileContents("setup2.exe") + FileContents("elf-32-1");
+  }
+
+  std::string patch = GeneratePatch(old_bytes, new_bytes, 1);
+  ASSERT_FALSE(patch.empty());
+  EXPECT_TRUE(patch == GeneratePatch(old_bytes, new_bytes, 2));
+  EXPECT_TRUE(patch == GeneratePatch(old_bytes, new_bytes, 3));
+}
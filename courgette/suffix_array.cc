@@ -0,0 +1,203 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "courgette/suffix_array.h"
+
+#include <vector>
+
+#include "base/logging.h"
+
+namespace courgette {
+
+namespace {
+
+// The top-level text: the input bytes shifted up by one, followed by a
+// virtual sentinel 0 that is smaller than every byte.  This saves copying the
+// input just to append a terminator.
+class ByteText {
+ public:
+  ByteText(const uint8* bytes, int size) : bytes_(bytes), size_(size) {}
+
+  int operator[](int i) const { return i < size_ ? bytes_[i] + 1 : 0; }
+
+ private:
+  const uint8* bytes_;
+  int size_;
+};
+
+// A window onto part of a PagedArray<int>.  Used for the suffix array at each
+// level of recursion and for the reduced text, which lives in the upper part
+// of the parent's suffix array.
+class IntWindow {
+ public:
+  IntWindow(PagedArray<int>* array, int offset)
+      : array_(array), offset_(offset) {}
+
+  int& operator[](int i) const { return (*array_)[offset_ + i]; }
+
+  PagedArray<int>* array() const { return array_; }
+  int offset() const { return offset_; }
+
+ private:
+  PagedArray<int>* array_;
+  int offset_;
+};
+
+// Suffix types: true for S-type (smaller than the following suffix), false
+// for L-type.
+typedef std::vector<bool> SuffixTypes;
+
+// A leftmost S-type position, i.e. an S-type suffix preceded by an L-type one.
+bool IsLMS(const SuffixTypes& types, int i) {
+  return i > 0 && types[i] && !types[i - 1];
+}
+
+// Fills |buckets| with the start (or one past the end, if |end|) of each
+// character's bucket in the suffix array.
+template <typename Text>
+void GetBuckets(const Text& text, int n, int max_char, bool end,
+                PagedArray<int>* buckets) {
+  for (int c = 0; c <= max_char; ++c)
+    (*buckets)[c] = 0;
+  for (int i = 0; i < n; ++i)
+    ++(*buckets)[text[i]];
+  int sum = 0;
+  for (int c = 0; c <= max_char; ++c) {
+    sum += (*buckets)[c];
+    (*buckets)[c] = end ? sum : sum - (*buckets)[c];
+  }
+}
+
+// Given the LMS suffixes placed at the ends of their buckets, induces the
+// order of the L-type suffixes (left to right) and then the S-type suffixes
+// (right to left).
+template <typename Text>
+void Induce(const Text& text, const SuffixTypes& types, int n, int max_char,
+            const IntWindow& sa, PagedArray<int>* buckets) {
+  GetBuckets(text, n, max_char, false, buckets);
+  for (int i = 0; i < n; ++i) {
+    int j = sa[i] - 1;
+    if (j >= 0 && !types[j])
+      sa[(*buckets)[text[j]]++] = j;
+  }
+  GetBuckets(text, n, max_char, true, buckets);
+  for (int i = n - 1; i >= 0; --i) {
+    int j = sa[i] - 1;
+    if (j >= 0 && types[j])
+      sa[--(*buckets)[text[j]]] = j;
+  }
+}
+
+// Sorts the suffixes of |text|, which has length |n| >= 2, characters in
+// [0, |max_char|] and a unique smallest character at the end.
+template <typename Text>
+bool SAIS(const Text& text, int n, int max_char, const IntWindow& sa) {
+  SuffixTypes types(n);
+  types[n - 1] = true;
+  types[n - 2] = false;
+  for (int i = n - 3; i >= 0; --i) {
+    types[i] = text[i] < text[i + 1] ||
+               (text[i] == text[i + 1] && types[i + 1]);
+  }
+
+  PagedArray<int> buckets;
+  if (!buckets.Allocate(max_char + 1))
+    return false;
+
+  // Stage 1: sort the LMS substrings by placing each LMS position at the end
+  // of its bucket and inducing.
+  GetBuckets(text, n, max_char, true, &buckets);
+  for (int i = 0; i < n; ++i)
+    sa[i] = -1;
+  for (int i = 1; i < n; ++i) {
+    if (IsLMS(types, i))
+      sa[--buckets[text[i]]] = i;
+  }
+  Induce(text, types, n, max_char, sa, &buckets);
+
+  // Compact the sorted LMS substrings into the first |n1| slots.  There are
+  // at most n / 2 of them.
+  int n1 = 0;
+  for (int i = 0; i < n; ++i) {
+    if (IsLMS(types, sa[i]))
+      sa[n1++] = sa[i];
+  }
+
+  // Name each LMS substring by its rank, giving equal substrings equal
+  // names.  LMS positions are at least two apart, so pos / 2 is a collision
+  // free slot in the upper half.
+  for (int i = n1; i < n; ++i)
+    sa[i] = -1;
+  int names = 0;
+  int prev = -1;
+  for (int i = 0; i < n1; ++i) {
+    int pos = sa[i];
+    bool differ = false;
+    for (int d = 0; d < n; ++d) {
+      if (prev == -1 || text[pos + d] != text[prev + d] ||
+          types[pos + d] != types[prev + d]) {
+        differ = true;
+        break;
+      }
+      if (d > 0 && (IsLMS(types, pos + d) || IsLMS(types, prev + d)))
+        break;
+    }
+    if (differ) {
+      ++names;
+      prev = pos;
+    }
+    sa[n1 + pos / 2] = names - 1;
+  }
+  for (int i = n - 1, j = n - 1; i >= n1; --i) {
+    if (sa[i] >= 0)
+      sa[j--] = sa[i];
+  }
+
+  // Stage 2: sort the reduced text, stored in the last |n1| slots.  If all
+  // names are unique its suffix array follows directly, otherwise recurse.
+  IntWindow reduced(sa.array(), sa.offset() + n - n1);
+  if (names < n1) {
+    if (!SAIS(reduced, n1, names - 1, sa))
+      return false;
+  } else {
+    for (int i = 0; i < n1; ++i)
+      sa[reduced[i]] = i;
+  }
+
+  // Stage 3: map the sorted reduced suffixes back to LMS positions, put them
+  // at the ends of their buckets in order, and induce the full suffix array.
+  for (int i = 1, j = 0; i < n; ++i) {
+    if (IsLMS(types, i))
+      reduced[j++] = i;
+  }
+  for (int i = 0; i < n1; ++i)
+    sa[i] = reduced[sa[i]];
+  for (int i = n1; i < n; ++i)
+    sa[i] = -1;
+  GetBuckets(text, n, max_char, true, &buckets);
+  for (int i = n1 - 1; i >= 0; --i) {
+    int j = sa[i];
+    sa[i] = -1;
+    sa[--buckets[text[j]]] = j;
+  }
+  Induce(text, types, n, max_char, sa, &buckets);
+  return true;
+}
+
+}  // namespace
+
+bool BuildSuffixArray(const uint8* text, int size,
+                      PagedArray<int>* suffix_array) {
+  DCHECK_GE(size, 0);
+  if (size == 0) {
+    (*suffix_array)[0] = 0;
+    return true;
+  }
+  // The sentinel makes the text one longer; the byte alphabet is shifted up
+  // by one to make room for it.
+  return SAIS(ByteText(text, size), size + 1, 256,
+              IntWindow(suffix_array, 0));
+}
+
+}  // namespace courgette
@@ -0,0 +1,31 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef COURGETTE_SUFFIX_ARRAY_H_
+#define COURGETTE_SUFFIX_ARRAY_H_
+
+#include "base/basictypes.h"
+#include "courgette/third_party/paged_array.h"
+
+namespace courgette {
+
+// Builds the suffix array of |text| using the SA-IS algorithm ("Linear Suffix
+// Array Construction by Almost Pure Induced-Sorting", Nong, Zhang and Chan).
+//
+// |suffix_array| must hold |size| + 1 elements.  On return it contains the
+// start positions of all suffixes of |text|, including the empty suffix, in
+// lexicographic order, so suffix_array[0] == |size|.  This is the same layout
+// bsdiff's qsufsort produces, and since a suffix array is unique the two are
+// interchangeable.
+//
+// Runs in linear time.  Besides |suffix_array| it needs about |size| / 8
+// bytes for suffix types, plus a bucket array that is small for the byte
+// alphabet and at most 2 * |size| bytes for the reduced problem.  Returns
+// false if that scratch space cannot be allocated.
+bool BuildSuffixArray(const uint8* text, int size,
+                      PagedArray<int>* suffix_array);
+
+}  // namespace courgette
+
+#endif  // COURGETTE_SUFFIX_ARRAY_H_
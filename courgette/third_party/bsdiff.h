@@ -50,12 +50,29 @@ enum BSDiffStatus {
 class SourceStream;
 class SinkStream;
 
-// Creates a binary patch.
+// Algorithms for building the suffix array of the old file.  Both produce the
+// same suffix array and hence byte-identical patches; they differ in speed and
+// memory.
+enum SuffixSortAlgorithm {
+  // Larsson-Sadakane qsufsort.  O(n log n) time, 8n bytes of working memory.
+  SUFFIX_SORT_QSUFSORT,
+  // SA-IS induced sorting.  O(n) time, about 4n bytes of working memory.
+  SUFFIX_SORT_SAIS,
+};
+
+// Creates a binary patch, building the suffix array with SA-IS.
 //
 BSDiffStatus CreateBinaryPatch(SourceStream* old_stream,
                                SourceStream* new_stream,
                                SinkStream* patch_stream);
 
+// As above, with an explicit choice of suffix sorting algorithm.
+//
+BSDiffStatus CreateBinaryPatch(SourceStream* old_stream,
+                               SourceStream* new_stream,
+                               SinkStream* patch_stream,
+                               SuffixSortAlgorithm algorithm);
+
 // Applies the given patch file to a given source file. This method validates
 // the CRC of the original file stored in the patch file, before applying the
 // patch to it.
@@ -20,6 +20,8 @@
   2010-05-26 - Use a paged array for V and I. The address space may be too
                fragmented for these big arrays to be contiguous.
                  --Stephen Adams <sra@chromium.org>
+  2012-06-11 - Build the suffix array with SA-IS by default; qsufsort is kept
+               as an option.
 */
 
 #include "courgette/third_party/bsdiff.h"
@@ -34,6 +36,7 @@
 
 #include "courgette/crc.h"
 #include "courgette/streams.h"
+#include "courgette/suffix_array.h"
 #include "courgette/third_party/paged_array.h"
 
 namespace courgette {
@@ -202,6 +205,15 @@ static CheckBool WriteHeader(SinkStream* stream, MBSPatchHeader* header) {
 BSDiffStatus CreateBinaryPatch(SourceStream* old_stream,
                                SourceStream* new_stream,
                                SinkStream* patch_stream)
+{
+  return CreateBinaryPatch(old_stream, new_stream, patch_stream,
+                           SUFFIX_SORT_SAIS);
+}
+
+BSDiffStatus CreateBinaryPatch(SourceStream* old_stream,
+                               SourceStream* new_stream,
+                               SinkStream* patch_stream,
+                               SuffixSortAlgorithm algorithm)
 {
   base::Time start_bsdiff_time = base::Time::Now();
   VLOG(1) << "Start bsdiff";
@@ -221,7 +233,6 @@ BSDiffStatus CreateBinaryPatch(SourceStream* old_stream,
   uint32 pending_diff_zeros = 0;
 
   PagedArray<int> I;
-  PagedArray<int> V;
 
   if (!I.Allocate(oldsize + 1)) {
     LOG(ERROR) << "Could not allocate I[], " << ((oldsize + 1) * sizeof(int))
@@ -229,17 +240,26 @@ BSDiffStatus CreateBinaryPatch(SourceStream* old_stream,
     return MEM_ERROR;
   }
 
-  if (!V.Allocate(oldsize + 1)) {
-    LOG(ERROR) << "Could not allocate V[], " << ((oldsize + 1) * sizeof(int))
-               << " bytes";
-    return MEM_ERROR;
-  }
-
   base::Time q_start_time = base::Time::Now();
-  qsufsort(I, V, old, oldsize);
-  VLOG(1) << " done qsufsort "
-          << (base::Time::Now() - q_start_time).InSecondsF();
-  V.clear();
+  if (algorithm == SUFFIX_SORT_SAIS) {
+    if (!BuildSuffixArray(old, oldsize, &I)) {
+      LOG(ERROR) << "Could not allocate SA-IS working memory";
+      return MEM_ERROR;
+    }
+    VLOG(1) << " done SA-IS "
+            << (base::Time::Now() - q_start_time).InSecondsF();
+  } else {
+    // qsufsort needs the inverse array V[] alongside I[].
+    PagedArray<int> V;
+    if (!V.Allocate(oldsize + 1)) {
+      LOG(ERROR) << "Could not allocate V[], " << ((oldsize + 1) * sizeof(int))
+                 << " bytes";
+      return MEM_ERROR;
+    }
+    qsufsort(I, V, old, oldsize);
+    VLOG(1) << " done qsufsort "
+            << (base::Time::Now() - q_start_time).InSecondsF();
+  }
 
   const uint8* newbuf = new_stream->Buffer();
   const int newsize = static_cast<int>(new_stream->Remaining());
@@ -26,6 +26,7 @@ CommandBufferHelper::CommandBufferHelper(CommandBuffer* command_buffer)
       put_(0),
       last_put_sent_(0),
       commands_issued_(0),
+      token_wait_count_(0),
       usable_(true),
       last_flush_time_(0) {
 }
@@ -168,6 +169,8 @@ void CommandBufferHelper::WaitForToken(int32 token) {
   if (token < 0)
     return;
   if (token > token_) return;  // we wrapped
+  if (last_token_read() < token)
+    ++token_wait_count_;
   while (last_token_read() < token) {
     if (get_offset() == put_) {
       GPU_LOG(FATAL) << "Empty command buffer while waiting on a token.";
@@ -83,6 +83,12 @@ class CommandBufferHelper {
   //   the value of the token to wait for.
   void WaitForToken(int32 token);
 
+  // Gets the number of calls to WaitForToken that had to block because the
+  // token had not passed yet.
+  int token_wait_count() const {
+    return token_wait_count_;
+  }
+
   // Called prior to each command being issued. Waits for a certain amount of
   // space to be available. Returns address of space.
   CommandBufferEntry* GetSpace(uint32 entries);
@@ -279,6 +285,7 @@ class CommandBufferHelper {
   int32 put_;
   int32 last_put_sent_;
   int commands_issued_;
+  int token_wait_count_;
   bool usable_;
 
   // Using C runtime instead of base because this file cannot depend on base.
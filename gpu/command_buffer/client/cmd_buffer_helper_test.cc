@@ -307,6 +307,25 @@ TEST_F(CommandBufferHelperTest, TestToken) {
   EXPECT_EQ(error::kNoError, GetError());
 }
 
+// Checks that only the waits that have to block are counted.
+TEST_F(CommandBufferHelperTest, TestTokenWaitCount) {
+  EXPECT_EQ(0, helper_->token_wait_count());
+
+  int32 token = helper_->InsertToken();
+  EXPECT_CALL(*api_mock_.get(), DoCommand(cmd::kSetToken, 1, _))
+      .WillOnce(DoAll(Invoke(api_mock_.get(), &AsyncAPIMock::SetToken),
+                      Return(error::kNoError)));
+  helper_->WaitForToken(token);
+  EXPECT_EQ(1, helper_->token_wait_count());
+
+  // The token has passed, so waiting for it again does not block.
+  helper_->WaitForToken(token);
+  EXPECT_EQ(1, helper_->token_wait_count());
+
+  Mock::VerifyAndClearExpectations(api_mock_.get());
+  EXPECT_EQ(error::kNoError, GetError());
+}
+
 TEST_F(CommandBufferHelperTest, FreeRingBuffer) {
   EXPECT_TRUE(helper_->HaveRingBuffer());
 
@@ -17,48 +17,48 @@ const FencedAllocator::Offset FencedAllocator::kInvalidOffset;
 FencedAllocator::FencedAllocator(unsigned int size,
                                  CommandBufferHelper *helper)
     : helper_(helper) {
-  Block block = { FREE, 0, size, kUnusedToken };
-  blocks_.push_back(block);
+  Block block = { FREE, size, kUnusedToken };
+  blocks_.insert(std::make_pair(0u, block));
+  free_blocks_.insert(std::make_pair(size, 0u));
 }
 
 FencedAllocator::~FencedAllocator() {
   // Free blocks pending tokens.
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    if (blocks_[i].state == FREE_PENDING_TOKEN) {
-      i = WaitForTokenAndFreeBlock(i);
-    }
-  }
+  while (!pending_blocks_.empty())
+    WaitForTokenAndFreeBlock(GetBlockByOffset(pending_blocks_.begin()->second));
   // These checks are not valid if the service has crashed or lost the context.
   // GPU_DCHECK_EQ(blocks_.size(), 1u);
-  // GPU_DCHECK_EQ(blocks_[0].state, FREE);
+  // GPU_DCHECK_EQ(blocks_.begin()->second.state, FREE);
 }
 
 // Looks for a non-allocated block that is big enough. Search in the FREE
-// blocks first (for direct usage), first-fit, then in the FREE_PENDING_TOKEN
-// blocks, waiting for them. The current implementation isn't smart about
-// optimizing what to wait for, just looks inside the block in order (first-fit
-// as well).
+// blocks first (for direct usage), best-fit, then in the FREE_PENDING_TOKEN
+// blocks, waiting for them oldest token first. Waiting for a token also frees
+// every block pending an older one, so the search goes back to the FREE
+// blocks after each wait.
 FencedAllocator::Offset FencedAllocator::Alloc(unsigned int size) {
   // Similarly to malloc, an allocation of 0 allocates at least 1 byte, to
   // return different pointers every time.
   if (size == 0) size = 1;
 
-  // Try first to allocate in a free block.
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    Block &block = blocks_[i];
-    if (block.state == FREE && block.size >= size) {
-      return AllocInBlock(i, size);
-    }
-  }
-
-  // No free block is available. Look for blocks pending tokens, and wait for
-  // them to be re-usable.
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    if (blocks_[i].state != FREE_PENDING_TOKEN)
-      continue;
-    i = WaitForTokenAndFreeBlock(i);
-    if (blocks_[i].size >= size)
-      return AllocInBlock(i, size);
+  // Try first to allocate in a free block. Among the blocks of the smallest
+  // size that fits, the one with the lowest offset is used.
+  FreeBlockSet::iterator it =
+      free_blocks_.lower_bound(std::make_pair(size, 0u));
+  if (it != free_blocks_.end())
+    return AllocInBlock(GetBlockByOffset(it->second), size);
+
+  // No free block is available. Wait for blocks pending tokens to be
+  // re-usable.
+  while (!pending_blocks_.empty()) {
+    BlockIterator block = WaitForTokenAndFreeBlock(
+        GetBlockByOffset(pending_blocks_.begin()->second));
+    if (block->second.size >= size)
+      return AllocInBlock(block, size);
+    FreeUnused();
+    it = free_blocks_.lower_bound(std::make_pair(size, 0u));
+    if (it != free_blocks_.end())
+      return AllocInBlock(GetBlockByOffset(it->second), size);
   }
   return kInvalidOffset;
 }
@@ -66,30 +66,31 @@ FencedAllocator::Offset FencedAllocator::Alloc(unsigned int size) {
 // Looks for the corresponding block, mark it FREE, and collapse it if
 // necessary.
 void FencedAllocator::Free(FencedAllocator::Offset offset) {
-  BlockIndex index = GetBlockByOffset(offset);
-  GPU_DCHECK_NE(blocks_[index].state, FREE);
-  blocks_[index].state = FREE;
-  CollapseFreeBlock(index);
+  BlockIterator block = GetBlockByOffset(offset);
+  GPU_DCHECK_NE(block->second.state, FREE);
+  if (block->second.state == FREE_PENDING_TOKEN)
+    pending_blocks_.erase(std::make_pair(block->second.token, offset));
+  block->second.state = FREE;
+  CollapseFreeBlock(block);
 }
 
 // Looks for the corresponding block, mark it FREE_PENDING_TOKEN.
 void FencedAllocator::FreePendingToken(
     FencedAllocator::Offset offset, int32 token) {
-  BlockIndex index = GetBlockByOffset(offset);
-  Block &block = blocks_[index];
-  block.state = FREE_PENDING_TOKEN;
-  block.token = token;
+  BlockIterator block = GetBlockByOffset(offset);
+  GPU_DCHECK_NE(block->second.state, FREE);
+  if (block->second.state == FREE_PENDING_TOKEN)
+    pending_blocks_.erase(std::make_pair(block->second.token, offset));
+  block->second.state = FREE_PENDING_TOKEN;
+  block->second.token = token;
+  pending_blocks_.insert(std::make_pair(token, offset));
 }
 
-// Gets the max of the size of the blocks marked as free.
+// The free blocks are sorted by size, so the largest is the last one.
 unsigned int FencedAllocator::GetLargestFreeSize() {
-  unsigned int max_size = 0;
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    Block &block = blocks_[i];
-    if (block.state == FREE)
-      max_size = std::max(max_size, block.size);
-  }
-  return max_size;
+  if (free_blocks_.empty())
+    return 0;
+  return free_blocks_.rbegin()->first;
 }
 
 // Gets the size of the largest segment of blocks that are either FREE or
@@ -97,8 +98,8 @@ unsigned int FencedAllocator::GetLargestFreeSize() {
 unsigned int FencedAllocator::GetLargestFreeOrPendingSize() {
   unsigned int max_size = 0;
   unsigned int current_size = 0;
-  for (unsigned int i = 0; i < blocks_.size(); ++i) {
-    Block &block = blocks_[i];
+  for (BlockIterator it = blocks_.begin(); it != blocks_.end(); ++it) {
+    Block &block = it->second;
     if (block.state == IN_USE) {
       max_size = std::max(max_size, current_size);
       current_size = 0;
@@ -114,99 +115,118 @@ unsigned int FencedAllocator::GetLargestFreeOrPendingSize() {
 // - there is at least one block.
 // - there are no contiguous FREE blocks (they should have been collapsed).
 // - the successive offsets match the block sizes, and they are in order.
+// - the FREE and FREE_PENDING_TOKEN blocks are exactly the ones in
+//   |free_blocks_| and |pending_blocks_|.
 bool FencedAllocator::CheckConsistency() {
   if (blocks_.size() < 1) return false;
-  for (unsigned int i = 0; i < blocks_.size() - 1; ++i) {
-    Block &current = blocks_[i];
-    Block &next = blocks_[i + 1];
+  size_t free_count = 0;
+  size_t pending_count = 0;
+  for (BlockIterator it = blocks_.begin(); it != blocks_.end(); ++it) {
+    Offset offset = it->first;
+    Block &current = it->second;
+    if (current.state == FREE) {
+      ++free_count;
+      if (!free_blocks_.count(std::make_pair(current.size, offset)))
+        return false;
+    } else if (current.state == FREE_PENDING_TOKEN) {
+      ++pending_count;
+      if (!pending_blocks_.count(std::make_pair(current.token, offset)))
+        return false;
+    }
+
+    BlockIterator next_it = it;
+    ++next_it;
+    if (next_it == blocks_.end())
+      break;
+    Block &next = next_it->second;
     // This test is NOT included in the next one, because offset is unsigned.
-    if (next.offset <= current.offset)
+    if (next_it->first <= offset)
       return false;
-    if (next.offset != current.offset + current.size)
+    if (next_it->first != offset + current.size)
       return false;
     if (current.state == FREE && next.state == FREE)
       return false;
   }
-  return true;
+  return free_count == free_blocks_.size() &&
+      pending_count == pending_blocks_.size();
 }
 
 bool FencedAllocator::InUse() {
-  return blocks_.size() != 1 || blocks_[0].state != FREE;
+  return blocks_.size() != 1 || blocks_.begin()->second.state != FREE;
 }
 
 // Collapse the block to the next one, then to the previous one. Provided the
 // structure is consistent, those are the only blocks eligible for collapse.
-FencedAllocator::BlockIndex FencedAllocator::CollapseFreeBlock(
-    BlockIndex index) {
-  if (index + 1 < blocks_.size()) {
-    Block &next = blocks_[index + 1];
-    if (next.state == FREE) {
-      blocks_[index].size += next.size;
-      blocks_.erase(blocks_.begin() + index + 1);
-    }
+FencedAllocator::BlockIterator FencedAllocator::CollapseFreeBlock(
+    BlockIterator block) {
+  GPU_DCHECK_EQ(block->second.state, FREE);
+  BlockIterator next = block;
+  ++next;
+  if (next != blocks_.end() && next->second.state == FREE) {
+    free_blocks_.erase(std::make_pair(next->second.size, next->first));
+    block->second.size += next->second.size;
+    blocks_.erase(next);
   }
-  if (index > 0) {
-    Block &prev = blocks_[index - 1];
-    if (prev.state == FREE) {
-      prev.size += blocks_[index].size;
-      blocks_.erase(blocks_.begin() + index);
-      --index;
+  if (block != blocks_.begin()) {
+    BlockIterator prev = block;
+    --prev;
+    if (prev->second.state == FREE) {
+      free_blocks_.erase(std::make_pair(prev->second.size, prev->first));
+      prev->second.size += block->second.size;
+      blocks_.erase(block);
+      block = prev;
     }
   }
-  return index;
+  free_blocks_.insert(std::make_pair(block->second.size, block->first));
+  return block;
 }
 
 // Waits for the block's token, then mark the block as free, then collapse it.
-FencedAllocator::BlockIndex FencedAllocator::WaitForTokenAndFreeBlock(
-    BlockIndex index) {
-  Block &block = blocks_[index];
-  GPU_DCHECK_EQ(block.state, FREE_PENDING_TOKEN);
-  helper_->WaitForToken(block.token);
-  block.state = FREE;
-  return CollapseFreeBlock(index);
+FencedAllocator::BlockIterator FencedAllocator::WaitForTokenAndFreeBlock(
+    BlockIterator block) {
+  GPU_DCHECK_EQ(block->second.state, FREE_PENDING_TOKEN);
+  helper_->WaitForToken(block->second.token);
+  pending_blocks_.erase(std::make_pair(block->second.token, block->first));
+  block->second.state = FREE;
+  return CollapseFreeBlock(block);
 }
 
-// Frees any blocks pending a token for which the token has been read.
+// Frees any blocks pending a token for which the token has been read. The
+// pending blocks are sorted by token, so only those are visited.
 void FencedAllocator::FreeUnused() {
   int32 last_token_read = helper_->last_token_read();
-  for (unsigned int i = 0; i < blocks_.size();) {
-    Block& block = blocks_[i];
-    if (block.state == FREE_PENDING_TOKEN && block.token <= last_token_read) {
-      block.state = FREE;
-      i = CollapseFreeBlock(i);
-    } else {
-      ++i;
-    }
+  while (!pending_blocks_.empty() &&
+         pending_blocks_.begin()->first <= last_token_read) {
+    BlockIterator block = GetBlockByOffset(pending_blocks_.begin()->second);
+    pending_blocks_.erase(pending_blocks_.begin());
+    block->second.state = FREE;
+    CollapseFreeBlock(block);
   }
 }
 
 // If the block is exactly the requested size, simply mark it IN_USE, otherwise
 // split it and mark the first one (of the requested size) IN_USE.
-FencedAllocator::Offset FencedAllocator::AllocInBlock(BlockIndex index,
+FencedAllocator::Offset FencedAllocator::AllocInBlock(BlockIterator block,
                                                       unsigned int size) {
-  Block &block = blocks_[index];
-  GPU_DCHECK_GE(block.size, size);
-  GPU_DCHECK_EQ(block.state, FREE);
-  Offset offset = block.offset;
-  if (block.size == size) {
-    block.state = IN_USE;
+  GPU_DCHECK_GE(block->second.size, size);
+  GPU_DCHECK_EQ(block->second.state, FREE);
+  Offset offset = block->first;
+  free_blocks_.erase(std::make_pair(block->second.size, offset));
+  block->second.state = IN_USE;
+  if (block->second.size == size)
     return offset;
-  }
-  Block newblock = { FREE, offset + size, block.size - size, kUnusedToken};
-  block.state = IN_USE;
-  block.size = size;
-  // this is the last thing being done because it may invalidate block;
-  blocks_.insert(blocks_.begin() + index + 1, newblock);
+  Block newblock = { FREE, block->second.size - size, kUnusedToken };
+  block->second.size = size;
+  blocks_.insert(block, std::make_pair(offset + size, newblock));
+  free_blocks_.insert(std::make_pair(newblock.size, offset + size));
   return offset;
 }
 
-// The blocks are in offset order, so we can do a binary search.
-FencedAllocator::BlockIndex FencedAllocator::GetBlockByOffset(Offset offset) {
-  Block templ = { IN_USE, offset, 0, kUnusedToken };
-  Container::iterator it = std::lower_bound(blocks_.begin(), blocks_.end(),
-                                            templ, OffsetCmp());
-  GPU_DCHECK(it != blocks_.end() && it->offset == offset);
-  return it-blocks_.begin();
+FencedAllocator::BlockIterator FencedAllocator::GetBlockByOffset(
+    Offset offset) {
+  BlockIterator it = blocks_.find(offset);
+  GPU_DCHECK(it != blocks_.end());
+  return it;
 }
 
 }  // namespace gpu
@@ -7,7 +7,9 @@
 #ifndef GPU_COMMAND_BUFFER_CLIENT_FENCED_ALLOCATOR_H_
 #define GPU_COMMAND_BUFFER_CLIENT_FENCED_ALLOCATOR_H_
 
-#include <vector>
+#include <map>
+#include <set>
+#include <utility>
 #include "../common/logging.h"
 #include "../common/types.h"
 
@@ -89,49 +91,50 @@ class FencedAllocator {
     FREE_PENDING_TOKEN
   };
 
-  // Book-keeping sturcture that describes a block of memory.
+  // Book-keeping sturcture that describes a block of memory. The offset of
+  // the block is its key in the Container.
   struct Block {
     State state;
-    Offset offset;
     unsigned int size;
     int32 token;  // token to wait for in the FREE_PENDING_TOKEN case.
   };
 
-  // Comparison functor for memory block sorting.
-  class OffsetCmp {
-   public:
-    bool operator() (const Block &left, const Block &right) {
-      return left.offset < right.offset;
-    }
-  };
+  // All the blocks, in offset order.
+  typedef std::map<Offset, Block> Container;
+  typedef Container::iterator BlockIterator;
+
+  // The FREE blocks, ordered by size then offset, so that the smallest block
+  // that fits an allocation can be found in O(log n).
+  typedef std::set<std::pair<unsigned int, Offset> > FreeBlockSet;
 
-  typedef std::vector<Block> Container;
-  typedef unsigned int BlockIndex;
+  // The FREE_PENDING_TOKEN blocks, ordered by token then offset, so that the
+  // blocks whose token has passed are at the front.
+  typedef std::set<std::pair<int32, Offset> > PendingBlockSet;
 
   static const int32 kUnusedToken = 0;
 
-  // Gets the index of a memory block, given its offset.
-  BlockIndex GetBlockByOffset(Offset offset);
+  // Gets a memory block, given its offset.
+  BlockIterator GetBlockByOffset(Offset offset);
 
-  // Collapse a free block with its neighbours if they are free. Returns the
-  // index of the collapsed block.
-  // NOTE: this will invalidate block indices.
-  BlockIndex CollapseFreeBlock(BlockIndex index);
+  // Collapse a free block with its neighbours if they are free, and add the
+  // result to the free blocks. Returns the collapsed block.
+  // NOTE: this will invalidate iterators to the neighbours.
+  BlockIterator CollapseFreeBlock(BlockIterator block);
 
   // Waits for a FREE_PENDING_TOKEN block to be usable, and free it. Returns
-  // the new index of that block (since it may have been collapsed).
-  // NOTE: this will invalidate block indices.
-  BlockIndex WaitForTokenAndFreeBlock(BlockIndex index);
+  // the block it ends up in (since it may have been collapsed).
+  // NOTE: this will invalidate iterators to the neighbours.
+  BlockIterator WaitForTokenAndFreeBlock(BlockIterator block);
 
-  // Allocates a block of memory inside a given block, splitting it in two
-  // (unless that block is of the exact requested size).
-  // NOTE: this will invalidate block indices.
-  // Returns the offset of the allocated block (NOTE: this is different from
-  // the other functions that return a block index).
-  Offset AllocInBlock(BlockIndex index, unsigned int size);
+  // Allocates a block of memory inside a given free block, splitting it in two
+  // (unless that block is of the exact requested size). Returns the offset of
+  // the allocated block.
+  Offset AllocInBlock(BlockIterator block, unsigned int size);
 
   CommandBufferHelper *helper_;
   Container blocks_;
+  FreeBlockSet free_blocks_;
+  PendingBlockSet pending_blocks_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(FencedAllocator);
 };
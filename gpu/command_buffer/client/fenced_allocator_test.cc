@@ -4,9 +4,13 @@
 
 // This file contains the tests for the FencedAllocator class.
 
+#include <vector>
+
 #include "base/bind.h"
 #include "base/bind_helpers.h"
+#include "base/logging.h"
 #include "base/message_loop.h"
+#include "base/time.h"
 #include "gpu/command_buffer/client/cmd_buffer_helper.h"
 #include "gpu/command_buffer/client/fenced_allocator.h"
 #include "gpu/command_buffer/service/cmd_buffer_engine.h"
@@ -291,7 +295,7 @@ TEST_F(FencedAllocatorTest, TestGetLargestFreeSize) {
   EXPECT_EQ(kBufferSize - kSize, allocator_->GetLargestFreeSize());
 
   // Allocate 2 more buffers (now 3), and then free the first two. This is to
-  // ensure a hole. Note that this is dependent on the first-fit current
+  // ensure a hole. Note that this is dependent on the best-fit current
   // implementation.
   FencedAllocator::Offset offset1 = allocator_->Alloc(kSize);
   ASSERT_NE(FencedAllocator::kInvalidOffset, offset1);
@@ -334,7 +338,7 @@ TEST_F(FencedAllocatorTest, TestGetLargestFreeOrPendingSize) {
   EXPECT_EQ(kBufferSize - kSize, allocator_->GetLargestFreeOrPendingSize());
 
   // Allocate 2 more buffers (now 3), and then free the first two. This is to
-  // ensure a hole. Note that this is dependent on the first-fit current
+  // ensure a hole. Note that this is dependent on the best-fit current
   // implementation.
   FencedAllocator::Offset offset1 = allocator_->Alloc(kSize);
   ASSERT_NE(FencedAllocator::kInvalidOffset, offset1);
@@ -373,6 +377,60 @@ TEST_F(FencedAllocatorTest, TestGetLargestFreeOrPendingSize) {
   EXPECT_EQ(kBufferSize, allocator_->GetLargestFreeSize());
 }
 
+// Benchmarks a randomized workload on a larger buffer: many live blocks of
+// mixed sizes, half of them freed pending a token, like the uploads that go
+// through MappedMemoryManager. Checks that the book-keeping stays consistent.
+TEST_F(FencedAllocatorTest, BenchmarkRandomAllocFreePendingToken) {
+  const unsigned int kBenchmarkBufferSize = 16 * 1024 * 1024;
+  const size_t kMaxLiveBlocks = 4096;
+  const int kOperations = 100000;
+
+  FencedAllocator allocator(kBenchmarkBufferSize, helper_.get());
+  std::vector<FencedAllocator::Offset> offsets;
+  uint32 seed = 1;
+  int failed_allocs = 0;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kOperations; ++i) {
+    seed = seed * 1103515245 + 12345;
+    uint32 random = seed >> 8;
+    if (offsets.size() < kMaxLiveBlocks && random % 3 != 0) {
+      // 16 bytes to 16KB, mostly small.
+      unsigned int size_class = 16u << (random % 10);
+      unsigned int size = size_class + (random >> 4) % size_class;
+      FencedAllocator::Offset offset = allocator.Alloc(size);
+      if (offset == FencedAllocator::kInvalidOffset) {
+        ++failed_allocs;
+        continue;
+      }
+      offsets.push_back(offset);
+    } else if (!offsets.empty()) {
+      size_t index = (random >> 4) % offsets.size();
+      FencedAllocator::Offset offset = offsets[index];
+      offsets[index] = offsets.back();
+      offsets.pop_back();
+      if (random & 1)
+        allocator.FreePendingToken(offset, helper_->InsertToken());
+      else
+        allocator.Free(offset);
+    }
+    if (i % 64 == 0)
+      allocator.FreeUnused();
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  EXPECT_TRUE(allocator.CheckConsistency());
+  EXPECT_EQ(0, failed_allocs);
+  LOG(INFO) << "FencedAllocator: " << kOperations << " operations with up to "
+            << kMaxLiveBlocks << " live blocks in "
+            << elapsed.InMillisecondsF() << " ms";
+
+  for (size_t i = 0; i < offsets.size(); ++i)
+    allocator.Free(offsets[i]);
+  allocator.FreeUnused();
+  EXPECT_TRUE(allocator.CheckConsistency());
+}
+
 // Test fixture for FencedAllocatorWrapper test - Creates a
 // FencedAllocatorWrapper, using a CommandBufferHelper with a mock
 // AsyncAPIInterface for its interface (calling it directly, not through the
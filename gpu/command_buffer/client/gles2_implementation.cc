@@ -682,6 +682,8 @@ GLES2Implementation::~GLES2Implementation() {
   }
   // Make sure the commands make it the service.
   Finish();
+  TRACE_COUNTER_ID1(
+      "gpu", "GLES2::TokenWaits", this, helper_->token_wait_count());
 }
 
 void* GLES2Implementation::GetResultBuffer() {
@@ -1263,12 +1265,14 @@ bool GLES2Implementation::DeleteShaderHelper(GLuint shader) {
 GLint GLES2Implementation::GetAttribLocationHelper(
     GLuint program, const char* name) {
   typedef GetAttribLocationBucket::Result Result;
+  // NOTE: We must look up the address of the result area AFTER allocation
+  // of the transfer buffer since the transfer buffer may be reallocated.
+  SetBucketAsCString(kResultBucketId, name);
   Result* result = GetResultAs<Result*>();
   if (!result) {
     return -1;
   }
   *result = -1;
-  SetBucketAsCString(kResultBucketId, name);
   helper_->GetAttribLocationBucket(
       program, kResultBucketId, GetResultShmId(), GetResultShmOffset());
   WaitForCmd();
@@ -1290,12 +1294,14 @@ GLint GLES2Implementation::GetAttribLocation(
 GLint GLES2Implementation::GetUniformLocationHelper(
     GLuint program, const char* name) {
   typedef GetUniformLocationBucket::Result Result;
+  // NOTE: We must look up the address of the result area AFTER allocation
+  // of the transfer buffer since the transfer buffer may be reallocated.
+  SetBucketAsCString(kResultBucketId, name);
   Result* result = GetResultAs<Result*>();
   if (!result) {
     return -1;
   }
   *result = -1;
-  SetBucketAsCString(kResultBucketId, name);
   helper_->GetUniformLocationBucket(program, kResultBucketId,
                                     GetResultShmId(), GetResultShmOffset());
   WaitForCmd();
@@ -1827,6 +1833,10 @@ void GLES2Implementation::TexSubImage2DImpl(
     GLint num_rows = ComputeNumRowsThatFitInBuffer(
         padded_row_size, unpadded_row_size, buffer->size());
     num_rows = std::min(num_rows, height);
+    if (num_rows == 0) {
+      SetGLError(GL_OUT_OF_MEMORY, "glTexSubImage2D: row too large");
+      return;
+    }
     GLint y;
     if (unpack_flip_y_) {
       CopyRectToBufferFlipped(
@@ -2213,6 +2223,10 @@ void GLES2Implementation::ReadPixels(
     GLint num_rows = ComputeNumRowsThatFitInBuffer(
         padded_row_size, unpadded_row_size, buffer.size());
     num_rows = std::min(num_rows, height);
+    if (num_rows == 0) {
+      SetGLError(GL_OUT_OF_MEMORY, "glReadPixels: row too large");
+      return;
+    }
     // NOTE: We must look up the address of the result area AFTER allocation
     // of the transfer buffer since the transfer buffer may be reallocated.
     Result* result = GetResultAs<Result*>();
@@ -2585,12 +2599,14 @@ GLboolean GLES2Implementation::EnableFeatureCHROMIUM(
                  << feature << ")");
   TRACE_EVENT0("gpu", "GLES2::EnableFeatureCHROMIUM");
   typedef EnableFeatureCHROMIUM::Result Result;
+  // NOTE: We must look up the address of the result area AFTER allocation
+  // of the transfer buffer since the transfer buffer may be reallocated.
+  SetBucketAsCString(kResultBucketId, feature);
   Result* result = GetResultAs<Result*>();
   if (!result) {
     return false;
   }
   *result = 0;
-  SetBucketAsCString(kResultBucketId, feature);
   helper_->EnableFeatureCHROMIUM(
       kResultBucketId, GetResultShmId(), GetResultShmOffset());
   WaitForCmd();
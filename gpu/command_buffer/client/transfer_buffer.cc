@@ -9,6 +9,12 @@
 
 namespace gpu {
 
+// GCC requires these declarations, but MSVC requires they not be present
+#ifndef _MSC_VER
+const unsigned int TransferBuffer::kShrinkCheckInterval;
+const unsigned int TransferBuffer::kShrinkQuietChecks;
+#endif
+
 AlignedRingBuffer::~AlignedRingBuffer() {
 }
 
@@ -22,7 +28,11 @@ TransferBuffer::TransferBuffer(
       buffer_id_(-1),
       result_buffer_(NULL),
       result_shm_offset_(0),
-      usable_(true) {
+      usable_(true),
+      outstanding_allocations_(0),
+      allocations_since_shrink_check_(0),
+      largest_recent_allocation_(0),
+      quiet_shrink_checks_(0) {
 }
 
 TransferBuffer::~TransferBuffer() {
@@ -53,6 +63,7 @@ void TransferBuffer::Free() {
     result_buffer_ = NULL;
     result_shm_offset_ = 0;
     ring_buffer_.reset();
+    outstanding_allocations_ = 0;
   }
 }
 
@@ -66,6 +77,8 @@ RingBuffer::Offset TransferBuffer::GetOffset(void* pointer) const {
 
 void TransferBuffer::FreePendingToken(void* p, unsigned int token) {
   ring_buffer_->FreePendingToken(p, token);
+  GPU_DCHECK_GT(outstanding_allocations_, 0u);
+  --outstanding_allocations_;
 }
 
 void TransferBuffer::AllocateRingBuffer(unsigned int size) {
@@ -137,22 +150,65 @@ void TransferBuffer::ReallocateRingBuffer(unsigned int size) {
   }
 }
 
+void TransferBuffer::RecordAllocation(unsigned int size) {
+  largest_recent_allocation_ = std::max(
+      largest_recent_allocation_, std::min(size, max_buffer_size_));
+  if (++allocations_since_shrink_check_ < kShrinkCheckInterval) {
+    return;
+  }
+
+  allocations_since_shrink_check_ = 0;
+
+  // Leave room for two of the largest allocations so that one can be filled
+  // while the service reads the other. Reallocating means waiting for the
+  // service to finish, so only shrink when that frees most of the buffer, and
+  // never while an allocation is still in use.
+  unsigned int needed_buffer_size =
+      ComputePOTSize(2 * largest_recent_allocation_ + result_size_);
+  needed_buffer_size = std::max(needed_buffer_size, min_buffer_size_);
+  if (!HaveBuffer() || needed_buffer_size * 4 > buffer_.size) {
+    quiet_shrink_checks_ = 0;
+    largest_recent_allocation_ = 0;
+    return;
+  }
+
+  // Periodic large uploads would otherwise make the buffer shrink and grow
+  // again around each one, so wait for several quiet intervals in a row.
+  if (++quiet_shrink_checks_ < kShrinkQuietChecks ||
+      outstanding_allocations_ != 0) {
+    return;
+  }
+  Free();
+  AllocateRingBuffer(needed_buffer_size);
+  quiet_shrink_checks_ = 0;
+  largest_recent_allocation_ = 0;
+}
+
 void* TransferBuffer::AllocUpTo(
     unsigned int size, unsigned int* size_allocated) {
   GPU_DCHECK(size_allocated);
 
+  RecordAllocation(size);
   ReallocateRingBuffer(size);
 
   if (!HaveBuffer()) {
     return NULL;
   }
 
+  // If the request is split anyway, use at most half the buffer so that the
+  // next part can be copied in while the service still reads this one,
+  // instead of waiting on its token.
   unsigned int max_size = ring_buffer_->GetLargestFreeOrPendingSize();
+  if (size > max_size && max_size / 2 >= alignment_) {
+    max_size = (max_size / 2) & ~(alignment_ - 1);
+  }
   *size_allocated = std::min(max_size, size);
+  ++outstanding_allocations_;
   return ring_buffer_->Alloc(*size_allocated);
 }
 
 void* TransferBuffer::Alloc(unsigned int size) {
+  RecordAllocation(size);
   ReallocateRingBuffer(size);
 
   if (!HaveBuffer()) {
@@ -164,6 +220,7 @@ void* TransferBuffer::Alloc(unsigned int size) {
     return NULL;
   }
 
+  ++outstanding_allocations_;
   return ring_buffer_->Alloc(size);
 }
 
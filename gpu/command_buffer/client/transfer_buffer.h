@@ -110,10 +110,23 @@ class TransferBuffer : public TransferBufferInterface {
   unsigned int GetCurrentMaxAllocationWithoutRealloc() const;
   unsigned int GetMaxAllocation() const;
 
+  // Number of allocations between checks for shrinking the buffer.
+  static const unsigned int kShrinkCheckInterval = 256;
+
+  // Number of consecutive checks that must find the buffer much larger than
+  // needed before it shrinks.
+  static const unsigned int kShrinkQuietChecks = 4;
+
  private:
   // Tries to reallocate the ring buffer if it's not large enough for size.
   void ReallocateRingBuffer(unsigned int size);
 
+  // Records the size of an allocation request. Every kShrinkCheckInterval
+  // requests, checks whether the ring buffer is much larger than the largest
+  // request since the buffer was last needed, and shrinks it once that has
+  // held for kShrinkQuietChecks checks in a row.
+  void RecordAllocation(unsigned int size);
+
   void AllocateRingBuffer(unsigned int size);
 
   CommandBufferHelper* helper_;
@@ -145,6 +158,19 @@ class TransferBuffer : public TransferBufferInterface {
 
   // false if we failed to allocate min_buffer_size
   bool usable_;
+
+  // number of ring buffer allocations not yet freed
+  unsigned int outstanding_allocations_;
+
+  // allocations requested since the last shrink check
+  unsigned int allocations_since_shrink_check_;
+
+  // largest allocation requested since the last shrink check that found the
+  // buffer needed
+  unsigned int largest_recent_allocation_;
+
+  // consecutive shrink checks that found the buffer much larger than needed
+  unsigned int quiet_shrink_checks_;
 };
 
 // A class that will manage the lifetime of a transferbuffer allocation.
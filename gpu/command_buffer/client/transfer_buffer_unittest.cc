@@ -0,0 +1,172 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Tests for the TransferBuffer class.
+
+#include "gpu/command_buffer/client/transfer_buffer.h"
+
+#include "gpu/command_buffer/client/client_test_helper.h"
+#include "gpu/command_buffer/client/cmd_buffer_helper.h"
+#include "gpu/command_buffer/common/command_buffer.h"
+#include "gpu/command_buffer/common/compiler_specific.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/gmock/include/gmock/gmock.h"
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::StrictMock;
+
+namespace gpu {
+
+class TransferBufferTest : public testing::Test {
+ protected:
+  static const int32 kNumCommandEntries = 400;
+  static const int32 kCommandBufferSizeBytes =
+      kNumCommandEntries * sizeof(CommandBufferEntry);
+  static const unsigned int kStartingOffset = 64;
+  static const unsigned int kAlignment = 4;
+  static const unsigned int kStartTransferBufferSize = 64 * 1024;
+  static const unsigned int kMinTransferBufferSize = 16 * 1024;
+  static const unsigned int kMaxTransferBufferSize = 1024 * 1024;
+
+  virtual void SetUp() OVERRIDE {
+    command_buffer_.reset(new StrictMock<MockClientCommandBuffer>());
+    ASSERT_TRUE(command_buffer_->Initialize());
+
+    helper_.reset(new CommandBufferHelper(command_buffer()));
+    ASSERT_TRUE(helper_->Initialize(kCommandBufferSizeBytes));
+
+    // Reallocating the transfer buffer waits for the service to finish.
+    EXPECT_CALL(*command_buffer(), OnFlush())
+        .Times(AnyNumber());
+    EXPECT_CALL(*command_buffer(), DestroyTransferBuffer(_))
+        .Times(AnyNumber());
+
+    transfer_buffer_.reset(new TransferBuffer(helper_.get()));
+    ASSERT_TRUE(transfer_buffer_->Initialize(
+        kStartTransferBufferSize,
+        kStartingOffset,
+        kMinTransferBufferSize,
+        kMaxTransferBufferSize,
+        kAlignment));
+  }
+
+  virtual void TearDown() OVERRIDE {
+    transfer_buffer_.reset();
+  }
+
+  MockClientCommandBuffer* command_buffer() const {
+    return command_buffer_.get();
+  }
+
+  // Allocates |size| bytes and frees them pending a token.
+  void AllocAndFree(unsigned int size) {
+    void* ptr = transfer_buffer_->Alloc(size);
+    ASSERT_TRUE(ptr != NULL);
+    transfer_buffer_->FreePendingToken(ptr, helper_->InsertToken());
+  }
+
+  scoped_ptr<MockClientCommandBuffer> command_buffer_;
+  scoped_ptr<CommandBufferHelper> helper_;
+  scoped_ptr<TransferBuffer> transfer_buffer_;
+};
+
+// GCC requires these declarations, but MSVC requires they not be present
+#ifndef _MSC_VER
+const int32 TransferBufferTest::kNumCommandEntries;
+const int32 TransferBufferTest::kCommandBufferSizeBytes;
+const unsigned int TransferBufferTest::kStartingOffset;
+const unsigned int TransferBufferTest::kAlignment;
+const unsigned int TransferBufferTest::kStartTransferBufferSize;
+const unsigned int TransferBufferTest::kMinTransferBufferSize;
+const unsigned int TransferBufferTest::kMaxTransferBufferSize;
+#endif
+
+TEST_F(TransferBufferTest, GrowsForLargeAllocations) {
+  EXPECT_EQ(kStartTransferBufferSize - kStartingOffset,
+            transfer_buffer_->GetCurrentMaxAllocationWithoutRealloc());
+  AllocAndFree(kStartTransferBufferSize * 2);
+  EXPECT_EQ(kStartTransferBufferSize * 4 - kStartingOffset,
+            transfer_buffer_->GetCurrentMaxAllocationWithoutRealloc());
+}
+
+TEST_F(TransferBufferTest, SplitsRequestsLargerThanTheBuffer) {
+  const unsigned int kSize = kMaxTransferBufferSize * 2;
+  const unsigned int kHalf =
+      ((kMaxTransferBufferSize - kStartingOffset) / 2) & ~(kAlignment - 1);
+
+  // The buffer grows to its maximum size, and each part of the request gets
+  // half of it, so that consecutive parts don't wait on each other.
+  unsigned int size_allocated = 0;
+  void* ptr1 = transfer_buffer_->AllocUpTo(kSize, &size_allocated);
+  ASSERT_TRUE(ptr1 != NULL);
+  EXPECT_EQ(kHalf, size_allocated);
+  EXPECT_EQ(kMaxTransferBufferSize - kStartingOffset,
+            transfer_buffer_->GetCurrentMaxAllocationWithoutRealloc());
+  transfer_buffer_->FreePendingToken(ptr1, helper_->InsertToken());
+
+  void* ptr2 = transfer_buffer_->AllocUpTo(kSize - kHalf, &size_allocated);
+  ASSERT_TRUE(ptr2 != NULL);
+  EXPECT_EQ(kHalf, size_allocated);
+  EXPECT_EQ(static_cast<int8*>(ptr1) + kHalf, ptr2);
+  transfer_buffer_->FreePendingToken(ptr2, helper_->InsertToken());
+
+  // Requests that fit are not split.
+  void* ptr3 = transfer_buffer_->AllocUpTo(kHalf + 1, &size_allocated);
+  ASSERT_TRUE(ptr3 != NULL);
+  EXPECT_EQ(kHalf + 1, size_allocated);
+  transfer_buffer_->FreePendingToken(ptr3, helper_->InsertToken());
+}
+
+TEST_F(TransferBufferTest, ShrinksAfterSmallAllocations) {
+  AllocAndFree(kMaxTransferBufferSize / 2);
+  EXPECT_EQ(kMaxTransferBufferSize - kStartingOffset,
+            transfer_buffer_->GetCurrentMaxAllocationWithoutRealloc());
+
+  // Large allocations keep the buffer.
+  for (unsigned int ii = 0; ii < TransferBuffer::kShrinkCheckInterval; ++ii) {
+    AllocAndFree(ii % 2 ? 100 : kMaxTransferBufferSize / 4);
+  }
+  EXPECT_EQ(kMaxTransferBufferSize - kStartingOffset,
+            transfer_buffer_->GetCurrentMaxAllocationWithoutRealloc());
+
+  // Small allocations shrink it down to the minimum size, once they have
+  // kept it idle for several checks in a row.
+  const unsigned int kQuietAllocations =
+      TransferBuffer::kShrinkCheckInterval * TransferBuffer::kShrinkQuietChecks;
+  for (unsigned int ii = 0;
+       ii < kQuietAllocations - TransferBuffer::kShrinkCheckInterval; ++ii) {
+    AllocAndFree(100);
+  }
+  EXPECT_EQ(kMaxTransferBufferSize - kStartingOffset,
+            transfer_buffer_->GetCurrentMaxAllocationWithoutRealloc());
+  for (unsigned int ii = 0; ii < TransferBuffer::kShrinkCheckInterval; ++ii) {
+    AllocAndFree(100);
+  }
+  EXPECT_EQ(kMinTransferBufferSize - kStartingOffset,
+            transfer_buffer_->GetCurrentMaxAllocationWithoutRealloc());
+
+  // And it grows again when needed.
+  AllocAndFree(kMaxTransferBufferSize / 2);
+  EXPECT_EQ(kMaxTransferBufferSize - kStartingOffset,
+            transfer_buffer_->GetCurrentMaxAllocationWithoutRealloc());
+}
+
+// Tests that a large upload every few hundred small allocations keeps the
+// buffer, instead of shrinking it between uploads and growing it again.
+TEST_F(TransferBufferTest, KeepsBufferForPeriodicLargeUploads) {
+  const unsigned int kSmallAllocationsBetweenUploads =
+      TransferBuffer::kShrinkCheckInterval + 44;
+  for (int upload = 0; upload < 8; ++upload) {
+    AllocAndFree(kMaxTransferBufferSize / 2);
+    for (unsigned int ii = 0; ii < kSmallAllocationsBetweenUploads; ++ii) {
+      AllocAndFree(100);
+    }
+    EXPECT_EQ(kMaxTransferBufferSize - kStartingOffset,
+              transfer_buffer_->GetCurrentMaxAllocationWithoutRealloc())
+        << "after upload " << upload;
+  }
+}
+
+}  // namespace gpu
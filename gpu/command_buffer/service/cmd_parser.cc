@@ -10,6 +10,14 @@
 
 namespace gpu {
 
+namespace {
+
+// Stands for no command in ProcessCommands(). Command indices are much
+// smaller.
+const unsigned int kNoCommand = ~0u;
+
+}  // namespace
+
 CommandParser::CommandParser(AsyncAPIInterface* handler)
     : get_(0),
       put_(0),
@@ -81,15 +89,53 @@ void CommandParser::ReportError(unsigned int command_id,
            << handler_->GetCommandName(command_id);
 }
 
+// Processes a run of commands in a single call to the handler. The run ends
+// at |put_| or at the end of the buffer, whichever comes first, so that the
+// handler sees the commands as one contiguous array.
+error::Error CommandParser::ProcessCommands(int num_commands) {
+  CommandBufferOffset get = get_;
+  if (get == put_)
+    return error::kNoError;
+
+  int num_entries = (put_ > get && put_ < entry_count_) ? put_ - get :
+                                                          entry_count_ - get;
+  int entries_processed = 0;
+  unsigned int error_command = kNoCommand;
+  error::Error result = handler_->DoCommands(
+      num_commands, buffer_ + get, num_entries, &entries_processed,
+      &error_command);
+
+  // Header errors were logged by the handler, like ProcessCommand() does.
+  if (error::IsError(result) && error_command != kNoCommand) {
+    ReportError(error_command, result);
+  }
+
+  // If get was not set somewhere else advance it.
+  if (get == get_)
+    get_ = (get + entries_processed) % entry_count_;
+  return result;
+}
+
 // Processes all the commands, while the buffer is not empty. Stop if an error
-// is encountered.
+// is encountered. A run can't hold more commands than the buffer has entries,
+// so each call processes as many commands as it can.
 error::Error CommandParser::ProcessAllCommands() {
   while (!IsEmpty()) {
-    error::Error error = ProcessCommand();
+    error::Error error = ProcessCommands(entry_count_);
     if (error)
       return error;
   }
   return error::kNoError;
 }
 
+error::Error AsyncAPIInterface::DoCommands(unsigned int num_commands,
+                                           const void* buffer,
+                                           int num_entries,
+                                           int* entries_processed,
+                                           unsigned int* error_command) {
+  return RunCommands<AsyncAPIInterface, &AsyncAPIInterface::DoCommand>(
+      this, num_commands, buffer, num_entries, entries_processed,
+      error_command);
+}
+
 }  // namespace gpu
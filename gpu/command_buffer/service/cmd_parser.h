@@ -7,6 +7,7 @@
 #ifndef GPU_COMMAND_BUFFER_SERVICE_CMD_PARSER_H_
 #define GPU_COMMAND_BUFFER_SERVICE_CMD_PARSER_H_
 
+#include "base/logging.h"
 #include "gpu/command_buffer/common/constants.h"
 #include "gpu/command_buffer/common/cmd_buffer_common.h"
 
@@ -56,7 +57,14 @@ class CommandParser {
   // if there are no commands in the buffer.
   error::Error ProcessCommand();
 
-  // Processes all commands until get == put.
+  // Processes up to |num_commands| commands in one call to the handler,
+  // updating the get pointer. A batch never wraps around the end of the
+  // buffer, and ends early at an error, at a deferred command, after a
+  // command that moves the get pointer or after the handler's
+  // ExitCommandProcessingEarly() is called.
+  error::Error ProcessCommands(int num_commands);
+
+  // Processes all commands until get == put, a run at a time.
   error::Error ProcessAllCommands();
 
   // Reports an error.
@@ -74,7 +82,7 @@ class CommandParser {
 // is responsible for de-multiplexing commands and their arguments.
 class AsyncAPIInterface {
  public:
-  AsyncAPIInterface() {}
+  AsyncAPIInterface() : exit_run_early_(false) {}
   virtual ~AsyncAPIInterface() {}
 
   // Executes a command.
@@ -90,8 +98,103 @@ class AsyncAPIInterface {
       unsigned int arg_count,
       const void* cmd_data) = 0;
 
+  // Executes a run of commands.
+  // Parameters:
+  //    num_commands: the maximum number of commands to execute.
+  //    buffer: the first command, as an array of CommandBufferEntry.
+  //    num_entries: the number of entries available in |buffer|.
+  //    entries_processed: set to the number of entries consumed by the
+  //        commands that were executed.
+  //    error_command: set to the command index of the command that returned
+  //        an error, if one did. Left unchanged for header errors.
+  // Returns:
+  //   error::kNoError if no error was found, the error of the command that
+  //   stopped the run otherwise. A command that fails is consumed, a command
+  //   that is deferred or has an invalid header is not.
+  // The default implementation calls DoCommand() through RunCommands().
+  virtual error::Error DoCommands(
+      unsigned int num_commands,
+      const void* buffer,
+      int num_entries,
+      int* entries_processed,
+      unsigned int* error_command);
+
   // Returns a name for a command. Useful for logging / debuging.
   virtual const char* GetCommandName(unsigned int command_id) const = 0;
+
+  // Ends the run DoCommands() is executing after the current command. Called
+  // when a command unschedules the scheduler that is processing the run.
+  void ExitCommandProcessingEarly() { exit_run_early_ = true; }
+
+ protected:
+  // Returns true if |command| is a common command that may set the get
+  // pointer. DoCommands() implementations execute such a command only as the
+  // first of a run, and end the run after it, so that the parser can tell
+  // whether to advance the get pointer.
+  static bool IsGetOffsetCommand(unsigned int command) {
+    return command >= cmd::kJump && command <= cmd::kReturn;
+  }
+
+  // Implements DoCommands() by calling |execute| on |handler| for each
+  // command. The headers are validated the same way
+  // CommandParser::ProcessCommand() does. Making |execute| a template
+  // parameter lets implementations run commands without a virtual call each.
+  template <typename T,
+            error::Error (T::*execute)(unsigned int command,
+                                       unsigned int arg_count,
+                                       const void* cmd_data)>
+  static error::Error RunCommands(T* handler,
+                                  unsigned int num_commands,
+                                  const void* buffer,
+                                  int num_entries,
+                                  int* entries_processed,
+                                  unsigned int* error_command) {
+    const CommandBufferEntry* cmd_data =
+        static_cast<const CommandBufferEntry*>(buffer);
+    int process_pos = 0;
+    error::Error result = error::kNoError;
+    handler->exit_run_early_ = false;
+
+    for (unsigned int i = 0; i < num_commands && process_pos < num_entries;
+         ++i) {
+      CommandHeader header = cmd_data[process_pos].value_header;
+      if (header.size == 0) {
+        DVLOG(1) << "Error: zero sized command in command buffer";
+        result = error::kInvalidSize;
+        break;
+      }
+
+      if (static_cast<int>(header.size) + process_pos > num_entries) {
+        DVLOG(1) << "Error: get offset out of bounds";
+        result = error::kOutOfBounds;
+        break;
+      }
+
+      bool sets_get = IsGetOffsetCommand(header.command);
+      if (sets_get && i > 0)
+        break;
+
+      result = (handler->*execute)(header.command, header.size - 1,
+                                   cmd_data + process_pos);
+      if (result == error::kDeferCommandUntilSwapBuffersAck)
+        break;
+
+      process_pos += header.size;
+      if (error::IsError(result)) {
+        *error_command = header.command;
+        break;
+      }
+      if (sets_get || handler->exit_run_early_)
+        break;
+    }
+
+    *entries_processed = process_pos;
+    return result;
+  }
+
+ private:
+  // Set by ExitCommandProcessingEarly() to end the current run.
+  bool exit_run_early_;
 };
 
 }  // namespace gpu
@@ -12,6 +12,8 @@
 
 namespace gpu {
 
+using testing::DoAll;
+using testing::InvokeWithoutArgs;
 using testing::Return;
 using testing::Mock;
 using testing::Truly;
@@ -286,6 +288,166 @@ TEST_F(CommandParserTest, TestError) {
   Mock::VerifyAndClearExpectations(api_mock());
 }
 
+// Tests processing runs of commands.
+TEST_F(CommandParserTest, TestProcessCommands) {
+  scoped_ptr<CommandParser> parser(MakeParser(10));
+  CommandBufferOffset put = parser->put();
+  CommandHeader header;
+
+  // add 3 commands.
+  header.size = 2;
+  header.command = 123;
+  buffer()[put++].value_header = header;
+  buffer()[put++].value_int32 = 5151;
+
+  header.size = 1;
+  header.command = 456;
+  buffer()[put++].value_header = header;
+  CommandBufferOffset put_cmd3 = put;
+
+  header.size = 2;
+  header.command = 789;
+  buffer()[put++].value_header = header;
+  buffer()[put++].value_int32 = 3434;
+
+  parser->set_put(put);
+  EXPECT_EQ(put, parser->put());
+
+  CommandBufferEntry param_array[2];
+  param_array[0].value_int32 = 5151;
+  param_array[1].value_int32 = 3434;
+  AddDoCommandExpect(error::kNoError, 123, 1, param_array);
+  AddDoCommandExpect(error::kNoError, 456, 0, NULL);
+  AddDoCommandExpect(error::kNoError, 789, 1, param_array + 1);
+
+  // The first run is limited to 2 commands.
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(2));
+  EXPECT_EQ(put_cmd3, parser->get());
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(100));
+  EXPECT_EQ(put, parser->get());
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(100));
+  EXPECT_EQ(put, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+
+  // add a command that may set the get pointer between 2 commands. It has to
+  // be processed in a run of its own.
+  header.size = 1;
+  header.command = 123;
+  buffer()[put++].value_header = header;
+  CommandBufferOffset put_jump = put;
+  header.command = cmd::kJumpRelative;
+  buffer()[put++].value_header = header;
+  CommandBufferOffset put_post_jump = put;
+  header.command = 456;
+  buffer()[put++].value_header = header;
+
+  parser->set_put(put);
+  AddDoCommandExpect(error::kNoError, 123, 0, NULL);
+  AddDoCommandExpect(error::kNoError, cmd::kJumpRelative, 0, NULL);
+  AddDoCommandExpect(error::kNoError, 456, 0, NULL);
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(100));
+  EXPECT_EQ(put_jump, parser->get());
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(100));
+  EXPECT_EQ(put_post_jump, parser->get());
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(100));
+  EXPECT_EQ(put, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+}
+
+// Tests that a run ends after a command that asks for it to end early, as
+// one that unschedules the scheduler does.
+TEST_F(CommandParserTest, TestProcessCommandsExitEarly) {
+  scoped_ptr<CommandParser> parser(MakeParser(10));
+  CommandBufferOffset put = parser->put();
+  CommandHeader header;
+
+  header.size = 1;
+  header.command = 123;
+  buffer()[put++].value_header = header;
+  CommandBufferOffset put_cmd2 = put;
+  header.command = 456;
+  buffer()[put++].value_header = header;
+  parser->set_put(put);
+
+  EXPECT_CALL(*api_mock(), DoCommand(123, 0, _))
+      .WillOnce(DoAll(
+          InvokeWithoutArgs(api_mock(),
+                            &AsyncAPIInterface::ExitCommandProcessingEarly),
+          Return(error::kNoError)));
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(100));
+  EXPECT_EQ(put_cmd2, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+
+  // The next run starts over.
+  AddDoCommandExpect(error::kNoError, 456, 0, NULL);
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(100));
+  EXPECT_EQ(put, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+}
+
+// Tests that runs of commands stop at the end of the buffer.
+TEST_F(CommandParserTest, TestProcessCommandsWrap) {
+  scoped_ptr<CommandParser> parser(MakeParser(5));
+  CommandBufferOffset put = 3;
+  CommandHeader header;
+
+  // add 2 commands at the end of the buffer, and 1 at the start.
+  EXPECT_TRUE(parser->set_get(put));
+  header.size = 1;
+  for (unsigned int i = 0; i < 2; ++i) {
+    header.command = 100 + i;
+    buffer()[put++].value_header = header;
+    AddDoCommandExpect(error::kNoError, 100 + i, 0, NULL);
+  }
+  put = 0;
+  header.command = 102;
+  buffer()[put++].value_header = header;
+  AddDoCommandExpect(error::kNoError, 102, 0, NULL);
+
+  parser->set_put(put);
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(100));
+  EXPECT_EQ(0, parser->get());
+  EXPECT_EQ(error::kNoError, parser->ProcessCommands(100));
+  EXPECT_EQ(put, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+}
+
+// Tests error conditions when processing runs of commands.
+TEST_F(CommandParserTest, TestProcessCommandsError) {
+  scoped_ptr<CommandParser> parser(MakeParser(5));
+  CommandBufferOffset put = parser->put();
+  CommandHeader header;
+
+  // Generates 3 commands, the second one fails.
+  header.size = 1;
+  header.command = 123;
+  buffer()[put++].value_header = header;
+  header.command = 456;
+  buffer()[put++].value_header = header;
+  CommandBufferOffset put_post_fail = put;
+  header.command = 789;
+  buffer()[put++].value_header = header;
+
+  parser->set_put(put);
+  AddDoCommandExpect(error::kNoError, 123, 0, NULL);
+  AddDoCommandExpect(error::kUnknownCommand, 456, 0, NULL);
+  EXPECT_EQ(error::kUnknownCommand, parser->ProcessCommands(100));
+  // check that the failed command was consumed, and that the last one was
+  // not executed.
+  EXPECT_EQ(put_post_fail, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+
+  // Generate a command with size 0.
+  header.size = 0;
+  header.command = 123;
+  buffer()[put++].value_header = header;
+  parser->set_put(put);
+  AddDoCommandExpect(error::kNoError, 789, 0, NULL);
+  EXPECT_EQ(error::kInvalidSize, parser->ProcessCommands(100));
+  EXPECT_EQ(put - 1, parser->get());
+  Mock::VerifyAndClearExpectations(api_mock());
+}
+
 TEST_F(CommandParserTest, SetBuffer) {
   scoped_ptr<CommandParser> parser(MakeParser(3));
   CommandBufferOffset put = parser->put();
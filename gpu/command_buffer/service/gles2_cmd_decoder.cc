@@ -114,23 +114,6 @@ bool ComputeDataSize(
   return true;
 }
 
-// A struct to hold info about each command.
-struct CommandInfo {
-  int arg_flags;  // How to handle the arguments for this command
-  int arg_count;  // How many arguments are expected for this command.
-};
-
-// A table of CommandInfo for all the commands.
-const CommandInfo g_command_info[] = {
-  #define GLES2_CMD_OP(name) {                                            \
-    name::kArgFlags,                                                      \
-    sizeof(name) / sizeof(CommandBufferEntry) - 1, },  /* NOLINT */       \
-
-  GLES2_COMMAND_LIST(GLES2_CMD_OP)
-
-  #undef GLES2_CMD_OP
-};
-
 static bool IsAngle() {
 #if defined(OS_WIN)
   return gfx::GetGLImplementation() == gfx::kGLImplementationEGLGLES2;
@@ -502,12 +485,42 @@ bool GLES2Decoder::GetServiceTextureId(uint32 client_texture_id,
 
 GLES2Decoder::GLES2Decoder()
     : debug_(false),
-      log_commands_(false) {
+      log_commands_(false),
+      collect_command_stats_(false) {
 }
 
 GLES2Decoder::~GLES2Decoder() {
 }
 
+void GLES2Decoder::set_collect_command_stats(bool collect_command_stats) {
+  collect_command_stats_ = collect_command_stats;
+  if (collect_command_stats_ && command_stats_.empty())
+    command_stats_.resize(kNumCommands);
+}
+
+GLES2Decoder::CommandStats GLES2Decoder::GetCommandStats(
+    unsigned int command_id) const {
+  if (command_id < command_stats_.size())
+    return command_stats_[command_id];
+  return CommandStats();
+}
+
+void GLES2Decoder::ResetCommandStats() {
+  std::fill(command_stats_.begin(), command_stats_.end(), CommandStats());
+}
+
+void GLES2Decoder::LogCommandStats() const {
+  for (size_t i = 0; i < command_stats_.size(); ++i) {
+    const CommandStats& stats = command_stats_[i];
+    if (stats.count) {
+      LOG(INFO) << "[" << this << "]" << "cmd: "
+                << GetCommandName(static_cast<unsigned int>(i))
+                << " count: " << stats.count
+                << " time: " << stats.time.InMillisecondsF() << "ms";
+    }
+  }
+}
+
 // This class implements GLES2Decoder so we don't have to expose all the GLES2
 // cmd stuff to outside this class.
 class GLES2DecoderImpl : public base::SupportsWeakPtr<GLES2DecoderImpl>,
@@ -521,6 +534,13 @@ class GLES2DecoderImpl : public base::SupportsWeakPtr<GLES2DecoderImpl>,
                           unsigned int arg_count,
                           const void* args);
 
+  // Overridden from AsyncAPIInterface.
+  virtual Error DoCommands(unsigned int num_commands,
+                           const void* buffer,
+                           int num_entries,
+                           int* entries_processed,
+                           unsigned int* error_command);
+
   // Overridden from AsyncAPIInterface.
   virtual const char* GetCommandName(unsigned int command_id) const;
 
@@ -1341,6 +1361,39 @@ class GLES2DecoderImpl : public base::SupportsWeakPtr<GLES2DecoderImpl>,
 
   #undef GLES2_CMD_OP
 
+  // Calls the handler of command T with the command data cast to T.
+  template <typename T, Error (GLES2DecoderImpl::*handler)(uint32, const T&)>
+  Error DispatchCommand(uint32 immediate_data_size, const void* cmd_data) {
+    return (this->*handler)(immediate_data_size,
+                            *static_cast<const T*>(cmd_data));
+  }
+
+  // Validates the argument count of a command, and calls its handler or
+  // DoCommonCommand().
+  Error ExecuteCommand(unsigned int command,
+                       unsigned int arg_count,
+                       const void* cmd_data);
+
+  // Calls ExecuteCommand(), timing it if command stats are collected. Shared
+  // by DoCommand() and DoCommands().
+  Error ExecuteCommandWithStats(unsigned int command,
+                                unsigned int arg_count,
+                                const void* cmd_data);
+
+  typedef Error (GLES2DecoderImpl::*CommandHandler)(uint32 immediate_data_size,
+                                                   const void* cmd_data);
+
+  // A struct to hold info about each command.
+  struct CommandInfo {
+    CommandHandler handler;  // Calls the Handle function for this command.
+    int arg_flags;  // How to handle the arguments for this command
+    int arg_count;  // How many arguments are expected for this command.
+  };
+
+  // A table of CommandInfo for all the commands, indexed by
+  // command id - kStartPoint - 1.
+  static const CommandInfo command_info_[];
+
   // The GL context this decoder renders to on behalf of the client.
   scoped_refptr<gfx::GLSurface> surface_;
   scoped_refptr<gfx::GLContext> context_;
@@ -1525,6 +1578,18 @@ class GLES2DecoderImpl : public base::SupportsWeakPtr<GLES2DecoderImpl>,
   DISALLOW_COPY_AND_ASSIGN(GLES2DecoderImpl);
 };
 
+const GLES2DecoderImpl::CommandInfo GLES2DecoderImpl::command_info_[] = {
+  #define GLES2_CMD_OP(name) {                                            \
+    &GLES2DecoderImpl::DispatchCommand<name,                              \
+                                       &GLES2DecoderImpl::Handle ## name>, \
+    name::kArgFlags,                                                      \
+    sizeof(name) / sizeof(CommandBufferEntry) - 1, },  /* NOLINT */       \
+
+  GLES2_COMMAND_LIST(GLES2_CMD_OP)
+
+  #undef GLES2_CMD_OP
+};
+
 ScopedGLErrorSuppressor::ScopedGLErrorSuppressor(GLES2DecoderImpl* decoder)
     : decoder_(decoder) {
   decoder_->CopyRealGLErrorsToWrapper();
@@ -3060,29 +3125,52 @@ error::Error GLES2DecoderImpl::DoCommand(
     unsigned int command,
     unsigned int arg_count,
     const void* cmd_data) {
+  return ExecuteCommandWithStats(command, arg_count, cmd_data);
+}
+
+// Same as DoCommand() for a run of commands, without a virtual call and a
+// return to the parser per command.
+error::Error GLES2DecoderImpl::DoCommands(unsigned int num_commands,
+                                          const void* buffer,
+                                          int num_entries,
+                                          int* entries_processed,
+                                          unsigned int* error_command) {
+  return RunCommands<GLES2DecoderImpl,
+                     &GLES2DecoderImpl::ExecuteCommandWithStats>(
+      this, num_commands, buffer, num_entries, entries_processed,
+      error_command);
+}
+
+error::Error GLES2DecoderImpl::ExecuteCommandWithStats(
+    unsigned int command,
+    unsigned int arg_count,
+    const void* cmd_data) {
+  if (!collect_command_stats())
+    return ExecuteCommand(command, arg_count, cmd_data);
+
+  base::TimeTicks start = base::TimeTicks::HighResNow();
+  error::Error result = ExecuteCommand(command, arg_count, cmd_data);
+  RecordCommandStats(command, base::TimeTicks::HighResNow() - start);
+  return result;
+}
+
+error::Error GLES2DecoderImpl::ExecuteCommand(
+    unsigned int command,
+    unsigned int arg_count,
+    const void* cmd_data) {
   error::Error result = error::kNoError;
   if (log_commands()) {
     LOG(INFO) << "[" << this << "]" << "cmd: " << GetCommandName(command);
   }
   unsigned int command_index = command - kStartPoint - 1;
-  if (command_index < arraysize(g_command_info)) {
-    const CommandInfo& info = g_command_info[command_index];
+  if (command_index < arraysize(command_info_)) {
+    const CommandInfo& info = command_info_[command_index];
     unsigned int info_arg_count = static_cast<unsigned int>(info.arg_count);
     if ((info.arg_flags == cmd::kFixed && arg_count == info_arg_count) ||
         (info.arg_flags == cmd::kAtLeastN && arg_count >= info_arg_count)) {
       uint32 immediate_data_size =
           (arg_count - info_arg_count) * sizeof(CommandBufferEntry);  // NOLINT
-      switch (command) {
-        #define GLES2_CMD_OP(name)                                 \
-          case name::kCmdId:                                       \
-            result = Handle ## name(                               \
-                immediate_data_size,                               \
-                *static_cast<const name*>(cmd_data));              \
-            break;                                                 \
-
-        GLES2_COMMAND_LIST(GLES2_CMD_OP)
-        #undef GLES2_CMD_OP
-      }
+      result = (this->*info.handler)(immediate_data_size, cmd_data);
       if (debug()) {
         GLenum error;
         while ((error = glGetError()) != GL_NO_ERROR) {
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "base/callback.h"
+#include "base/time.h"
 #include "build/build_config.h"
 #include "gpu/command_buffer/service/common_decoder.h"
 #include "ui/gfx/size.h"
@@ -68,6 +69,31 @@ class GLES2Decoder : public CommonDecoder {
     log_commands_ = log_commands;
   }
 
+  // Counters for one command id.
+  struct CommandStats {
+    CommandStats() : count(0) {}
+
+    int64 count;
+    base::TimeDelta time;
+  };
+
+  bool collect_command_stats() const {
+    return collect_command_stats_;
+  }
+
+  // Set to true to count the commands executed and the time spent in each of
+  // them, per command id.
+  void set_collect_command_stats(bool collect_command_stats);
+
+  // Gets the counters collected for a command id.
+  CommandStats GetCommandStats(unsigned int command_id) const;
+
+  // Clears the counters of all the commands.
+  void ResetCommandStats();
+
+  // LOGs the counters of the commands that were executed.
+  void LogCommandStats() const;
+
   // Initializes the graphics context. Can create an offscreen
   // decoder with a frame buffer that can be referenced from the parent.
   // Takes ownership of GLContext.
@@ -148,9 +174,22 @@ class GLES2Decoder : public CommonDecoder {
  protected:
   GLES2Decoder();
 
+  // Adds a command that took |time| to execute to the counters.
+  void RecordCommandStats(unsigned int command_id, base::TimeDelta time) {
+    if (command_id < command_stats_.size()) {
+      CommandStats& stats = command_stats_[command_id];
+      ++stats.count;
+      stats.time += time;
+    }
+  }
+
  private:
   bool debug_;
   bool log_commands_;
+  bool collect_command_stats_;
+
+  // Counters indexed by command id. Empty until stats are first collected.
+  std::vector<CommandStats> command_stats_;
 
   DISALLOW_COPY_AND_ASSIGN(GLES2Decoder);
 };
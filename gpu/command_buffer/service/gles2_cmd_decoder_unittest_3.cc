@@ -4,6 +4,10 @@
 
 #include "gpu/command_buffer/service/gles2_cmd_decoder.h"
 
+#include <vector>
+
+#include "base/logging.h"
+#include "base/time.h"
 #include "gpu/command_buffer/common/gl_mock.h"
 #include "gpu/command_buffer/common/gles2_cmd_format.h"
 #include "gpu/command_buffer/common/gles2_cmd_utils.h"
@@ -30,8 +34,135 @@ namespace gles2 {
 class GLES2DecoderTest3 : public GLES2DecoderTestBase {
  public:
   GLES2DecoderTest3() { }
+
+ protected:
+  // Fills |commands| with |count| IsBuffer commands, which don't call GL.
+  // Each writes its result to its own slot of shared memory.
+  void MakeIsBufferCommands(int count, std::vector<IsBuffer>* commands) {
+    commands->resize(count);
+    for (int i = 0; i < count; ++i) {
+      (*commands)[i].Init(
+          i % 2 ? client_buffer_id_ : kInvalidClientId, shared_memory_id_,
+          shared_memory_offset_ + (i % 64) * sizeof(IsBuffer::Result));
+    }
+  }
+
+  static int NumEntries(const std::vector<IsBuffer>& commands) {
+    return static_cast<int>(
+        commands.size() * sizeof(IsBuffer) / sizeof(CommandBufferEntry));
+  }
 };
 
+TEST_F(GLES2DecoderTest3, DoCommands) {
+  DoBindBuffer(GL_ARRAY_BUFFER, client_buffer_id_, kServiceBufferId);
+  std::vector<IsBuffer> commands;
+  MakeIsBufferCommands(4, &commands);
+  const int kCommandEntries = NumEntries(commands) / 4;
+  IsBuffer::Result* results = GetSharedMemoryAs<IsBuffer::Result*>();
+
+  // Stops after |num_commands|.
+  int entries_processed = 0;
+  unsigned int error_command = 0;
+  EXPECT_EQ(error::kNoError, decoder_->DoCommands(
+      1, &commands[0], NumEntries(commands), &entries_processed,
+      &error_command));
+  EXPECT_EQ(kCommandEntries, entries_processed);
+  EXPECT_EQ(0u, results[0]);
+  EXPECT_EQ(kInitialResult, results[1]);
+
+  // Stops at the end of the entries.
+  EXPECT_EQ(error::kNoError, decoder_->DoCommands(
+      100, &commands[0], NumEntries(commands), &entries_processed,
+      &error_command));
+  EXPECT_EQ(NumEntries(commands), entries_processed);
+  EXPECT_EQ(1u, results[1]);
+  EXPECT_EQ(1u, results[3]);
+
+  // A command that does not fit in the entries is not executed.
+  EXPECT_EQ(error::kOutOfBounds, decoder_->DoCommands(
+      100, &commands[0], NumEntries(commands) - 1, &entries_processed,
+      &error_command));
+  EXPECT_EQ(3 * kCommandEntries, entries_processed);
+  EXPECT_EQ(0u, error_command);
+
+  // A failing command is consumed and ends the run.
+  commands[2].result_shm_id = kInvalidSharedMemoryId;
+  ClearSharedMemory();
+  EXPECT_EQ(error::kOutOfBounds, decoder_->DoCommands(
+      100, &commands[0], NumEntries(commands), &entries_processed,
+      &error_command));
+  EXPECT_EQ(3 * kCommandEntries, entries_processed);
+  EXPECT_EQ(static_cast<unsigned int>(IsBuffer::kCmdId), error_command);
+  EXPECT_EQ(kInitialResult, results[3]);
+}
+
+TEST_F(GLES2DecoderTest3, CommandStats) {
+  std::vector<IsBuffer> commands;
+  MakeIsBufferCommands(3, &commands);
+  int entries_processed = 0;
+  unsigned int error_command = 0;
+
+  // Nothing is counted until stats are enabled.
+  EXPECT_EQ(error::kNoError, ExecuteCmd(commands[0]));
+  EXPECT_EQ(0, decoder_->GetCommandStats(IsBuffer::kCmdId).count);
+
+  decoder_->set_collect_command_stats(true);
+  EXPECT_EQ(error::kNoError, ExecuteCmd(commands[0]));
+  EXPECT_EQ(error::kNoError, decoder_->DoCommands(
+      100, &commands[0], NumEntries(commands), &entries_processed,
+      &error_command));
+  GLES2Decoder::CommandStats stats =
+      decoder_->GetCommandStats(IsBuffer::kCmdId);
+  EXPECT_EQ(4, stats.count);
+  EXPECT_LE(0, stats.time.InMicroseconds());
+  EXPECT_EQ(0, decoder_->GetCommandStats(IsEnabled::kCmdId).count);
+  EXPECT_EQ(0, decoder_->GetCommandStats(kNumCommands).count);
+
+  decoder_->ResetCommandStats();
+  EXPECT_EQ(0, decoder_->GetCommandStats(IsBuffer::kCmdId).count);
+}
+
+// Compares the rate at which cheap commands are decoded one at a time through
+// DoCommand() and in runs through DoCommands().
+TEST_F(GLES2DecoderTest3, BenchmarkDoCommands) {
+  const int kCommands = 1024;
+  const int kIterations = 1000;
+  const int kCommandsPerRun = 128;
+
+  std::vector<IsBuffer> commands;
+  MakeIsBufferCommands(kCommands, &commands);
+  const int kCommandEntries = NumEntries(commands) / kCommands;
+  const CommandBufferEntry* entries =
+      reinterpret_cast<const CommandBufferEntry*>(&commands[0]);
+
+  base::TimeTicks start = base::TimeTicks::HighResNow();
+  for (int i = 0; i < kIterations; ++i) {
+    for (int j = 0; j < kCommands; ++j) {
+      ASSERT_EQ(error::kNoError, decoder_->DoCommand(
+          IsBuffer::kCmdId, kCommandEntries - 1, &commands[j]));
+    }
+  }
+  base::TimeDelta single = base::TimeTicks::HighResNow() - start;
+
+  start = base::TimeTicks::HighResNow();
+  for (int i = 0; i < kIterations; ++i) {
+    for (int j = 0; j < NumEntries(commands);) {
+      int entries_processed = 0;
+      unsigned int error_command = 0;
+      ASSERT_EQ(error::kNoError, decoder_->DoCommands(
+          kCommandsPerRun, entries + j, NumEntries(commands) - j,
+          &entries_processed, &error_command));
+      j += entries_processed;
+    }
+  }
+  base::TimeDelta batched = base::TimeTicks::HighResNow() - start;
+
+  double total = static_cast<double>(kCommands) * kIterations;
+  LOG(INFO) << "GLES2Decoder: DoCommand "
+            << total / single.InSecondsF() << " commands/s, DoCommands "
+            << total / batched.InSecondsF() << " commands/s";
+}
+
 #include "gpu/command_buffer/service/gles2_cmd_decoder_unittest_3_autogen.h"
 
 }  // namespace gles2
@@ -20,6 +20,10 @@ namespace gpu {
 
 namespace {
 const int64 kRescheduleTimeOutDelay = 100;
+
+// The most commands processed between updates of the get offset and calls to
+// the command processed callback.
+const int kCommandsPerRun = 20;
 }
 
 GpuScheduler::GpuScheduler(
@@ -66,18 +70,19 @@ void GpuScheduler::PutChanged() {
     DCHECK(IsScheduled());
     DCHECK(unschedule_fences_.empty());
 
-    error = parser_->ProcessCommand();
-
-    if (error == error::kDeferCommandUntilSwapBuffersAck) {
-      DCHECK(unscheduled_count_ > 0);
-      return;
-    }
+    // A run ends early if one of its commands unschedules the scheduler.
+    error = parser_->ProcessCommands(kCommandsPerRun);
 
     // TODO(piman): various classes duplicate various pieces of state, leading
     // to needlessly complex update logic. It should be possible to simply
     // share the state across all of them.
     command_buffer_->SetGetOffset(static_cast<int32>(parser_->get()));
 
+    if (error == error::kDeferCommandUntilSwapBuffersAck) {
+      DCHECK(unscheduled_count_ > 0);
+      return;
+    }
+
     if (error::IsError(error)) {
       command_buffer_->SetContextLostReason(decoder_->GetContextLostReason());
       command_buffer_->SetParseError(error);
@@ -118,6 +123,9 @@ void GpuScheduler::SetScheduled(bool scheduled) {
         scheduled_callback_.Run();
     }
   } else {
+    // Don't process the rest of the run if a command unscheduled us.
+    handler_->ExitCommandProcessingEarly();
+
     if (unscheduled_count_ == 0) {
 #if defined(OS_WIN)
       // When the scheduler transitions from scheduled to unscheduled, post a
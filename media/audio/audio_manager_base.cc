@@ -5,10 +5,13 @@
 #include "media/audio/audio_manager_base.h"
 
 #include "base/bind.h"
+#include "base/command_line.h"
 #include "base/message_loop_proxy.h"
 #include "base/threading/thread.h"
 #include "media/audio/audio_output_dispatcher.h"
+#include "media/audio/audio_output_mixer.h"
 #include "media/audio/audio_output_proxy.h"
+#include "media/base/media_switches.h"
 
 static const int kStreamCloseDelaySeconds = 5;
 
@@ -67,9 +70,18 @@ AudioOutputStream* AudioManagerBase::MakeAudioOutputStreamProxy(
 
   scoped_refptr<AudioOutputDispatcher>& dispatcher =
       output_dispatchers_[params];
-  if (!dispatcher)
+  if (!dispatcher) {
+    // Low latency streams wait for their renderers in OnMoreData(), which
+    // would hold up every other stream of a mixer.
+    bool use_mixer =
+        params.format == AudioParameters::AUDIO_PCM_LINEAR &&
+        AudioOutputMixer::IsSupported(params) &&
+        CommandLine::ForCurrentProcess()->HasSwitch(
+            switches::kEnableAudioMixer);
     dispatcher = new AudioOutputDispatcher(
-        this, params, base::TimeDelta::FromSeconds(kStreamCloseDelaySeconds));
+        this, params, base::TimeDelta::FromSeconds(kStreamCloseDelaySeconds),
+        use_mixer);
+  }
   return new AudioOutputProxy(dispatcher);
 }
 
@@ -9,10 +9,11 @@
 #include "base/message_loop.h"
 #include "base/time.h"
 #include "media/audio/audio_io.h"
+#include "media/audio/audio_output_mixer.h"
 
 AudioOutputDispatcher::AudioOutputDispatcher(
     AudioManager* audio_manager, const AudioParameters& params,
-    base::TimeDelta close_delay)
+    base::TimeDelta close_delay, bool use_mixer)
     : audio_manager_(audio_manager),
       message_loop_(MessageLoop::current()),
       params_(params),
@@ -20,6 +21,7 @@ AudioOutputDispatcher::AudioOutputDispatcher(
           2 * params.samples_per_packet *
           base::Time::kMillisecondsPerSecond / params.sample_rate)),
       paused_proxies_(0),
+      use_mixer_(use_mixer),
       ALLOW_THIS_IN_INITIALIZER_LIST(weak_this_(this)),
       close_timer_(FROM_HERE,
           close_delay,
@@ -39,7 +41,10 @@ bool AudioOutputDispatcher::StreamOpened() {
   paused_proxies_++;
 
   // Ensure that there is at least one open stream.
-  if (idle_streams_.empty() && !CreateAndOpenStream()) {
+  if (use_mixer_) {
+    if (!CreateMixer())
+      return false;
+  } else if (idle_streams_.empty() && !CreateAndOpenStream()) {
     return false;
   }
 
@@ -51,6 +56,17 @@ bool AudioOutputDispatcher::StreamOpened() {
 AudioOutputStream* AudioOutputDispatcher::StreamStarted() {
   DCHECK_EQ(MessageLoop::current(), message_loop_);
 
+  if (use_mixer_) {
+    if (!CreateMixer())
+      return NULL;
+
+    DCHECK_GT(paused_proxies_, 0u);
+    paused_proxies_--;
+
+    close_timer_.Reset();
+    return mixer_->CreateInput();
+  }
+
   if (idle_streams_.empty() && !CreateAndOpenStream()) {
     return NULL;
   }
@@ -75,6 +91,13 @@ void AudioOutputDispatcher::StreamStopped(AudioOutputStream* stream) {
 
   paused_proxies_++;
 
+  // Inputs of the mixer stop right away, so they don't need to sit idle.
+  if (use_mixer_) {
+    stream->Close();
+    close_timer_.Reset();
+    return;
+  }
+
   pausing_streams_.push_front(stream);
 
   // Don't recycle stream until two buffers worth of time has elapsed.
@@ -108,6 +131,9 @@ void AudioOutputDispatcher::StreamClosed() {
   DCHECK_GT(paused_proxies_, 0u);
   paused_proxies_--;
 
+  if (mixer_.get() && mixer_->inputs() == 0 && paused_proxies_ == 0)
+    mixer_.reset();
+
   while (idle_streams_.size() > paused_proxies_) {
     idle_streams_.back()->Close();
     idle_streams_.pop_back();
@@ -133,6 +159,8 @@ void AudioOutputDispatcher::Shutdown() {
   for (; it != pausing_streams_.end(); ++it)
     (*it)->Close();
   pausing_streams_.clear();
+
+  mixer_.reset();
 }
 
 bool AudioOutputDispatcher::CreateAndOpenStream() {
@@ -148,6 +176,22 @@ bool AudioOutputDispatcher::CreateAndOpenStream() {
   return true;
 }
 
+bool AudioOutputDispatcher::CreateMixer() {
+  if (mixer_.get())
+    return true;
+
+  AudioOutputStream* stream = audio_manager_->MakeAudioOutputStream(params_);
+  if (!stream)
+    return false;
+
+  if (!stream->Open()) {
+    stream->Close();
+    return false;
+  }
+  mixer_.reset(new AudioOutputMixer(stream, params_));
+  return true;
+}
+
 void AudioOutputDispatcher::OpenTask() {
   // Make sure that we have at least one stream allocated if there
   // are paused streams.
@@ -167,4 +211,7 @@ void AudioOutputDispatcher::ClosePendingStreams() {
     idle_streams_.back()->Close();
     idle_streams_.pop_back();
   }
+
+  if (mixer_.get() && mixer_->inputs() == 0)
+    mixer_.reset();
 }
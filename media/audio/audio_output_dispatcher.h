@@ -14,6 +14,10 @@
 // only if it hasn't been used for a certain period of time (specified via the
 // constructor).
 //
+// If |use_mixer| is set, the dispatcher instead plays all of its streams
+// through a single physical stream owned by an AudioOutputMixer, and
+// StreamStarted() returns inputs of the mixer.
+//
 // AudioManagerBase creates one AudioOutputDispatcher on the audio thread for
 // each possible set of audio parameters. I.e streams with different parameters
 // are managed independently.  The AudioOutputDispatcher instance is then
@@ -27,11 +31,13 @@
 
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/timer.h"
 #include "media/audio/audio_manager.h"
 #include "media/audio/audio_parameters.h"
 
+class AudioOutputMixer;
 class AudioOutputStream;
 class MessageLoop;
 
@@ -39,10 +45,12 @@ class MEDIA_EXPORT AudioOutputDispatcher
     : public base::RefCountedThreadSafe<AudioOutputDispatcher> {
  public:
   // |close_delay_ms| specifies delay after the stream is paused until
-  // the audio device is closed.
+  // the audio device is closed. |use_mixer| selects whether the streams
+  // share one physical stream.
   AudioOutputDispatcher(AudioManager* audio_manager,
                         const AudioParameters& params,
-                        base::TimeDelta close_delay);
+                        base::TimeDelta close_delay,
+                        bool use_mixer);
   ~AudioOutputDispatcher();
 
   // Called by AudioOutputProxy when the stream is closed. Opens a new
@@ -70,6 +78,7 @@ class MEDIA_EXPORT AudioOutputDispatcher
   void Shutdown();
 
  private:
+  friend class AudioOutputMixerTest;
   friend class AudioOutputProxyTest;
 
   // Creates a new physical output stream, opens it and pushes to
@@ -88,6 +97,10 @@ class MEDIA_EXPORT AudioOutputDispatcher
   // Called by |close_timer_|. Closes all pending stream.
   void ClosePendingStreams();
 
+  // Creates |mixer_| if there is none. Returns false if its physical stream
+  // couldn't be created or opened.
+  bool CreateMixer();
+
   // A no-reference-held pointer (we don't want circular references) back to the
   // AudioManager that owns this object.
   AudioManager* audio_manager_;
@@ -100,6 +113,11 @@ class MEDIA_EXPORT AudioOutputDispatcher
   AudioOutputStreamList idle_streams_;
   AudioOutputStreamList pausing_streams_;
 
+  // Mixes the streams into one physical stream if |use_mixer_| is set. Used
+  // instead of the lists above.
+  bool use_mixer_;
+  scoped_ptr<AudioOutputMixer> mixer_;
+
   // Used to post delayed tasks to ourselves that we cancel inside Shutdown().
   base::WeakPtrFactory<AudioOutputDispatcher> weak_this_;
   base::DelayTimer<AudioOutputDispatcher> close_timer_;
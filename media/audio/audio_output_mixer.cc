@@ -0,0 +1,267 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Software mixing of audio streams that share a physical output stream.
+
+// The inputs are summed in 32 bit accumulators (64 bit for 32 bit audio), so
+// that only the final sum is clipped. The loops are kept simple enough for
+// the compiler to vectorize them.
+
+#include "media/audio/audio_output_mixer.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "media/audio/audio_util.h"
+
+// Adds |sample_count| samples from |src|, scaled by |fixed_volume| in 16.16
+// fixed point, to the accumulators in |dest|.
+template<class Format, class Fixed, int bias>
+static void AccumulateSamples(const Format* src,
+                              int sample_count,
+                              int fixed_volume,
+                              Fixed* dest) {
+  if (fixed_volume == 65536) {
+    for (int i = 0; i < sample_count; ++i)
+      dest[i] += static_cast<Fixed>(src[i]) - bias;
+    return;
+  }
+  for (int i = 0; i < sample_count; ++i) {
+    dest[i] += ((static_cast<Fixed>(src[i]) - bias) * fixed_volume) >> 16;
+  }
+}
+
+// Clips |sample_count| accumulators from |src| to the range of Format and
+// stores them in |dest|.
+template<class Format, class Fixed, int min_value, int max_value, int bias>
+static void ClipSamples(const Fixed* src, int sample_count, Format* dest) {
+  for (int i = 0; i < sample_count; ++i) {
+    Fixed sample = std::max(static_cast<Fixed>(min_value),
+                            std::min(static_cast<Fixed>(max_value), src[i]));
+    dest[i] = static_cast<Format>(sample + bias);
+  }
+}
+
+static void AccumulateBuffer(const uint8* src,
+                             uint32 size,
+                             int bytes_per_sample,
+                             float volume,
+                             int64* mix) {
+  const int fixed_volume = static_cast<int>(volume * 65536);
+  if (bytes_per_sample == 1) {
+    AccumulateSamples<uint8, int32, 128>(src, size, fixed_volume,
+                                         reinterpret_cast<int32*>(mix));
+  } else if (bytes_per_sample == 2) {
+    AccumulateSamples<int16, int32, 0>(reinterpret_cast<const int16*>(src),
+                                       size / 2, fixed_volume,
+                                       reinterpret_cast<int32*>(mix));
+  } else if (bytes_per_sample == 4) {
+    AccumulateSamples<int32, int64, 0>(reinterpret_cast<const int32*>(src),
+                                       size / 4, fixed_volume, mix);
+  }
+}
+
+static void ClipBuffer(const int64* mix,
+                       uint32 size,
+                       int bytes_per_sample,
+                       uint8* dest) {
+  if (bytes_per_sample == 1) {
+    ClipSamples<uint8, int32, -128, 127, 128>(
+        reinterpret_cast<const int32*>(mix), size, dest);
+  } else if (bytes_per_sample == 2) {
+    ClipSamples<int16, int32, kint16min, kint16max, 0>(
+        reinterpret_cast<const int32*>(mix), size / 2,
+        reinterpret_cast<int16*>(dest));
+  } else if (bytes_per_sample == 4) {
+    ClipSamples<int32, int64, kint32min, kint32max, 0>(
+        mix, size / 4, reinterpret_cast<int32*>(dest));
+  }
+}
+
+// The stream returned by AudioOutputMixer::CreateInput(). |callback_| and
+// |volume_| are guarded by the lock of the mixer.
+class AudioOutputMixer::Input : public AudioOutputStream {
+ public:
+  explicit Input(AudioOutputMixer* mixer)
+      : mixer_(mixer),
+        callback_(NULL),
+        volume_(1.0) {
+  }
+
+  virtual bool Open() OVERRIDE {
+    return true;
+  }
+
+  virtual void Start(AudioSourceCallback* callback) OVERRIDE {
+    mixer_->StartInput(this, callback);
+  }
+
+  virtual void Stop() OVERRIDE {
+    mixer_->StopInput(this);
+  }
+
+  virtual void SetVolume(double volume) OVERRIDE {
+    mixer_->SetInputVolume(this, volume);
+  }
+
+  virtual void GetVolume(double* volume) OVERRIDE {
+    *volume = volume_;
+  }
+
+  virtual void Close() OVERRIDE {
+    mixer_->CloseInput(this);
+    delete this;
+  }
+
+ private:
+  friend class AudioOutputMixer;
+
+  virtual ~Input() {}
+
+  AudioOutputMixer* mixer_;
+
+  // The source of the audio while playing, NULL otherwise.
+  AudioSourceCallback* callback_;
+
+  double volume_;
+
+  DISALLOW_COPY_AND_ASSIGN(Input);
+};
+
+AudioOutputMixer::AudioOutputMixer(AudioOutputStream* physical_stream,
+                                   const AudioParameters& params)
+    : physical_stream_(physical_stream),
+      params_(params),
+      inputs_(0) {
+  DCHECK(IsSupported(params));
+}
+
+AudioOutputMixer::~AudioOutputMixer() {
+  DCHECK_EQ(inputs_, 0u);
+  physical_stream_->Close();
+}
+
+// static
+bool AudioOutputMixer::IsSupported(const AudioParameters& params) {
+  return params.bits_per_sample == 8 || params.bits_per_sample == 16 ||
+      params.bits_per_sample == 32;
+}
+
+AudioOutputStream* AudioOutputMixer::CreateInput() {
+  inputs_++;
+  return new Input(this);
+}
+
+size_t AudioOutputMixer::playing_inputs() const {
+  base::AutoLock auto_lock(lock_);
+  return playing_inputs_.size();
+}
+
+void AudioOutputMixer::StartInput(Input* input,
+                                  AudioSourceCallback* callback) {
+  bool start_physical_stream;
+  {
+    base::AutoLock auto_lock(lock_);
+    DCHECK(!input->callback_);
+    input->callback_ = callback;
+    playing_inputs_.push_back(input);
+    start_physical_stream = playing_inputs_.size() == 1;
+  }
+
+  // Starting the stream fetches the first packets on this thread, so it must
+  // not hold |lock_|.
+  if (start_physical_stream)
+    physical_stream_->Start(this);
+}
+
+void AudioOutputMixer::StopInput(Input* input) {
+  bool stop_physical_stream;
+  {
+    base::AutoLock auto_lock(lock_);
+    if (!input->callback_)
+      return;
+    input->callback_ = NULL;
+    playing_inputs_.remove(input);
+    stop_physical_stream = playing_inputs_.empty();
+  }
+
+  // Stopping the stream may wait for a callback that is blocked on |lock_|.
+  if (stop_physical_stream)
+    physical_stream_->Stop();
+}
+
+void AudioOutputMixer::SetInputVolume(Input* input, double volume) {
+  base::AutoLock auto_lock(lock_);
+  input->volume_ = volume;
+}
+
+void AudioOutputMixer::CloseInput(Input* input) {
+  StopInput(input);
+  DCHECK_GT(inputs_, 0u);
+  inputs_--;
+}
+
+uint32 AudioOutputMixer::OnMoreData(AudioOutputStream* stream, uint8* dest,
+                                    uint32 max_size,
+                                    AudioBuffersState buffers_state) {
+  base::AutoLock auto_lock(lock_);
+
+  // A single input plays straight into the physical stream.
+  if (playing_inputs_.size() == 1) {
+    Input* input = playing_inputs_.front();
+    uint32 size = std::min(max_size, input->callback_->OnMoreData(
+        input, dest, max_size, buffers_state));
+    media::AdjustVolume(dest, size, params_.channels,
+                        params_.bits_per_sample / 8, input->volume_);
+    return size;
+  }
+
+  return MixInputs(dest, max_size, buffers_state);
+}
+
+void AudioOutputMixer::OnError(AudioOutputStream* stream, int code) {
+  base::AutoLock auto_lock(lock_);
+  for (InputList::iterator it = playing_inputs_.begin();
+       it != playing_inputs_.end(); ++it) {
+    (*it)->callback_->OnError(*it, code);
+  }
+}
+
+void AudioOutputMixer::WaitTillDataReady() {
+  base::AutoLock auto_lock(lock_);
+  for (InputList::iterator it = playing_inputs_.begin();
+       it != playing_inputs_.end(); ++it) {
+    (*it)->callback_->WaitTillDataReady();
+  }
+}
+
+uint32 AudioOutputMixer::MixInputs(uint8* dest, uint32 max_size,
+                                   AudioBuffersState buffers_state) {
+  lock_.AssertAcquired();
+  if (playing_inputs_.empty()) {
+    memset(dest, 0, max_size);
+    return max_size;
+  }
+
+  const int bytes_per_sample = params_.bits_per_sample / 8;
+  if (input_buffer_.size() < max_size)
+    input_buffer_.resize(max_size);
+  mix_buffer_.assign(max_size / bytes_per_sample, 0);
+
+  uint32 mixed_size = 0;
+  for (InputList::iterator it = playing_inputs_.begin();
+       it != playing_inputs_.end(); ++it) {
+    Input* input = *it;
+    uint32 size = std::min(max_size, input->callback_->OnMoreData(
+        input, &input_buffer_[0], max_size, buffers_state));
+    mixed_size = std::max(mixed_size, size);
+    if (input->volume_ > 0.0) {
+      AccumulateBuffer(&input_buffer_[0], size, bytes_per_sample,
+                       static_cast<float>(input->volume_), &mix_buffer_[0]);
+    }
+  }
+
+  ClipBuffer(&mix_buffer_[0], mixed_size, bytes_per_sample, dest);
+  return mixed_size;
+}
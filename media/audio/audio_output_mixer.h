@@ -0,0 +1,97 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// AudioOutputMixer plays any number of audio streams through a single
+// physical output stream. All of the streams use the same AudioParameters as
+// the physical stream. CreateInput() returns an AudioOutputStream whose audio
+// is mixed in software into the physical stream while it is playing. The
+// physical stream runs only while at least one input is playing.
+//
+// Inputs are created, started, stopped and closed on the audio thread, like
+// the AudioOutputProxy objects that use them. The physical stream pulls the
+// mixed audio on its own thread.
+
+#ifndef MEDIA_AUDIO_AUDIO_OUTPUT_MIXER_H_
+#define MEDIA_AUDIO_AUDIO_OUTPUT_MIXER_H_
+
+#include <list>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/synchronization/lock.h"
+#include "media/audio/audio_io.h"
+#include "media/audio/audio_parameters.h"
+
+class MEDIA_EXPORT AudioOutputMixer
+    : public AudioOutputStream::AudioSourceCallback {
+ public:
+  // Takes ownership of |physical_stream|, which must already be open and use
+  // |params|.
+  AudioOutputMixer(AudioOutputStream* physical_stream,
+                   const AudioParameters& params);
+
+  // Closes the physical stream. All inputs must be closed first.
+  virtual ~AudioOutputMixer();
+
+  // Returns true if streams with |params| can be mixed.
+  static bool IsSupported(const AudioParameters& params);
+
+  // Returns a new stream that plays through the physical stream. The caller
+  // must Close() it, which also deletes it, before the mixer is deleted.
+  AudioOutputStream* CreateInput();
+
+  // Number of inputs that have not been closed yet.
+  size_t inputs() const { return inputs_; }
+
+  // Number of inputs that are playing.
+  size_t playing_inputs() const;
+
+  // AudioSourceCallback implementation, called on the thread of the
+  // physical stream.
+  virtual uint32 OnMoreData(AudioOutputStream* stream, uint8* dest,
+                            uint32 max_size,
+                            AudioBuffersState buffers_state) OVERRIDE;
+  virtual void OnError(AudioOutputStream* stream, int code) OVERRIDE;
+  virtual void WaitTillDataReady() OVERRIDE;
+
+ private:
+  class Input;
+  friend class Input;
+
+  // Called by Input.
+  void StartInput(Input* input, AudioSourceCallback* callback);
+  void StopInput(Input* input);
+  void SetInputVolume(Input* input, double volume);
+  void CloseInput(Input* input);
+
+  // Mixes the audio of all playing inputs into |dest|. Returns the size of
+  // the largest packet an input filled.
+  uint32 MixInputs(uint8* dest, uint32 max_size,
+                   AudioBuffersState buffers_state);
+
+  AudioOutputStream* physical_stream_;
+  AudioParameters params_;
+
+  // Number of inputs that have not been closed yet.
+  size_t inputs_;
+
+  // Protects |playing_inputs_|, the volume of the inputs and the buffers
+  // below, which are used by both the audio thread and the thread of the
+  // physical stream.
+  mutable base::Lock lock_;
+  typedef std::list<Input*> InputList;
+  InputList playing_inputs_;
+
+  // Audio of the input being mixed in.
+  std::vector<uint8> input_buffer_;
+
+  // Sum of the inputs mixed in so far. Holds int32 accumulators for 8 and
+  // 16 bit audio and int64 accumulators for 32 bit audio.
+  std::vector<int64> mix_buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(AudioOutputMixer);
+};
+
+#endif  // MEDIA_AUDIO_AUDIO_OUTPUT_MIXER_H_
@@ -0,0 +1,115 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "media/audio/audio_output_mixer.h"
+#include "media/audio/fake_audio_output_stream.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Stereo 16 bit audio at 48 kHz, in the packets AudioOutputController uses.
+const int kSampleRate = 48000;
+const int kBitsPerSample = 16;
+const int kSamplesPerPacket = 2048;
+
+// Number of packets mixed for each number of streams.
+const int kPackets = 2000;
+
+// Fills every sample with the same value, so that almost all of the time is
+// spent mixing.
+class ConstantSource : public AudioOutputStream::AudioSourceCallback {
+ public:
+  explicit ConstantSource(int16 value) : value_(value) {}
+
+  virtual uint32 OnMoreData(
+      AudioOutputStream* stream, uint8* dest, uint32 max_size,
+      AudioBuffersState buffers_state) OVERRIDE {
+    int16* samples = reinterpret_cast<int16*>(dest);
+    for (uint32 i = 0; i < max_size / sizeof(int16); ++i)
+      samples[i] = value_;
+    return max_size;
+  }
+
+  virtual void OnError(AudioOutputStream* stream, int code) OVERRIDE {}
+
+ private:
+  int16 value_;
+};
+
+}  // namespace
+
+class AudioOutputMixerPerfTest : public testing::Test {
+ protected:
+  AudioOutputMixerPerfTest()
+      : params_(AudioParameters::AUDIO_PCM_LINEAR, CHANNEL_LAYOUT_STEREO,
+                kSampleRate, kBitsPerSample, kSamplesPerPacket),
+        buffer_(params_.GetPacketSize()) {
+  }
+
+  // Returns a mixer that plays through a FakeAudioOutputStream.
+  AudioOutputMixer* CreateMixer() {
+    AudioOutputStream* stream = FakeAudioOutputStream::MakeFakeStream(params_);
+    EXPECT_TRUE(stream->Open());
+    return new AudioOutputMixer(stream, params_);
+  }
+
+  // Pulls one packet from |mixer| the way the physical stream does, and
+  // returns its first sample.
+  int16 Pull(AudioOutputMixer* mixer) {
+    EXPECT_EQ(buffer_.size(),
+              mixer->OnMoreData(FakeAudioOutputStream::GetLastFakeStream(),
+                                &buffer_[0], buffer_.size(),
+                                AudioBuffersState(0, 0)));
+    return *reinterpret_cast<int16*>(&buffer_[0]);
+  }
+
+  // Mixes |streams| streams for kPackets packets and logs the time spent per
+  // packet, and per stream for each second of audio played.
+  void RunMix(int streams) {
+    scoped_ptr<AudioOutputMixer> mixer(CreateMixer());
+    ConstantSource source(1);
+    std::vector<AudioOutputStream*> inputs;
+    for (int i = 0; i < streams; ++i) {
+      inputs.push_back(mixer->CreateInput());
+      inputs.back()->Start(&source);
+    }
+    EXPECT_EQ(static_cast<size_t>(streams), mixer->playing_inputs());
+
+    int16 sample = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kPackets; ++i)
+      sample = Pull(mixer.get());
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    EXPECT_EQ(streams, sample);
+
+    double played_seconds =
+        static_cast<double>(kPackets) * kSamplesPerPacket / kSampleRate;
+    LogPerfResult(base::StringPrintf("AudioOutputMixer_packet_%d_streams",
+                                     streams).c_str(),
+                  elapsed.InMicroseconds() / static_cast<double>(kPackets),
+                  "us");
+    LogPerfResult(base::StringPrintf("AudioOutputMixer_cpu_per_stream_%d",
+                                     streams).c_str(),
+                  elapsed.InMicroseconds() / played_seconds / streams,
+                  "us/s");
+
+    for (int i = 0; i < streams; ++i)
+      inputs[i]->Close();
+  }
+
+  AudioParameters params_;
+  std::vector<uint8> buffer_;
+};
+
+TEST_F(AudioOutputMixerPerfTest, Mix) {
+  for (int streams = 1; streams <= 16; streams *= 2)
+    RunMix(streams);
+}
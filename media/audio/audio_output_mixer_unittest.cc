@@ -0,0 +1,186 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/message_loop_proxy.h"
+#include "media/audio/audio_manager.h"
+#include "media/audio/audio_output_dispatcher.h"
+#include "media/audio/audio_output_mixer.h"
+#include "media/audio/fake_audio_output_stream.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::Return;
+
+namespace {
+
+const int kSampleRate = 48000;
+const int kBitsPerSample = 16;
+const int kSamplesPerPacket = 1024;
+
+// Fills every sample with the same value.
+class ConstantSource : public AudioOutputStream::AudioSourceCallback {
+ public:
+  explicit ConstantSource(int16 value) : value_(value) {}
+
+  virtual uint32 OnMoreData(
+      AudioOutputStream* stream, uint8* dest, uint32 max_size,
+      AudioBuffersState buffers_state) OVERRIDE {
+    int16* samples = reinterpret_cast<int16*>(dest);
+    for (uint32 i = 0; i < max_size / sizeof(int16); ++i)
+      samples[i] = value_;
+    return max_size;
+  }
+
+  virtual void OnError(AudioOutputStream* stream, int code) OVERRIDE {}
+
+ private:
+  int16 value_;
+};
+
+class MockAudioManager : public AudioManager {
+ public:
+  MockAudioManager() {}
+
+  MOCK_METHOD0(Init, void());
+  MOCK_METHOD0(HasAudioOutputDevices, bool());
+  MOCK_METHOD0(HasAudioInputDevices, bool());
+  MOCK_METHOD0(GetAudioInputDeviceModel, string16());
+  MOCK_METHOD1(MakeAudioOutputStream, AudioOutputStream*(
+      const AudioParameters& params));
+  MOCK_METHOD1(MakeAudioOutputStreamProxy, AudioOutputStream*(
+      const AudioParameters& params));
+  MOCK_METHOD2(MakeAudioInputStream, AudioInputStream*(
+      const AudioParameters& params, const std::string& device_id));
+  MOCK_METHOD0(MuteAll, void());
+  MOCK_METHOD0(UnMuteAll, void());
+  MOCK_METHOD0(CanShowAudioInputSettings, bool());
+  MOCK_METHOD0(ShowAudioInputSettings, void());
+  MOCK_METHOD0(GetMessageLoop, scoped_refptr<base::MessageLoopProxy>());
+  MOCK_METHOD1(GetAudioInputDeviceNames, void(
+      media::AudioDeviceNames* device_name));
+  MOCK_METHOD0(IsRecordingInProcess, bool());
+};
+
+}  // namespace
+
+class AudioOutputMixerTest : public testing::Test {
+ protected:
+  AudioOutputMixerTest()
+      : params_(AudioParameters::AUDIO_PCM_LINEAR, CHANNEL_LAYOUT_STEREO,
+                kSampleRate, kBitsPerSample, kSamplesPerPacket),
+        buffer_(params_.GetPacketSize()) {
+  }
+
+  // Returns a mixer that plays through a FakeAudioOutputStream.
+  AudioOutputMixer* CreateMixer() {
+    AudioOutputStream* stream = FakeAudioOutputStream::MakeFakeStream(params_);
+    EXPECT_TRUE(stream->Open());
+    return new AudioOutputMixer(stream, params_);
+  }
+
+  // Pulls one packet from |mixer| the way the physical stream does, and
+  // returns its first sample.
+  int16 Pull(AudioOutputMixer* mixer) {
+    EXPECT_EQ(buffer_.size(),
+              mixer->OnMoreData(FakeAudioOutputStream::GetLastFakeStream(),
+                                &buffer_[0], buffer_.size(),
+                                AudioBuffersState(0, 0)));
+    return *reinterpret_cast<int16*>(&buffer_[0]);
+  }
+
+  AudioOutputMixer* GetMixer(AudioOutputDispatcher* dispatcher) {
+    return dispatcher->mixer_.get();
+  }
+
+  AudioParameters params_;
+  std::vector<uint8> buffer_;
+};
+
+TEST_F(AudioOutputMixerTest, MixesIntoFakeStream) {
+  scoped_ptr<AudioOutputMixer> mixer(CreateMixer());
+  FakeAudioOutputStream* physical_stream =
+      FakeAudioOutputStream::GetLastFakeStream();
+  ConstantSource source1(1000);
+  ConstantSource source2(-3000);
+  ConstantSource loud_source(kint16max);
+
+  // Starting the first input starts the physical stream, which plays the
+  // input without mixing.
+  AudioOutputStream* input1 = mixer->CreateInput();
+  AudioOutputStream* input2 = mixer->CreateInput();
+  input1->Start(&source1);
+  EXPECT_EQ(1000, *reinterpret_cast<int16*>(physical_stream->buffer()));
+  EXPECT_EQ(1000, Pull(mixer.get()));
+
+  input2->SetVolume(0.5);
+  input2->Start(&source2);
+  EXPECT_EQ(2u, mixer->playing_inputs());
+  EXPECT_EQ(-500, Pull(mixer.get()));
+
+  // The sum is clipped.
+  AudioOutputStream* input3 = mixer->CreateInput();
+  input3->Start(&loud_source);
+  input2->Stop();
+  EXPECT_EQ(kint16max, Pull(mixer.get()));
+
+  input1->Close();
+  input2->Close();
+  input3->Close();
+  EXPECT_EQ(0u, mixer->playing_inputs());
+  EXPECT_EQ(0u, mixer->inputs());
+}
+
+// Tests that a dispatcher using a mixer plays all of its streams through one
+// physical stream, and closes it once no proxy uses the dispatcher.
+TEST_F(AudioOutputMixerTest, DispatcherSharesPhysicalStream) {
+  MessageLoop message_loop;
+  scoped_refptr<MockAudioManager> manager(new MockAudioManager());
+  EXPECT_CALL(*manager, GetMessageLoop())
+      .WillRepeatedly(Return(message_loop.message_loop_proxy()));
+  EXPECT_CALL(*manager, MakeAudioOutputStream(_))
+      .WillOnce(Invoke(&FakeAudioOutputStream::MakeFakeStream));
+
+  scoped_refptr<AudioOutputDispatcher> dispatcher(new AudioOutputDispatcher(
+      manager, params_, base::TimeDelta::FromSeconds(1), true));
+  ConstantSource source1(1000);
+  ConstantSource source2(2000);
+
+  // Each proxy opens and then starts its stream.
+  ASSERT_TRUE(dispatcher->StreamOpened());
+  ASSERT_TRUE(dispatcher->StreamOpened());
+  AudioOutputStream* stream1 = dispatcher->StreamStarted();
+  AudioOutputStream* stream2 = dispatcher->StreamStarted();
+  ASSERT_TRUE(stream1);
+  ASSERT_TRUE(stream2);
+  EXPECT_NE(stream1, stream2);
+  stream1->Start(&source1);
+  stream2->Start(&source2);
+
+  AudioOutputMixer* mixer = GetMixer(dispatcher);
+  ASSERT_TRUE(mixer);
+  EXPECT_EQ(2u, mixer->playing_inputs());
+  EXPECT_EQ(3000, Pull(mixer));
+
+  // A stopped stream is closed right away, and the others keep playing.
+  stream1->Stop();
+  dispatcher->StreamStopped(stream1);
+  EXPECT_EQ(1u, mixer->inputs());
+  EXPECT_EQ(2000, Pull(mixer));
+
+  stream2->Stop();
+  dispatcher->StreamStopped(stream2);
+  dispatcher->StreamClosed();
+  dispatcher->StreamClosed();
+  EXPECT_FALSE(GetMixer(dispatcher));
+
+  dispatcher->Shutdown();
+}
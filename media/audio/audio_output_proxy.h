@@ -18,7 +18,7 @@ class AudioOutputDispatcher;
 // efficiently than a regular audio output stream: it opens audio
 // device only when sound is playing, i.e. between Start() and Stop()
 // (there is still one physical stream per each audio output proxy in
-// playing state).
+// playing state, unless the dispatcher mixes them into one).
 //
 // AudioOutputProxy uses AudioOutputDispatcher to open and close
 // physical output streams.
@@ -0,0 +1,138 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/audio/audio_packet_ring.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+using base::subtle::Atomic32;
+
+namespace media {
+
+// Layout of the shared memory: the header, the sizes of the packets, and
+// then the packets.
+struct AudioPacketRing::Header {
+  Atomic32 write_sequence;
+  Atomic32 read_sequence;
+  Atomic32 producer_waiting;
+  Atomic32 pending_bytes;
+};
+
+// GCC requires these declarations, but MSVC requires they not be present
+#ifndef _MSC_VER
+const int AudioPacketRing::kMaxPackets;
+#endif
+
+// static
+uint32 AudioPacketRing::RequiredMemorySize(uint32 packet_size, int packets) {
+  DCHECK_GT(packets, 0);
+  DCHECK_LE(packets, kMaxPackets);
+  return sizeof(Header) + packets * (sizeof(Atomic32) + packet_size);
+}
+
+AudioPacketRing::AudioPacketRing(void* memory, uint32 packet_size,
+                                 int packets)
+    : header_(static_cast<Header*>(memory)),
+      sizes_(reinterpret_cast<Atomic32*>(header_ + 1)),
+      data_(reinterpret_cast<uint8*>(sizes_ + packets)),
+      packet_size_(packet_size),
+      packets_(packets),
+      write_sequence_(0),
+      read_sequence_(0),
+      underruns_(0) {
+  DCHECK_EQ(0u, reinterpret_cast<size_t>(memory) & 3);
+  DCHECK_GT(packets_, 0);
+  DCHECK_LE(packets_, kMaxPackets);
+}
+
+AudioPacketRing::~AudioPacketRing() {
+}
+
+void AudioPacketRing::Initialize() {
+  base::subtle::NoBarrier_Store(&header_->write_sequence, 0);
+  base::subtle::NoBarrier_Store(&header_->read_sequence, 0);
+  base::subtle::NoBarrier_Store(&header_->pending_bytes, 0);
+  base::subtle::Release_Store(&header_->producer_waiting, 1);
+}
+
+uint8* AudioPacketRing::GetWriteBuffer() {
+  uint32 read_sequence = base::subtle::Acquire_Load(&header_->read_sequence);
+  if (write_sequence_ - read_sequence >= static_cast<uint32>(packets_))
+    return NULL;
+  return data_ + (write_sequence_ % packets_) * packet_size_;
+}
+
+void AudioPacketRing::CommitWrite(uint32 size) {
+  base::subtle::NoBarrier_Store(&sizes_[write_sequence_ % packets_],
+                                std::min(size, packet_size_));
+  ++write_sequence_;
+  base::subtle::Release_Store(&header_->write_sequence, write_sequence_);
+}
+
+bool AudioPacketRing::PrepareToWait() {
+  base::subtle::NoBarrier_Store(&header_->producer_waiting, 1);
+
+  // Pairs with the barrier in ShouldWakeProducer(): either the consumer sees
+  // the flag, or we see the packet it read.
+  base::subtle::MemoryBarrier();
+  uint32 read_sequence = base::subtle::NoBarrier_Load(&header_->read_sequence);
+  return write_sequence_ - read_sequence >= static_cast<uint32>(packets_);
+}
+
+uint32 AudioPacketRing::GetDelayBytes() {
+  uint32 read_sequence = base::subtle::Acquire_Load(&header_->read_sequence);
+  uint32 pending_bytes = base::subtle::NoBarrier_Load(&header_->pending_bytes);
+  return pending_bytes + (write_sequence_ - read_sequence) * packet_size_;
+}
+
+uint32 AudioPacketRing::Read(void* dest, uint32 size) {
+  if (!GetReadablePackets()) {
+    underruns_++;
+    memset(dest, 0, size);
+    return 0;
+  }
+
+  int index = read_sequence_ % packets_;
+  uint32 packet_bytes = base::subtle::NoBarrier_Load(&sizes_[index]);
+  uint32 read_size = std::min(std::min(packet_bytes, packet_size_), size);
+  memcpy(dest, data_ + index * packet_size_, read_size);
+  if (read_size < size)
+    memset(static_cast<uint8*>(dest) + read_size, 0, size - read_size);
+
+  ++read_sequence_;
+  base::subtle::Release_Store(&header_->read_sequence, read_sequence_);
+  return read_size;
+}
+
+int AudioPacketRing::GetReadablePackets() {
+  uint32 write_sequence = base::subtle::Acquire_Load(&header_->write_sequence);
+  uint32 readable = write_sequence - read_sequence_;
+  if (readable > static_cast<uint32>(packets_))
+    return 0;
+  return readable;
+}
+
+void AudioPacketRing::DropUnreadPackets() {
+  read_sequence_ += GetReadablePackets();
+  base::subtle::Release_Store(&header_->read_sequence, read_sequence_);
+}
+
+void AudioPacketRing::SetPendingBytes(uint32 bytes) {
+  base::subtle::NoBarrier_Store(&header_->pending_bytes, bytes);
+}
+
+bool AudioPacketRing::ShouldWakeProducer() {
+  // Pairs with the barrier in PrepareToWait().
+  base::subtle::MemoryBarrier();
+  if (GetReadablePackets() > packets_ / 2)
+    return false;
+  return base::subtle::NoBarrier_CompareAndSwap(
+      &header_->producer_waiting, 1, 0) == 1;
+}
+
+}  // namespace media
@@ -0,0 +1,110 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// AudioPacketRing is a lock-free single producer, single consumer ring of
+// audio packets in a block of shared memory. The renderer produces packets
+// and the browser consumes them, each through its own AudioPacketRing on
+// its own mapping of the memory. The two sides only share sequence numbers
+// that each of them advances, so the consumer can read ahead up to the size
+// of the ring without asking the producer for every packet.
+//
+// The producer waits on some other channel, e.g. a SyncSocket, when the ring
+// is full. PrepareToWait() and ShouldWakeProducer() decide when the consumer
+// has to wake it, which is once the ring has drained to half its size.
+//
+// The consumer does not trust anything the producer writes to the memory:
+// sizes are clipped to the packet size, and a ring that claims to hold more
+// packets than it can is treated as empty.
+
+#ifndef MEDIA_AUDIO_AUDIO_PACKET_RING_H_
+#define MEDIA_AUDIO_AUDIO_PACKET_RING_H_
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "media/base/media_export.h"
+
+namespace media {
+
+class MEDIA_EXPORT AudioPacketRing {
+ public:
+  // Largest number of packets a ring may hold.
+  static const int kMaxPackets = 16;
+
+  // Returns the size of the shared memory for a ring of |packets| packets of
+  // |packet_size| bytes.
+  static uint32 RequiredMemorySize(uint32 packet_size, int packets);
+
+  // |memory| must be 4 byte aligned and RequiredMemorySize() bytes large.
+  AudioPacketRing(void* memory, uint32 packet_size, int packets);
+  ~AudioPacketRing();
+
+  // Called by the consumer on zero filled memory, before the memory is
+  // shared. The producer starts out waiting to be woken.
+  void Initialize();
+
+  // Producer methods.
+
+  // Returns the buffer for the next packet, or NULL if the ring is full.
+  uint8* GetWriteBuffer();
+
+  // Publishes the packet returned by GetWriteBuffer(), which holds |size|
+  // bytes of audio.
+  void CommitWrite(uint32 size);
+
+  // Called when the ring is full, before waiting to be woken. Returns false if
+  // a packet was read in the meantime, in which case the producer should fill
+  // the ring again instead of waiting. Either way the consumer may still wake
+  // the producer once more, so waking up to a full ring must be harmless.
+  bool PrepareToWait();
+
+  // Returns the number of bytes that have been produced but not played yet:
+  // the packets in the ring plus the bytes the consumer last reported.
+  uint32 GetDelayBytes();
+
+  // Consumer methods.
+
+  // Copies the next packet to |dest| and zero fills the rest of |size|.
+  // Returns the number of bytes of audio copied, or 0 if the ring was empty.
+  uint32 Read(void* dest, uint32 size);
+
+  // Returns the number of packets ready to be read.
+  int GetReadablePackets();
+
+  // Discards the packets that have not been read yet, e.g. audio rendered
+  // before a seek, so that the next packet read is one written afterwards.
+  void DropUnreadPackets();
+
+  // Stores the number of bytes played but still buffered downstream, for
+  // GetDelayBytes().
+  void SetPendingBytes(uint32 bytes);
+
+  // Returns true if the producer is waiting and needs to be woken now. Only
+  // returns true once per wait.
+  bool ShouldWakeProducer();
+
+  // Number of Read() calls that found the ring empty.
+  int underruns() const { return underruns_; }
+
+ private:
+  struct Header;
+
+  Header* header_;
+  base::subtle::Atomic32* sizes_;
+  uint8* data_;
+  uint32 packet_size_;
+  int packets_;
+
+  // The sequence numbers owned by this side. The shared copies are written
+  // but never read back, since the other process may change them.
+  uint32 write_sequence_;
+  uint32 read_sequence_;
+
+  int underruns_;
+
+  DISALLOW_COPY_AND_ASSIGN(AudioPacketRing);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_AUDIO_AUDIO_PACKET_RING_H_
@@ -0,0 +1,176 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/sync_socket.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+#include "media/audio/audio_packet_ring.h"
+#include "media/audio/fake_audio_output_stream.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using media::AudioPacketRing;
+
+namespace {
+
+// Stereo 16 bit audio at 48 kHz, in 10 ms packets.
+const int kSampleRate = 48000;
+const int kBitsPerSample = 16;
+const int kSamplesPerPacket = 480;
+const int kPacketMs = 10;
+
+// Number of packets played for each ring size.
+const int kPackets = 100;
+
+// The renderer stalls for kStallMs after every kStallInterval packets, as it
+// does when its thread is descheduled or busy with garbage collection.
+const int kStallInterval = 10;
+const int kStallMs = 15;
+
+// Plays the renderer side of AudioDevice: fills the ring until it is full,
+// then waits on |socket| to be woken.
+class RingProducer : public base::DelegateSimpleThread::Delegate {
+ public:
+  RingProducer(void* memory, uint32 packet_size, int packets,
+               base::CancelableSyncSocket* socket)
+      : ring_(memory, packet_size, packets),
+        socket_(socket),
+        packet_size_(packet_size),
+        packets_produced_(0) {
+  }
+
+  virtual void Run() OVERRIDE {
+    uint32 pending_data;
+    while (socket_->Receive(&pending_data, sizeof(pending_data)) ==
+           sizeof(pending_data)) {
+      do {
+        while (uint8* packet = ring_.GetWriteBuffer()) {
+          if (++packets_produced_ % kStallInterval == 0) {
+            base::PlatformThread::Sleep(
+                base::TimeDelta::FromMilliseconds(kStallMs));
+          }
+          memset(packet, 0, packet_size_);
+          ring_.CommitWrite(packet_size_);
+        }
+      } while (!ring_.PrepareToWait());
+    }
+  }
+
+ private:
+  AudioPacketRing ring_;
+  base::CancelableSyncSocket* socket_;
+  uint32 packet_size_;
+  int packets_produced_;
+};
+
+// Plays the browser side of AudioSyncReader: reads a packet from the ring
+// each time the stream pulls, and wakes the producer when it has to.
+class RingConsumer : public AudioOutputStream::AudioSourceCallback {
+ public:
+  RingConsumer(void* memory, uint32 packet_size, int packets,
+               base::CancelableSyncSocket* socket)
+      : ring_(memory, packet_size, packets),
+        socket_(socket),
+        wake_ups_(0) {
+    ring_.Initialize();
+  }
+
+  virtual uint32 OnMoreData(
+      AudioOutputStream* stream, uint8* dest, uint32 max_size,
+      AudioBuffersState buffers_state) OVERRIDE {
+    uint32 size = ring_.Read(dest, max_size);
+    UpdatePendingBytes(buffers_state.total_bytes() + size);
+    return size;
+  }
+
+  virtual void OnError(AudioOutputStream* stream, int code) OVERRIDE {}
+
+  void UpdatePendingBytes(uint32 bytes) {
+    ring_.SetPendingBytes(bytes);
+    if (ring_.ShouldWakeProducer()) {
+      wake_ups_++;
+      socket_->Send(&bytes, sizeof(bytes));
+    }
+  }
+
+  AudioPacketRing* ring() { return &ring_; }
+  int wake_ups() const { return wake_ups_; }
+
+ private:
+  AudioPacketRing ring_;
+  base::CancelableSyncSocket* socket_;
+  int wake_ups_;
+};
+
+}  // namespace
+
+class AudioPacketRingPerfTest : public testing::Test {
+ protected:
+  AudioPacketRingPerfTest()
+      : params_(AudioParameters::AUDIO_PCM_LINEAR, CHANNEL_LAYOUT_STEREO,
+                kSampleRate, kBitsPerSample, kSamplesPerPacket),
+        buffer_(params_.GetPacketSize()) {
+  }
+
+  // Plays kPackets packets through a ring of |packets| packets, pulled by a
+  // FakeAudioOutputStream at the rate they play, and logs how often the ring
+  // ran dry and how often the producer had to be woken.
+  void RunRing(int packets) {
+    uint32 packet_size = params_.GetPacketSize();
+    std::vector<uint32> memory(
+        AudioPacketRing::RequiredMemorySize(packet_size, packets) /
+        sizeof(uint32) + 1);
+
+    base::CancelableSyncSocket browser_socket;
+    base::CancelableSyncSocket renderer_socket;
+    ASSERT_TRUE(base::CancelableSyncSocket::CreatePair(&browser_socket,
+                                                       &renderer_socket));
+    RingConsumer consumer(&memory[0], packet_size, packets, &browser_socket);
+    RingProducer producer(&memory[0], packet_size, packets, &renderer_socket);
+    base::DelegateSimpleThread producer_thread(&producer, "RingProducer");
+    producer_thread.Start();
+
+    // Like AudioOutputController, start playing once the renderer has filled
+    // the ring.
+    consumer.UpdatePendingBytes(0);
+    while (consumer.ring()->GetReadablePackets() < packets)
+      base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+
+    AudioOutputStream* stream = FakeAudioOutputStream::MakeFakeStream(params_);
+    ASSERT_TRUE(stream->Open());
+    stream->Start(&consumer);
+    for (int i = 1; i < kPackets; ++i) {
+      base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(kPacketMs));
+      consumer.OnMoreData(stream, &buffer_[0], buffer_.size(),
+                          AudioBuffersState(0, 0));
+    }
+    stream->Stop();
+    stream->Close();
+
+    renderer_socket.Shutdown();
+    producer_thread.Join();
+
+    double played_seconds = kPackets * kPacketMs / 1000.0;
+    LogPerfResult(base::StringPrintf("AudioPacketRing_underruns_%d_packets",
+                                     packets).c_str(),
+                  consumer.ring()->underruns() / played_seconds, "/s");
+    LogPerfResult(base::StringPrintf("AudioPacketRing_wake_ups_%d_packets",
+                                     packets).c_str(),
+                  consumer.wake_ups() / played_seconds, "/s");
+  }
+
+  AudioParameters params_;
+  std::vector<uint8> buffer_;
+};
+
+TEST_F(AudioPacketRingPerfTest, Stalls) {
+  const int kRingSizes[] = { 1, 2, 3, 4, 8 };
+  for (size_t i = 0; i < arraysize(kRingSizes); ++i)
+    RunRing(kRingSizes[i]);
+}
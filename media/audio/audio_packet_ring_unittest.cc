@@ -0,0 +1,177 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/sync_socket.h"
+#include "media/audio/audio_packet_ring.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using media::AudioPacketRing;
+
+namespace {
+
+const uint32 kPacketSize = 8;
+
+// Plays the browser side of AudioSyncReader: reads packets from the ring and
+// wakes the renderer through |socket| when it has to.
+class RingReader {
+ public:
+  RingReader(void* memory, int packets, base::CancelableSyncSocket* socket)
+      : ring_(memory, kPacketSize, packets),
+        socket_(socket),
+        wake_ups_(0),
+        paused_(false) {
+    ring_.Initialize();
+  }
+
+  // Reads a packet the way OnMoreData() does, with nothing left in the
+  // stream's buffers.
+  uint32 Read(uint8* dest) {
+    uint32 size = ring_.Read(dest, kPacketSize);
+    UpdatePendingBytes(size);
+    return size;
+  }
+
+  // Called when AudioSyncReader gets the pause mark.
+  void Pause() {
+    ring_.DropUnreadPackets();
+    paused_ = true;
+  }
+
+  void UpdatePendingBytes(uint32 bytes) {
+    if (paused_) {
+      ring_.DropUnreadPackets();
+      paused_ = false;
+    }
+    ring_.SetPendingBytes(bytes);
+    if (ring_.ShouldWakeProducer()) {
+      wake_ups_++;
+      socket_->Send(&bytes, sizeof(bytes));
+    }
+  }
+
+  AudioPacketRing* ring() { return &ring_; }
+  int wake_ups() const { return wake_ups_; }
+
+ private:
+  AudioPacketRing ring_;
+  base::CancelableSyncSocket* socket_;
+  int wake_ups_;
+  bool paused_;
+
+  DISALLOW_COPY_AND_ASSIGN(RingReader);
+};
+
+// Fills |count| packets of |ring| with |value|, as the renderer does.
+void WritePackets(AudioPacketRing* ring, int count, uint8 value) {
+  for (int i = 0; i < count; ++i) {
+    uint8* packet = ring->GetWriteBuffer();
+    ASSERT_TRUE(packet);
+    memset(packet, value, kPacketSize);
+    ring->CommitWrite(kPacketSize);
+  }
+}
+
+// Returns enough memory for a ring of |packets| packets.
+std::vector<uint32> RingMemory(int packets) {
+  return std::vector<uint32>(
+      AudioPacketRing::RequiredMemorySize(kPacketSize, packets) /
+      sizeof(uint32));
+}
+
+}  // namespace
+
+TEST(AudioPacketRingTest, ReadsWhatWasWritten) {
+  const int kRingPackets = 3;
+  std::vector<uint32> memory = RingMemory(kRingPackets);
+  AudioPacketRing consumer(&memory[0], kPacketSize, kRingPackets);
+  consumer.Initialize();
+  AudioPacketRing producer(&memory[0], kPacketSize, kRingPackets);
+
+  // The producer starts out waiting and is woken exactly once.
+  EXPECT_TRUE(consumer.ShouldWakeProducer());
+  EXPECT_FALSE(consumer.ShouldWakeProducer());
+
+  for (int i = 0; i < kRingPackets; ++i) {
+    uint8* packet = producer.GetWriteBuffer();
+    ASSERT_TRUE(packet);
+    memset(packet, i + 1, kPacketSize);
+    producer.CommitWrite(i == 0 ? kPacketSize / 2 : kPacketSize);
+  }
+  EXPECT_FALSE(producer.GetWriteBuffer());
+  EXPECT_EQ(kRingPackets * kPacketSize, producer.GetDelayBytes());
+  EXPECT_TRUE(producer.PrepareToWait());
+
+  // Short packets are zero filled.
+  uint8 packet[kPacketSize];
+  EXPECT_EQ(kPacketSize / 2, consumer.Read(packet, kPacketSize));
+  EXPECT_EQ(1, packet[0]);
+  EXPECT_EQ(0, packet[kPacketSize - 1]);
+  EXPECT_FALSE(consumer.ShouldWakeProducer());
+
+  // The producer is woken once the ring has drained to half its size.
+  EXPECT_EQ(kPacketSize, consumer.Read(packet, kPacketSize));
+  EXPECT_EQ(2, packet[kPacketSize - 1]);
+  EXPECT_TRUE(consumer.ShouldWakeProducer());
+
+  // Reading from an empty ring is an underrun.
+  EXPECT_EQ(kPacketSize, consumer.Read(packet, kPacketSize));
+  EXPECT_EQ(0u, consumer.Read(packet, kPacketSize));
+  EXPECT_EQ(0, packet[0]);
+  EXPECT_EQ(1, consumer.underruns());
+}
+
+TEST(AudioPacketRingTest, IgnoresBogusWriteSequence) {
+  const int kRingPackets = 2;
+  std::vector<uint32> memory = RingMemory(kRingPackets);
+  AudioPacketRing consumer(&memory[0], kPacketSize, kRingPackets);
+  consumer.Initialize();
+
+  // A renderer claiming to have written more packets than fit in the ring is
+  // treated as having written none. The write sequence comes first in the
+  // memory.
+  memory[0] = 1000;
+  EXPECT_EQ(0, consumer.GetReadablePackets());
+  uint8 packet[kPacketSize];
+  EXPECT_EQ(0u, consumer.Read(packet, kPacketSize));
+}
+
+TEST(AudioPacketRingTest, PauseFlushAndPlay) {
+  const int kRingPackets = 3;
+  std::vector<uint32> memory = RingMemory(kRingPackets);
+  base::CancelableSyncSocket browser_socket;
+  base::CancelableSyncSocket renderer_socket;
+  ASSERT_TRUE(base::CancelableSyncSocket::CreatePair(&browser_socket,
+                                                     &renderer_socket));
+  RingReader reader(&memory[0], kRingPackets, &browser_socket);
+  AudioPacketRing producer(&memory[0], kPacketSize, kRingPackets);
+
+  // Play until the renderer has refilled the ring after the first read.
+  reader.UpdatePendingBytes(0);
+  EXPECT_EQ(1, reader.wake_ups());
+  WritePackets(&producer, kRingPackets, 1);
+  uint8 packet[kPacketSize];
+  EXPECT_EQ(kPacketSize, reader.Read(packet));
+  EXPECT_EQ(1, packet[0]);
+
+  // Pausing drops what is left. The renderer was still rendering when the
+  // pause arrived, and fills the ring again with audio from before the seek.
+  reader.Pause();
+  EXPECT_EQ(0, reader.ring()->GetReadablePackets());
+  WritePackets(&producer, kRingPackets, 1);
+  EXPECT_TRUE(producer.PrepareToWait());
+
+  // The flush for the seek does not reach the reader. Playing again drops the
+  // stale audio and wakes the renderer, so no data is ready until the
+  // renderer has written audio from after the seek.
+  reader.UpdatePendingBytes(0);
+  EXPECT_EQ(2, reader.wake_ups());
+  EXPECT_EQ(0, reader.ring()->GetReadablePackets());
+  WritePackets(&producer, kRingPackets, 2);
+  EXPECT_EQ(kPacketSize, reader.Read(packet));
+  EXPECT_EQ(2, packet[0]);
+  EXPECT_EQ(0, reader.ring()->underruns());
+}
@@ -22,6 +22,12 @@ bool hasSSE2();
 // Returns true if CPU supports SSE2, SSE3, and SSSE3.
 bool hasSSSE3();
 
+// Returns true if CPU and OS support AVX2.
+bool hasAVX2();
+
+// Returns true if CPU has NEON support.
+bool hasNEON();
+
 }  // namespace media
 
 #endif  // MEDIA_BASE_CPU_FEATURES_H_
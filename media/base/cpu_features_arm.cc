@@ -14,4 +14,19 @@ bool hasSSSE3() {
   return false;
 }
 
+bool hasAVX2() {
+  return false;
+}
+
+// The NEON kernels are only built with arm_neon=1, which compiles everything
+// with -mfpu=neon and so already requires NEON. Other builds have no NEON
+// code to choose, so there is nothing to detect at runtime.
+bool hasNEON() {
+#if defined(__ARM_NEON__)
+  return true;
+#else
+  return false;
+#endif
+}
+
 }  // namespace media
@@ -22,4 +22,12 @@ bool hasSSSE3() {
   return false;
 }
 
+bool hasAVX2() {
+  return false;
+}
+
+bool hasNEON() {
+  return false;
+}
+
 }  // namespace media
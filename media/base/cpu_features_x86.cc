@@ -12,10 +12,13 @@
 
 namespace media {
 
+// cpuid is always called with ecx cleared, which selects the first sub-leaf
+// of leaves that have them, such as leaf 7.
 #ifdef _MSC_VER
 static inline void getcpuid(int info_type, int info[4]) {
   __asm {
     mov    eax, [info_type]
+        xor    ecx, ecx
         cpuid
         mov    edi, [info]
         mov    [edi], eax
@@ -24,6 +27,20 @@ static inline void getcpuid(int info_type, int info[4]) {
         mov    [edi+12], edx
         }
 }
+
+// Returns the low half of the extended control register |xcr|, which says
+// which register states the OS saves on context switches.
+static inline int getxcr(int xcr) {
+  int result;
+  __asm {
+    mov    ecx, [xcr]
+        _emit  0x0f
+        _emit  0x01
+        _emit  0xd0
+        mov    [result], eax
+        }
+  return result;
+}
 #else
 static inline void getcpuid(int info_type, int info[4]) {
   // We save and restore ebx, so this code can be compatible with -fPIC
@@ -34,19 +51,30 @@ static inline void getcpuid(int info_type, int info[4]) {
         "movl %%ebx, %1   \n\t"
         "popl %%ebx       \n\t"
         : "=a"(info[0]), "=r"(info[1]), "=c"(info[2]), "=d"(info[3])
-        : "a"(info_type)
+        : "a"(info_type), "c"(0)
                 );
 #else
   // We can use cpuid instruction without pushing ebx on gcc x86-64 because it
   // does not use ebx (or rbx) as a GOT register.
   asm volatile (
       "cpuid            \n\t"
-      : "=a"(info[0]), "=r"(info[1]), "=c"(info[2]), "=d"(info[3])
-      : "a"(info_type)
-      : "%rbx"
+      : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3])
+      : "a"(info_type), "c"(0)
   );
 #endif
 }
+
+static inline int getxcr(int xcr) {
+  int result;
+  // xgetbv, which older assemblers don't know.
+  asm volatile (
+      ".byte 0x0f, 0x01, 0xd0  \n\t"
+      : "=a"(result)
+      : "c"(xcr)
+      : "%edx"
+  );
+  return result;
+}
 #endif
 
 bool hasMMX() {
@@ -89,4 +117,28 @@ bool hasSSSE3() {
       (cpu_info[2] & 0x00000200) != 0;
 }
 
+bool hasAVX2() {
+  int cpu_info[4] = { 0 };
+  getcpuid(0, cpu_info);
+  if (cpu_info[0] < 7)
+    return false;
+
+  // The CPU must support AVX, and the OS must save the YMM registers, which
+  // it reports through xgetbv when OSXSAVE is set.
+  getcpuid(1, cpu_info);
+  const int kAVXAndOSXSAVE = (1 << 28) | (1 << 27);
+  if ((cpu_info[2] & kAVXAndOSXSAVE) != kAVXAndOSXSAVE)
+    return false;
+  const int kXMMAndYMMState = (1 << 2) | (1 << 1);
+  if ((getxcr(0) & kXMMAndYMMState) != kXMMAndYMMState)
+    return false;
+
+  getcpuid(7, cpu_info);
+  return (cpu_info[1] & (1 << 5)) != 0;
+}
+
+bool hasNEON() {
+  return false;
+}
+
 }  // namespace media
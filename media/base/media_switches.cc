@@ -18,6 +18,10 @@ const char kAlsaInputDevice[] = "alsa-input-device";
 const char kUsePulseAudio[] = "use-pulseaudio";
 #endif
 
+// Play audio streams with the same parameters through one mixed output
+// stream.
+const char kEnableAudioMixer[] = "enable-audio-mixer";
+
 // Set number of threads to use for video decoding.
 const char kVideoThreads[] = "video-threads";
 
@@ -21,6 +21,8 @@ extern const char kAlsaInputDevice[];
 MEDIA_EXPORT extern const char kUsePulseAudio[];
 #endif
 
+MEDIA_EXPORT extern const char kEnableAudioMixer[];
+
 MEDIA_EXPORT extern const char kVideoThreads[];
 
 }  // namespace switches
@@ -11,23 +11,30 @@
 
 namespace media {
 
+// Size of the blocks that Append(const uint8*, size_t) copies into.
+static const size_t kBlockSize = 32 * 1024;
+
+// Maximum number of evicted blocks kept for reuse.
+static const size_t kMaxFreeBlocks = 8;
+
 SeekableBuffer::SeekableBuffer(size_t backward_capacity,
                                size_t forward_capacity)
-    : current_buffer_offset_(0),
+    : current_buffer_index_(0),
+      current_buffer_offset_(0),
       backward_capacity_(backward_capacity),
       backward_bytes_(0),
       forward_capacity_(forward_capacity),
       forward_bytes_(0),
       current_time_(kNoTimestamp()) {
-  current_buffer_ = buffers_.begin();
 }
 
 SeekableBuffer::~SeekableBuffer() {
 }
 
 void SeekableBuffer::Clear() {
-  buffers_.clear();
-  current_buffer_ = buffers_.begin();
+  while (!buffers_.empty())
+    PopFrontBuffer();
+  current_buffer_index_ = 0;
   current_buffer_offset_ = 0;
   backward_bytes_ = 0;
   forward_bytes_ = 0;
@@ -45,37 +52,56 @@ size_t SeekableBuffer::Peek(uint8* data, size_t size) {
 }
 
 bool SeekableBuffer::GetCurrentChunk(const uint8** data, size_t* size) const {
-  BufferQueue::iterator current_buffer = current_buffer_;
+  size_t current_buffer_index = current_buffer_index_;
   size_t current_buffer_offset = current_buffer_offset_;
   // Advance position if we are in the end of the current buffer.
-  while (current_buffer != buffers_.end() &&
-         current_buffer_offset >= (*current_buffer)->GetDataSize()) {
-    ++current_buffer;
+  while (current_buffer_index < buffers_.size() &&
+         current_buffer_offset >=
+             buffers_[current_buffer_index]->GetDataSize()) {
+    ++current_buffer_index;
     current_buffer_offset = 0;
   }
-  if (current_buffer == buffers_.end())
+  if (current_buffer_index == buffers_.size())
     return false;
-  *data = (*current_buffer)->GetData() + current_buffer_offset;
-  *size = (*current_buffer)->GetDataSize() - current_buffer_offset;
+  const Buffer* buffer = buffers_[current_buffer_index];
+  *data = buffer->GetData() + current_buffer_offset;
+  *size = buffer->GetDataSize() - current_buffer_offset;
   return true;
 }
 
+size_t SeekableBuffer::PeekSpans(size_t size, std::vector<Span>* spans) const {
+  spans->clear();
+  size_t taken = 0;
+  size_t offset = current_buffer_offset_;
+  for (size_t i = current_buffer_index_;
+       i < buffers_.size() && taken < size; ++i) {
+    const Buffer* buffer = buffers_[i];
+    size_t span_size = std::min(size - taken, buffer->GetDataSize() - offset);
+    if (span_size > 0) {
+      Span span = { buffer->GetData() + offset, span_size };
+      spans->push_back(span);
+      taken += span_size;
+    }
+    offset = 0;
+  }
+  return taken;
+}
+
+size_t SeekableBuffer::Consume(size_t size) {
+  return InternalRead(NULL, size, true);
+}
+
 bool SeekableBuffer::Append(Buffer* buffer_in) {
   if (buffers_.empty() && buffer_in->GetTimestamp().InMicroseconds() > 0) {
     current_time_ = buffer_in->GetTimestamp();
   }
 
   // Since the forward capacity is only used to check the criteria for buffer
-  // full, we always append data to the buffer.
+  // full, we always append data to the buffer. |current_buffer_index_| is
+  // already zero if this is the first buffer.
+  DCHECK(!buffers_.empty() || forward_bytes_ == 0u);
   buffers_.push_back(scoped_refptr<Buffer>(buffer_in));
 
-  // After we have written the first buffer, update |current_buffer_| to point
-  // to it.
-  if (current_buffer_ == buffers_.end()) {
-    DCHECK_EQ(0u, forward_bytes_);
-    current_buffer_ = buffers_.begin();
-  }
-
   // Update the |forward_bytes_| counter since we have more bytes.
   forward_bytes_ += buffer_in->GetDataSize();
 
@@ -88,15 +114,21 @@ bool SeekableBuffer::Append(Buffer* buffer_in) {
 }
 
 bool SeekableBuffer::Append(const uint8* data, size_t size) {
-  if (size > 0) {
-    DataBuffer* data_buffer = new DataBuffer(size);
-    memcpy(data_buffer->GetWritableData(), data, size);
-    data_buffer->SetDataSize(size);
-    return Append(data_buffer);
-  } else {
-    // Return true if we have forward capacity.
-    return forward_bytes_ < forward_capacity_;
+  // Fill up the last block before starting a new one. The bytes already in
+  // the block don't move, so this doesn't disturb readers.
+  while (size > 0) {
+    DataBuffer* block = GetAppendBlock();
+    size_t block_size = block->GetDataSize();
+    size_t copied = std::min(size, block->GetBufferSize() - block_size);
+    memcpy(block->GetWritableData() + block_size, data, copied);
+    block->SetDataSize(block_size + copied);
+    forward_bytes_ += copied;
+    data += copied;
+    size -= copied;
   }
+
+  // Return true if we have forward capacity.
+  return forward_bytes_ < forward_capacity_;
 }
 
 bool SeekableBuffer::Seek(int32 offset) {
@@ -125,10 +157,10 @@ bool SeekableBuffer::SeekBackward(size_t size) {
   size_t taken = 0;
   // Loop until we taken enough bytes and rewind by the desired |size|.
   while (taken < size) {
-    // |current_buffer_| can never be invalid when we are in this loop. It can
-    // only be invalid before any data is appended. The invalid case should be
-    // handled by checks before we enter this loop.
-    DCHECK(current_buffer_ != buffers_.end());
+    // |current_buffer_index_| can never be invalid when we are in this loop.
+    // It can only be invalid before any data is appended. The invalid case
+    // should be handled by checks before we enter this loop.
+    DCHECK_LT(current_buffer_index_, buffers_.size());
 
     // We try to consume at most |size| bytes in the backward direction. We also
     // have to account for the offset we are in the current buffer, so take the
@@ -149,37 +181,69 @@ bool SeekableBuffer::SeekBackward(size_t size) {
     backward_bytes_ -= consumed;
     DCHECK_GE(backward_bytes_, 0u);
 
-    // The current buffer pointed by current iterator has been consumed. Move
-    // the iterator backward so it points to the previous buffer.
+    // The current buffer has been consumed. Move back to the previous buffer.
     if (current_buffer_offset_ == 0) {
-      if (current_buffer_ == buffers_.begin())
+      if (current_buffer_index_ == 0)
         break;
-      // Move the iterator backward.
-      --current_buffer_;
+      --current_buffer_index_;
       // Set the offset into the current buffer to be the buffer size as we
       // are preparing for rewind for next iteration.
-      current_buffer_offset_ = (*current_buffer_)->GetDataSize();
+      current_buffer_offset_ = buffers_[current_buffer_index_]->GetDataSize();
     }
   }
 
-  UpdateCurrentTime(current_buffer_, current_buffer_offset_);
+  UpdateCurrentTime(current_buffer_index_, current_buffer_offset_);
 
   DCHECK_EQ(taken, size);
   return true;
 }
 
 void SeekableBuffer::EvictBackwardBuffers() {
-  // Advances the iterator until we hit the current pointer.
+  // Drops buffers from the front until we hit the current buffer.
   while (backward_bytes_ > backward_capacity_) {
-    BufferQueue::iterator i = buffers_.begin();
-    if (i == current_buffer_)
+    if (current_buffer_index_ == 0)
       break;
-    scoped_refptr<Buffer> buffer = *i;
-    backward_bytes_ -= buffer->GetDataSize();
+    backward_bytes_ -= buffers_.front()->GetDataSize();
     DCHECK_GE(backward_bytes_, 0u);
 
-    buffers_.erase(i);
+    PopFrontBuffer();
+    --current_buffer_index_;
+  }
+}
+
+void SeekableBuffer::PopFrontBuffer() {
+  // Blocks are appended to |buffers_| and |blocks_| in the same order, so an
+  // evicted block is always the first of |blocks_|.
+  bool is_block =
+      !blocks_.empty() && blocks_.front().get() == buffers_.front().get();
+  buffers_.pop_front();
+  if (!is_block)
+    return;
+
+  if (blocks_.front()->HasOneRef() && free_blocks_.size() < kMaxFreeBlocks)
+    free_blocks_.push_back(blocks_.front());
+  blocks_.pop_front();
+}
+
+DataBuffer* SeekableBuffer::GetAppendBlock() {
+  if (!buffers_.empty() && !blocks_.empty() &&
+      buffers_.back().get() == blocks_.back().get()) {
+    DataBuffer* block = blocks_.back();
+    if (block->GetDataSize() < block->GetBufferSize())
+      return block;
+  }
+
+  scoped_refptr<DataBuffer> block;
+  if (free_blocks_.empty()) {
+    block = new DataBuffer(kBlockSize);
+  } else {
+    block = free_blocks_.back();
+    free_blocks_.pop_back();
+    block->SetDataSize(0);
   }
+  blocks_.push_back(block);
+  Append(block);
+  return block;
 }
 
 size_t SeekableBuffer::InternalRead(uint8* data, size_t size,
@@ -187,16 +251,16 @@ size_t SeekableBuffer::InternalRead(uint8* data, size_t size,
   // Counts how many bytes are actually read from the buffer queue.
   size_t taken = 0;
 
-  BufferQueue::iterator current_buffer = current_buffer_;
+  size_t current_buffer_index = current_buffer_index_;
   size_t current_buffer_offset = current_buffer_offset_;
 
   while (taken < size) {
-    // |current_buffer| is valid since the first time this buffer is appended
-    // with data.
-    if (current_buffer == buffers_.end())
+    // |current_buffer_index| is valid since the first time this buffer is
+    // appended with data.
+    if (current_buffer_index == buffers_.size())
       break;
 
-    scoped_refptr<Buffer> buffer = *current_buffer;
+    const Buffer* buffer = buffers_[current_buffer_index];
 
     // Find the right amount to copy from the current buffer referenced by
     // |buffer|. We shall copy no more than |size| bytes in total and each
@@ -220,17 +284,15 @@ size_t SeekableBuffer::InternalRead(uint8* data, size_t size,
       if (advance_position) {
         // Next buffer may not have timestamp, so we need to update current
         // timestamp before switching to the next buffer.
-        UpdateCurrentTime(current_buffer, current_buffer_offset);
+        UpdateCurrentTime(current_buffer_index, current_buffer_offset);
       }
 
-      BufferQueue::iterator next = current_buffer;
-      ++next;
       // If we are at the last buffer, don't advance.
-      if (next == buffers_.end())
+      if (current_buffer_index + 1 == buffers_.size())
         break;
 
-      // Advances the iterator.
-      current_buffer = next;
+      // Advances to the next buffer.
+      ++current_buffer_index;
       current_buffer_offset = 0;
     }
   }
@@ -241,27 +303,27 @@ size_t SeekableBuffer::InternalRead(uint8* data, size_t size,
     forward_bytes_ -= taken;
     backward_bytes_ += taken;
     DCHECK_GE(forward_bytes_, 0u);
-    DCHECK(current_buffer_ != buffers_.end() || forward_bytes_ == 0u);
+    DCHECK(current_buffer_index < buffers_.size() || forward_bytes_ == 0u);
 
-    current_buffer_ = current_buffer;
+    current_buffer_index_ = current_buffer_index;
     current_buffer_offset_ = current_buffer_offset;
 
-    UpdateCurrentTime(current_buffer_, current_buffer_offset_);
+    UpdateCurrentTime(current_buffer_index_, current_buffer_offset_);
     EvictBackwardBuffers();
   }
 
   return taken;
 }
 
-void SeekableBuffer::UpdateCurrentTime(BufferQueue::iterator buffer,
-                                       size_t offset) {
+void SeekableBuffer::UpdateCurrentTime(size_t buffer_index, size_t offset) {
   // Garbage values are unavoidable, so this check will remain.
-  if (buffer != buffers_.end() &&
-      (*buffer)->GetTimestamp().InMicroseconds() > 0) {
-    int64 time_offset = ((*buffer)->GetDuration().InMicroseconds() *
-                         offset) / (*buffer)->GetDataSize();
+  if (buffer_index < buffers_.size() &&
+      buffers_[buffer_index]->GetTimestamp().InMicroseconds() > 0) {
+    const Buffer* buffer = buffers_[buffer_index];
+    int64 time_offset = (buffer->GetDuration().InMicroseconds() *
+                         offset) / buffer->GetDataSize();
 
-    current_time_ = (*buffer)->GetTimestamp() +
+    current_time_ = buffer->GetTimestamp() +
         base::TimeDelta::FromMicroseconds(time_offset);
   }
 }
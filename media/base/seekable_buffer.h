@@ -27,13 +27,19 @@
 // are not advised. Since this class is used as a backend buffer for caching
 // media files downloaded from network we cannot afford losing data, we can
 // only advise a halt of further writing to this buffer.
+//
+// Data appended with Append(const uint8*, size_t) is copied into fixed size
+// blocks, so that runs of small appends share a block. Blocks are recycled
+// once they have been read and evicted. PeekSpans() and Consume() let readers
+// use the buffered bytes in place instead of copying them out with Read().
 // This class is not inherently thread-safe. Concurrent access must be
 // externally serialized.
 
 #ifndef MEDIA_BASE_SEEKABLE_BUFFER_H_
 #define MEDIA_BASE_SEEKABLE_BUFFER_H_
 
-#include <list>
+#include <deque>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
@@ -41,8 +47,16 @@
 
 namespace media {
 
+class DataBuffer;
+
 class MEDIA_EXPORT SeekableBuffer {
  public:
+  // A contiguous run of buffered bytes.
+  struct Span {
+    const uint8* data;
+    size_t size;
+  };
+
   // Constructs an instance with |forward_capacity| and |backward_capacity|.
   // The values are in bytes.
   SeekableBuffer(size_t backward_capacity, size_t forward_capacity);
@@ -70,6 +84,17 @@ class MEDIA_EXPORT SeekableBuffer {
   // are called.
   bool GetCurrentChunk(const uint8** data, size_t* size) const;
 
+  // Replaces the contents of |spans| with pointers to the buffered bytes from
+  // the current position, up to |size| bytes in total. Returns the number of
+  // bytes covered. Nothing is copied and the current position doesn't move.
+  // The spans are valid until the next call to Read(), Consume(), Seek() or
+  // Clear().
+  size_t PeekSpans(size_t size, std::vector<Span>* spans) const;
+
+  // Advances the current position by up to |size| bytes, like Read() without
+  // copying. Returns the number of bytes consumed.
+  size_t Consume(size_t size);
+
   // Appends |buffer_in| to this buffer. Returns false if forward_bytes() is
   // greater than or equals to forward_capacity(), true otherwise. The data
   // is added to the buffer in any case.
@@ -126,7 +151,15 @@ class MEDIA_EXPORT SeekableBuffer {
 
  private:
   // Definition of the buffer queue.
-  typedef std::list<scoped_refptr<Buffer> > BufferQueue;
+  typedef std::deque<scoped_refptr<Buffer> > BufferQueue;
+
+  // Removes the first buffer from |buffers_|, keeping it for reuse if it is
+  // one of |blocks_|.
+  void PopFrontBuffer();
+
+  // Returns the last buffer if it is a block with room for more data,
+  // otherwise appends and returns an empty block.
+  DataBuffer* GetAppendBlock();
 
   // A helper method to evict buffers in the backward direction until backward
   // bytes is within the backward capacity.
@@ -155,12 +188,19 @@ class MEDIA_EXPORT SeekableBuffer {
 
   // Updates |current_time_| with the time that corresponds to the
   // specified position in the buffer.
-  void UpdateCurrentTime(BufferQueue::iterator buffer, size_t offset);
+  void UpdateCurrentTime(size_t buffer_index, size_t offset);
 
-  BufferQueue::iterator current_buffer_;
   BufferQueue buffers_;
+  size_t current_buffer_index_;
   size_t current_buffer_offset_;
 
+  // The blocks in |buffers_| that hold data from Append(const uint8*, size_t),
+  // in the same order.
+  std::deque<scoped_refptr<DataBuffer> > blocks_;
+
+  // Evicted blocks waiting to be reused.
+  std::vector<scoped_refptr<DataBuffer> > free_blocks_;
+
   size_t backward_capacity_;
   size_t backward_bytes_;
 
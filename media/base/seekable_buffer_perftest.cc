@@ -0,0 +1,120 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/perftimer.h"
+#include "base/time.h"
+#include "media/base/seekable_buffer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+// Bytes streamed through the buffer by each test.
+const size_t kStreamSize = 256 * 1024 * 1024;
+
+// Same capacities as the smallest BufferedResourceLoader buffer.
+const size_t kBackwardCapacity = 2 * 1024 * 1024;
+const size_t kForwardCapacity = 2 * 1024 * 1024;
+
+// Network reads arrive in chunks of up to this many bytes.
+const size_t kMaxAppendSize = 32 * 1024;
+
+// Demuxers read up to this many bytes at a time.
+const size_t kMaxReadSize = 64 * 1024;
+
+// One read in this many is preceded by a seek.
+const int kSeekInterval = 16;
+
+// A fixed pseudo random sequence, so that every run and every reader sees
+// the same appends, reads and seeks.
+class Random {
+ public:
+  Random() : seed_(1) {}
+
+  size_t Next(size_t range) {
+    seed_ = seed_ * 1103515245 + 12345;
+    return ((seed_ >> 8) & 0xffffff) % range;
+  }
+
+ private:
+  uint32 seed_;
+};
+
+}  // namespace
+
+class SeekableBufferPerfTest : public testing::Test {
+ protected:
+  SeekableBufferPerfTest() : source_(kMaxAppendSize), data_(kMaxReadSize) {
+    for (size_t i = 0; i < source_.size(); ++i)
+      source_[i] = static_cast<uint8>(i * 7 + (i >> 8));
+  }
+
+  // Streams kStreamSize bytes through a SeekableBuffer, reading either by
+  // copying or in place, and returns a checksum of the first and last byte of
+  // each read. Only the copying reader touches every byte it reads.
+  uint32 Stream(const char* name, bool in_place) {
+    SeekableBuffer buffer(kBackwardCapacity, kForwardCapacity);
+    Random random;
+    std::vector<SeekableBuffer::Span> spans;
+    uint32 checksum = 0;
+    size_t appended = 0;
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    while (appended < kStreamSize) {
+      // Fill the buffer up, then read half of it back.
+      while (buffer.forward_bytes() < kForwardCapacity) {
+        size_t size = 1 + random.Next(kMaxAppendSize);
+        buffer.Append(&source_[0], size);
+        appended += size;
+      }
+
+      while (buffer.forward_bytes() > kForwardCapacity / 2) {
+        if (random.Next(kSeekInterval) == 0) {
+          size_t position = random.Next(buffer.backward_bytes() +
+                                        buffer.forward_bytes() + 1);
+          int32 offset = static_cast<int32>(position) -
+                         static_cast<int32>(buffer.backward_bytes());
+          EXPECT_TRUE(buffer.Seek(offset));
+        }
+
+        size_t size = 1 + random.Next(kMaxReadSize);
+        if (in_place) {
+          size_t bytes = buffer.PeekSpans(size, &spans);
+          if (bytes) {
+            const SeekableBuffer::Span& last = spans.back();
+            checksum = checksum * 31 + spans[0].data[0];
+            checksum = checksum * 31 + last.data[last.size - 1];
+          }
+          buffer.Consume(bytes);
+        } else {
+          size_t bytes = buffer.Read(&data_[0], size);
+          if (bytes) {
+            checksum = checksum * 31 + data_[0];
+            checksum = checksum * 31 + data_[bytes - 1];
+          }
+        }
+      }
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    LogPerfResult(name, appended / elapsed.InSecondsF() / (1024 * 1024),
+                  "MB/s");
+    return checksum;
+  }
+
+  std::vector<uint8> source_;
+  std::vector<uint8> data_;
+};
+
+TEST_F(SeekableBufferPerfTest, StreamWithSeeks) {
+  uint32 copied = Stream("SeekableBuffer_stream_read", false);
+  uint32 in_place = Stream("SeekableBuffer_stream_peek_spans", true);
+  EXPECT_EQ(copied, in_place);
+}
+
+}  // namespace media
@@ -46,7 +46,19 @@ void ConvertRGB32ToYUV_SSE2(const uint8* rgbframe,
                             int ystride,
                             int uvstride);
 
-// This is a C reference implementation of the above routine.
+// AVX2 version of converting RGBA to YV12. The output is the same as
+// ConvertRGB32ToYUV_SSE2.
+void ConvertRGB32ToYUV_AVX2(const uint8* rgbframe,
+                            uint8* yplane,
+                            uint8* uplane,
+                            uint8* vplane,
+                            int width,
+                            int height,
+                            int rgbstride,
+                            int ystride,
+                            int uvstride);
+
+// This is a C reference implementation of ConvertRGB32ToYUV_SSE2.
 // This method should only be used in unit test.
 // TODO(hclam): Should use this as the C version of RGB to YUV.
 void ConvertRGB32ToYUV_SSE2_Reference(const uint8* rgbframe,
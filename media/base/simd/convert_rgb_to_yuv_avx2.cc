@@ -0,0 +1,143 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#include "media/base/simd/convert_rgb_to_yuv.h"
+
+namespace media {
+
+// Same fixed point coefficients as ConvertRGB32ToYUV_SSE2, laid out as B, G,
+// R and A multipliers for each pixel.
+#define FIX_SHIFT 12
+#define FIX(x) ((x) * (1 << FIX_SHIFT))
+
+#define PIXEL_COEFFICIENTS(b, g, r) \
+  FIX(b), FIX(g), FIX(r), 0, FIX(b), FIX(g), FIX(r), 0
+
+// Converts 8 pixels from each of two rows per loop iteration.
+static void ConvertRGB32ToYUVRow_AVX2(const uint8* rgb_buf_1,
+                                      const uint8* rgb_buf_2,
+                                      uint8* y_buf_1,
+                                      uint8* y_buf_2,
+                                      uint8* u_buf,
+                                      uint8* v_buf,
+                                      int width) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i y_table = _mm256_setr_epi16(
+      PIXEL_COEFFICIENTS(0.098, 0.504, 0.257),
+      PIXEL_COEFFICIENTS(0.098, 0.504, 0.257));
+  const __m256i u_table = _mm256_setr_epi16(
+      PIXEL_COEFFICIENTS(0.439, -0.291, -0.148),
+      PIXEL_COEFFICIENTS(0.439, -0.291, -0.148));
+  const __m256i v_table = _mm256_setr_epi16(
+      PIXEL_COEFFICIENTS(-0.071, -0.368, 0.439),
+      PIXEL_COEFFICIENTS(-0.071, -0.368, 0.439));
+  const __m256i y_offset = _mm256_set1_epi32(16);
+  const __m256i uv_offset = _mm256_set1_epi32(128);
+
+  for (int x = 0; x < width; x += 8) {
+    __m256i rgb_row_1 = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(rgb_buf_1 + x * 4));
+    __m256i rgb_row_2 = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(rgb_buf_2 + x * 4));
+
+    // Unpacking within 128-bit lanes gives pixels 0 1 4 5 in the low half and
+    // 2 3 6 7 in the high half, which horizontal adds put back in order.
+    __m256i rgb_lo_1 = _mm256_unpacklo_epi8(rgb_row_1, zero);
+    __m256i rgb_hi_1 = _mm256_unpackhi_epi8(rgb_row_1, zero);
+    __m256i rgb_lo_2 = _mm256_unpacklo_epi8(rgb_row_2, zero);
+    __m256i rgb_hi_2 = _mm256_unpackhi_epi8(rgb_row_2, zero);
+
+    __m256i y_1 = _mm256_hadd_epi32(_mm256_madd_epi16(rgb_lo_1, y_table),
+                                    _mm256_madd_epi16(rgb_hi_1, y_table));
+    __m256i y_2 = _mm256_hadd_epi32(_mm256_madd_epi16(rgb_lo_2, y_table),
+                                    _mm256_madd_epi16(rgb_hi_2, y_table));
+    y_1 = _mm256_add_epi32(_mm256_srai_epi32(y_1, FIX_SHIFT), y_offset);
+    y_2 = _mm256_add_epi32(_mm256_srai_epi32(y_2, FIX_SHIFT), y_offset);
+
+    // Gather the first row into the low lane and the second into the high
+    // lane before packing down to bytes.
+    __m256i y_12 = _mm256_permute4x64_epi64(_mm256_packs_epi32(y_1, y_2), 0xd8);
+    y_12 = _mm256_packus_epi16(y_12, y_12);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(y_buf_1 + x),
+                     _mm256_castsi256_si128(y_12));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(y_buf_2 + x),
+                     _mm256_extracti128_si256(y_12, 1));
+
+    // Add the two rows together, then each pair of columns, for the 2x2
+    // subsampled chroma.
+    __m256i rgb_lo = _mm256_add_epi16(rgb_lo_1, rgb_lo_2);
+    __m256i rgb_hi = _mm256_add_epi16(rgb_hi_1, rgb_hi_2);
+    __m256i u = _mm256_hadd_epi32(_mm256_madd_epi16(rgb_lo, u_table),
+                                  _mm256_madd_epi16(rgb_hi, u_table));
+    __m256i v = _mm256_hadd_epi32(_mm256_madd_epi16(rgb_lo, v_table),
+                                  _mm256_madd_epi16(rgb_hi, v_table));
+    __m256i uv = _mm256_permute4x64_epi64(_mm256_hadd_epi32(u, v), 0xd8);
+
+    // Right shift 14 because of 12 from fixed point and 2 from subsampling.
+    uv = _mm256_add_epi32(_mm256_srai_epi32(uv, FIX_SHIFT + 2), uv_offset);
+    uv = _mm256_packs_epi32(uv, uv);
+    uv = _mm256_packus_epi16(uv, uv);
+    *reinterpret_cast<int*>(u_buf + x / 2) =
+        _mm_cvtsi128_si32(_mm256_castsi256_si128(uv));
+    *reinterpret_cast<int*>(v_buf + x / 2) =
+        _mm_cvtsi128_si32(_mm256_extracti128_si256(uv, 1));
+  }
+}
+
+// The output matches ConvertRGB32ToYUV_SSE2, whose reference implementation
+// converts the columns and rows that don't fill a whole loop iteration.
+void ConvertRGB32ToYUV_AVX2(const uint8* rgbframe,
+                            uint8* yplane,
+                            uint8* uplane,
+                            uint8* vplane,
+                            int width,
+                            int height,
+                            int rgbstride,
+                            int ystride,
+                            int uvstride) {
+  int vector_width = width & ~7;
+  int vector_height = height & ~1;
+
+  for (int y = 0; y < vector_height; y += 2) {
+    ConvertRGB32ToYUVRow_AVX2(rgbframe + y * rgbstride,
+                              rgbframe + (y + 1) * rgbstride,
+                              yplane + y * ystride,
+                              yplane + (y + 1) * ystride,
+                              uplane + y / 2 * uvstride,
+                              vplane + y / 2 * uvstride,
+                              vector_width);
+  }
+
+  if (vector_width < width) {
+    ConvertRGB32ToYUV_SSE2_Reference(rgbframe + vector_width * 4,
+                                     yplane + vector_width,
+                                     uplane + vector_width / 2,
+                                     vplane + vector_width / 2,
+                                     width - vector_width,
+                                     vector_height,
+                                     rgbstride,
+                                     ystride,
+                                     uvstride);
+  }
+
+  if (vector_height < height) {
+    ConvertRGB32ToYUV_SSE2_Reference(rgbframe + vector_height * rgbstride,
+                                     yplane + vector_height * ystride,
+                                     uplane + vector_height / 2 * uvstride,
+                                     vplane + vector_height / 2 * uvstride,
+                                     width,
+                                     1,
+                                     rgbstride,
+                                     ystride,
+                                     uvstride);
+  }
+}
+
+}  // namespace media
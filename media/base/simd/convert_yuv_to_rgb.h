@@ -54,6 +54,28 @@ void ConvertYUVToRGB32_MMX(const uint8* yplane,
                            int rgbstride,
                            YUVType yuv_type);
 
+void ConvertYUVToRGB32_AVX2(const uint8* yplane,
+                            const uint8* uplane,
+                            const uint8* vplane,
+                            uint8* rgbframe,
+                            int width,
+                            int height,
+                            int ystride,
+                            int uvstride,
+                            int rgbstride,
+                            YUVType yuv_type);
+
+void ConvertYUVToRGB32_NEON(const uint8* yplane,
+                            const uint8* uplane,
+                            const uint8* vplane,
+                            uint8* rgbframe,
+                            int width,
+                            int height,
+                            int ystride,
+                            int uvstride,
+                            int rgbstride,
+                            YUVType yuv_type);
+
 }  // namespace media
 
 // Assembly functions are declared without namespace.
@@ -70,6 +92,13 @@ typedef void (*ScaleYUVToRGB32RowProc)(const uint8*,
                                        uint8*,
                                        int,
                                        int);
+typedef void (*LinearScaleYUVToRGB32RowWithRangeProc)(const uint8*,
+                                                      const uint8*,
+                                                      const uint8*,
+                                                      uint8*,
+                                                      int,
+                                                      int,
+                                                      int);
 
 void ConvertYUVToRGB32Row_C(const uint8* yplane,
                             const uint8* uplane,
@@ -89,6 +118,18 @@ void ConvertYUVToRGB32Row_SSE(const uint8* yplane,
                               uint8* rgbframe,
                               int width);
 
+void ConvertYUVToRGB32Row_AVX2(const uint8* yplane,
+                               const uint8* uplane,
+                               const uint8* vplane,
+                               uint8* rgbframe,
+                               int width);
+
+void ConvertYUVToRGB32Row_NEON(const uint8* yplane,
+                               const uint8* uplane,
+                               const uint8* vplane,
+                               uint8* rgbframe,
+                               int width);
+
 void ScaleYUVToRGB32Row_C(const uint8* y_buf,
                           const uint8* u_buf,
                           const uint8* v_buf,
@@ -117,6 +158,20 @@ void ScaleYUVToRGB32Row_SSE2_X64(const uint8* y_buf,
                                  int width,
                                  int source_dx);
 
+void ScaleYUVToRGB32Row_AVX2(const uint8* y_buf,
+                             const uint8* u_buf,
+                             const uint8* v_buf,
+                             uint8* rgb_buf,
+                             int width,
+                             int source_dx);
+
+void ScaleYUVToRGB32Row_NEON(const uint8* y_buf,
+                             const uint8* u_buf,
+                             const uint8* v_buf,
+                             uint8* rgb_buf,
+                             int width,
+                             int source_dx);
+
 void LinearScaleYUVToRGB32Row_C(const uint8* y_buf,
                                 const uint8* u_buf,
                                 const uint8* v_buf,
@@ -153,6 +208,21 @@ void LinearScaleYUVToRGB32Row_MMX_X64(const uint8* y_buf,
                                       int width,
                                       int source_dx);
 
+void LinearScaleYUVToRGB32Row_AVX2(const uint8* y_buf,
+                                   const uint8* u_buf,
+                                   const uint8* v_buf,
+                                   uint8* rgb_buf,
+                                   int width,
+                                   int source_dx);
+
+void LinearScaleYUVToRGB32RowWithRange_AVX2(const uint8* y_buf,
+                                            const uint8* u_buf,
+                                            const uint8* v_buf,
+                                            uint8* rgb_buf,
+                                            int dest_width,
+                                            int source_x,
+                                            int source_dx);
+
 }  // extern "C"
 
 #endif  // MEDIA_BASE_SIMD_CONVERT_YUV_TO_RGB_H_
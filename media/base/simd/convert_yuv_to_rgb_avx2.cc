@@ -0,0 +1,244 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// AVX2 versions of the YUV to RGB row converters. Pixels are converted eight
+// at a time by gathering the entries of kCoefficientsRgbY and combining them
+// with the same saturating adds and shifts as the C version, so the output is
+// bit-exact with ConvertYUVToRGB32Row_C and friends.
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#include "media/base/simd/convert_yuv_to_rgb.h"
+#include "media/base/simd/yuv_to_rgb_table.h"
+
+namespace {
+
+// Number of pixels converted by each loop iteration.
+const int kPixelsPerLoop = 8;
+
+// Converts eight pixels given the Y values of each pixel in |y| and the U and
+// V values shared by each pair of pixels in |u| and |v|, and returns them as
+// packed ARGB.
+inline __m256i ConvertYUVToRGB32Pixels(__m256i y, __m128i u, __m128i v) {
+  const long long* table = reinterpret_cast<const long long*>(
+      kCoefficientsRgbY);
+
+  // Each table row is 4 int16s, so gathering 64 bits per index fetches the
+  // B, G, R and A terms of a pixel at once.
+  __m256i uv = _mm256_adds_epi16(
+      _mm256_i32gather_epi64(table + 256, u, 8),
+      _mm256_i32gather_epi64(table + 512, v, 8));
+  __m256i y_0123 = _mm256_i32gather_epi64(
+      table, _mm256_castsi256_si128(y), 8);
+  __m256i y_4567 = _mm256_i32gather_epi64(
+      table, _mm256_extracti128_si256(y, 1), 8);
+
+  // Each pair of pixels shares its U and V terms.
+  __m256i rgb_0123 = _mm256_adds_epi16(
+      _mm256_permute4x64_epi64(uv, 0x50), y_0123);
+  __m256i rgb_4567 = _mm256_adds_epi16(
+      _mm256_permute4x64_epi64(uv, 0xfa), y_4567);
+  rgb_0123 = _mm256_srai_epi16(rgb_0123, 6);
+  rgb_4567 = _mm256_srai_epi16(rgb_4567, 6);
+
+  // Packing works within each 128-bit lane, which leaves the pixels in the
+  // order 0 1 4 5 2 3 6 7.
+  __m256i rgb = _mm256_packus_epi16(rgb_0123, rgb_4567);
+  return _mm256_permute4x64_epi64(rgb, 0xd8);
+}
+
+}  // namespace
+
+extern "C" {
+
+void ConvertYUVToRGB32Row_AVX2(const uint8* y_buf,
+                               const uint8* u_buf,
+                               const uint8* v_buf,
+                               uint8* rgb_buf,
+                               int width) {
+  int x = 0;
+  for (; x + kPixelsPerLoop <= width; x += kPixelsPerLoop) {
+    __m256i y = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(y_buf + x)));
+    __m128i u = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(
+        *reinterpret_cast<const int*>(u_buf + x / 2)));
+    __m128i v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(
+        *reinterpret_cast<const int*>(v_buf + x / 2)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgb_buf + x * 4),
+                        ConvertYUVToRGB32Pixels(y, u, v));
+  }
+
+  if (x < width) {
+    ConvertYUVToRGB32Row_C(y_buf + x, u_buf + x / 2, v_buf + x / 2,
+                           rgb_buf + x * 4, width - x);
+  }
+}
+
+// The source positions are stepped in 16.16 fixed point like the C version.
+// The samples are read one at a time because the positions may run
+// backwards, and gathering whole words could read past either end of a row.
+void ScaleYUVToRGB32Row_AVX2(const uint8* y_buf,
+                             const uint8* u_buf,
+                             const uint8* v_buf,
+                             uint8* rgb_buf,
+                             int width,
+                             int source_dx) {
+  int x = 0;
+  while (width > 0) {
+    int pixels = std::min(width, kPixelsPerLoop);
+    int32 y[kPixelsPerLoop] = { 0 };
+    int32 u[kPixelsPerLoop / 2] = { 0 };
+    int32 v[kPixelsPerLoop / 2] = { 0 };
+    for (int i = 0; i < pixels; ++i) {
+      if (!(i & 1)) {
+        u[i / 2] = u_buf[x >> 17];
+        v[i / 2] = v_buf[x >> 17];
+      }
+      y[i] = y_buf[x >> 16];
+      x += source_dx;
+    }
+
+    __m256i rgb = ConvertYUVToRGB32Pixels(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(u)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(v)));
+    if (pixels == kPixelsPerLoop) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgb_buf), rgb);
+    } else {
+      uint8 last[kPixelsPerLoop * 4];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(last), rgb);
+      memcpy(rgb_buf, last, pixels * 4);
+    }
+    rgb_buf += pixels * 4;
+    width -= pixels;
+  }
+}
+
+void LinearScaleYUVToRGB32Row_AVX2(const uint8* y_buf,
+                                   const uint8* u_buf,
+                                   const uint8* v_buf,
+                                   uint8* rgb_buf,
+                                   int width,
+                                   int source_dx) {
+  // Avoid point-sampling for down-scaling by > 2:1.
+  int source_x = 0;
+  if (source_dx >= 0x20000)
+    source_x += 0x8000;
+  LinearScaleYUVToRGB32RowWithRange_AVX2(y_buf, u_buf, v_buf, rgb_buf, width,
+                                         source_x, source_dx);
+}
+
+// Interpolates in 32-bit lanes, where the 16-bit fractions multiply the
+// samples without overflow exactly as in the C version.
+void LinearScaleYUVToRGB32RowWithRange_AVX2(const uint8* y_buf,
+                                            const uint8* u_buf,
+                                            const uint8* v_buf,
+                                            uint8* rgb_buf,
+                                            int dest_width,
+                                            int x,
+                                            int source_dx) {
+  const __m256i fraction_mask = _mm256_set1_epi32(65535);
+  const __m256i even_pixels = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  const __m256i steps = _mm256_mullo_epi32(
+      _mm256_set1_epi32(source_dx), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+  while (dest_width > 0) {
+    int pixels = std::min(dest_width, kPixelsPerLoop);
+    int32 y0[kPixelsPerLoop] = { 0 };
+    int32 y1[kPixelsPerLoop] = { 0 };
+    int32 uv0[kPixelsPerLoop] = { 0 };
+    int32 uv1[kPixelsPerLoop] = { 0 };
+    int source_x = x;
+    for (int i = 0; i < pixels; ++i) {
+      if (!(i & 1)) {
+        // U goes in the low half and V in the high half.
+        uv0[i / 2] = u_buf[source_x >> 17];
+        uv1[i / 2] = u_buf[(source_x >> 17) + 1];
+        uv0[i / 2 + 4] = v_buf[source_x >> 17];
+        uv1[i / 2 + 4] = v_buf[(source_x >> 17) + 1];
+      }
+      y0[i] = y_buf[source_x >> 16];
+      y1[i] = y_buf[(source_x >> 16) + 1];
+      source_x += source_dx;
+    }
+
+    __m256i positions = _mm256_add_epi32(_mm256_set1_epi32(x), steps);
+    __m256i y_fraction = _mm256_and_si256(positions, fraction_mask);
+    __m256i y = _mm256_add_epi32(
+        _mm256_mullo_epi32(
+            y_fraction,
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y1))),
+        _mm256_mullo_epi32(
+            _mm256_xor_si256(y_fraction, fraction_mask),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y0))));
+    y = _mm256_srli_epi32(y, 16);
+
+    // The chroma of each pair of pixels is sampled at the first of the pair,
+    // for both U and V.
+    __m256i uv_fraction = _mm256_and_si256(
+        _mm256_srai_epi32(
+            _mm256_permutevar8x32_epi32(positions, even_pixels), 1),
+        fraction_mask);
+    __m256i uv = _mm256_add_epi32(
+        _mm256_mullo_epi32(
+            uv_fraction,
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv1))),
+        _mm256_mullo_epi32(
+            _mm256_xor_si256(uv_fraction, fraction_mask),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv0))));
+    uv = _mm256_srli_epi32(uv, 16);
+
+    __m256i rgb = ConvertYUVToRGB32Pixels(
+        y, _mm256_castsi256_si128(uv), _mm256_extracti128_si256(uv, 1));
+    if (pixels == kPixelsPerLoop) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgb_buf), rgb);
+    } else {
+      uint8 last[kPixelsPerLoop * 4];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(last), rgb);
+      memcpy(rgb_buf, last, pixels * 4);
+    }
+    x = source_x;
+    rgb_buf += pixels * 4;
+    dest_width -= pixels;
+  }
+}
+
+}  // extern "C"
+
+namespace media {
+
+void ConvertYUVToRGB32_AVX2(const uint8* yplane,
+                            const uint8* uplane,
+                            const uint8* vplane,
+                            uint8* rgbframe,
+                            int width,
+                            int height,
+                            int ystride,
+                            int uvstride,
+                            int rgbstride,
+                            YUVType yuv_type) {
+  unsigned int y_shift = yuv_type;
+  for (int y = 0; y < height; ++y) {
+    uint8* rgb_row = rgbframe + y * rgbstride;
+    const uint8* y_ptr = yplane + y * ystride;
+    const uint8* u_ptr = uplane + (y >> y_shift) * uvstride;
+    const uint8* v_ptr = vplane + (y >> y_shift) * uvstride;
+
+    ConvertYUVToRGB32Row_AVX2(y_ptr,
+                              u_ptr,
+                              v_ptr,
+                              rgb_row,
+                              width);
+  }
+}
+
+}  // namespace media
@@ -0,0 +1,108 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// NEON versions of the YUV to RGB row converters. NEON has no gather, so the
+// entries of kCoefficientsRgbY are loaded per pixel, but the saturating adds,
+// shifts and packing of each pair of pixels are done together. The output is
+// bit-exact with ConvertYUVToRGB32Row_C and ScaleYUVToRGB32Row_C.
+
+#include <arm_neon.h>
+
+#include "media/base/simd/convert_yuv_to_rgb.h"
+#include "media/base/simd/yuv_to_rgb_table.h"
+
+namespace {
+
+// Converts two pixels that share |u| and |v| and returns them as packed ARGB.
+inline uint8x8_t ConvertYUVToRGB32Pair(int y0, int y1, int u, int v) {
+  int16x4_t uv = vqadd_s16(vld1_s16(kCoefficientsRgbY[256 + u]),
+                           vld1_s16(kCoefficientsRgbY[512 + v]));
+  int16x8_t rgb = vqaddq_s16(vcombine_s16(uv, uv),
+                             vcombine_s16(vld1_s16(kCoefficientsRgbY[y0]),
+                                          vld1_s16(kCoefficientsRgbY[y1])));
+  return vqmovun_s16(vshrq_n_s16(rgb, 6));
+}
+
+// Stores the first pixel of |rgb|, for rows with an odd width.
+inline void StoreFirstPixel(uint8* rgb_buf, uint8x8_t rgb) {
+  vst1_lane_u32(reinterpret_cast<uint32*>(rgb_buf),
+                vreinterpret_u32_u8(rgb), 0);
+}
+
+}  // namespace
+
+extern "C" {
+
+void ConvertYUVToRGB32Row_NEON(const uint8* y_buf,
+                               const uint8* u_buf,
+                               const uint8* v_buf,
+                               uint8* rgb_buf,
+                               int width) {
+  int x = 0;
+  for (; x + 2 <= width; x += 2) {
+    vst1_u8(rgb_buf, ConvertYUVToRGB32Pair(y_buf[x], y_buf[x + 1],
+                                           u_buf[x >> 1], v_buf[x >> 1]));
+    rgb_buf += 8;
+  }
+  if (x < width) {
+    StoreFirstPixel(rgb_buf, ConvertYUVToRGB32Pair(y_buf[x], 0,
+                                                   u_buf[x >> 1],
+                                                   v_buf[x >> 1]));
+  }
+}
+
+// 16.16 fixed point is used like ScaleYUVToRGB32Row_C.
+void ScaleYUVToRGB32Row_NEON(const uint8* y_buf,
+                             const uint8* u_buf,
+                             const uint8* v_buf,
+                             uint8* rgb_buf,
+                             int width,
+                             int source_dx) {
+  int x = 0;
+  for (int i = 0; i < width; i += 2) {
+    int y0 = y_buf[x >> 16];
+    int u = u_buf[x >> 17];
+    int v = v_buf[x >> 17];
+    x += source_dx;
+    if ((i + 1) < width) {
+      int y1 = y_buf[x >> 16];
+      x += source_dx;
+      vst1_u8(rgb_buf, ConvertYUVToRGB32Pair(y0, y1, u, v));
+    } else {
+      StoreFirstPixel(rgb_buf, ConvertYUVToRGB32Pair(y0, 0, u, v));
+    }
+    rgb_buf += 8;
+  }
+}
+
+}  // extern "C"
+
+namespace media {
+
+void ConvertYUVToRGB32_NEON(const uint8* yplane,
+                            const uint8* uplane,
+                            const uint8* vplane,
+                            uint8* rgbframe,
+                            int width,
+                            int height,
+                            int ystride,
+                            int uvstride,
+                            int rgbstride,
+                            YUVType yuv_type) {
+  unsigned int y_shift = yuv_type;
+  for (int y = 0; y < height; ++y) {
+    uint8* rgb_row = rgbframe + y * rgbstride;
+    const uint8* y_ptr = yplane + y * ystride;
+    const uint8* u_ptr = uplane + (y >> y_shift) * uvstride;
+    const uint8* v_ptr = vplane + (y >> y_shift) * uvstride;
+
+    ConvertYUVToRGB32Row_NEON(y_ptr,
+                              u_ptr,
+                              v_ptr,
+                              rgb_row,
+                              width);
+  }
+}
+
+}  // namespace media
@@ -36,6 +36,14 @@
 namespace media {
 
 static FilterYUVRowsProc ChooseFilterYUVRowsProc() {
+#if defined(MEDIA_USE_AVX2)
+  if (hasAVX2())
+    return &FilterYUVRows_AVX2;
+#endif
+#if defined(MEDIA_USE_NEON)
+  if (hasNEON())
+    return &FilterYUVRows_NEON;
+#endif
 #if defined(ARCH_CPU_X86_FAMILY)
   if (hasSSE2())
     return &FilterYUVRows_SSE2;
@@ -46,6 +54,14 @@ static FilterYUVRowsProc ChooseFilterYUVRowsProc() {
 }
 
 static ConvertYUVToRGB32RowProc ChooseConvertYUVToRGB32RowProc() {
+#if defined(MEDIA_USE_AVX2)
+  if (hasAVX2())
+    return &ConvertYUVToRGB32Row_AVX2;
+#endif
+#if defined(MEDIA_USE_NEON)
+  if (hasNEON())
+    return &ConvertYUVToRGB32Row_NEON;
+#endif
 #if defined(ARCH_CPU_X86_FAMILY)
   if (hasSSE())
     return &ConvertYUVToRGB32Row_SSE;
@@ -56,6 +72,14 @@ static ConvertYUVToRGB32RowProc ChooseConvertYUVToRGB32RowProc() {
 }
 
 static ScaleYUVToRGB32RowProc ChooseScaleYUVToRGB32RowProc() {
+#if defined(MEDIA_USE_AVX2)
+  if (hasAVX2())
+    return &ScaleYUVToRGB32Row_AVX2;
+#endif
+#if defined(MEDIA_USE_NEON)
+  if (hasNEON())
+    return &ScaleYUVToRGB32Row_NEON;
+#endif
 #if defined(ARCH_CPU_X86_FAMILY)
 #if defined(ARCH_CPU_X86_64)
   // Use 64-bits version if possible.
@@ -71,6 +95,10 @@ static ScaleYUVToRGB32RowProc ChooseScaleYUVToRGB32RowProc() {
 }
 
 static ScaleYUVToRGB32RowProc ChooseLinearScaleYUVToRGB32RowProc() {
+#if defined(MEDIA_USE_AVX2)
+  if (hasAVX2())
+    return &LinearScaleYUVToRGB32Row_AVX2;
+#endif
 #if defined(ARCH_CPU_X86_FAMILY)
 #if defined(ARCH_CPU_X86_64)
   // Use 64-bits version if possible.
@@ -85,6 +113,15 @@ static ScaleYUVToRGB32RowProc ChooseLinearScaleYUVToRGB32RowProc() {
   return &LinearScaleYUVToRGB32Row_C;
 }
 
+static LinearScaleYUVToRGB32RowWithRangeProc
+ChooseLinearScaleYUVToRGB32RowWithRangeProc() {
+#if defined(MEDIA_USE_AVX2)
+  if (hasAVX2())
+    return &LinearScaleYUVToRGB32RowWithRange_AVX2;
+#endif
+  return &LinearScaleYUVToRGB32RowWithRange_C;
+}
+
 // Empty SIMD registers state after using them.
 void EmptyRegisterState() {
 #if defined(ARCH_CPU_X86_FAMILY)
@@ -295,8 +332,11 @@ void ScaleYUVToRGB32WithRect(const uint8* y_buf,
                              int uv_pitch,
                              int rgb_pitch) {
   static FilterYUVRowsProc filter_proc = NULL;
+  static LinearScaleYUVToRGB32RowWithRangeProc linear_scale_proc = NULL;
   if (!filter_proc)
     filter_proc = ChooseFilterYUVRowsProc();
+  if (!linear_scale_proc)
+    linear_scale_proc = ChooseLinearScaleYUVToRGB32RowWithRangeProc();
 
   // This routine doesn't currently support up-scaling.
   CHECK(dest_width <= source_width && dest_height <= source_height);
@@ -355,9 +395,11 @@ void ScaleYUVToRGB32WithRect(const uint8* y_buf,
   // The buffer is 16-byte aligned and padded with 16 extra bytes; some of the
   // FilterYUVRowProcs have alignment requirements, and the SSE version can
   // write up to 16 bytes past the end of the buffer.
+  // Frames that are too wide are not filtered vertically. This is decided
+  // per call, since calls for different bands of a frame can run concurrently.
   const int kFilterBufferSize = 4096;
-  if (source_width > kFilterBufferSize)
-    filter_proc = NULL;
+  FilterYUVRowsProc row_filter_proc =
+      source_width > kFilterBufferSize ? NULL : filter_proc;
   uint8 yuv_temp[16 + kFilterBufferSize * 3 + 16];
   uint8* y_temp =
       reinterpret_cast<uint8*>(
@@ -399,24 +441,24 @@ void ScaleYUVToRGB32WithRect(const uint8* y_buf,
       v1_ptr = v0_ptr + uv_pitch;
     }
 
-    if (filter_proc) {
+    if (row_filter_proc) {
       // Vertical scaler uses 16.8 fixed point.
       int fraction = (source_top & kFractionMask) >> 8;
-      filter_proc(y_temp + source_y_left, y0_ptr, y1_ptr,
-                  source_y_width, fraction);
-      filter_proc(u_temp + source_uv_left, u0_ptr, u1_ptr,
-                  source_uv_width, fraction);
-      filter_proc(v_temp + source_uv_left, v0_ptr, v1_ptr,
-                  source_uv_width, fraction);
+      row_filter_proc(y_temp + source_y_left, y0_ptr, y1_ptr,
+                      source_y_width, fraction);
+      row_filter_proc(u_temp + source_uv_left, u0_ptr, u1_ptr,
+                      source_uv_width, fraction);
+      row_filter_proc(v_temp + source_uv_left, v0_ptr, v1_ptr,
+                      source_uv_width, fraction);
 
       // Perform horizontal interpolation and color space conversion.
       // TODO(hclam): Use the MMX version after more testing.
-      LinearScaleYUVToRGB32RowWithRange_C(
+      linear_scale_proc(
           y_temp, u_temp, v_temp, rgb_buf,
           dest_rect_width, source_left, x_step);
     } else {
       // If the frame is too large then we linear scale a single row.
-      LinearScaleYUVToRGB32RowWithRange_C(
+      linear_scale_proc(
           y0_ptr, u0_ptr, v0_ptr, rgb_buf,
           dest_rect_width, source_left, x_step);
     }
@@ -448,7 +490,12 @@ void ConvertRGB32ToYUV(const uint8* rgbframe,
 #else
     // TODO(hclam): Switch to SSSE3 version when the cyan problem is solved.
     // See: crbug.com/100462
-      if (hasSSE2())
+#if defined(MEDIA_USE_AVX2)
+    if (hasAVX2())
+      convert_proc = &ConvertRGB32ToYUV_AVX2;
+    else
+#endif
+    if (hasSSE2())
       convert_proc = &ConvertRGB32ToYUV_SSE2;
     else
       convert_proc = &ConvertRGB32ToYUV_C;
@@ -525,11 +572,24 @@ void ConvertYUVToRGB32(const uint8* yplane,
                        int rgbstride,
                        YUVType yuv_type) {
 #if defined(ARCH_CPU_ARM_FAMILY)
+#if defined(MEDIA_USE_NEON)
+  if (hasNEON()) {
+    ConvertYUVToRGB32_NEON(yplane, uplane, vplane, rgbframe,
+                           width, height, ystride, uvstride, rgbstride,
+                           yuv_type);
+    return;
+  }
+#endif
   ConvertYUVToRGB32_C(yplane, uplane, vplane, rgbframe,
                       width, height, ystride, uvstride, rgbstride, yuv_type);
 #else
   static ConvertYUVToRGB32Proc convert_proc = NULL;
   if (!convert_proc) {
+#if defined(MEDIA_USE_AVX2)
+    if (hasAVX2())
+      convert_proc = &ConvertYUVToRGB32_AVX2;
+    else
+#endif
     if (hasSSE())
       convert_proc = &ConvertYUVToRGB32_SSE;
     else if (hasMMX())
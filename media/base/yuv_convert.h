@@ -86,6 +86,36 @@ void ScaleYUVToRGB32WithRect(const uint8* yplane,
                              int uvstride,
                              int rgbstride);
 
+// Same as ConvertYUVToRGB32() and ScaleYUVToRGB32WithRect(), but large frames
+// are split into bands of rows that are converted on a few worker threads.
+// The output is identical to the serial versions.
+void ConvertYUVToRGB32Parallel(const uint8* yplane,
+                               const uint8* uplane,
+                               const uint8* vplane,
+                               uint8* rgbframe,
+                               int width,
+                               int height,
+                               int ystride,
+                               int uvstride,
+                               int rgbstride,
+                               YUVType yuv_type);
+
+void ScaleYUVToRGB32WithRectParallel(const uint8* yplane,
+                                     const uint8* uplane,
+                                     const uint8* vplane,
+                                     uint8* rgbframe,
+                                     int source_width,
+                                     int source_height,
+                                     int dest_width,
+                                     int dest_height,
+                                     int dest_rect_left,
+                                     int dest_rect_top,
+                                     int dest_rect_right,
+                                     int dest_rect_bottom,
+                                     int ystride,
+                                     int uvstride,
+                                     int rgbstride);
+
 void ConvertRGB32ToYUV(const uint8* rgbframe,
                        uint8* yplane,
                        uint8* uplane,
@@ -0,0 +1,340 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Each row of the converted frame depends only on the source and its own
+// position, so a frame can be split into bands of rows that are converted
+// concurrently, with output identical to converting the whole frame at once.
+
+#include "media/base/yuv_convert.h"
+
+#include <algorithm>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/memory/scoped_vector.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/sys_info.h"
+#include "base/threading/simple_thread.h"
+
+namespace media {
+
+namespace {
+
+// Frames are split into bands of at least this many destination pixels, so
+// that handing a band to another thread costs much less than converting it.
+const int kMinPixelsPerBand = 256 * 1024;
+
+// Conversion is bound by memory bandwidth well before it runs out of cores.
+const int kMaxWorkers = 3;
+
+// A conversion that can be run one band of rows at a time.
+class RowBandJob {
+ public:
+  virtual ~RowBandJob() {}
+
+  // Converts band |band| of |num_bands|. Bands don't overlap, so they may run
+  // concurrently in any order.
+  virtual void RunBand(int band, int num_bands) = 0;
+};
+
+// Returns the first row of band |band| of |num_bands| over |rows| rows,
+// rounded down to a multiple of |alignment|.
+int BandTop(int band, int num_bands, int rows, int alignment) {
+  if (band == num_bands)
+    return rows;
+  return rows * band / num_bands / alignment * alignment;
+}
+
+// A few threads that run the bands of a job together with the thread that
+// asks for it. The threads are started on first use and never exit.
+class RowBandWorkerPool : public base::DelegateSimpleThread::Delegate {
+ public:
+  RowBandWorkerPool()
+      : job_available_(&lock_),
+        job_done_(&lock_),
+        job_(NULL),
+        num_bands_(0),
+        next_band_(0),
+        bands_running_(0) {
+    int num_workers = std::min(base::SysInfo::NumberOfProcessors() - 1,
+                               kMaxWorkers);
+    for (int i = 0; i < num_workers; ++i) {
+      base::DelegateSimpleThread* worker =
+          new base::DelegateSimpleThread(this, "YUVConvertWorker");
+      worker->Start();
+      workers_.push_back(worker);
+    }
+  }
+
+  // Returns the number of threads that can run bands at once, including the
+  // calling thread.
+  int num_threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Runs every band of |job| and returns once they have all finished. If
+  // another thread is already running a job, the bands are all run on the
+  // calling thread instead of waiting for the workers.
+  void RunBands(RowBandJob* job, int num_bands) {
+    if (workers_.empty() || num_bands < 2 || !run_lock_.Try()) {
+      for (int i = 0; i < num_bands; ++i)
+        job->RunBand(i, num_bands);
+      return;
+    }
+
+    {
+      base::AutoLock auto_lock(lock_);
+      DCHECK(!job_);
+      job_ = job;
+      num_bands_ = num_bands;
+      next_band_ = 0;
+      job_available_.Broadcast();
+      RunBandsLocked();
+      while (next_band_ < num_bands_ || bands_running_)
+        job_done_.Wait();
+      job_ = NULL;
+    }
+    run_lock_.Release();
+  }
+
+ private:
+  // base::DelegateSimpleThread::Delegate implementation.
+  virtual void Run() OVERRIDE {
+    base::AutoLock auto_lock(lock_);
+    for (;;) {
+      while (!job_ || next_band_ == num_bands_)
+        job_available_.Wait();
+      RunBandsLocked();
+    }
+  }
+
+  // Claims and runs bands of the current job until none are left. |lock_|
+  // is released while each band runs.
+  void RunBandsLocked() {
+    lock_.AssertAcquired();
+    while (job_ && next_band_ < num_bands_) {
+      RowBandJob* job = job_;
+      int band = next_band_++;
+      int num_bands = num_bands_;
+      ++bands_running_;
+      {
+        base::AutoUnlock auto_unlock(lock_);
+        job->RunBand(band, num_bands);
+      }
+      --bands_running_;
+      if (next_band_ == num_bands_ && !bands_running_)
+        job_done_.Signal();
+    }
+  }
+
+  // Held by the thread whose job the workers are running.
+  base::Lock run_lock_;
+
+  // Protects the fields below.
+  base::Lock lock_;
+  base::ConditionVariable job_available_;
+  base::ConditionVariable job_done_;
+  RowBandJob* job_;
+  int num_bands_;
+  int next_band_;
+  int bands_running_;
+
+  ScopedVector<base::DelegateSimpleThread> workers_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowBandWorkerPool);
+};
+
+base::LazyInstance<RowBandWorkerPool>::Leaky g_row_band_worker_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+// Returns how many bands a conversion to |width| x |height| pixels should be
+// split into.
+int NumBands(int width, int height) {
+  int pixels = width * height;
+  if (pixels < kMinPixelsPerBand * 2)
+    return 1;
+  return std::min(g_row_band_worker_pool.Get().num_threads(),
+                  pixels / kMinPixelsPerBand);
+}
+
+class ConvertYUVToRGB32Job : public RowBandJob {
+ public:
+  ConvertYUVToRGB32Job(const uint8* yplane,
+                       const uint8* uplane,
+                       const uint8* vplane,
+                       uint8* rgbframe,
+                       int width,
+                       int height,
+                       int ystride,
+                       int uvstride,
+                       int rgbstride,
+                       YUVType yuv_type)
+      : yplane_(yplane),
+        uplane_(uplane),
+        vplane_(vplane),
+        rgbframe_(rgbframe),
+        width_(width),
+        height_(height),
+        ystride_(ystride),
+        uvstride_(uvstride),
+        rgbstride_(rgbstride),
+        yuv_type_(yuv_type) {
+  }
+
+  virtual void RunBand(int band, int num_bands) OVERRIDE {
+    // Bands start on even rows so that YV12 bands begin on a chroma row.
+    int top = BandTop(band, num_bands, height_, 2);
+    int bottom = BandTop(band + 1, num_bands, height_, 2);
+    if (top == bottom)
+      return;
+    ConvertYUVToRGB32(yplane_ + top * ystride_,
+                      uplane_ + (top >> yuv_type_) * uvstride_,
+                      vplane_ + (top >> yuv_type_) * uvstride_,
+                      rgbframe_ + top * rgbstride_,
+                      width_,
+                      bottom - top,
+                      ystride_,
+                      uvstride_,
+                      rgbstride_,
+                      yuv_type_);
+  }
+
+ private:
+  const uint8* yplane_;
+  const uint8* uplane_;
+  const uint8* vplane_;
+  uint8* rgbframe_;
+  int width_;
+  int height_;
+  int ystride_;
+  int uvstride_;
+  int rgbstride_;
+  YUVType yuv_type_;
+
+  DISALLOW_COPY_AND_ASSIGN(ConvertYUVToRGB32Job);
+};
+
+// ScaleYUVToRGB32WithRect computes each row from its position in the
+// destination, so each band is the same call with a shorter rectangle.
+class ScaleYUVToRGB32WithRectJob : public RowBandJob {
+ public:
+  ScaleYUVToRGB32WithRectJob(const uint8* yplane,
+                             const uint8* uplane,
+                             const uint8* vplane,
+                             uint8* rgbframe,
+                             int source_width,
+                             int source_height,
+                             int dest_width,
+                             int dest_height,
+                             int dest_rect_left,
+                             int dest_rect_top,
+                             int dest_rect_right,
+                             int dest_rect_bottom,
+                             int ystride,
+                             int uvstride,
+                             int rgbstride)
+      : yplane_(yplane),
+        uplane_(uplane),
+        vplane_(vplane),
+        rgbframe_(rgbframe),
+        source_width_(source_width),
+        source_height_(source_height),
+        dest_width_(dest_width),
+        dest_height_(dest_height),
+        dest_rect_left_(dest_rect_left),
+        dest_rect_top_(dest_rect_top),
+        dest_rect_right_(dest_rect_right),
+        dest_rect_bottom_(dest_rect_bottom),
+        ystride_(ystride),
+        uvstride_(uvstride),
+        rgbstride_(rgbstride) {
+  }
+
+  virtual void RunBand(int band, int num_bands) OVERRIDE {
+    int rows = dest_rect_bottom_ - dest_rect_top_;
+    int top = dest_rect_top_ + BandTop(band, num_bands, rows, 1);
+    int bottom = dest_rect_top_ + BandTop(band + 1, num_bands, rows, 1);
+    if (top == bottom)
+      return;
+    ScaleYUVToRGB32WithRect(yplane_, uplane_, vplane_, rgbframe_,
+                            source_width_, source_height_,
+                            dest_width_, dest_height_,
+                            dest_rect_left_, top, dest_rect_right_, bottom,
+                            ystride_, uvstride_, rgbstride_);
+  }
+
+ private:
+  const uint8* yplane_;
+  const uint8* uplane_;
+  const uint8* vplane_;
+  uint8* rgbframe_;
+  int source_width_;
+  int source_height_;
+  int dest_width_;
+  int dest_height_;
+  int dest_rect_left_;
+  int dest_rect_top_;
+  int dest_rect_right_;
+  int dest_rect_bottom_;
+  int ystride_;
+  int uvstride_;
+  int rgbstride_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScaleYUVToRGB32WithRectJob);
+};
+
+}  // namespace
+
+void ConvertYUVToRGB32Parallel(const uint8* yplane,
+                               const uint8* uplane,
+                               const uint8* vplane,
+                               uint8* rgbframe,
+                               int width,
+                               int height,
+                               int ystride,
+                               int uvstride,
+                               int rgbstride,
+                               YUVType yuv_type) {
+  ConvertYUVToRGB32Job job(yplane, uplane, vplane, rgbframe, width, height,
+                           ystride, uvstride, rgbstride, yuv_type);
+  int num_bands = NumBands(width, height);
+  if (num_bands < 2) {
+    job.RunBand(0, 1);
+    return;
+  }
+  g_row_band_worker_pool.Get().RunBands(&job, num_bands);
+}
+
+void ScaleYUVToRGB32WithRectParallel(const uint8* yplane,
+                                     const uint8* uplane,
+                                     const uint8* vplane,
+                                     uint8* rgbframe,
+                                     int source_width,
+                                     int source_height,
+                                     int dest_width,
+                                     int dest_height,
+                                     int dest_rect_left,
+                                     int dest_rect_top,
+                                     int dest_rect_right,
+                                     int dest_rect_bottom,
+                                     int ystride,
+                                     int uvstride,
+                                     int rgbstride) {
+  ScaleYUVToRGB32WithRectJob job(yplane, uplane, vplane, rgbframe,
+                                 source_width, source_height,
+                                 dest_width, dest_height,
+                                 dest_rect_left, dest_rect_top,
+                                 dest_rect_right, dest_rect_bottom,
+                                 ystride, uvstride, rgbstride);
+  int num_bands = NumBands(dest_rect_right - dest_rect_left,
+                           dest_rect_bottom - dest_rect_top);
+  if (num_bands < 2) {
+    job.RunBand(0, 1);
+    return;
+  }
+  g_row_band_worker_pool.Get().RunBands(&job, num_bands);
+}
+
+}  // namespace media
@@ -0,0 +1,450 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/perftimer.h"
+#include "base/rand_util.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "build/build_config.h"
+#include "media/base/cpu_features.h"
+#include "media/base/simd/convert_rgb_to_yuv.h"
+#include "media/base/simd/convert_yuv_to_rgb.h"
+#include "media/base/simd/filter_yuv.h"
+#include "media/base/yuv_convert.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+const int kFrames = 50;
+
+// 16.16 fixed point, as in yuv_convert.cc.
+const int kFractionBits = 16;
+const int kFractionMax = 1 << kFractionBits;
+const int kFractionMask = kFractionMax - 1;
+
+// Widest row that the vertical filter buffers hold.
+const int kFilterBufferSize = 4096;
+
+struct FrameSize {
+  const char* name;
+  int width;
+  int height;
+};
+
+const FrameSize k720p = { "720p", 1280, 720 };
+const FrameSize k1080p = { "1080p", 1920, 1080 };
+const FrameSize k2160p = { "2160p", 3840, 2160 };
+
+bool Always() {
+  return true;
+}
+
+// A row converter, with the kernel that it must match exactly, if any.
+struct ConvertKernel {
+  const char* name;
+  bool (*supported)();
+  ConvertYUVToRGB32RowProc convert;
+  ConvertYUVToRGB32RowProc reference;
+};
+
+const ConvertKernel kConvertKernels[] = {
+  { "c", &Always, &ConvertYUVToRGB32Row_C, NULL },
+#if defined(ARCH_CPU_X86_FAMILY)
+  { "mmx", &hasMMX, &ConvertYUVToRGB32Row_MMX, NULL },
+  { "sse", &hasSSE, &ConvertYUVToRGB32Row_SSE, NULL },
+#endif
+#if defined(MEDIA_USE_AVX2)
+  { "avx2", &hasAVX2, &ConvertYUVToRGB32Row_AVX2, &ConvertYUVToRGB32Row_C },
+#endif
+#if defined(MEDIA_USE_NEON)
+  { "neon", &hasNEON, &ConvertYUVToRGB32Row_NEON, &ConvertYUVToRGB32Row_C },
+#endif
+};
+
+// The kernels that ScaleYUVToRGB32 combines for scaling: vertical filtering,
+// then point sampled or bilinear horizontal scaling.
+struct ScaleKernel {
+  const char* name;
+  bool (*supported)();
+  FilterYUVRowsProc filter;
+  ScaleYUVToRGB32RowProc scale;
+  ScaleYUVToRGB32RowProc linear_scale;
+  bool bit_exact;
+};
+
+const ScaleKernel kScaleKernels[] = {
+  { "c", &Always, &FilterYUVRows_C, &ScaleYUVToRGB32Row_C,
+    &LinearScaleYUVToRGB32Row_C, true },
+#if defined(ARCH_CPU_X86_FAMILY)
+  { "mmx", &hasMMX, &FilterYUVRows_MMX, &ScaleYUVToRGB32Row_MMX,
+    &LinearScaleYUVToRGB32Row_MMX, false },
+  { "sse", &hasSSE2, &FilterYUVRows_SSE2, &ScaleYUVToRGB32Row_SSE,
+    &LinearScaleYUVToRGB32Row_SSE, false },
+#endif
+#if defined(ARCH_CPU_X86_64)
+  { "sse2_x64", &hasSSE2, &FilterYUVRows_SSE2, &ScaleYUVToRGB32Row_SSE2_X64,
+    &LinearScaleYUVToRGB32Row_MMX_X64, false },
+#endif
+#if defined(MEDIA_USE_AVX2)
+  { "avx2", &hasAVX2, &FilterYUVRows_AVX2, &ScaleYUVToRGB32Row_AVX2,
+    &LinearScaleYUVToRGB32Row_AVX2, true },
+#endif
+#if defined(MEDIA_USE_NEON)
+  { "neon", &hasNEON, &FilterYUVRows_NEON, &ScaleYUVToRGB32Row_NEON,
+    &LinearScaleYUVToRGB32Row_C, true },
+#endif
+};
+
+typedef void (*ConvertRGB32ToYUVProc)(const uint8*, uint8*, uint8*, uint8*,
+                                      int, int, int, int, int);
+
+struct RGBToYUVKernel {
+  const char* name;
+  bool (*supported)();
+  ConvertRGB32ToYUVProc convert;
+  ConvertRGB32ToYUVProc reference;
+};
+
+const RGBToYUVKernel kRGBToYUVKernels[] = {
+  { "c", &Always, &ConvertRGB32ToYUV_C, NULL },
+#if defined(ARCH_CPU_X86_FAMILY)
+  { "sse2", &hasSSE2, &ConvertRGB32ToYUV_SSE2,
+    &ConvertRGB32ToYUV_SSE2_Reference },
+  { "ssse3", &hasSSSE3, &ConvertRGB32ToYUV_SSSE3, NULL },
+#endif
+#if defined(MEDIA_USE_AVX2)
+  { "avx2", &hasAVX2, &ConvertRGB32ToYUV_AVX2,
+    &ConvertRGB32ToYUV_SSE2_Reference },
+#endif
+};
+
+// A YV12 frame and its RGB32 conversion.
+struct Frame {
+  explicit Frame(const FrameSize& size)
+      : width(size.width),
+        height(size.height),
+        y(width * height),
+        u(width / 2 * height / 2),
+        v(width / 2 * height / 2),
+        rgb(width * height * 4) {
+  }
+
+  void Randomize() {
+    base::RandBytes(&y[0], y.size());
+    base::RandBytes(&u[0], u.size());
+    base::RandBytes(&v[0], v.size());
+    base::RandBytes(&rgb[0], rgb.size());
+  }
+
+  int width;
+  int height;
+  std::vector<uint8> y;
+  std::vector<uint8> u;
+  std::vector<uint8> v;
+  std::vector<uint8> rgb;
+};
+
+void ConvertFrame(ConvertYUVToRGB32RowProc convert, Frame* frame) {
+  for (int row = 0; row < frame->height; ++row) {
+    convert(&frame->y[row * frame->width],
+            &frame->u[row / 2 * frame->width / 2],
+            &frame->v[row / 2 * frame->width / 2],
+            &frame->rgb[row * frame->width * 4],
+            frame->width);
+  }
+  EmptyRegisterState();
+}
+
+// Scales |source| into |dest| the way ScaleYUVToRGB32 does for unrotated
+// YV12 frames, using the kernels of |kernel|.
+void ScaleFrame(const ScaleKernel& kernel, const Frame& source, bool bilinear,
+                Frame* dest) {
+  uint8 filter_buffer[16 + kFilterBufferSize * 3 + 16];
+  uint8* ybuf = reinterpret_cast<uint8*>(
+      reinterpret_cast<uintptr_t>(filter_buffer + 15) & ~15);
+  uint8* ubuf = ybuf + kFilterBufferSize;
+  uint8* vbuf = ubuf + kFilterBufferSize;
+
+  int uv_width = source.width / 2;
+  int source_dx = source.width * kFractionMax / dest->width;
+  int source_dy = (source.height << kFractionBits) / dest->height;
+  for (int row = 0; row < dest->height; ++row) {
+    int source_y_subpixel = row * source_dy;
+    if (source_dy >= kFractionMax * 2)
+      source_y_subpixel += kFractionMax / 2;
+    int source_y = source_y_subpixel >> kFractionBits;
+    const uint8* y_ptr = &source.y[source_y * source.width];
+    const uint8* u_ptr = &source.u[(source_y >> 1) * uv_width];
+    const uint8* v_ptr = &source.v[(source_y >> 1) * uv_width];
+    uint8* rgb_ptr = &dest->rgb[row * dest->width * 4];
+
+    if (!bilinear) {
+      kernel.scale(y_ptr, u_ptr, v_ptr, rgb_ptr, dest->width, source_dx);
+      continue;
+    }
+
+    int y_fraction = (source_y_subpixel & kFractionMask) >> 8;
+    if (y_fraction && source_y + 1 < source.height) {
+      kernel.filter(ybuf, y_ptr, y_ptr + source.width, source.width,
+                    y_fraction);
+    } else {
+      memcpy(ybuf, y_ptr, source.width);
+    }
+    ybuf[source.width] = ybuf[source.width - 1];
+
+    int uv_fraction = ((source_y_subpixel >> 1) & kFractionMask) >> 8;
+    if (uv_fraction && (source_y >> 1) + 1 < source.height / 2) {
+      kernel.filter(ubuf, u_ptr, u_ptr + uv_width, uv_width, uv_fraction);
+      kernel.filter(vbuf, v_ptr, v_ptr + uv_width, uv_width, uv_fraction);
+    } else {
+      memcpy(ubuf, u_ptr, uv_width);
+      memcpy(vbuf, v_ptr, uv_width);
+    }
+    ubuf[uv_width] = ubuf[uv_width - 1];
+    vbuf[uv_width] = vbuf[uv_width - 1];
+
+    kernel.linear_scale(ybuf, ubuf, vbuf, rgb_ptr, dest->width, source_dx);
+  }
+  EmptyRegisterState();
+}
+
+void ConvertFrameToYUV(ConvertRGB32ToYUVProc convert, Frame* frame) {
+  convert(&frame->rgb[0], &frame->y[0], &frame->u[0], &frame->v[0],
+          frame->width, frame->height, frame->width * 4, frame->width,
+          frame->width / 2);
+}
+
+void LogFramesPerSecond(const std::string& name, base::TimeDelta elapsed) {
+  LogPerfResult(name.c_str(), kFrames / elapsed.InSecondsF(), "frames/s");
+}
+
+// Logs the time per frame of the serial and parallel versions of a
+// conversion, and how much the parallel version saves.
+void LogParallelFrameTimes(const std::string& name,
+                           base::TimeDelta serial,
+                           base::TimeDelta parallel) {
+  double serial_ms = serial.InMillisecondsF() / kFrames;
+  double parallel_ms = parallel.InMillisecondsF() / kFrames;
+  LogPerfResult((name + "_serial").c_str(), serial_ms, "ms/frame");
+  LogPerfResult((name + "_parallel").c_str(), parallel_ms, "ms/frame");
+  LogPerfResult((name + "_reduction").c_str(),
+                100 * (serial_ms - parallel_ms) / serial_ms, "%");
+}
+
+}  // namespace
+
+class YUVConvertPerfTest : public testing::Test {
+ protected:
+  void RunConvert(const FrameSize& size) {
+    Frame frame(size);
+    frame.Randomize();
+    Frame reference(size);
+    reference.y = frame.y;
+    reference.u = frame.u;
+    reference.v = frame.v;
+
+    for (size_t i = 0; i < arraysize(kConvertKernels); ++i) {
+      const ConvertKernel& kernel = kConvertKernels[i];
+      if (!kernel.supported())
+        continue;
+
+      base::TimeTicks start = base::TimeTicks::Now();
+      for (int j = 0; j < kFrames; ++j)
+        ConvertFrame(kernel.convert, &frame);
+      LogFramesPerSecond(base::StringPrintf("YUVConvert_convert_%s_%s",
+                                            size.name, kernel.name),
+                         base::TimeTicks::Now() - start);
+
+      if (kernel.reference) {
+        ConvertFrame(kernel.reference, &reference);
+        EXPECT_TRUE(reference.rgb == frame.rgb) << kernel.name;
+      }
+    }
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int j = 0; j < kFrames; ++j) {
+      ConvertYUVToRGB32(&frame.y[0], &frame.u[0], &frame.v[0], &frame.rgb[0],
+                        frame.width, frame.height, frame.width,
+                        frame.width / 2, frame.width * 4, YV12);
+    }
+    LogFramesPerSecond(base::StringPrintf("YUVConvert_convert_%s_selected",
+                                          size.name),
+                       base::TimeTicks::Now() - start);
+  }
+
+  void RunScale(const FrameSize& source_size, const FrameSize& dest_size,
+                bool bilinear) {
+    Frame source(source_size);
+    source.Randomize();
+    Frame dest(dest_size);
+    Frame reference(dest_size);
+    ScaleFrame(kScaleKernels[0], source, bilinear, &reference);
+    std::string name = base::StringPrintf(
+        "YUVConvert_scale_%s_to_%s_%s", source_size.name, dest_size.name,
+        bilinear ? "bilinear" : "point");
+
+    for (size_t i = 0; i < arraysize(kScaleKernels); ++i) {
+      const ScaleKernel& kernel = kScaleKernels[i];
+      if (!kernel.supported())
+        continue;
+
+      base::TimeTicks start = base::TimeTicks::Now();
+      for (int j = 0; j < kFrames; ++j)
+        ScaleFrame(kernel, source, bilinear, &dest);
+      LogFramesPerSecond(name + "_" + kernel.name,
+                         base::TimeTicks::Now() - start);
+
+      if (kernel.bit_exact)
+        EXPECT_TRUE(reference.rgb == dest.rgb) << kernel.name;
+    }
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int j = 0; j < kFrames; ++j) {
+      ScaleYUVToRGB32(&source.y[0], &source.u[0], &source.v[0], &dest.rgb[0],
+                      source.width, source.height, dest.width, dest.height,
+                      source.width, source.width / 2, dest.width * 4, YV12,
+                      ROTATE_0, bilinear ? FILTER_BILINEAR : FILTER_NONE);
+    }
+    LogFramesPerSecond(name + "_selected", base::TimeTicks::Now() - start);
+  }
+
+  void RunConvertParallel(const FrameSize& size) {
+    Frame frame(size);
+    frame.Randomize();
+    Frame serial(size);
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int j = 0; j < kFrames; ++j) {
+      ConvertYUVToRGB32(&frame.y[0], &frame.u[0], &frame.v[0], &serial.rgb[0],
+                        frame.width, frame.height, frame.width,
+                        frame.width / 2, frame.width * 4, YV12);
+    }
+    base::TimeDelta serial_time = base::TimeTicks::Now() - start;
+
+    start = base::TimeTicks::Now();
+    for (int j = 0; j < kFrames; ++j) {
+      ConvertYUVToRGB32Parallel(&frame.y[0], &frame.u[0], &frame.v[0],
+                                &frame.rgb[0], frame.width, frame.height,
+                                frame.width, frame.width / 2, frame.width * 4,
+                                YV12);
+    }
+    LogParallelFrameTimes(
+        base::StringPrintf("YUVConvert_convert_%s", size.name),
+        serial_time, base::TimeTicks::Now() - start);
+    EXPECT_TRUE(serial.rgb == frame.rgb);
+  }
+
+  void RunScaleWithRectParallel(const FrameSize& source_size,
+                                const FrameSize& dest_size) {
+    Frame source(source_size);
+    source.Randomize();
+    Frame serial(dest_size);
+    Frame parallel(dest_size);
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int j = 0; j < kFrames; ++j) {
+      ScaleYUVToRGB32WithRect(&source.y[0], &source.u[0], &source.v[0],
+                              &serial.rgb[0], source.width, source.height,
+                              serial.width, serial.height, 0, 0,
+                              serial.width, serial.height, source.width,
+                              source.width / 2, serial.width * 4);
+    }
+    base::TimeDelta serial_time = base::TimeTicks::Now() - start;
+
+    start = base::TimeTicks::Now();
+    for (int j = 0; j < kFrames; ++j) {
+      ScaleYUVToRGB32WithRectParallel(&source.y[0], &source.u[0],
+                                      &source.v[0], &parallel.rgb[0],
+                                      source.width, source.height,
+                                      parallel.width, parallel.height, 0, 0,
+                                      parallel.width, parallel.height,
+                                      source.width, source.width / 2,
+                                      parallel.width * 4);
+    }
+    LogParallelFrameTimes(
+        base::StringPrintf("YUVConvert_scale_with_rect_%s_to_%s",
+                           source_size.name, dest_size.name),
+        serial_time, base::TimeTicks::Now() - start);
+    EXPECT_TRUE(serial.rgb == parallel.rgb);
+  }
+
+  void RunConvertToYUV(const FrameSize& size) {
+    Frame frame(size);
+    frame.Randomize();
+    Frame reference(size);
+    reference.rgb = frame.rgb;
+
+    for (size_t i = 0; i < arraysize(kRGBToYUVKernels); ++i) {
+      const RGBToYUVKernel& kernel = kRGBToYUVKernels[i];
+      if (!kernel.supported())
+        continue;
+
+      base::TimeTicks start = base::TimeTicks::Now();
+      for (int j = 0; j < kFrames; ++j)
+        ConvertFrameToYUV(kernel.convert, &frame);
+      LogFramesPerSecond(base::StringPrintf("YUVConvert_rgb_to_yuv_%s_%s",
+                                            size.name, kernel.name),
+                         base::TimeTicks::Now() - start);
+
+      if (kernel.reference) {
+        ConvertFrameToYUV(kernel.reference, &reference);
+        EXPECT_TRUE(reference.y == frame.y) << kernel.name;
+        EXPECT_TRUE(reference.u == frame.u) << kernel.name;
+        EXPECT_TRUE(reference.v == frame.v) << kernel.name;
+      }
+    }
+  }
+};
+
+TEST_F(YUVConvertPerfTest, Convert720p) {
+  RunConvert(k720p);
+}
+
+TEST_F(YUVConvertPerfTest, Convert1080p) {
+  RunConvert(k1080p);
+}
+
+TEST_F(YUVConvertPerfTest, Scale720pTo1080p) {
+  RunScale(k720p, k1080p, false);
+  RunScale(k720p, k1080p, true);
+}
+
+TEST_F(YUVConvertPerfTest, Scale1080pTo720p) {
+  RunScale(k1080p, k720p, false);
+  RunScale(k1080p, k720p, true);
+}
+
+TEST_F(YUVConvertPerfTest, ConvertParallel720p) {
+  RunConvertParallel(k720p);
+}
+
+TEST_F(YUVConvertPerfTest, ConvertParallel1080p) {
+  RunConvertParallel(k1080p);
+}
+
+TEST_F(YUVConvertPerfTest, ConvertParallel2160p) {
+  RunConvertParallel(k2160p);
+}
+
+TEST_F(YUVConvertPerfTest, ScaleWithRectParallel2160pTo1080p) {
+  RunScaleWithRectParallel(k2160p, k1080p);
+}
+
+TEST_F(YUVConvertPerfTest, ConvertRGBToYUV720p) {
+  RunConvertToYUV(k720p);
+}
+
+TEST_F(YUVConvertPerfTest, ConvertRGBToYUV1080p) {
+  RunConvertToYUV(k1080p);
+}
+
+}  // namespace media
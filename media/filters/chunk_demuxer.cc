@@ -480,8 +480,6 @@ bool ChunkDemuxer::AppendData(const uint8* data, size_t length) {
   {
     base::AutoLock auto_lock(lock_);
 
-    byte_queue_.Push(data, length);
-
     const uint8* cur = NULL;
     int cur_size = 0;
     int bytes_parsed = 0;
@@ -492,7 +490,18 @@ bool ChunkDemuxer::AppendData(const uint8* data, size_t length) {
     // calls during the parse.
     bool old_seek_waits_for_data = seek_waits_for_data_;
 
+    // The parser resumes in the middle of elements, so |byte_queue_| only
+    // holds the few bytes it couldn't use yet. Parse straight out of |data|
+    // when there are none, so that appended data is only copied once.
     byte_queue_.Peek(&cur, &cur_size);
+    bool parse_from_queue = cur_size > 0;
+    if (parse_from_queue) {
+      byte_queue_.Push(data, length);
+      byte_queue_.Peek(&cur, &cur_size);
+    } else {
+      cur = data;
+      cur_size = length;
+    }
 
     do {
       switch(state_) {
@@ -528,7 +537,10 @@ bool ChunkDemuxer::AppendData(const uint8* data, size_t length) {
       }
     } while (result > 0 && cur_size > 0);
 
-    byte_queue_.Pop(bytes_parsed);
+    if (parse_from_queue)
+      byte_queue_.Pop(bytes_parsed);
+    else if (cur_size > 0)
+      byte_queue_.Push(cur, cur_size);
 
     // Check to see if parsing triggered seek_waits_for_data_ to go from true to
     // false. This indicates we have parsed enough data to complete the seek.
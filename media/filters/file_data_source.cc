@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <limits>
 
 #include "base/file_util.h"
@@ -12,35 +13,147 @@
 #include "media/base/pipeline.h"
 #include "media/filters/file_data_source.h"
 
+#if defined(OS_POSIX)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/eintr_wrapper.h"
+#endif
+
 namespace media {
 
+// How far ahead of the current position the kernel is asked to read mapped
+// files. After a seek the window starts small, so that seeking around the file
+// doesn't read much that is never used, and it doubles for as long as reads
+// carry on sequentially.
+static const int64 kMinReadAheadSize = 256 * 1024;
+static const int64 kMaxReadAheadSize = 2 * 1024 * 1024;
+
+// Largest file that is memory mapped. 32-bit processes fall back to stdio for
+// big files rather than use up their address space.
+#if defined(ARCH_CPU_64_BITS)
+static const int64 kMaxMappedFileSize = std::numeric_limits<int64>::max();
+#else
+static const int64 kMaxMappedFileSize = 256 * 1024 * 1024;
+#endif
+
+// A read-only memory mapping of the file. It is reference counted so that a
+// read can copy out of the mapping without holding |lock_|, while Stop()
+// releases the data source's reference.
+//
+// Touching the pages of a mapping past the end of a file that was truncated
+// after it was mapped raises SIGBUS, where fread() would return a short read.
+// On POSIX the size of the file is checked before each copy, so that reads
+// are cut short instead, unless the file is truncated while the copy is in
+// progress. Windows doesn't allow mapped files to be truncated.
+class FileDataSource::MappedFile
+    : public base::RefCountedThreadSafe<FileDataSource::MappedFile> {
+ public:
+  MappedFile() {
+#if defined(OS_POSIX)
+    fd_ = -1;
+#endif
+  }
+
+  bool Initialize(const FilePath& file_path) {
+    base::PlatformFile file = base::CreatePlatformFile(
+        file_path, base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ,
+        NULL, NULL);
+    if (file == base::kInvalidPlatformFileValue)
+      return false;
+#if defined(OS_POSIX)
+    // |mapping_| closes |file|, so keep a descriptor of our own to check the
+    // size of the file with.
+    fd_ = dup(file);
+    if (fd_ < 0) {
+      base::ClosePlatformFile(file);
+      return false;
+    }
+#endif
+    return mapping_.Initialize(file);
+  }
+
+  const uint8* data() const { return mapping_.data(); }
+  size_t length() const { return mapping_.length(); }
+
+  // Returns how many of the |size| bytes at |position| are still in the file.
+  size_t ClampToFileSize(int64 position, size_t size) const {
+#if defined(OS_POSIX)
+    struct stat file_info;
+    if (fstat(fd_, &file_info) != 0 || position >= file_info.st_size)
+      return 0;
+    return static_cast<size_t>(
+        std::min<int64>(size, file_info.st_size - position));
+#else
+    return size;
+#endif
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<MappedFile>;
+
+  ~MappedFile() {
+#if defined(OS_POSIX)
+    if (fd_ >= 0)
+      ignore_result(HANDLE_EINTR(close(fd_)));
+#endif
+  }
+
+  file_util::MemoryMappedFile mapping_;
+#if defined(OS_POSIX)
+  int fd_;
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFile);
+};
+
 FileDataSource::FileDataSource()
-    : file_(NULL),
+    : read_ahead_start_(0),
+      read_ahead_end_(0),
+      read_ahead_size_(0),
+      file_(NULL),
       file_size_(0),
-      disable_file_size_(false) {
+      disable_file_size_(false),
+      disable_memory_mapping_(false) {
 }
 
 FileDataSource::FileDataSource(bool disable_file_size)
-    : file_(NULL),
+    : read_ahead_start_(0),
+      read_ahead_end_(0),
+      read_ahead_size_(0),
+      file_(NULL),
       file_size_(0),
-      disable_file_size_(disable_file_size) {
+      disable_file_size_(disable_file_size),
+      disable_memory_mapping_(false) {
 }
 
 FileDataSource::~FileDataSource() {
-  DCHECK(!file_);
+  DCHECK(!IsOpen());
 }
 
 PipelineStatus FileDataSource::Initialize(const std::string& url) {
-  DCHECK(!file_);
+  DCHECK(!IsOpen());
 #if defined(OS_WIN)
   FilePath file_path(UTF8ToWide(url));
 #else
   FilePath file_path(url);
 #endif
   if (file_util::GetFileSize(file_path, &file_size_)) {
-    file_ = file_util::OpenFile(file_path, "rb");
+    // Empty files can't be mapped, and neither can special files whose
+    // contents don't match their size.
+    if (!disable_memory_mapping_ && file_size_ > 0 &&
+        file_size_ <= kMaxMappedFileSize) {
+      mapped_file_ = new MappedFile();
+      if (!mapped_file_->Initialize(file_path) ||
+          static_cast<int64>(mapped_file_->length()) != file_size_) {
+        mapped_file_ = NULL;
+      }
+    }
+    if (!mapped_file_)
+      file_ = file_util::OpenFile(file_path, "rb");
   }
-  if (!file_) {
+  if (!IsOpen()) {
     file_size_ = 0;
     return PIPELINE_ERROR_URL_NOT_FOUND;
   }
@@ -55,7 +168,7 @@ void FileDataSource::set_host(DataSourceHost* host) {
 }
 
 void FileDataSource::UpdateHostBytes() {
-  if (host() && file_) {
+  if (host() && IsOpen()) {
     host()->SetTotalBytes(file_size_);
     host()->SetBufferedBytes(file_size_);
   }
@@ -63,8 +176,10 @@ void FileDataSource::UpdateHostBytes() {
 
 void FileDataSource::Stop(const base::Closure& callback) {
   base::AutoLock l(lock_);
-  if (file_) {
-    file_util::CloseFile(file_);
+  if (IsOpen()) {
+    mapped_file_ = NULL;
+    if (file_)
+      file_util::CloseFile(file_);
     file_ = NULL;
     file_size_ = 0;
   }
@@ -74,8 +189,40 @@ void FileDataSource::Stop(const base::Closure& callback) {
 
 void FileDataSource::Read(int64 position, size_t size, uint8* data,
                           const DataSource::ReadCallback& read_callback) {
-  DCHECK(file_);
-  base::AutoLock l(lock_);
+  DCHECK(IsOpen());
+  scoped_refptr<MappedFile> mapped_file;
+  {
+    base::AutoLock l(lock_);
+    if (!mapped_file_) {
+      ReadFromFile_Locked(position, size, data, read_callback);
+      return;
+    }
+    if (position < 0) {
+      read_callback.Run(DataSource::kReadError);
+      return;
+    }
+    // Like fread(), reading at or past the end of the file reads nothing.
+    if (position >= file_size_) {
+      read_callback.Run(0);
+      return;
+    }
+    size = static_cast<size_t>(std::min<int64>(size, file_size_ - position));
+    ReadAhead_Locked(position);
+    mapped_file = mapped_file_;
+  }
+
+  // The copy may have to wait for the disk, so it is made without holding
+  // |lock_|. |mapped_file| keeps the mapping alive if Stop() is called
+  // meanwhile.
+  size = mapped_file->ClampToFileSize(position, size);
+  memcpy(data, mapped_file->data() + position, size);
+  read_callback.Run(size);
+}
+
+void FileDataSource::ReadFromFile_Locked(
+    int64 position, size_t size, uint8* data,
+    const DataSource::ReadCallback& read_callback) {
+  lock_.AssertAcquired();
   if (file_) {
 #if defined(OS_WIN)
     if (_fseeki64(file_, position, SEEK_SET)) {
@@ -102,10 +249,10 @@ void FileDataSource::Read(int64 position, size_t size, uint8* data,
 
 bool FileDataSource::GetSize(int64* size_out) {
   DCHECK(size_out);
-  DCHECK(file_);
+  DCHECK(IsOpen());
   base::AutoLock l(lock_);
   *size_out = file_size_;
-  return (NULL != file_ && !disable_file_size_);
+  return (IsOpen() && !disable_file_size_);
 }
 
 bool FileDataSource::IsStreaming() {
@@ -118,4 +265,37 @@ void FileDataSource::SetPreload(Preload preload) {
 void FileDataSource::SetBitrate(int bitrate) {
 }
 
+bool FileDataSource::IsOpen() const {
+  return file_ || mapped_file_.get();
+}
+
+void FileDataSource::ReadAhead_Locked(int64 position) {
+  lock_.AssertAcquired();
+#if defined(OS_POSIX)
+  const uint8* mapped_data = mapped_file_->data();
+  // Request a new window once reads get within half a window of the end of
+  // the previous one, unless it reached the end of the file, or move outside
+  // it.
+  if (position < read_ahead_start_ ||
+      (position + read_ahead_size_ / 2 > read_ahead_end_ &&
+       read_ahead_end_ < file_size_)) {
+    if (read_ahead_size_ && position >= read_ahead_start_ &&
+        position <= read_ahead_end_) {
+      read_ahead_size_ = std::min(read_ahead_size_ * 2, kMaxReadAheadSize);
+    } else {
+      read_ahead_size_ = kMinReadAheadSize;
+    }
+
+    // madvise() takes a page aligned address.
+    int64 page_mask = getpagesize() - 1;
+    read_ahead_start_ = position & ~page_mask;
+    read_ahead_end_ = std::min(position + read_ahead_size_, file_size_);
+    if (read_ahead_end_ > read_ahead_start_) {
+      madvise(const_cast<uint8*>(mapped_data) + read_ahead_start_,
+              read_ahead_end_ - read_ahead_start_, MADV_WILLNEED);
+    }
+  }
+#endif
+}
+
 }  // namespace media
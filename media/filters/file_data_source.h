@@ -8,6 +8,7 @@
 #include <string>
 
 #include "base/gtest_prod_util.h"
+#include "base/memory/ref_counted.h"
 #include "base/synchronization/lock.h"
 #include "media/base/data_source.h"
 
@@ -15,6 +16,12 @@ namespace media {
 
 // Basic data source that treats the URL as a file path, and uses the file
 // system to read data for a media pipeline.
+//
+// The file is memory mapped when possible, so that reads are copied straight
+// out of the page cache without a seek and read per call. The kernel is asked
+// to read ahead of the current position. Files that can't be mapped are read
+// with stdio instead. See MappedFile in the .cc for what happens when a mapped
+// file is truncated.
 class MEDIA_EXPORT FileDataSource : public DataSource {
  public:
   FileDataSource();
@@ -23,6 +30,15 @@ class MEDIA_EXPORT FileDataSource : public DataSource {
 
   PipelineStatus Initialize(const std::string& url);
 
+  // Reads the file with stdio even if it could be mapped. Must be called
+  // before Initialize().
+  void set_disable_memory_mapping(bool disable_memory_mapping) {
+    disable_memory_mapping_ = disable_memory_mapping;
+  }
+
+  // Returns true if the file is read through a memory mapping.
+  bool is_memory_mapped() const { return mapped_file_.get() != NULL; }
+
   // Implementation of DataSource.
   virtual void set_host(DataSourceHost* host) OVERRIDE;
   virtual void Stop(const base::Closure& callback) OVERRIDE;
@@ -42,10 +58,33 @@ class MEDIA_EXPORT FileDataSource : public DataSource {
   FRIEND_TEST_ALL_PREFIXES(FileDataSourceTest, ReadData);
   FRIEND_TEST_ALL_PREFIXES(FileDataSourceTest, Seek);
 
+  class MappedFile;
+
   // Informs the host of changes in total and buffered bytes.
   void UpdateHostBytes();
 
-  // File handle.  NULL if not initialized or an error occurs.
+  // Returns true if the file has been opened and not stopped.
+  bool IsOpen() const;
+
+  // Asks the kernel to read |mapped_file_| ahead if |position| is near the end
+  // of or outside the current read-ahead window.
+  void ReadAhead_Locked(int64 position);
+
+  // Reads from |file_| and runs |read_callback|.
+  void ReadFromFile_Locked(int64 position, size_t size, uint8* data,
+                           const DataSource::ReadCallback& read_callback);
+
+  // Memory mapping of the file. NULL if the file isn't mapped.
+  scoped_refptr<MappedFile> mapped_file_;
+
+  // Range of the file that the kernel was last asked to read ahead, and the
+  // size of the window it was asked for.
+  int64 read_ahead_start_;
+  int64 read_ahead_end_;
+  int64 read_ahead_size_;
+
+  // File handle for files that aren't mapped.  NULL if not initialized, an
+  // error occurs or the file is mapped.
   FILE* file_;
 
   // Size of the file in bytes.
@@ -55,8 +94,13 @@ class MEDIA_EXPORT FileDataSource : public DataSource {
   // otherwise.
   bool disable_file_size_;
 
+  // True if the file should be read with stdio even if it could be mapped.
+  bool disable_memory_mapping_;
+
   // Critical section that protects all of the DataSource methods to prevent
-  // a Stop from happening while in the middle of a file I/O operation.
+  // a Stop from happening while in the middle of a file I/O operation. Copies
+  // out of a mapping, which may fault pages in from the disk, are made
+  // without holding it.
   // TODO(ralphl): Ideally this would use asynchronous I/O or we will know
   // that we will block for a short period of time in reads.  Otherwise, we can
   // hang the pipeline Stop.
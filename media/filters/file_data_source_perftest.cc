@@ -0,0 +1,147 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/perftimer.h"
+#include "base/rand_util.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "build/build_config.h"
+#include "media/base/pipeline_status.h"
+#include "media/filters/file_data_source.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(OS_LINUX)
+#include <fcntl.h>
+#endif
+
+namespace media {
+
+namespace {
+
+// Size of the file that is read. Larger than the read-ahead window and the
+// CPU caches, but small enough to map in 32-bit processes.
+const int64 kFileSize = 192 * 1024 * 1024;
+
+// FFmpegDemuxer reads through FFmpeg's 32KB I/O buffer.
+const size_t kReadSize = 32 * 1024;
+
+// Number of random seeks timed.
+const int kSeeks = 500;
+
+void OnReadDone(size_t* size_out, size_t size) {
+  *size_out = size;
+}
+
+}  // namespace
+
+class FileDataSourcePerfTest : public testing::Test {
+ protected:
+  FileDataSourcePerfTest() : buffer_(kReadSize) {}
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(file_util::CreateTemporaryFile(&path_));
+    FILE* file = file_util::OpenFile(path_, "wb");
+    ASSERT_TRUE(file);
+    std::string chunk = base::RandBytesAsString(1024 * 1024);
+    for (int64 i = 0; i < kFileSize; i += chunk.size())
+      ASSERT_EQ(chunk.size(), fwrite(chunk.data(), 1, chunk.size(), file));
+    ASSERT_TRUE(file_util::CloseFile(file));
+  }
+
+  virtual void TearDown() OVERRIDE {
+    file_util::Delete(path_, false);
+  }
+
+  // Drops the file from the page cache where the platform allows, so that
+  // reads go to the disk.
+  void DropFromPageCache() {
+#if defined(OS_LINUX)
+    FILE* file = file_util::OpenFile(path_, "rb");
+    ASSERT_TRUE(file);
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_DONTNEED);
+    file_util::CloseFile(file);
+#endif
+  }
+
+  // Reads the whole file in order, like demuxing it from start to end.
+  void RunSequential(const char* name, bool cold) {
+    scoped_refptr<FileDataSource> data_source = Open(name);
+    if (cold)
+      DropFromPageCache();
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int64 position = 0; position < kFileSize; position += kReadSize)
+      ASSERT_EQ(kReadSize, Read(data_source, position));
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    LogPerfResult(base::StringPrintf("FileDataSource_sequential_%s_%s", name,
+                                     cold ? "cold" : "warm").c_str(),
+                  kFileSize / elapsed.InSecondsF() / (1024 * 1024), "MB/s");
+    data_source->Stop(base::Closure());
+  }
+
+  // Reads a little at random positions, like seeking during playback.
+  void RunSeeks(const char* name, bool cold) {
+    scoped_refptr<FileDataSource> data_source = Open(name);
+    if (cold)
+      DropFromPageCache();
+
+    std::vector<int64> positions(kSeeks);
+    for (int i = 0; i < kSeeks; ++i)
+      positions[i] = base::RandGenerator(kFileSize - kReadSize);
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kSeeks; ++i)
+      ASSERT_EQ(kReadSize, Read(data_source, positions[i]));
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    LogPerfResult(base::StringPrintf("FileDataSource_seek_%s_%s", name,
+                                     cold ? "cold" : "warm").c_str(),
+                  elapsed.InMicroseconds() / static_cast<double>(kSeeks),
+                  "us");
+    data_source->Stop(base::Closure());
+  }
+
+  scoped_refptr<FileDataSource> Open(const std::string& mode) {
+    scoped_refptr<FileDataSource> data_source = new FileDataSource();
+    data_source->set_disable_memory_mapping(mode == "stdio");
+    EXPECT_EQ(PIPELINE_OK, data_source->Initialize(path_.value()));
+    EXPECT_EQ(mode == "mapped", data_source->is_memory_mapped());
+    return data_source;
+  }
+
+  size_t Read(FileDataSource* data_source, int64 position) {
+    size_t size = DataSource::kReadError;
+    data_source->Read(position, kReadSize, &buffer_[0],
+                      base::Bind(&OnReadDone, &size));
+    return size;
+  }
+
+  FilePath path_;
+  std::vector<uint8> buffer_;
+};
+
+TEST_F(FileDataSourcePerfTest, Sequential) {
+  RunSequential("stdio", false);
+  RunSequential("mapped", false);
+  RunSequential("stdio", true);
+  RunSequential("mapped", true);
+}
+
+TEST_F(FileDataSourcePerfTest, Seek) {
+  RunSeeks("stdio", false);
+  RunSeeks("mapped", false);
+  RunSeeks("stdio", true);
+  RunSeeks("mapped", true);
+}
+
+}  // namespace media
@@ -0,0 +1,76 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "media/base/pipeline_status.h"
+#include "media/filters/file_data_source.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+const int64 kFileSize = 64 * 1024;
+const size_t kReadSize = 32 * 1024;
+
+void OnReadDone(size_t* size_out, size_t size) {
+  *size_out = size;
+}
+
+}  // namespace
+
+class FileDataSourceTest : public testing::Test {
+ protected:
+  FileDataSourceTest() : buffer_(kReadSize) {}
+
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(file_util::CreateTemporaryFile(&path_));
+    std::string contents(kFileSize, 'a');
+    ASSERT_EQ(static_cast<int>(contents.size()),
+              file_util::WriteFile(path_, contents.data(), contents.size()));
+  }
+
+  virtual void TearDown() OVERRIDE {
+    file_util::Delete(path_, false);
+  }
+
+  size_t Read(FileDataSource* data_source, int64 position) {
+    size_t size = DataSource::kReadError;
+    data_source->Read(position, kReadSize, &buffer_[0],
+                      base::Bind(&OnReadDone, &size));
+    return size;
+  }
+
+  FilePath path_;
+  std::vector<uint8> buffer_;
+};
+
+#if defined(OS_POSIX)
+// Reads from a mapped file that has been truncated are cut short at the new
+// end of the file instead of touching pages that are gone.
+TEST_F(FileDataSourceTest, TruncatedWhileMapped) {
+  scoped_refptr<FileDataSource> data_source = new FileDataSource();
+  ASSERT_EQ(PIPELINE_OK, data_source->Initialize(path_.value()));
+  ASSERT_TRUE(data_source->is_memory_mapped());
+
+  FILE* file = file_util::OpenFile(path_, "r+b");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(0, fseek(file, kReadSize / 2, SEEK_SET));
+  ASSERT_TRUE(file_util::TruncateFile(file));
+  ASSERT_TRUE(file_util::CloseFile(file));
+
+  EXPECT_EQ(kReadSize / 2, Read(data_source, 0));
+  EXPECT_EQ(0u, Read(data_source, kFileSize - kReadSize));
+  data_source->Stop(base::Closure());
+}
+#endif
+
+}  // namespace media
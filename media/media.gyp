@@ -7,6 +7,17 @@
     'chromium_code': 1,
     # Override to dynamically link the PulseAudio library.
     'use_pulseaudio%': 0,
+    'conditions': [
+      # The AVX2 YUV conversion kernels need a compiler that accepts -mavx2,
+      # which gcc does from 4.7.
+      ['os_posix == 1 and OS != "mac" and OS != "android" and '
+       '(target_arch == "ia32" or target_arch == "x64") and '
+       '(clang == 1 or gcc_version >= 47)', {
+        'media_use_avx2%': 1,
+      }, {
+        'media_use_avx2%': 0,
+      }],
+    ],
   },
   'targets': [
     {
@@ -42,8 +53,12 @@
         'audio/audio_output_controller.h',
         'audio/audio_output_dispatcher.cc',
         'audio/audio_output_dispatcher.h',
+        'audio/audio_output_mixer.cc',
+        'audio/audio_output_mixer.h',
         'audio/audio_output_proxy.cc',
         'audio/audio_output_proxy.h',
+        'audio/audio_packet_ring.cc',
+        'audio/audio_packet_ring.h',
         'audio/audio_parameters.cc',
         'audio/audio_parameters.h',
         'audio/audio_util.cc',
@@ -404,6 +419,7 @@
       ],
       'dependencies': [
         'cpu_features',
+        '../base/base.gyp:base',
       ],
       'conditions': [
         [ 'target_arch == "ia32" or target_arch == "x64"', {
@@ -416,10 +432,24 @@
             'yuv_convert_simd_c',
           ],
         }],
+        [ 'media_use_avx2 == 1', {
+          'dependencies': [
+            'yuv_convert_simd_avx2',
+          ],
+          'defines': [
+            'MEDIA_USE_AVX2',
+          ],
+        }],
+        [ 'target_arch == "arm" and arm_neon == 1', {
+          'defines': [
+            'MEDIA_USE_NEON',
+          ],
+        }],
       ],
       'sources': [
         'base/yuv_convert.cc',
         'base/yuv_convert.h',
+        'base/yuv_convert_parallel.cc',
       ],
     },
     {
@@ -552,6 +582,14 @@
         'base/simd/yuv_to_rgb_table.cc',
         'base/simd/yuv_to_rgb_table.h',
       ],
+      'conditions': [
+        [ 'target_arch == "arm" and arm_neon == 1', {
+          'sources': [
+            'base/simd/convert_yuv_to_rgb_neon.cc',
+            'base/simd/filter_yuv_neon.cc',
+          ],
+        }],
+      ],
     },
     {
       'target_name': 'media_unittests',
@@ -573,7 +611,9 @@
         'audio/audio_input_unittest.cc',
         'audio/audio_low_latency_input_output_unittest.cc',
         'audio/audio_output_controller_unittest.cc',
+        'audio/audio_output_mixer_unittest.cc',
         'audio/audio_output_proxy_unittest.cc',
+        'audio/audio_packet_ring_unittest.cc',
         'audio/audio_parameters_unittest.cc',
         'audio/audio_util_unittest.cc',
         'audio/linux/alsa_output_unittest.cc',
@@ -680,6 +720,40 @@
         'base/mock_filters.h',
       ],
     },
+    {
+      'target_name': 'media_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'cpu_features',
+        'media',
+        'yuv_convert',
+        '../base/base.gyp:base',
+        '../base/base.gyp:test_support_perf',
+        '../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        'audio/audio_output_mixer_perftest.cc',
+        'audio/audio_packet_ring_perftest.cc',
+        'base/seekable_buffer_perftest.cc',
+        'base/yuv_convert_perftest.cc',
+        'filters/file_data_source_perftest.cc',
+        'webm/cluster_builder.cc',
+        'webm/cluster_builder.h',
+        'webm/webm_cluster_parser_perftest.cc',
+      ],
+      'conditions': [
+        [ 'media_use_avx2 == 1', {
+          'defines': [
+            'MEDIA_USE_AVX2',
+          ],
+        }],
+        [ 'target_arch == "arm" and arm_neon == 1', {
+          'defines': [
+            'MEDIA_USE_NEON',
+          ],
+        }],
+      ],
+    },
     {
       'target_name': 'scaler_bench',
       'type': 'executable',
@@ -702,6 +776,31 @@
     },
   ],
   'conditions': [
+    ['media_use_avx2 == 1', {
+      'targets': [
+        {
+          # The AVX2 kernels are kept apart from yuv_convert_simd_x86 so that
+          # -mavx2 doesn't let the compiler use AVX2 in code that runs on
+          # older CPUs.
+          'target_name': 'yuv_convert_simd_avx2',
+          'type': 'static_library',
+          'include_dirs': [
+            '..',
+          ],
+          'dependencies': [
+            'yuv_convert_simd_x86',
+          ],
+          'sources': [
+            'base/simd/convert_rgb_to_yuv_avx2.cc',
+            'base/simd/convert_yuv_to_rgb_avx2.cc',
+            'base/simd/filter_yuv_avx2.cc',
+          ],
+          'cflags': [
+            '-mavx2',
+          ],
+        },
+      ],
+    }],
     ['OS=="win"', {
       'targets': [
         {
@@ -31,6 +31,7 @@ WebMClusterParser::WebMClusterParser(int64 timecode_scale,
       video_track_num_(video_track_num),
       video_default_duration_(video_default_duration),
       parser_(kWebMIdCluster, this),
+      in_cluster_(false),
       last_block_timecode_(-1),
       cluster_timecode_(-1) {
 }
@@ -42,6 +43,7 @@ void WebMClusterParser::Reset() {
   video_buffers_.clear();
   last_block_timecode_ = -1;
   cluster_timecode_ = -1;
+  in_cluster_ = false;
   parser_.Reset();
 }
 
@@ -68,15 +70,19 @@ int WebMClusterParser::Parse(const uint8* buf, int size) {
 }
 
 WebMParserClient* WebMClusterParser::OnListStart(int id) {
-  if (id == kWebMIdCluster)
+  if (id == kWebMIdCluster) {
     cluster_timecode_ = -1;
+    in_cluster_ = true;
+  }
 
   return this;
 }
 
 bool WebMClusterParser::OnListEnd(int id) {
-  if (id == kWebMIdCluster)
+  if (id == kWebMIdCluster) {
     cluster_timecode_ = -1;
+    in_cluster_ = false;
+  }
 
   return true;
 }
@@ -35,6 +35,10 @@ class WebMClusterParser : public WebMParserClient {
   // Returns the number of bytes parsed on success.
   int Parse(const uint8* buf, int size);
 
+  // Returns true if the last Parse() call ended inside a cluster, so the
+  // next bytes continue that cluster instead of starting a new element.
+  bool IsParsingCluster() const { return in_cluster_; }
+
   const BufferQueue& audio_buffers() const { return audio_buffers_; }
   const BufferQueue& video_buffers() const { return video_buffers_; }
 
@@ -54,6 +58,7 @@ class WebMClusterParser : public WebMParserClient {
   base::TimeDelta  video_default_duration_;
 
   WebMListParser parser_;
+  bool in_cluster_;
 
   int64 last_block_timecode_;
 
@@ -0,0 +1,149 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "media/base/byte_queue.h"
+#include "media/webm/cluster_builder.h"
+#include "media/webm/webm_cluster_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+const int kTimecodeScale = 1000000;  // Timecodes are in milliseconds.
+const int kAudioTrackNum = 1;
+const int kVideoTrackNum = 2;
+
+// Number of one second clusters in the stream.
+const int kClusters = 96;
+
+// Roughly a 5 Mbps video stream with a keyframe every second, and Vorbis
+// audio.
+const int kVideoFrameDurationMs = 33;
+const int kVideoFrameSize = 20 * 1024;
+const int kVideoKeyframeSize = 160 * 1024;
+const int kAudioFrameDurationMs = 23;
+const int kAudioFrameSize = 400;
+
+}  // namespace
+
+class WebMClusterParserPerfTest : public testing::Test {
+ protected:
+  WebMClusterParserPerfTest()
+      : frame_data_(std::string(kVideoKeyframeSize, '\x5a')) {
+    ClusterBuilder builder;
+    for (int i = 0; i < kClusters; ++i) {
+      int64 start = i * 1000;
+      int64 end = start + 1000;
+      builder.SetClusterTimecode(start);
+
+      // Interleave the audio and video blocks in timecode order.
+      int64 audio_timecode = start;
+      int64 video_timecode = start;
+      while (audio_timecode < end || video_timecode < end) {
+        if (audio_timecode <= video_timecode) {
+          AddBlock(&builder, kAudioTrackNum, audio_timecode, kAudioFrameSize);
+          audio_timecode += kAudioFrameDurationMs;
+        } else {
+          int size = video_timecode == start ? kVideoKeyframeSize :
+              kVideoFrameSize;
+          AddBlock(&builder, kVideoTrackNum, video_timecode, size);
+          video_timecode += kVideoFrameDurationMs;
+        }
+      }
+
+      scoped_ptr<Cluster> cluster(builder.Finish());
+      stream_.append(reinterpret_cast<const char*>(cluster->data()),
+                     cluster->size());
+    }
+  }
+
+  // Appends the whole stream |append_size| bytes at a time the way
+  // ChunkDemuxer::AppendData() does, and returns the number of buffers
+  // parsed out of it.
+  int AppendStream(int append_size) {
+    WebMClusterParser parser(kTimecodeScale,
+                             kAudioTrackNum, base::TimeDelta(),
+                             kVideoTrackNum, base::TimeDelta());
+    ByteQueue byte_queue;
+    const uint8* stream = reinterpret_cast<const uint8*>(stream_.data());
+    int stream_size = static_cast<int>(stream_.size());
+    int buffers = 0;
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int position = 0; position < stream_size; position += append_size) {
+      int length = std::min(append_size, stream_size - position);
+
+      const uint8* cur = NULL;
+      int cur_size = 0;
+      byte_queue.Peek(&cur, &cur_size);
+      bool parse_from_queue = cur_size > 0;
+      if (parse_from_queue) {
+        byte_queue.Push(stream + position, length);
+        byte_queue.Peek(&cur, &cur_size);
+      } else {
+        cur = stream + position;
+        cur_size = length;
+      }
+
+      int bytes_parsed = 0;
+      int result = 0;
+      do {
+        result = parser.Parse(cur, cur_size);
+        EXPECT_GE(result, 0);
+        if (result <= 0)
+          break;
+        buffers += parser.audio_buffers().size();
+        buffers += parser.video_buffers().size();
+        cur += result;
+        cur_size -= result;
+        bytes_parsed += result;
+      } while (cur_size > 0);
+
+      if (parse_from_queue)
+        byte_queue.Pop(bytes_parsed);
+      else if (cur_size > 0)
+        byte_queue.Push(cur, cur_size);
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    LogPerfResult(base::StringPrintf("WebMClusterParser_append_%dKB",
+                                     append_size / 1024).c_str(),
+                  stream_size / elapsed.InSecondsF() / (1024 * 1024), "MB/s");
+    return buffers;
+  }
+
+ private:
+  void AddBlock(ClusterBuilder* builder, int track_num, int64 timecode,
+                int size) {
+    builder->AddSimpleBlock(track_num, timecode, 0,
+                            reinterpret_cast<const uint8*>(frame_data_.data()),
+                            size);
+  }
+
+  std::string frame_data_;
+  std::string stream_;
+};
+
+TEST_F(WebMClusterParserPerfTest, Append) {
+  int expected_buffers = 0;
+  for (int i = 0; i < kClusters; ++i) {
+    expected_buffers += (1000 + kAudioFrameDurationMs - 1) /
+        kAudioFrameDurationMs;
+    expected_buffers += (1000 + kVideoFrameDurationMs - 1) /
+        kVideoFrameDurationMs;
+  }
+
+  for (int append_size = 1024; append_size <= 1024 * 1024; append_size *= 4)
+    EXPECT_EQ(expected_buffers, AppendStream(append_size));
+}
+
+}  // namespace media
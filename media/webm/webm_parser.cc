@@ -8,6 +8,7 @@
 // from information in the Matroska spec.
 // http://www.matroska.org/technical/specs/index.html
 
+#include <algorithm>
 #include <iomanip>
 
 #include "base/logging.h"
@@ -696,7 +697,11 @@ WebMListParser::WebMListParser(int id, WebMParserClient* client)
     : state_(NEED_LIST_HEADER),
       root_id_(id),
       root_level_(FindListLevel(id)),
-      root_client_(client) {
+      root_client_(client),
+      element_id_(0),
+      element_header_size_(0),
+      element_size_(0),
+      element_bytes_received_(0) {
   DCHECK_GE(root_level_, 0);
   DCHECK(client);
 }
@@ -706,6 +711,7 @@ WebMListParser::~WebMListParser() {}
 void WebMListParser::Reset() {
   ChangeState(NEED_LIST_HEADER);
   list_state_stack_.clear();
+  element_data_.clear();
 }
 
 int WebMListParser::Parse(const uint8* buf, int size) {
@@ -722,6 +728,19 @@ int WebMListParser::Parse(const uint8* buf, int size) {
   int bytes_parsed = 0;
 
   while (cur_size > 0 && state_ != PARSE_ERROR && state_ != DONE_PARSING_LIST) {
+    if (state_ == INSIDE_ELEMENT) {
+      int result = ContinueElement(cur, cur_size);
+      if (result < 0) {
+        ChangeState(PARSE_ERROR);
+        return -1;
+      }
+
+      cur += result;
+      cur_size -= result;
+      bytes_parsed += result;
+      continue;
+    }
+
     int element_id = 0;
     int64 element_size = 0;
     int result = WebMParseElementHeader(cur, cur_size, &element_id,
@@ -775,6 +794,7 @@ int WebMListParser::Parse(const uint8* buf, int size) {
 
         break;
       }
+      case INSIDE_ELEMENT:
       case DONE_PARSING_LIST:
       case PARSE_ERROR:
         // Shouldn't be able to get here.
@@ -831,14 +851,63 @@ int WebMListParser::ParseListElement(int header_size,
     return header_size;
   }
 
-  // Make sure we have the entire element before trying to parse a non-list
-  // element.
-  if (size < element_size)
-    return 0;
+  // If only part of the element has arrived, hold on to it and pick up where
+  // it left off on the next call, so that the bytes seen so far don't have to
+  // be passed to Parse() again.
+  if (size < element_size) {
+    element_id_ = id;
+    element_header_size_ = header_size;
+    element_size_ = element_size;
+    element_bytes_received_ = size;
+    element_data_.clear();
+    if (id_type != SKIP)
+      element_data_.assign(data, data + size);
+    ChangeState(INSIDE_ELEMENT);
+    return header_size + size;
+  }
+
+  return ParseElementBody(header_size, id, element_size, data);
+}
+
+int WebMListParser::ContinueElement(const uint8* data, int size) {
+  DCHECK_EQ(state_, INSIDE_ELEMENT);
+  DCHECK_GT(list_state_stack_.size(), 0u);
+
+  int64 remaining = element_size_ - element_bytes_received_;
+  int consumed = static_cast<int>(std::min<int64>(remaining, size));
+  const ListElementInfo* element_info = list_state_stack_.back().element_info_;
+  if (FindIdType(element_id_, element_info->id_info_,
+                 element_info->id_info_count_) != SKIP) {
+    element_data_.insert(element_data_.end(), data, data + consumed);
+  }
+  element_bytes_received_ += consumed;
+
+  if (element_bytes_received_ < element_size_)
+    return consumed;
+
+  ChangeState(INSIDE_LIST);
+  const uint8* element_data = element_data_.empty() ? data : &element_data_[0];
+  if (ParseElementBody(element_header_size_, element_id_, element_size_,
+                       element_data) <= 0) {
+    return -1;
+  }
+
+  // Keep the capacity of |element_data_| for the next partial element.
+  element_data_.clear();
+  return consumed;
+}
+
+int WebMListParser::ParseElementBody(int header_size, int id,
+                                     int64 element_size, const uint8* data) {
+  ListState& list_state = list_state_stack_.back();
+  const ListElementInfo* element_info = list_state.element_info_;
+  ElementType id_type =
+      FindIdType(id, element_info->id_info_, element_info->id_info_count_);
 
   int bytes_parsed = ParseNonListElement(id_type, id, element_size,
-                                         data, size, list_state.client_);
-  DCHECK_LE(bytes_parsed, size);
+                                         data, static_cast<int>(element_size),
+                                         list_state.client_);
+  DCHECK_LE(bytes_parsed, element_size);
 
   // Return if an error occurred or we need more data.
   // Note: bytes_parsed is 0 for a successful parse of a size 0 element. We
@@ -50,8 +50,9 @@ struct ListElementInfo;
 // Parses a WebM list element and all of its children. This
 // class supports incremental parsing of the list so Parse()
 // can be called multiple times with pieces of the list.
-// IsParsingComplete() will return true once the entire list has
-// been parsed.
+// Parsing resumes in the middle of an element, so every byte
+// passed to Parse() is only seen once. IsParsingComplete() will
+// return true once the entire list has been parsed.
 class MEDIA_EXPORT WebMListParser {
  public:
   // |id| - Element ID of the list we intend to parse.
@@ -76,6 +77,7 @@ class MEDIA_EXPORT WebMListParser {
   enum State {
     NEED_LIST_HEADER,
     INSIDE_LIST,
+    INSIDE_ELEMENT,
     DONE_PARSING_LIST,
     PARSE_ERROR,
   };
@@ -106,6 +108,24 @@ class MEDIA_EXPORT WebMListParser {
                        int id, int64 element_size,
                        const uint8* data, int size);
 
+  // Adds up to |size| bytes from |data| to the partial element that the
+  // previous Parse() call ended in, and parses the element once all of it
+  // has arrived.
+  //
+  // Returns < 0 if the parse fails.
+  // Returns the number of bytes consumed otherwise.
+  int ContinueElement(const uint8* data, int size);
+
+  // Parses the body of a non-list element in the current list once all
+  // |element_size| bytes of it are in |data|.
+  //
+  // Returns < 0 if the parse fails.
+  // Returns 0 if more data is needed.
+  // Returning > 0 indicates success & the number of bytes parsed, including
+  // the |header_size| bytes of the header.
+  int ParseElementBody(int header_size, int id, int64 element_size,
+                       const uint8* data);
+
   // Called when starting to parse a new list.
   //
   // |id| - The ID of the new list.
@@ -139,6 +159,15 @@ class MEDIA_EXPORT WebMListParser {
   // added and removed from this stack as they are parsed.
   std::vector<ListState> list_state_stack_;
 
+  // The non-list element that has only partly arrived while in the
+  // INSIDE_ELEMENT state. |element_data_| holds the bytes of its body seen
+  // so far, except for elements that are skipped, which are only counted.
+  int element_id_;
+  int element_header_size_;
+  int64 element_size_;
+  int64 element_bytes_received_;
+  std::vector<uint8> element_data_;
+
   DISALLOW_COPY_AND_ASSIGN(WebMListParser);
 };
 
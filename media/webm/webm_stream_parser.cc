@@ -4,6 +4,8 @@
 
 #include "media/webm/webm_stream_parser.h"
 
+#include <algorithm>
+
 #include "base/callback.h"
 #include "base/logging.h"
 #include "media/ffmpeg/ffmpeg_common.h"
@@ -181,7 +183,8 @@ bool FFmpegConfigHelper::SetupStreamConfigs() {
 
 WebMStreamParser::WebMStreamParser()
     : state_(WAITING_FOR_INIT),
-      host_(NULL) {
+      host_(NULL),
+      bytes_to_skip_(0) {
 }
 
 WebMStreamParser::~WebMStreamParser() {}
@@ -201,6 +204,8 @@ void WebMStreamParser::Init(const InitCB& init_cb, StreamParserHost* host) {
 void WebMStreamParser::Flush() {
   DCHECK_NE(state_, WAITING_FOR_INIT);
 
+  bytes_to_skip_ = 0;
+
   if (state_ != PARSING_CLUSTERS)
     return;
 
@@ -210,6 +215,12 @@ void WebMStreamParser::Flush() {
 int WebMStreamParser::Parse(const uint8* buf, int size) {
   DCHECK_NE(state_, WAITING_FOR_INIT);
 
+  if (bytes_to_skip_ > 0) {
+    int skipped = static_cast<int>(std::min<int64>(bytes_to_skip_, size));
+    bytes_to_skip_ -= skipped;
+    return skipped;
+  }
+
   if (state_ == PARSING_HEADERS)
     return ParseInfoAndTracks(buf, size);
 
@@ -244,12 +255,7 @@ int WebMStreamParser::ParseInfoAndTracks(const uint8* data, int size) {
     case kWebMIdVoid:
     case kWebMIdCRC32:
     case kWebMIdCues:
-      if (cur_size < (result + element_size)) {
-        // We don't have the whole element yet. Signal we need more data.
-        return 0;
-      }
-      // Skip the element.
-      return result + element_size;
+      return SkipElement(result, element_size, cur_size);
       break;
     case kWebMIdSegment:
       // Just consume the segment header.
@@ -314,20 +320,18 @@ int WebMStreamParser::ParseCluster(const uint8* data, int size) {
   if (!cluster_parser_.get())
     return -1;
 
-  int id;
-  int64 element_size;
-  int result = WebMParseElementHeader(data, size, &id, &element_size);
+  // Between clusters, look for CUES elements to skip. Inside a cluster the
+  // data may start in the middle of a block.
+  if (!cluster_parser_->IsParsingCluster()) {
+    int id;
+    int64 element_size;
+    int result = WebMParseElementHeader(data, size, &id, &element_size);
 
-  if (result <= 0)
-    return result;
+    if (result <= 0)
+      return result;
 
-  if (id == kWebMIdCues) {
-    if (size < (result + element_size)) {
-      // We don't have the whole element yet. Signal we need more data.
-      return 0;
-    }
-    // Skip the element.
-    return result + element_size;
+    if (id == kWebMIdCues)
+      return SkipElement(result, element_size, size);
   }
 
   int bytes_parsed = cluster_parser_->Parse(data, size);
@@ -349,4 +353,21 @@ int WebMStreamParser::ParseCluster(const uint8* data, int size) {
   return bytes_parsed;
 }
 
+int WebMStreamParser::SkipElement(int header_size, int64 element_size,
+                                  int size) {
+  DCHECK_EQ(bytes_to_skip_, 0);
+
+  if (element_size == kWebMUnknownSize) {
+    DVLOG(1) << "Can't skip an element of unknown size.";
+    return -1;
+  }
+
+  int64 total_size = header_size + element_size;
+  if (total_size <= size)
+    return static_cast<int>(total_size);
+
+  bytes_to_skip_ = total_size - size;
+  return size;
+}
+
 }  // namespace media
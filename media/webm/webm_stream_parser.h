@@ -53,10 +53,22 @@ class WebMStreamParser : public StreamParser {
   // Returning > 0 indicates success & the number of bytes parsed.
   int ParseCluster(const uint8* data, int size);
 
+  // Consumes the part of an unused element that is in |size| bytes of data,
+  // and arranges for the rest of it to be skipped by the next Parse() calls
+  // so that it is never buffered. |header_size| and |element_size| are the
+  // sizes of the element's header and body.
+  //
+  // Returns < 0 if the element can't be skipped.
+  // Returns the number of bytes consumed otherwise.
+  int SkipElement(int header_size, int64 element_size, int size);
+
   State state_;
   InitCB init_cb_;
   StreamParserHost* host_;
 
+  // Number of bytes of the element being skipped that haven't arrived yet.
+  int64 bytes_to_skip_;
+
   scoped_ptr<WebMClusterParser> cluster_parser_;
 
   DISALLOW_COPY_AND_ASSIGN(WebMStreamParser);
@@ -197,6 +197,10 @@ class NET_EXPORT_PRIVATE Filter {
   static void FixupEncodingTypes(const FilterContext& filter_context,
                                  std::vector<FilterType>* encoding_types);
 
+  // Returns how many stream buffers have been allocated, as opposed to reused
+  // from the buffer pool, since the process started.
+  static int stream_buffer_allocations_for_testing();
+
  protected:
   friend class GZipUnitTest;
   friend class SdchFilterChainingTest;
@@ -235,6 +239,9 @@ class NET_EXPORT_PRIVATE Filter {
 
  private:
   // Allocates and initializes stream_buffer_ and stream_buffer_size_.
+  // Buffers of the default size come from a process-wide pool and are
+  // returned to it when the filter is destroyed, so creating a filter chain
+  // for each response does not allocate once the pool is warm.
   void InitBuffer(int size);
 
   // A factory helper for creating filters for within a chain of potentially
@@ -0,0 +1,260 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/filter.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mock_filter_context.h"
+#include "net/base/sdch_manager.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
+namespace net {
+
+namespace {
+
+const int kBodySize = 4 * 1024 * 1024;
+const int kIterations = 20;
+// The size URLRequestJob reads filtered data in.
+const int kOutputBufferSize = 32 * 1024;
+const char kSampleDomain[] = "sdchtest.com";
+// Must stay below SdchManager::kMaxDictionarySize.
+const int kDictionarySize = 512 * 1024;
+
+// Deterministic, mildly repetitive markup that compresses about as well as a
+// typical page.
+std::string MakeBody(int size) {
+  static const char* const kWords[] = {
+    "<div class=\"item\">", "</div>", "<a href=\"/path/to/page", "\">",
+    "</a>", "<span>", "</span>", "lorem", "ipsum", "dolor", "sit", "amet",
+    "consectetur", "adipiscing", "elit", " ", " ", "\n",
+  };
+  std::string body;
+  body.reserve(size);
+  uint32 seed = 1;
+  while (static_cast<int>(body.size()) < size) {
+    seed = seed * 1103515245 + 12345;
+    body.append(kWords[(seed >> 16) % arraysize(kWords)]);
+    if ((seed >> 8) % 16 == 0)
+      body.append(base::StringPrintf("%u", seed % 100000));
+  }
+  body.resize(size);
+  return body;
+}
+
+// Compresses |input| with zlib; |window_bits| selects the wrapper (zlib for
+// deflate, 16 + MAX_WBITS for gzip).
+std::string Compress(const std::string& input, int window_bits) {
+  z_stream zlib_stream;
+  memset(&zlib_stream, 0, sizeof(zlib_stream));
+  int code = deflateInit2(&zlib_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                          window_bits, 8, Z_DEFAULT_STRATEGY);
+  CHECK_EQ(Z_OK, code);
+  std::string output(deflateBound(&zlib_stream, input.size()), '\0');
+  zlib_stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  zlib_stream.avail_in = input.size();
+  zlib_stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+  zlib_stream.avail_out = output.size();
+  code = deflate(&zlib_stream, Z_FINISH);
+  CHECK_EQ(Z_STREAM_END, code);
+  output.resize(zlib_stream.total_out);
+  deflateEnd(&zlib_stream);
+  return output;
+}
+
+void AppendVarint(size_t value, std::string* output) {
+  char bytes[10];
+  int length = 0;
+  do {
+    bytes[length++] = static_cast<char>(value & 0x7f);
+    value >>= 7;
+  } while (value);
+  while (length > 1)
+    output->push_back(bytes[--length] | 0x80);
+  output->push_back(bytes[0]);
+}
+
+// Builds a VCDIFF delta (RFC 3284, default code table) that reconstructs
+// |target| from |dictionary|.  Every |kChunk| bytes of the target are either
+// copied from the same offset modulo the dictionary size, when they match, or
+// added literally.  That is enough to exercise the decoder's COPY and ADD
+// paths at realistic ratios without needing an encoder.
+std::string MakeVcdiffDelta(const std::string& dictionary,
+                            const std::string& target) {
+  const size_t kChunk = 256;
+  const size_t kWindowSize = 64 * 1024;
+  const char kAddSizeFollows = 1;
+  const char kCopySizeFollowsSelfMode = 19;
+
+  std::string delta("\xd6\xc3\xc4\x00\x00", 5);
+  for (size_t window = 0; window < target.size(); window += kWindowSize) {
+    size_t window_end = std::min(target.size(), window + kWindowSize);
+    std::string data;
+    std::string instructions;
+    std::string addresses;
+    for (size_t pos = window; pos < window_end; pos += kChunk) {
+      size_t length = std::min(kChunk, window_end - pos);
+      size_t source = pos % dictionary.size();
+      if (source + length <= dictionary.size() &&
+          dictionary.compare(source, length, target, pos, length) == 0) {
+        instructions.push_back(kCopySizeFollowsSelfMode);
+        AppendVarint(length, &instructions);
+        AppendVarint(source, &addresses);
+      } else {
+        instructions.push_back(kAddSizeFollows);
+        AppendVarint(length, &instructions);
+        data.append(target, pos, length);
+      }
+    }
+
+    std::string encoding;
+    AppendVarint(window_end - window, &encoding);
+    encoding.push_back(0);  // Delta_Indicator.
+    AppendVarint(data.size(), &encoding);
+    AppendVarint(instructions.size(), &encoding);
+    AppendVarint(addresses.size(), &encoding);
+    encoding += data + instructions + addresses;
+
+    delta.push_back(1);  // Win_Indicator: VCD_SOURCE.
+    AppendVarint(dictionary.size(), &delta);
+    AppendVarint(0, &delta);
+    AppendVarint(encoding.size(), &delta);
+    delta += encoding;
+  }
+  return delta;
+}
+
+// Feeds |input| through |filter| the way URLRequestJob does, and returns the
+// number of bytes produced, or -1 on error.
+int RunFilter(Filter* filter, const std::string& input, IOBuffer* output) {
+  size_t consumed = 0;
+  int produced = 0;
+  while (true) {
+    if (!filter->stream_data_len() && consumed < input.size()) {
+      int length = std::min(static_cast<size_t>(filter->stream_buffer_size()),
+                            input.size() - consumed);
+      memcpy(filter->stream_buffer()->data(), input.data() + consumed, length);
+      consumed += length;
+      filter->FlushStreamBuffer(length);
+    }
+    int output_length = kOutputBufferSize;
+    Filter::FilterStatus status = filter->ReadData(output->data(),
+                                                   &output_length);
+    produced += output_length;
+    if (status == Filter::FILTER_ERROR)
+      return -1;
+    if (status == Filter::FILTER_DONE)
+      return produced;
+    if (status == Filter::FILTER_NEED_MORE_DATA && consumed == input.size() &&
+        !filter->stream_data_len()) {
+      return produced;
+    }
+  }
+}
+
+class FilterPerfTest : public testing::Test {
+ protected:
+  FilterPerfTest()
+      : body_(MakeBody(kBodySize)),
+        output_(new IOBuffer(kOutputBufferSize)) {
+    filter_context_.SetMimeType("text/html");
+    filter_context_.SetURL(GURL(std::string("http://") + kSampleDomain +
+                                "/index.html"));
+  }
+
+  void RunDecodeTest(const char* name,
+                     const std::vector<Filter::FilterType>& types,
+                     const std::string& encoded) {
+    // Warm up, which also fills the stream buffer pool.
+    {
+      scoped_ptr<Filter> filter(Filter::Factory(types, filter_context_));
+      ASSERT_TRUE(filter.get());
+      ASSERT_EQ(kBodySize, RunFilter(filter.get(), encoded, output_));
+    }
+
+    int allocations_before = Filter::stream_buffer_allocations_for_testing();
+    PerfTimer timer;
+    for (int i = 0; i < kIterations; ++i) {
+      scoped_ptr<Filter> filter(Filter::Factory(types, filter_context_));
+      ASSERT_EQ(kBodySize, RunFilter(filter.get(), encoded, output_));
+    }
+    base::TimeDelta elapsed = timer.Elapsed();
+    int allocations = Filter::stream_buffer_allocations_for_testing() -
+                      allocations_before;
+
+    double megabytes = static_cast<double>(kBodySize) * kIterations /
+                       (1024 * 1024);
+    LogPerfResult(base::StringPrintf("Filter_%s_decode", name).c_str(),
+                  megabytes / elapsed.InSecondsF(), "MB/s");
+    LogPerfResult(
+        base::StringPrintf("Filter_%s_buffer_allocations", name).c_str(),
+        static_cast<double>(allocations) / kIterations, "per_response");
+  }
+
+  const std::string body_;
+  scoped_refptr<IOBuffer> output_;
+  MockFilterContext filter_context_;
+};
+
+}  // namespace
+
+TEST_F(FilterPerfTest, Gzip) {
+  std::vector<Filter::FilterType> types;
+  types.push_back(Filter::FILTER_TYPE_GZIP);
+  RunDecodeTest("gzip", types, Compress(body_, 16 + MAX_WBITS));
+}
+
+TEST_F(FilterPerfTest, Deflate) {
+  std::vector<Filter::FilterType> types;
+  types.push_back(Filter::FILTER_TYPE_DEFLATE);
+  RunDecodeTest("deflate", types, Compress(body_, MAX_WBITS));
+}
+
+TEST_F(FilterPerfTest, SdchGzip) {
+  SdchManager sdch_manager;
+  SdchManager::EnableSdchSupport(true);
+
+  // Dictionaries are limited in size, so the body is the dictionary text
+  // repeated, with every fourth chunk perturbed so that the delta is a mix of
+  // copies and literal adds.
+  std::string dictionary_text = body_.substr(0, kDictionarySize);
+  std::string sdch_target;
+  while (static_cast<int>(sdch_target.size()) < kBodySize)
+    sdch_target += dictionary_text;
+  sdch_target.resize(kBodySize);
+  for (size_t i = 0; i < sdch_target.size(); i += 1024)
+    sdch_target[i] = '#';
+  std::string dictionary = base::StringPrintf("Domain: %s\n\n", kSampleDomain) +
+                           dictionary_text;
+  GURL dictionary_url(std::string("http://") + kSampleDomain + "/dict");
+  ASSERT_TRUE(sdch_manager.AddSdchDictionary(dictionary, dictionary_url));
+  std::string client_hash;
+  std::string server_hash;
+  SdchManager::GenerateHash(dictionary, &client_hash, &server_hash);
+
+  std::string sdch_body = server_hash;
+  sdch_body.push_back('\0');
+  sdch_body += MakeVcdiffDelta(dictionary_text, sdch_target);
+
+  filter_context_.SetSdchResponse(true);
+  std::vector<Filter::FilterType> types;
+  types.push_back(Filter::FILTER_TYPE_SDCH);
+  types.push_back(Filter::FILTER_TYPE_GZIP);
+  RunDecodeTest("sdch_gzip", types, Compress(sdch_body, 16 + MAX_WBITS));
+}
+
+}  // namespace net
@@ -0,0 +1,205 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/net_log_binary_capture.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+#include "base/values.h"
+
+namespace net {
+
+namespace {
+
+struct Event {
+  Event() : type(NetLog::TYPE_CANCELLED), phase(NetLog::PHASE_NONE) {}
+
+  NetLog::EventType type;
+  NetLog::EventPhase phase;
+  NetLog::Source source;
+  base::TimeTicks time;
+  scoped_refptr<NetLog::EventParameters> params;
+};
+
+bool EventTimeLess(const Event& a, const Event& b) {
+  return a.time < b.time;
+}
+
+// The number to add to a TimeTicks value, in milliseconds, to get a unix
+// timestamp.  Matches the "timeTickOffset" constant of net-internals.
+int64 GetTickToUnixTimeMs() {
+  int64 time_ms = (base::Time::Now() - base::Time()).InMilliseconds();
+  int64 ticks_ms =
+      (base::TimeTicks::Now() - base::TimeTicks()).InMilliseconds();
+  // base::Time uses the Windows epoch (Jan 1 1601).
+  const int64 kUnixEpochMs = 11644473600000LL;
+  return time_ms - ticks_ms - kUnixEpochMs;
+}
+
+}  // namespace
+
+// Events logged on one thread.  Only that thread adds to it, so |lock_| is
+// uncontended except while the capture is being serialized.
+class NetLogBinaryCapture::ThreadBuffer {
+ public:
+  // The buffer grows as events are added, so threads that log little don't
+  // allocate the full |capacity|.
+  explicit ThreadBuffer(size_t capacity) : capacity_(capacity), next_(0) {}
+
+  void Add(NetLog::EventType type,
+           const base::TimeTicks& time,
+           const NetLog::Source& source,
+           NetLog::EventPhase phase,
+           NetLog::EventParameters* params) {
+    // The parameters of the event that is overwritten.  They are released
+    // once |lock_| is dropped, since they may be the last reference to
+    // objects that are costly to destroy.
+    scoped_refptr<NetLog::EventParameters> overwritten_params;
+    base::AutoLock lock(lock_);
+    if (events_.size() < capacity_) {
+      events_.push_back(Event());
+      next_ = events_.size() % capacity_;
+      Fill(&events_.back(), type, time, source, phase, params);
+      return;
+    }
+    Event* event = &events_[next_];
+    overwritten_params.swap(event->params);
+    Fill(event, type, time, source, phase, params);
+    next_ = (next_ + 1) % capacity_;
+  }
+
+  // Appends the buffered events to |events|, oldest first.
+  void AppendTo(std::vector<Event>* events) const {
+    base::AutoLock lock(lock_);
+    if (events_.size() < capacity_) {
+      events->insert(events->end(), events_.begin(), events_.end());
+      return;
+    }
+    events->insert(events->end(), events_.begin() + next_, events_.end());
+    events->insert(events->end(), events_.begin(), events_.begin() + next_);
+  }
+
+  size_t size() const {
+    base::AutoLock lock(lock_);
+    return events_.size();
+  }
+
+ private:
+  static void Fill(Event* event,
+                   NetLog::EventType type,
+                   const base::TimeTicks& time,
+                   const NetLog::Source& source,
+                   NetLog::EventPhase phase,
+                   NetLog::EventParameters* params) {
+    event->type = type;
+    event->phase = phase;
+    event->source = source;
+    event->time = time;
+    event->params = params;
+  }
+
+  const size_t capacity_;
+
+  mutable base::Lock lock_;
+
+  // Used as a ring once it reaches |capacity_|; |next_| is the slot that the
+  // next event goes in, which then holds the oldest event.
+  std::vector<Event> events_;
+  size_t next_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadBuffer);
+};
+
+// static
+const uint32 NetLogBinaryCapture::kMagic;
+// static
+const int NetLogBinaryCapture::kVersion;
+
+NetLogBinaryCapture::NetLogBinaryCapture(NetLog::LogLevel log_level,
+                                         size_t events_per_thread)
+    : NetLog::ThreadSafeObserver(log_level),
+      events_per_thread_(events_per_thread) {
+  DCHECK_GT(events_per_thread, 0u);
+}
+
+NetLogBinaryCapture::~NetLogBinaryCapture() {
+}
+
+void NetLogBinaryCapture::Serialize(Pickle* pickle) const {
+  std::vector<Event> events;
+  {
+    base::AutoLock lock(lock_);
+    for (size_t i = 0; i < buffers_.size(); ++i)
+      buffers_[i]->AppendTo(&events);
+  }
+  // Each buffer is already in order, so this mostly merges them.
+  std::stable_sort(events.begin(), events.end(), EventTimeLess);
+
+  pickle->WriteUInt32(kMagic);
+  pickle->WriteInt(kVersion);
+  pickle->WriteInt64(GetTickToUnixTimeMs());
+  pickle->WriteInt(static_cast<int>(events.size()));
+
+  std::string params_json;
+  for (size_t i = 0; i < events.size(); ++i) {
+    const Event& event = events[i];
+    pickle->WriteInt(static_cast<int>(event.type));
+    pickle->WriteInt(static_cast<int>(event.phase));
+    pickle->WriteInt(static_cast<int>(event.source.type));
+    pickle->WriteUInt32(event.source.id);
+    pickle->WriteInt64((event.time - base::TimeTicks()).InMicroseconds());
+    params_json.clear();
+    if (event.params) {
+      scoped_ptr<Value> value(event.params->ToValue());
+      if (value.get())
+        base::JSONWriter::Write(value.get(), false, &params_json);
+    }
+    pickle->WriteString(params_json);
+  }
+}
+
+bool NetLogBinaryCapture::WriteToFile(const FilePath& path) const {
+  Pickle pickle;
+  Serialize(&pickle);
+  int size = static_cast<int>(pickle.size());
+  return file_util::WriteFile(path, static_cast<const char*>(pickle.data()),
+                              size) == size;
+}
+
+size_t NetLogBinaryCapture::GetEventCount() const {
+  base::AutoLock lock(lock_);
+  size_t count = 0;
+  for (size_t i = 0; i < buffers_.size(); ++i)
+    count += buffers_[i]->size();
+  return count;
+}
+
+void NetLogBinaryCapture::OnAddEntry(NetLog::EventType type,
+                                     const base::TimeTicks& time,
+                                     const NetLog::Source& source,
+                                     NetLog::EventPhase phase,
+                                     NetLog::EventParameters* params) {
+  GetThreadBuffer()->Add(type, time, source, phase, params);
+}
+
+NetLogBinaryCapture::ThreadBuffer* NetLogBinaryCapture::GetThreadBuffer() {
+  ThreadBuffer* buffer = thread_buffer_.Get();
+  if (buffer)
+    return buffer;
+  buffer = new ThreadBuffer(events_per_thread_);
+  {
+    base::AutoLock lock(lock_);
+    buffers_.push_back(buffer);
+  }
+  thread_buffer_.Set(buffer);
+  return buffer;
+}
+
+}  // namespace net
@@ -0,0 +1,90 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_NET_LOG_BINARY_CAPTURE_H_
+#define NET_BASE_NET_LOG_BINARY_CAPTURE_H_
+#pragma once
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/memory/scoped_vector.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/thread_local.h"
+#include "base/time.h"
+#include "net/base/net_export.h"
+#include "net/base/net_log.h"
+
+class FilePath;
+class Pickle;
+
+namespace net {
+
+// NetLogBinaryCapture is an observer that keeps the most recent events of
+// each thread in a ring buffer, so that detailed logging can stay enabled
+// without the cost of converting every event to a Value.
+//
+// Adding an event only copies its fields and takes a reference to its
+// parameters, which is dropped when a newer event overwrites it; nothing is
+// shared between threads on that path.  Parameters
+// are serialized to JSON when the capture is written out, which makes the
+// output compact but means that parameters must stay immutable after they
+// are logged (as the EventParameters contract already requires).
+//
+// The output is a Pickle:
+//   uint32 kMagic, int kVersion, int64 tick-to-unix-time offset in ms,
+//   int event count, then for each event, oldest first:
+//   int type, int phase, int source type, uint32 source id,
+//   int64 time in microseconds since TimeTicks(), string params JSON
+//   (empty when there are no parameters).
+//
+// net/tools/net_log_binary_to_json converts it to the JSON format that
+// chrome://net-internals loads.
+class NET_EXPORT NetLogBinaryCapture : public NetLog::ThreadSafeObserver {
+ public:
+  static const uint32 kMagic = 0x4e4c4243;  // 'NLBC'
+  static const int kVersion = 1;
+
+  // Keeps up to |events_per_thread| events for each thread that logs.
+  NetLogBinaryCapture(NetLog::LogLevel log_level, size_t events_per_thread);
+  virtual ~NetLogBinaryCapture();
+
+  // Serializes all buffered events, ordered by time.
+  void Serialize(Pickle* pickle) const;
+
+  // Serializes all buffered events to |path|.  Returns false on failure.
+  bool WriteToFile(const FilePath& path) const;
+
+  // Number of events currently buffered, across all threads.
+  size_t GetEventCount() const;
+
+  // NetLog::ThreadSafeObserver implementation:
+  virtual void OnAddEntry(NetLog::EventType type,
+                          const base::TimeTicks& time,
+                          const NetLog::Source& source,
+                          NetLog::EventPhase phase,
+                          NetLog::EventParameters* params) OVERRIDE;
+
+ private:
+  class ThreadBuffer;
+
+  // Returns the calling thread's buffer, creating it if needed.
+  ThreadBuffer* GetThreadBuffer();
+
+  const size_t events_per_thread_;
+
+  base::ThreadLocalPointer<ThreadBuffer> thread_buffer_;
+
+  // Protects |buffers_|.  Only taken when a thread logs its first event and
+  // when the capture is serialized.
+  mutable base::Lock lock_;
+  ScopedVector<ThreadBuffer> buffers_;
+
+  DISALLOW_COPY_AND_ASSIGN(NetLogBinaryCapture);
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_NET_LOG_BINARY_CAPTURE_H_
@@ -0,0 +1,153 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/pickle.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+#include "base/values.h"
+#include "net/base/net_log.h"
+#include "net/base/net_log_binary_capture.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kEvents = 200000;
+
+// Dispatches to its observers under a lock, the way ChromeNetLog does.
+class ObservedNetLog : public NetLog {
+ public:
+  ObservedNetLog() : last_id_(0) {}
+  virtual ~ObservedNetLog() {}
+
+  virtual void AddEntry(EventType type,
+                        const base::TimeTicks& time,
+                        const Source& source,
+                        EventPhase phase,
+                        EventParameters* params) OVERRIDE {
+    base::AutoLock lock(lock_);
+    for (size_t i = 0; i < observers_.size(); ++i)
+      observers_[i]->OnAddEntry(type, time, source, phase, params);
+  }
+
+  virtual uint32 NextID() OVERRIDE { return ++last_id_; }
+
+  virtual LogLevel GetLogLevel() const OVERRIDE { return LOG_ALL; }
+
+  virtual void AddThreadSafeObserver(ThreadSafeObserver* observer) OVERRIDE {
+    base::AutoLock lock(lock_);
+    observers_.push_back(observer);
+  }
+
+  virtual void RemoveThreadSafeObserver(
+      ThreadSafeObserver* observer) OVERRIDE {
+    base::AutoLock lock(lock_);
+    observers_.erase(
+        std::find(observers_.begin(), observers_.end(), observer));
+  }
+
+ private:
+  base::Lock lock_;
+  std::vector<ThreadSafeObserver*> observers_;
+  uint32 last_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(ObservedNetLog);
+};
+
+// Converts every event to JSON, as the --log-net-log logger does.
+class JsonObserver : public NetLog::ThreadSafeObserver {
+ public:
+  JsonObserver() : NetLog::ThreadSafeObserver(NetLog::LOG_ALL), bytes_(0) {}
+
+  virtual void OnAddEntry(NetLog::EventType type,
+                          const base::TimeTicks& time,
+                          const NetLog::Source& source,
+                          NetLog::EventPhase phase,
+                          NetLog::EventParameters* params) OVERRIDE {
+    scoped_ptr<Value> value(NetLog::EntryToDictionaryValue(
+        type, time, source, phase, params, false));
+    std::string json;
+    base::JSONWriter::Write(value.get(), false, &json);
+    bytes_ += json.size();
+  }
+
+  size_t bytes() const { return bytes_; }
+
+ private:
+  size_t bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(JsonObserver);
+};
+
+// Logs a mix of events resembling a URL request: begin and end events with
+// and without parameters, and byte transfer events.
+void LogEvents(NetLog* net_log) {
+  BoundNetLog bound = BoundNetLog::Make(net_log, NetLog::SOURCE_URL_REQUEST);
+  const char kBytes[] = "GET / HTTP/1.1\r\nHost: www.example.com\r\n\r\n";
+  for (int i = 0; i < kEvents; i += 4) {
+    bound.BeginEvent(
+        NetLog::TYPE_URL_REQUEST_START_JOB,
+        make_scoped_refptr(new NetLogStringParameter(
+            "url", "http://www.example.com/index.html")));
+    bound.AddByteTransferEvent(NetLog::TYPE_SOCKET_BYTES_SENT,
+                               arraysize(kBytes) - 1, kBytes);
+    bound.AddEvent(NetLog::TYPE_HTTP_STREAM_REQUEST_BOUND_TO_JOB,
+                   make_scoped_refptr(new NetLogSourceParameter(
+                       "source_dependency", bound.source())));
+    bound.EndEventWithNetErrorCode(NetLog::TYPE_URL_REQUEST_START_JOB, 0);
+  }
+}
+
+double NanosecondsPerEvent(base::TimeDelta elapsed) {
+  return elapsed.InMicroseconds() * 1000.0 / kEvents;
+}
+
+}  // namespace
+
+TEST(NetLogPerfTest, PerEventOverhead) {
+  ObservedNetLog net_log;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  LogEvents(&net_log);
+  LogPerfResult("NetLog_no_observers",
+                NanosecondsPerEvent(base::TimeTicks::Now() - start), "ns");
+
+  JsonObserver json_observer;
+  net_log.AddThreadSafeObserver(&json_observer);
+  start = base::TimeTicks::Now();
+  LogEvents(&net_log);
+  LogPerfResult("NetLog_json_observer",
+                NanosecondsPerEvent(base::TimeTicks::Now() - start), "ns");
+  net_log.RemoveThreadSafeObserver(&json_observer);
+  LogPerfResult("NetLog_json_bytes_per_event",
+                static_cast<double>(json_observer.bytes()) / kEvents, "bytes");
+
+  NetLogBinaryCapture capture(NetLog::LOG_ALL, kEvents);
+  net_log.AddThreadSafeObserver(&capture);
+  start = base::TimeTicks::Now();
+  LogEvents(&net_log);
+  LogPerfResult("NetLog_binary_capture",
+                NanosecondsPerEvent(base::TimeTicks::Now() - start), "ns");
+  net_log.RemoveThreadSafeObserver(&capture);
+  EXPECT_EQ(static_cast<size_t>(kEvents), capture.GetEventCount());
+
+  // Parameters are serialized here, once, rather than as events are logged.
+  Pickle pickle;
+  start = base::TimeTicks::Now();
+  capture.Serialize(&pickle);
+  LogPerfResult("NetLog_binary_serialize",
+                NanosecondsPerEvent(base::TimeTicks::Now() - start), "ns");
+  LogPerfResult("NetLog_binary_bytes_per_event",
+                static_cast<double>(pickle.size()) / kEvents, "bytes");
+}
+
+}  // namespace net
@@ -45,6 +45,8 @@
 
 #include "net/base/registry_controlled_domain.h"
 
+#include <string.h>
+
 #include "base/logging.h"
 #include "base/memory/singleton.h"
 #include "base/string_util.h"
@@ -54,7 +56,12 @@
 #include "net/base/net_module.h"
 #include "net/base/net_util.h"
 
-#include "effective_tld_names.cc"
+// The rule type returned by the gperf lookups that unit tests substitute for
+// the graph.
+struct DomainRule {
+  const char *name;
+  int type;  // 1: exception, 2: wildcard
+};
 
 namespace net {
 
@@ -63,11 +70,41 @@ namespace {
 const int kExceptionRule = 1;
 const int kWildcardRule = 2;
 
+// See net/tools/dafsa/make_dafsa.py for the layout of the graph.
+const unsigned char kChainNode = 0x80;
+const unsigned char kLastCharInChain = 0x80;
+const int kBitmapBytes = 5;
+
+// Returns the bit of |c| in the child bitmaps of the graph, or -1 if no rule
+// contains |c|.  Must match ALPHABET in make_dafsa.py.
+int CharIndex(unsigned char c) {
+  if (c >= 'a' && c <= 'z')
+    return c - 'a';
+  if (c >= '0' && c <= '9')
+    return 26 + c - '0';
+  if (c == '-')
+    return 36;
+  if (c == '.')
+    return 37;
+  return -1;
+}
+
+int CountBits(uint64 bits) {
+  bits -= (bits >> 1) & GG_UINT64_C(0x5555555555555555);
+  bits = (bits & GG_UINT64_C(0x3333333333333333)) +
+      ((bits >> 2) & GG_UINT64_C(0x3333333333333333));
+  bits = (bits + (bits >> 4)) & GG_UINT64_C(0x0f0f0f0f0f0f0f0f);
+  return static_cast<int>((bits * GG_UINT64_C(0x0101010101010101)) >> 56);
+}
+
+size_t ReadOffset(const unsigned char* offset) {
+  return offset[0] | (offset[1] << 8);
+}
+
 }  // namespace
 
 RegistryControlledDomainService::FindDomainPtr
-RegistryControlledDomainService::find_domain_function_ =
-    Perfect_Hash::FindDomain;
+RegistryControlledDomainService::find_domain_function_ = NULL;
 
 // static
 std::string RegistryControlledDomainService::GetDomainAndRegistry(
@@ -76,7 +113,7 @@ std::string RegistryControlledDomainService::GetDomainAndRegistry(
       gurl.parsed_for_possibly_invalid_spec().host;
   if ((host.len <= 0) || gurl.HostIsIPAddress())
     return std::string();
-  return GetDomainAndRegistryImpl(std::string(
+  return GetDomainAndRegistryImpl(base::StringPiece(
       gurl.possibly_invalid_spec().data() + host.begin, host.len));
 }
 
@@ -123,7 +160,8 @@ size_t RegistryControlledDomainService::GetRegistryLength(
   if (gurl.HostIsIPAddress())
     return 0;
   return GetRegistryLengthImpl(
-      std::string(gurl.possibly_invalid_spec().data() + host.begin, host.len),
+      base::StringPiece(gurl.possibly_invalid_spec().data() + host.begin,
+                        host.len),
       allow_unknown_registries);
 }
 
@@ -143,16 +181,12 @@ size_t RegistryControlledDomainService::GetRegistryLength(
 // static
 void RegistryControlledDomainService::UseFindDomainFunction(
     FindDomainPtr function) {
-  if (function) {
-    find_domain_function_ = function;
-  } else {
-    find_domain_function_ = Perfect_Hash::FindDomain;
-  }
+  find_domain_function_ = function;
 }
 
 // static
 std::string RegistryControlledDomainService::GetDomainAndRegistryImpl(
-    const std::string& host) {
+    const base::StringPiece& host) {
   DCHECK(!host.empty());
 
   // Find the length of the registry for this host.
@@ -172,19 +206,19 @@ std::string RegistryControlledDomainService::GetDomainAndRegistryImpl(
   // dot.  Return the host from after that dot, or the whole host when there is
   // no dot.
   const size_t dot = host.rfind('.', host.length() - registry_length - 2);
-  if (dot == std::string::npos)
-    return host;
-  return host.substr(dot + 1);
+  if (dot == base::StringPiece::npos)
+    return host.as_string();
+  return host.substr(dot + 1).as_string();
 }
 
 size_t RegistryControlledDomainService::GetRegistryLengthImpl(
-    const std::string& host,
+    const base::StringPiece& host,
     bool allow_unknown_registries) {
   DCHECK(!host.empty());
 
   // Skip leading dots.
   const size_t host_check_begin = host.find_first_not_of('.');
-  if (host_check_begin == std::string::npos)
+  if (host_check_begin == base::StringPiece::npos)
     return 0;  // Host is only dots.
 
   // A single trailing dot isn't relevant in this determination, but does need
@@ -198,62 +232,131 @@ size_t RegistryControlledDomainService::GetRegistryLengthImpl(
       return 0;  // Multiple trailing dots.
   }
 
-  // Walk up the domain tree, most specific to least specific,
-  // looking for matches at each level.
-  size_t prev_start = std::string::npos;
-  size_t curr_start = host_check_begin;
-  size_t next_dot = host.find('.', curr_start);
-  if (next_dot >= host_check_len)  // Catches std::string::npos as well.
-    return 0;  // This can't have a registry + domain.
-  while (1) {
-    const char* domain_str = host.data() + curr_start;
-    int domain_length = host_check_len - curr_start;
-    const DomainRule* rule = find_domain_function_(domain_str, domain_length);
-
-    // We need to compare the string after finding a match because the
-    // no-collisions of perfect hashing only refers to items in the set.  Since
-    // we're searching for arbitrary domains, there could be collisions.
-    if (rule &&
-        base::strncasecmp(domain_str, rule->name, domain_length) == 0) {
-      // Exception rules override wildcard rules when the domain is an exact
-      // match, but wildcards take precedence when there's a subdomain.
-      if (rule->type == kWildcardRule && (prev_start != std::string::npos)) {
-        // If prev_start == host_check_begin, then the host is the registry
-        // itself, so return 0.
-        return (prev_start == host_check_begin) ?
-            0 : (host.length() - prev_start);
+  // A host without a dot can't have a registry + domain.
+  const size_t last_dot = host.rfind('.', host_check_len - 1);
+  if (last_dot == base::StringPiece::npos || last_dot < host_check_begin)
+    return 0;
+
+  size_t rule_start;
+  int rule_type;
+  if (!FindRule(host, host_check_begin, host_check_len, &rule_start,
+                &rule_type)) {
+    // No rule found in the registry.  If we allow unknown registries, return
+    // the length of the last subcomponent of the host.
+    return allow_unknown_registries ? (host.length() - last_dot - 1) : 0;
+  }
+
+  // Exception rules override wildcard rules when the domain is an exact match,
+  // but wildcards take precedence when there's a subdomain.
+  if (rule_type == kWildcardRule && rule_start != host_check_begin) {
+    // The registry is the rule plus the subcomponent in front of it.  If that
+    // subcomponent starts the host, then the host is the registry itself, so
+    // return 0.
+    const size_t dot = host.rfind('.', rule_start - 2);
+    if (dot == base::StringPiece::npos || dot < host_check_begin)
+      return 0;
+    return host.length() - dot - 1;
+  }
+
+  if (rule_type == kExceptionRule) {
+    const size_t next_dot = host.find('.', rule_start);
+    if (next_dot >= host_check_len) {
+      // If we get here, we had an exception rule with no dots (e.g.
+      // "!foo").  This would only be valid if we had a corresponding
+      // wildcard rule, which would have to be "*".  But we explicitly
+      // disallow that case, so this kind of rule is invalid.
+      NOTREACHED() << "Invalid exception rule";
+      return 0;
+    }
+    return host.length() - next_dot - 1;
+  }
+
+  // If rule_start == host_check_begin, then the host is the registry itself,
+  // so return 0.
+  return (rule_start == host_check_begin) ? 0 : (host.length() - rule_start);
+}
+
+// static
+bool RegistryControlledDomainService::FindRule(const base::StringPiece& host,
+                                               size_t begin,
+                                               size_t end,
+                                               size_t* rule_start,
+                                               int* rule_type) {
+  if (find_domain_function_) {
+    // Walk up the domain tree, most specific to least specific, looking for
+    // matches at each level.
+    size_t curr_start = begin;
+    while (1) {
+      const char* domain_str = host.data() + curr_start;
+      int domain_length = end - curr_start;
+      const DomainRule* rule = find_domain_function_(domain_str, domain_length);
+
+      // We need to compare the string after finding a match because the
+      // no-collisions of perfect hashing only refers to items in the set.
+      // Since we're searching for arbitrary domains, there could be
+      // collisions.
+      if (rule &&
+          base::strncasecmp(domain_str, rule->name, domain_length) == 0) {
+        *rule_start = curr_start;
+        *rule_type = rule->type;
+        return true;
       }
 
-      if (rule->type == kExceptionRule) {
-        if (next_dot == std::string::npos) {
-          // If we get here, we had an exception rule with no dots (e.g.
-          // "!foo").  This would only be valid if we had a corresponding
-          // wildcard rule, which would have to be "*".  But we explicitly
-          // disallow that case, so this kind of rule is invalid.
-          NOTREACHED() << "Invalid exception rule";
-          return 0;
+      const size_t next_dot = host.find('.', curr_start);
+      if (next_dot >= end)  // Catches npos as well.
+        return false;
+      curr_start = next_dot + 1;
+    }
+  }
+
+  // Walk the graph from the last character of the host towards the first.
+  // Every node that ends a rule at a label boundary is a match, and the last
+  // one found is the longest.
+  bool found = false;
+  size_t i = end;
+  const unsigned char* node = kGraph;
+  while (1) {
+    DCHECK_LT(static_cast<size_t>(node - kGraph), kGraphSize);
+    if (*node == kChainNode) {
+      // Follow the chain as far as the host matches it.
+      const unsigned char* label = node + 1;
+      while (1) {
+        if (i == begin ||
+            static_cast<unsigned char>(host[i - 1]) !=
+                (*label & ~kLastCharInChain)) {
+          return found;
         }
-        return host.length() - next_dot - 1;
+        --i;
+        if (*label++ & kLastCharInChain)
+          break;
       }
-
-      // If curr_start == host_check_begin, then the host is the registry
-      // itself, so return 0.
-      return (curr_start == host_check_begin) ?
-          0 : (host.length() - curr_start);
+      node += ReadOffset(label);
+      continue;
     }
 
-    if (next_dot >= host_check_len)  // Catches std::string::npos as well.
-      break;
+    if (*node && (i == begin || host[i - 1] == '.')) {
+      *rule_start = i;
+      *rule_type = *node - 1;
+      found = true;
+    }
+    if (i == begin)
+      return found;
 
-    prev_start = curr_start;
-    curr_start = next_dot + 1;
-    next_dot = host.find('.', curr_start);
+    const int index = CharIndex(static_cast<unsigned char>(host[i - 1]));
+    if (index < 0)
+      return found;
+    // Only the low kBitmapBytes bytes are the bitmap, but the bits above
+    // |index| don't matter.  The graph is padded so that this can't read past
+    // its end, and all our targets are little-endian.
+    uint64 bitmap;
+    memcpy(&bitmap, node + 1, sizeof(bitmap));
+    const uint64 bit = GG_UINT64_C(1) << index;
+    if (!(bitmap & bit))
+      return found;
+    --i;
+    node += ReadOffset(node + 1 + kBitmapBytes +
+                       2 * CountBits(bitmap & (bit - 1)));
   }
-
-  // No rule found in the registry.  curr_start now points to the first
-  // character of the last subcomponent of the host, so if we allow unknown
-  // registries, return the length of this subcomponent.
-  return allow_unknown_registries ? (host.length() - curr_start) : 0;
 }
 
 }  // namespace net
@@ -117,6 +117,7 @@
 #include <string>
 
 #include "base/basictypes.h"
+#include "base/string_piece.h"
 #include "net/base/net_export.h"
 
 class GURL;
@@ -194,21 +195,40 @@ class NET_EXPORT RegistryControlledDomainService {
 
  private:
   friend class RegistryControlledDomainTest;
+  friend class RegistryControlledDomainPerfTest;
 
-  // Internal workings of the static public methods.  See above.
-  static std::string GetDomainAndRegistryImpl(const std::string& host);
-  static size_t GetRegistryLengthImpl(const std::string& host,
+  // Internal workings of the static public methods.  See above.  |host| is
+  // not copied, so the GURL versions can pass the host in place.
+  static std::string GetDomainAndRegistryImpl(const base::StringPiece& host);
+  static size_t GetRegistryLengthImpl(const base::StringPiece& host,
                                       bool allow_unknown_registries);
 
+  // Finds the longest rule that matches a suffix of |host| starting at a
+  // label boundary at or after |begin|, and ending at |end|.  On success sets
+  // |rule_start| to the offset of the match in |host| and |rule_type| to its
+  // type.
+  static bool FindRule(const base::StringPiece& host,
+                       size_t begin,
+                       size_t end,
+                       size_t* rule_start,
+                       int* rule_type);
+
   typedef const struct DomainRule* (*FindDomainPtr)(const char *, unsigned int);
 
   // Used for unit tests, so that a different perfect hash map from the full
-  // list is used. Set to NULL to use the Default function.
+  // list is used.  Set to NULL to use the default graph below.
   static void UseFindDomainFunction(FindDomainPtr function);
 
-  // Function that returns a DomainRule given a domain.
+  // Function that returns a DomainRule given a domain, or NULL to look up
+  // rules in |kGraph|.
   static FindDomainPtr find_domain_function_;
 
+  // The effective-TLD rules, reversed and stored as a DAFSA so that a host
+  // can be matched from right to left in one pass.  Generated at build time
+  // from effective_tld_names.gperf by net/tools/dafsa/make_dafsa.py, which
+  // describes the format.
+  static const unsigned char kGraph[];
+  static const size_t kGraphSize;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(RegistryControlledDomainService);
 };
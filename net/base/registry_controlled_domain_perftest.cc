@@ -0,0 +1,158 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/path_service.h"
+#include "base/perftimer.h"
+#include "base/string_util.h"
+#include "base/time.h"
+#include "net/base/registry_controlled_domain.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+// The gperf table that the graph replaced, for comparison.
+#include "effective_tld_names.cc"
+
+namespace net {
+
+namespace {
+
+const int kIterations = 20;
+
+// Registries that most hosts seen in practice fall under.
+const char* const kPopularRegistries[] = {
+  "com", "net", "org", "de", "co.uk", "ru", "jp", "com.br", "fr", "it", "pl",
+  "info", "co.jp", "com.au", "edu", "gov", "nl", "cn", "com.cn", "in", "es",
+  "ca", "com.tw", "ne.jp",
+};
+
+// Hosts to look up under each registry, from plain registrations to deep
+// subdomains.
+const char* const kPrefixes[] = {
+  "",
+  "example.",
+  "www.example.",
+  "a.b.c.example.",
+  "static.ak.cdn.",
+  "mail.google.",
+  "en.m.wikipedia.",
+};
+
+// Hosts that match no rule.
+const char* const kUnknownHosts[] = {
+  "localhost.localdomain",
+  "intranet.corp",
+  "printer.lan",
+  "www.example.invalid",
+};
+
+}  // namespace
+
+class RegistryControlledDomainPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    FilePath path;
+    PathService::Get(base::DIR_SOURCE_ROOT, &path);
+    path = path.AppendASCII("net");
+    path = path.AppendASCII("base");
+    path = path.AppendASCII("effective_tld_names.gperf");
+    std::string contents;
+    ASSERT_TRUE(file_util::ReadFileToString(path, &contents));
+
+    std::vector<std::string> lines;
+    Tokenize(contents, "\n", &lines);
+    bool in_rules = false;
+    for (size_t i = 0; i < lines.size(); ++i) {
+      if (lines[i] == "%%") {
+        if (in_rules)
+          break;
+        in_rules = true;
+        continue;
+      }
+      if (in_rules)
+        rules_.push_back(lines[i].substr(0, lines[i].find(',')));
+    }
+    ASSERT_GT(rules_.size(), 1000u);
+  }
+
+  // Adds a host under each of |registries| for each prefix, plus the hosts
+  // that match no rule.
+  void AddHosts(const std::vector<std::string>& registries) {
+    for (size_t i = 0; i < registries.size(); ++i) {
+      hosts_.push_back(registries[i]);
+      for (size_t j = 0; j < arraysize(kPrefixes); ++j)
+        hosts_.push_back(kPrefixes[j] + registries[i]);
+    }
+    for (size_t i = 0; i < arraysize(kUnknownHosts); ++i)
+      hosts_.push_back(kUnknownHosts[i]);
+  }
+
+  virtual void TearDown() {
+    UseGraph();
+  }
+
+  // Looks up every host |kIterations| times and returns the sum of the
+  // registry lengths, so that the lookups can't be optimized away.
+  size_t RunLookups(const std::string& name) {
+    size_t total = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kIterations; ++i) {
+      for (size_t j = 0; j < hosts_.size(); ++j) {
+        total += RegistryControlledDomainService::GetRegistryLengthImpl(
+            hosts_[j], true);
+      }
+    }
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    LogPerfResult(name.c_str(),
+                  kIterations * hosts_.size() / elapsed.InSecondsF(),
+                  "lookups/s");
+    return total;
+  }
+
+  static void UseGperfTable() {
+    RegistryControlledDomainService::UseFindDomainFunction(
+        Perfect_Hash::FindDomain);
+  }
+
+  static void UseGraph() {
+    RegistryControlledDomainService::UseFindDomainFunction(NULL);
+  }
+
+  std::vector<std::string> rules_;
+  std::vector<std::string> hosts_;
+};
+
+// Hosts like the ones a browser sees: mostly under a few large registries,
+// where the lookup ends within a couple of labels.
+TEST_F(RegistryControlledDomainPerfTest, PopularHosts) {
+  std::vector<std::string> registries;
+  for (size_t i = 0; i < 100; ++i) {
+    registries.insert(registries.end(), kPopularRegistries,
+                      kPopularRegistries + arraysize(kPopularRegistries));
+  }
+  AddHosts(registries);
+
+  UseGperfTable();
+  size_t gperf_total = RunLookups("RegistryControlledDomain_popular_gperf");
+  UseGraph();
+  size_t graph_total = RunLookups("RegistryControlledDomain_popular_dafsa");
+  EXPECT_EQ(gperf_total, graph_total);
+}
+
+// Hosts under every rule in the list, which makes the lookups walk the whole
+// of long rules such as city.kawasaki.jp.
+TEST_F(RegistryControlledDomainPerfTest, EveryRule) {
+  AddHosts(rules_);
+
+  UseGperfTable();
+  size_t gperf_total = RunLookups("RegistryControlledDomain_every_rule_gperf");
+  UseGraph();
+  size_t graph_total = RunLookups("RegistryControlledDomain_every_rule_dafsa");
+  EXPECT_EQ(gperf_total, graph_total);
+}
+
+}  // namespace net
@@ -8,15 +8,74 @@
 #include <ctype.h>
 #include <algorithm>
 
+#include "base/compiler_specific.h"
 #include "base/file_util.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
 #include "net/base/sdch_manager.h"
 
+#include "sdch/open-vcdiff/src/google/output_string.h"
 #include "sdch/open-vcdiff/src/google/vcdecoder.h"
 
 namespace net {
 
+namespace {
+
+// Lets the vcdiff decoder write straight into the caller's buffer rather than
+// into a string that is then copied out.  Output that does not fit is kept in
+// |excess| for later reads.
+class DirectOutput : public open_vcdiff::OutputStringInterface {
+ public:
+  DirectOutput(char* dest, size_t capacity, std::string* excess)
+      : dest_(dest),
+        capacity_(capacity),
+        used_(0),
+        excess_(excess) {
+    DCHECK(excess_->empty());
+  }
+
+  virtual DirectOutput& append(const char* s, size_t n) OVERRIDE {
+    size_t direct = std::min(n, capacity_ - used_);
+    memcpy(dest_ + used_, s, direct);
+    used_ += direct;
+    if (direct < n)
+      excess_->append(s + direct, n - direct);
+    return *this;
+  }
+
+  virtual void clear() OVERRIDE {
+    used_ = 0;
+    excess_->clear();
+  }
+
+  virtual void push_back(char c) OVERRIDE {
+    append(&c, 1);
+  }
+
+  virtual void ReserveAdditionalBytes(size_t res_arg) OVERRIDE {
+    size_t room = capacity_ - used_;
+    if (res_arg > room)
+      excess_->reserve(excess_->size() + res_arg - room);
+  }
+
+  virtual size_t size() const OVERRIDE {
+    return used_ + excess_->size();
+  }
+
+  // Bytes written to the caller's buffer.
+  size_t used() const { return used_; }
+
+ private:
+  char* const dest_;
+  const size_t capacity_;
+  size_t used_;
+  std::string* excess_;
+
+  DISALLOW_COPY_AND_ASSIGN(DirectOutput);
+};
+
+}  // namespace
+
 SdchFilter::SdchFilter(const FilterContext& filter_context)
     : filter_context_(filter_context),
       decoding_status_(DECODING_UNINITIALIZED),
@@ -46,7 +105,9 @@ SdchFilter::~SdchFilter() {
   }
 
   if (vcdiff_streaming_decoder_.get()) {
-    if (!vcdiff_streaming_decoder_->FinishDecoding()) {
+    if (vcdiff_streaming_decoder_->FinishDecoding()) {
+      dictionary_->ReturnDecoder(vcdiff_streaming_decoder_.Pass());
+    } else {
       decoding_status_ = DECODING_ERROR;
       SdchManager::SdchErrorRecovery(SdchManager::INCOMPLETE_SDCH_CONTENT);
       // Make it possible for the user to hit reload, and get non-sdch content.
@@ -288,13 +349,14 @@ Filter::FilterStatus SdchFilter::ReadFilteredData(char* dest_buffer,
   if (!next_stream_data_ || stream_data_len_ <= 0)
     return FILTER_NEED_MORE_DATA;
 
-  bool ret = vcdiff_streaming_decoder_->DecodeChunk(
-    next_stream_data_, stream_data_len_, &dest_buffer_excess_);
+  DirectOutput output(dest_buffer, available_space, &dest_buffer_excess_);
+  bool ret = vcdiff_streaming_decoder_->DecodeChunkToInterface(
+    next_stream_data_, stream_data_len_, &output);
   // Assume all data was used in decoding.
   next_stream_data_ = NULL;
   source_bytes_ += stream_data_len_;
   stream_data_len_ = 0;
-  output_bytes_ += dest_buffer_excess_.size();
+  output_bytes_ += output.size();
   if (!ret) {
     vcdiff_streaming_decoder_.reset(NULL);  // Don't call it again.
     decoding_status_ = DECODING_ERROR;
@@ -302,11 +364,9 @@ Filter::FilterStatus SdchFilter::ReadFilteredData(char* dest_buffer,
     return FILTER_ERROR;
   }
 
-  amount = OutputBufferExcess(dest_buffer, available_space);
-  *dest_len += amount;
-  dest_buffer += amount;
-  available_space -= amount;
-  if (0 == available_space && !dest_buffer_excess_.empty())
+  // Anything left in dest_buffer_excess_ means the caller's buffer is full.
+  *dest_len += output.used();
+  if (!dest_buffer_excess_.empty())
       return FILTER_OK;
   return FILTER_NEED_MORE_DATA;
 }
@@ -361,10 +421,7 @@ Filter::FilterStatus SdchFilter::InitializeDictionary() {
     return FILTER_ERROR;
   }
   dictionary_ = dictionary;
-  vcdiff_streaming_decoder_.reset(new open_vcdiff::VCDiffStreamingDecoder);
-  vcdiff_streaming_decoder_->SetAllowVcdTarget(false);
-  vcdiff_streaming_decoder_->StartDecoding(dictionary_->text().data(),
-                                           dictionary_->text().size());
+  vcdiff_streaming_decoder_ = dictionary_->StartDecoder();
   decoding_status_ = DECODING_IN_PROGRESS;
   return FILTER_OK;
 }
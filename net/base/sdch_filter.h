@@ -96,8 +96,8 @@ class NET_EXPORT_PRIVATE SdchFilter : public Filter {
   // That char* data is part of the dictionary_ we hold a reference to.
   scoped_refptr<SdchManager::Dictionary> dictionary_;
 
-  // The decoder may demand a larger output buffer than the target of
-  // ReadFilteredData so we buffer the excess output between calls.
+  // The decoder writes directly into the target of ReadFilteredData, but may
+  // produce more than fits, so we buffer the excess output between calls.
   std::string dest_buffer_excess_;
   // To avoid moving strings around too much, we save the index into
   // dest_buffer_excess_ that has the next byte to output.
@@ -12,6 +12,7 @@
 #include "crypto/sha2.h"
 #include "net/base/registry_controlled_domain.h"
 #include "net/url_request/url_request_http_job.h"
+#include "sdch/open-vcdiff/src/google/vcdecoder.h"
 
 namespace net {
 
@@ -49,6 +50,28 @@ SdchManager::Dictionary::Dictionary(const std::string& dictionary_text,
 SdchManager::Dictionary::~Dictionary() {
 }
 
+scoped_ptr<open_vcdiff::VCDiffStreamingDecoder>
+SdchManager::Dictionary::StartDecoder() {
+  scoped_ptr<open_vcdiff::VCDiffStreamingDecoder> decoder;
+  if (idle_decoders_.empty()) {
+    decoder.reset(new open_vcdiff::VCDiffStreamingDecoder);
+    decoder->SetAllowVcdTarget(false);
+  } else {
+    decoder.reset(idle_decoders_[idle_decoders_.size() - 1]);
+    idle_decoders_.weak_erase(idle_decoders_.end() - 1);
+  }
+  decoder->StartDecoding(text_.data(), text_.size());
+  return decoder.Pass();
+}
+
+void SdchManager::Dictionary::ReturnDecoder(
+    scoped_ptr<open_vcdiff::VCDiffStreamingDecoder> decoder) {
+  // Enough for the responses a page typically has in flight at once.
+  const size_t kMaxIdleDecoders = 4;
+  if (idle_decoders_.size() < kMaxIdleDecoders)
+    idle_decoders_.push_back(decoder.release());
+}
+
 bool SdchManager::Dictionary::CanAdvertise(const GURL& target_url) {
   if (!SdchManager::Global()->IsInSupportedDomain(target_url))
     return false;
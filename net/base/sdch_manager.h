@@ -28,11 +28,16 @@
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/time.h"
 #include "base/threading/non_thread_safe.h"
 #include "googleurl/src/gurl.h"
 #include "net/base/net_export.h"
 
+namespace open_vcdiff {
+class VCDiffStreamingDecoder;
+}
+
 namespace net {
 
 //------------------------------------------------------------------------------
@@ -168,6 +173,15 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
     // Sdch filters can get our text to use in decoding compressed data.
     const std::string& text() const { return text_; }
 
+    // Returns a decoder that has been started on text().  Decoders handed
+    // back through ReturnDecoder() are reused, so a response does not pay for
+    // constructing a decoder and regrowing its window buffer each time.
+    scoped_ptr<open_vcdiff::VCDiffStreamingDecoder> StartDecoder();
+
+    // Takes back a decoder whose FinishDecoding() succeeded.  Idle decoders
+    // live as long as the dictionary, so they go away when it is evicted.
+    void ReturnDecoder(scoped_ptr<open_vcdiff::VCDiffStreamingDecoder> decoder);
+
    private:
     friend class base::RefCounted<Dictionary>;
     friend class SdchManager;  // Only manager can construct an instance.
@@ -229,6 +243,9 @@ class NET_EXPORT SdchManager : public NON_EXPORTED_BASE(base::NonThreadSafe) {
     const base::Time expiration_;  // Implied by max-age.
     const std::set<int> ports_;
 
+    // Finished decoders kept for reuse by StartDecoder().
+    ScopedVector<open_vcdiff::VCDiffStreamingDecoder> idle_decoders_;
+
     DISALLOW_COPY_AND_ASSIGN(Dictionary);
   };
 
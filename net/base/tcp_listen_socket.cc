@@ -160,7 +160,9 @@ void TCPListenSocket::SendInternal(const char* bytes, int len) {
 }
 
 void TCPListenSocket::Listen() {
-  int backlog = 10;  // TODO(erikkay): maybe don't allow any backlog?
+  // Let bursts of clients connect without having their SYNs dropped and
+  // retried a second or more later.
+  int backlog = SOMAXCONN;
   listen(socket_, backlog);
   // TODO(erikkay): error handling
 #if defined(OS_POSIX)
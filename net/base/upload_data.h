@@ -24,7 +24,9 @@ class FileStream;
 // of data are added.
 class NET_EXPORT_PRIVATE ChunkCallback {
  public:
-  // Invoked when a new data chunk was given for a chunked transfer upload.
+  // Invoked when a new data chunk was given for a chunked transfer upload, or
+  // when UploadDataStream has finished reading file data that it was waiting
+  // for.
   virtual void OnChunkAvailable() = 0;
 
  protected:
@@ -4,15 +4,120 @@
 
 #include "net/base/upload_data_stream.h"
 
+#include <algorithm>
+
+#include "base/bind.h"
 #include "base/file_util.h"
+#include "base/location.h"
 #include "base/logging.h"
-#include "base/threading/thread_restrictions.h"
+#include "base/threading/worker_pool.h"
 #include "net/base/file_stream.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
 
 namespace net {
 
+namespace {
+
+// Points into the data of an element of |upload_data|, and keeps it alive for
+// as long as a socket may still be writing from the buffer, e.g. after the
+// request has been cancelled.
+class UploadElementIOBuffer : public WrappedIOBuffer {
+ public:
+  UploadElementIOBuffer(UploadData* upload_data, const char* data)
+      : WrappedIOBuffer(data),
+        upload_data_(upload_data) {
+  }
+
+ private:
+  virtual ~UploadElementIOBuffer() {}
+
+  scoped_refptr<UploadData> upload_data_;
+};
+
+}  // namespace
+
+// Reads a TYPE_FILE element, one buffer at a time, on a worker thread.  It is
+// reference counted so that a read can finish after the stream is gone.
+class UploadDataStream::FileReader
+    : public base::RefCountedThreadSafe<UploadDataStream::FileReader> {
+ public:
+  // |file| is NULL if the file is missing or not readable.
+  explicit FileReader(FileStream* file)
+      : file_(file),
+        read_pending_(false),
+        data_len_(0),
+        data_offset_(0) {
+  }
+
+  // Reads up to |len| bytes on a worker thread, then runs |callback| on this
+  // thread.
+  void Start(size_t len, const base::Closure& callback) {
+    DCHECK(!read_pending_);
+    DCHECK(!available());
+    DCHECK_LE(len, kBufferSize);
+    // The previous buffer may still be held by the stream's buf(), and the
+    // one before that by a socket.  Use whichever is free.
+    if (buf_ && !buf_->HasOneRef())
+      buf_.swap(spare_buf_);
+    if (!buf_ || !buf_->HasOneRef())
+      buf_ = new IOBuffer(kBufferSize);
+    read_pending_ = true;
+    base::WorkerPool::PostTaskAndReply(
+        FROM_HERE, base::Bind(&FileReader::Read, this, len), callback, false);
+  }
+
+  // Called on this thread when the read has completed.
+  void DidRead() { read_pending_ = false; }
+
+  bool read_pending() const { return read_pending_; }
+
+  // The data read and not yet taken by the stream.  Only valid while no
+  // read is pending.
+  IOBuffer* buf() const { return buf_; }
+  size_t offset() const { return data_offset_; }
+  size_t available() const {
+    DCHECK(!read_pending_);
+    return data_len_ - data_offset_;
+  }
+
+  void DidTake(size_t num_bytes) {
+    DCHECK_LE(num_bytes, available());
+    data_offset_ += num_bytes;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<FileReader>;
+
+  ~FileReader() {}
+
+  // Runs on a worker thread.
+  void Read(size_t len) {
+    int rv = 0;
+    if (file_.get())
+      rv = file_->Read(buf_->data(), static_cast<int>(len),
+                       CompletionCallback());
+    if (rv <= 0) {
+      // If there's less data to read than we initially observed, then pad
+      // with zero.  Otherwise the server will hang waiting for the rest of
+      // the data.
+      memset(buf_->data(), 0, len);
+      rv = static_cast<int>(len);
+    }
+    data_len_ = rv;
+    data_offset_ = 0;
+  }
+
+  scoped_ptr<FileStream> file_;
+  scoped_refptr<IOBuffer> buf_;
+  scoped_refptr<IOBuffer> spare_buf_;
+  bool read_pending_;
+  size_t data_len_;
+  size_t data_offset_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileReader);
+};
+
 const size_t UploadDataStream::kBufferSize = 16384;
 bool UploadDataStream::merge_chunks_ = true;
 
@@ -41,9 +146,16 @@ void UploadDataStream::MarkConsumedAndFillBuffer(size_t num_bytes) {
 
   if (num_bytes) {
     buf_len_ -= num_bytes;
-    // Move the remaining data to the beginning.
-    if (buf_len_ > 0)
+    if (drainable_buf_) {
+      drainable_buf_->DidConsume(static_cast<int>(num_bytes));
+      if (!buf_len_) {
+        drainable_buf_ = NULL;
+        buf_ = copy_buf_;
+      }
+    } else if (buf_len_ > 0) {
+      // Move the remaining data to the beginning.
       memmove(buf_->data(), buf_->data() + num_bytes, buf_len_);
+    }
   }
 
   FillBuffer();
@@ -55,18 +167,23 @@ UploadDataStream::UploadDataStream(UploadData* upload_data)
     : upload_data_(upload_data),
       buf_(new IOBuffer(kBufferSize)),
       buf_len_(0),
+      copy_buf_(buf_),
       element_index_(0),
       element_offset_(0),
       element_file_bytes_remaining_(0),
       total_size_(upload_data->GetContentLength()),
       current_position_(0),
-      eof_(false) {
+      eof_(false),
+      chunk_callback_(NULL),
+      ALLOW_THIS_IN_INITIALIZER_LIST(weak_factory_(this)) {
 }
 
 int UploadDataStream::FillBuffer() {
   std::vector<UploadData::Element>& elements = *upload_data_->elements();
 
-  while (buf_len_ < kBufferSize && element_index_ < elements.size()) {
+  // Nothing can be added to a buffer that is exposed in place.
+  while (buf_len_ < kBufferSize && !drainable_buf_ &&
+         element_index_ < elements.size()) {
     bool advance_to_next_element = false;
 
     // This is not const as GetContentLength() is not const.
@@ -76,21 +193,26 @@ int UploadDataStream::FillBuffer() {
     if (element.type() == UploadData::TYPE_BYTES ||
         element.type() == UploadData::TYPE_CHUNK) {
       const std::vector<char>& element_data = element.bytes();
-      const size_t num_bytes_left_in_element =
-          element_data.size() - element_offset_;
-
-      const size_t num_bytes_to_copy = std::min(num_bytes_left_in_element,
-                                                free_buffer_space);
-
-      // Check if we have anything to copy first, because we are getting
-      // the address of an element in |element_data| and that will throw an
-      // exception if |element_data| is an empty vector.
-      if (num_bytes_to_copy > 0) {
-        memcpy(buf_->data() + buf_len_,
-               &element_data[element_offset_],
-               num_bytes_to_copy);
-        buf_len_ += num_bytes_to_copy;
-        element_offset_ += num_bytes_to_copy;
+
+      if (!buf_len_ && ExposeElementInPlace(&element)) {
+        // The buffer now points into the element.
+      } else {
+        const size_t num_bytes_left_in_element =
+            element_data.size() - element_offset_;
+
+        const size_t num_bytes_to_copy = std::min(num_bytes_left_in_element,
+                                                  free_buffer_space);
+
+        // Check if we have anything to copy first, because we are getting
+        // the address of an element in |element_data| and that will throw an
+        // exception if |element_data| is an empty vector.
+        if (num_bytes_to_copy > 0) {
+          memcpy(buf_->data() + buf_len_,
+                 &element_data[element_offset_],
+                 num_bytes_to_copy);
+          buf_len_ += num_bytes_to_copy;
+          element_offset_ += num_bytes_to_copy;
+        }
       }
 
       // Advance to the next element if we have consumed all data in the
@@ -101,7 +223,7 @@ int UploadDataStream::FillBuffer() {
       DCHECK(element.type() == UploadData::TYPE_FILE);
 
       // Open the file of the current element if not yet opened.
-      if (!element_file_stream_.get()) {
+      if (!element_file_reader_) {
         // If the underlying file has been changed, treat it as error.
         // Note that the expected modification time from WebKit is based on
         // time_t precision. So we have to convert both to time_t to compare.
@@ -114,34 +236,14 @@ int UploadDataStream::FillBuffer() {
           }
         }
         element_file_bytes_remaining_ = element.GetContentLength();
-        element_file_stream_.reset(element.NewFileStreamForReading());
+        element_file_reader_ =
+            new FileReader(element.NewFileStreamForReading());
       }
 
-      const int num_bytes_to_read =
-          static_cast<int>(std::min(element_file_bytes_remaining_,
-                                    static_cast<uint64>(free_buffer_space)));
-      if (num_bytes_to_read > 0) {
-        int num_bytes_consumed = 0;
-        // Temporarily allow until fix: http://crbug.com/72001.
-        base::ThreadRestrictions::ScopedAllowIO allow_io;
-        // element_file_stream_.get() is NULL if the target file is
-        // missing or not readable.
-        if (element_file_stream_.get()) {
-          num_bytes_consumed =
-              element_file_stream_->Read(buf_->data() + buf_len_,
-                                         num_bytes_to_read,
-                                         CompletionCallback());
-        }
-        if (num_bytes_consumed <= 0) {
-          // If there's less data to read than we initially observed, then
-          // pad with zero.  Otherwise the server will hang waiting for the
-          // rest of the data.
-          memset(buf_->data() + buf_len_, 0, num_bytes_to_read);
-          num_bytes_consumed = num_bytes_to_read;
-        }
-        buf_len_ += num_bytes_consumed;
-        element_file_bytes_remaining_ -= num_bytes_consumed;
-      }
+      // Stop here if the data isn't there yet; OnFileReadComplete() carries
+      // on once it has been read.
+      if (element_file_bytes_remaining_ > 0 && !TakeFileData())
+        break;
 
       // Advance to the next element if we have consumed all data in the
       // current element.
@@ -161,11 +263,82 @@ int UploadDataStream::FillBuffer() {
   return OK;
 }
 
+bool UploadDataStream::ExposeElementInPlace(UploadData::Element* element) {
+  DCHECK(!buf_len_);
+  // New chunks can reallocate the elements, so only fixed data is exposed.
+  // The end of an element is copied so that it can be sent along with what
+  // follows it.
+  if (is_chunked() ||
+      element->bytes().size() - element_offset_ < kBufferSize) {
+    return false;
+  }
+  drainable_buf_ = new DrainableIOBuffer(
+      new UploadElementIOBuffer(upload_data_,
+                                &element->bytes()[element_offset_]),
+      kBufferSize);
+  buf_ = drainable_buf_;
+  buf_len_ = kBufferSize;
+  element_offset_ += kBufferSize;
+  return true;
+}
+
+bool UploadDataStream::TakeFileData() {
+  FileReader* reader = element_file_reader_;
+  if (reader->read_pending())
+    return false;
+  if (!reader->available()) {
+    StartFileRead();
+    return false;
+  }
+
+  const size_t num_bytes = std::min(reader->available(),
+                                    kBufferSize - buf_len_);
+  if (!buf_len_) {
+    // Send the data from the reader's buffer.
+    drainable_buf_ = new DrainableIOBuffer(
+        reader->buf(), static_cast<int>(reader->offset() + num_bytes));
+    drainable_buf_->SetOffset(static_cast<int>(reader->offset()));
+    buf_ = drainable_buf_;
+  } else {
+    memcpy(buf_->data() + buf_len_, reader->buf()->data() + reader->offset(),
+           num_bytes);
+  }
+  reader->DidTake(num_bytes);
+  buf_len_ += num_bytes;
+  element_file_bytes_remaining_ -= num_bytes;
+
+  // Read the next part while this one is sent.
+  if (!reader->available() && element_file_bytes_remaining_ > 0)
+    StartFileRead();
+  return true;
+}
+
+void UploadDataStream::StartFileRead() {
+  const size_t len = static_cast<size_t>(
+      std::min(element_file_bytes_remaining_,
+               static_cast<uint64>(kBufferSize)));
+  element_file_reader_->Start(
+      len,
+      base::Bind(&UploadDataStream::OnFileReadComplete,
+                 weak_factory_.GetWeakPtr(), element_file_reader_));
+}
+
+void UploadDataStream::OnFileReadComplete(scoped_refptr<FileReader> reader) {
+  reader->DidRead();
+  DCHECK_EQ(element_file_reader_, reader);
+  // If the buffer isn't empty, the data is taken when it has been consumed.
+  if (buf_len_)
+    return;
+  FillBuffer();
+  if (chunk_callback_)
+    chunk_callback_->OnChunkAvailable();
+}
+
 void UploadDataStream::AdvanceToNextElement() {
   ++element_index_;
   element_offset_ = 0;
   element_file_bytes_remaining_ = 0;
-  element_file_stream_.reset();
+  element_file_reader_ = NULL;
 }
 
 bool UploadDataStream::IsEOF() const {
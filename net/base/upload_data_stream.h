@@ -6,15 +6,24 @@
 #define NET_BASE_UPLOAD_DATA_STREAM_H_
 #pragma once
 
-#include "base/memory/scoped_ptr.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "net/base/net_export.h"
 #include "net/base/upload_data.h"
 
 namespace net {
 
-class FileStream;
+class DrainableIOBuffer;
 class IOBuffer;
 
+// UploadDataStream presents the elements of an UploadData as a sequence of
+// buffers of at most GetBufferSize() bytes.
+//
+// Large in-memory elements are exposed in place rather than copied, and file
+// elements are read on a worker thread, one read ahead of the data being
+// sent.  While a read is outstanding buf_len() may be 0 without eof() being
+// true; the chunk callback is then invoked once the data is available, just
+// as it is when a chunked upload receives a new chunk.
 class NET_EXPORT UploadDataStream {
  public:
   ~UploadDataStream();
@@ -42,8 +51,10 @@ class NET_EXPORT UploadDataStream {
   // the upload data to be consumed.
   void MarkConsumedAndFillBuffer(size_t num_bytes);
 
-  // Sets the callback to be invoked when new chunks are available to upload.
+  // Sets the callback to be invoked when new chunks are available to upload,
+  // or when file data that the stream was waiting for has been read.
   void set_chunk_callback(ChunkCallback* callback) {
+    chunk_callback_ = callback;
     upload_data_->set_chunk_callback(callback);
   }
 
@@ -73,15 +84,32 @@ class NET_EXPORT UploadDataStream {
   static void set_merge_chunks(bool merge) { merge_chunks_ = merge; }
 
  private:
+  class FileReader;
+
   // Protects from public access since now we have a static creator function
   // which will do both creation and initialization and might return an error.
   explicit UploadDataStream(UploadData* upload_data);
 
   // Fills the buffer with any remaining data and sets eof_ if there was nothing
-  // left to fill the buffer with.
+  // left to fill the buffer with.  Starts a read and returns with the buffer
+  // short when the next file data has not been read yet.
   // Returns OK if the operation succeeds. Otherwise error code is returned.
   int FillBuffer();
 
+  // Points buf() at the next part of the current element if it can be sent
+  // without copying.  Returns false if it has to be copied into |copy_buf_|.
+  bool ExposeElementInPlace(UploadData::Element* element);
+
+  // Moves data that the file reader has read into the buffer, and starts
+  // reading the next part of the file.  Returns false if there is no data yet.
+  bool TakeFileData();
+
+  // Starts reading the next part of the current element's file.
+  void StartFileRead();
+
+  // Called on this thread when a read started by StartFileRead() completes.
+  void OnFileReadComplete(scoped_refptr<FileReader> reader);
+
   // Advances to the next element. Updates the internal states.
   void AdvanceToNextElement();
 
@@ -91,13 +119,22 @@ class NET_EXPORT UploadDataStream {
 
   scoped_refptr<UploadData> upload_data_;
 
-  // This buffer is filled with data to be uploaded.  The data to be sent is
-  // always at the front of the buffer.  If we cannot send all of the buffer at
-  // once, then we memmove the remaining portion and back-fill the buffer for
-  // the next "write" call.  buf_len_ indicates how much data is in the buffer.
+  // The data to be sent, of which there are buf_len_ bytes.  This is either
+  // |copy_buf_|, or a DrainableIOBuffer over part of an element or over data
+  // read from a file, which is drained as it is consumed.
   scoped_refptr<IOBuffer> buf_;
   size_t buf_len_;
 
+  // Small elements and the ends of large ones are copied into this buffer, so
+  // that they can be sent together.  The data to be sent is always at the
+  // front of the buffer.  If we cannot send all of the buffer at once, then we
+  // memmove the remaining portion and back-fill the buffer for the next
+  // "write" call.
+  scoped_refptr<IOBuffer> copy_buf_;
+
+  // Set when |buf_| is a DrainableIOBuffer rather than |copy_buf_|.
+  scoped_refptr<DrainableIOBuffer> drainable_buf_;
+
   // Index of the current upload element (i.e. the element currently being
   // read). The index is used as a cursor to iterate over elements in
   // |upload_data_|.
@@ -107,12 +144,12 @@ class NET_EXPORT UploadDataStream {
   // element is a TYPE_BYTES or TYPE_DATA element.
   size_t element_offset_;
 
-  // A stream to the currently open file, for the current element if the
-  // current element is a TYPE_FILE element.
-  scoped_ptr<FileStream> element_file_stream_;
+  // Reads the current element's file on a worker thread, if the current
+  // element is a TYPE_FILE element.
+  scoped_refptr<FileReader> element_file_reader_;
 
-  // The number of bytes remaining to be read from the currently open file
-  // if the current element is of TYPE_FILE.
+  // The number of bytes of the current TYPE_FILE element that have not been
+  // put in the buffer yet, including those the reader holds.
   uint64 element_file_bytes_remaining_;
 
   // Size and current read position within the upload data stream.
@@ -122,10 +159,14 @@ class NET_EXPORT UploadDataStream {
   // Whether there is no data left to read.
   bool eof_;
 
+  ChunkCallback* chunk_callback_;
+
+  base::WeakPtrFactory<UploadDataStream> weak_factory_;
+
   // TODO(satish): Remove this once we have a better way to unit test POST
   // requests with chunked uploads.
   static bool merge_chunks_;
-  // The size of the stream's buffer pointed by buf_.
+  // The size of the stream's buffer pointed by buf_, and of each file read.
   static const size_t kBufferSize;
 
   DISALLOW_COPY_AND_ASSIGN(UploadDataStream);
@@ -0,0 +1,138 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/scoped_temp_dir.h"
+#include "base/time.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/upload_data.h"
+#include "net/base/upload_data_stream.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kFileSize = 32 * 1024 * 1024;
+const int kMemorySize = 8 * 1024 * 1024;
+const char kPartHeader[] =
+    "--boundary\r\n"
+    "Content-Disposition: form-data; name=\"file\"; filename=\"a.bin\"\r\n"
+    "Content-Type: application/octet-stream\r\n\r\n";
+const char kTrailer[] = "\r\n--boundary--\r\n";
+
+// Drains an UploadDataStream the way HttpStreamParser does, copying each
+// buffer out as a socket write would, and waiting for the chunk callback
+// when the stream has nothing ready.
+class UploadConsumer : public ChunkCallback {
+ public:
+  UploadConsumer() : bytes_(0), waits_(0) {}
+
+  virtual void OnChunkAvailable() OVERRIDE {
+    MessageLoop::current()->Quit();
+  }
+
+  // Returns the time spent in the stream's calls, which is time that the IO
+  // thread is blocked.
+  base::TimeDelta Consume(UploadData* upload_data) {
+    std::vector<char> sink(UploadDataStream::GetBufferSize());
+    base::TimeDelta blocked;
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    int rv = ERR_FAILED;
+    scoped_ptr<UploadDataStream> stream(
+        UploadDataStream::Create(upload_data, &rv));
+    blocked += base::TimeTicks::Now() - start;
+    EXPECT_EQ(OK, rv);
+    if (rv != OK)
+      return blocked;
+    stream->set_chunk_callback(this);
+
+    while (!stream->eof()) {
+      size_t len = stream->buf_len();
+      if (!len) {
+        ++waits_;
+        MessageLoop::current()->Run();
+        continue;
+      }
+      memcpy(&sink[0], stream->buf()->data(), len);
+      bytes_ += len;
+      start = base::TimeTicks::Now();
+      stream->MarkConsumedAndFillBuffer(len);
+      blocked += base::TimeTicks::Now() - start;
+    }
+    stream->set_chunk_callback(NULL);
+    return blocked;
+  }
+
+  int64 bytes() const { return bytes_; }
+  int waits() const { return waits_; }
+
+ private:
+  int64 bytes_;
+  int waits_;
+
+  DISALLOW_COPY_AND_ASSIGN(UploadConsumer);
+};
+
+class UploadDataStreamPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    file_path_ = temp_dir_.path().AppendASCII("upload.bin");
+    std::string contents(kFileSize, 'f');
+    ASSERT_EQ(kFileSize, file_util::WriteFile(file_path_, contents.data(),
+                                              contents.size()));
+  }
+
+  void RunUpload(const std::string& name, UploadData* upload_data) {
+    UploadConsumer consumer;
+    base::TimeTicks start = base::TimeTicks::Now();
+    base::TimeDelta blocked = consumer.Consume(upload_data);
+    base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    EXPECT_EQ(static_cast<int64>(upload_data->GetContentLength()),
+              consumer.bytes());
+    LogPerfResult((name + "_throughput").c_str(),
+                  consumer.bytes() / elapsed.InSecondsF() / (1024 * 1024),
+                  "MB/s");
+    LogPerfResult((name + "_io_thread_blocked").c_str(),
+                  blocked.InMillisecondsF(), "ms");
+    LogPerfResult((name + "_waits").c_str(), consumer.waits(), "");
+  }
+
+  MessageLoopForIO message_loop_;
+  ScopedTempDir temp_dir_;
+  FilePath file_path_;
+};
+
+}  // namespace
+
+TEST_F(UploadDataStreamPerfTest, Memory) {
+  scoped_refptr<UploadData> upload_data(new UploadData);
+  std::string contents(kMemorySize, 'm');
+  upload_data->AppendBytes(kPartHeader, arraysize(kPartHeader) - 1);
+  upload_data->AppendBytes(contents.data(), contents.size());
+  upload_data->AppendBytes(kTrailer, arraysize(kTrailer) - 1);
+  RunUpload("UploadDataStream_memory", upload_data);
+}
+
+TEST_F(UploadDataStreamPerfTest, MultipartFile) {
+  scoped_refptr<UploadData> upload_data(new UploadData);
+  upload_data->AppendBytes(kPartHeader, arraysize(kPartHeader) - 1);
+  upload_data->AppendFileRange(file_path_, 0, kuint64max, base::Time());
+  upload_data->AppendBytes(kTrailer, arraysize(kTrailer) - 1);
+  RunUpload("UploadDataStream_file", upload_data);
+}
+
+}  // namespace net
@@ -0,0 +1,189 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/upload_data_stream.h"
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/time.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/upload_data.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const char kTestData[] = "0123456789";
+const size_t kTestDataSize = arraysize(kTestData) - 1;
+
+// Quits the current message loop when the stream has data again.
+class QuitOnChunkAvailable : public ChunkCallback {
+ public:
+  QuitOnChunkAvailable() {}
+
+  virtual void OnChunkAvailable() OVERRIDE {
+    MessageLoop::current()->Quit();
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(QuitOnChunkAvailable);
+};
+
+}  // namespace
+
+class UploadDataStreamTest : public testing::Test {
+ protected:
+  UploadDataStreamTest() : upload_data_(new UploadData) {}
+
+  // Consumes the whole stream, waiting for file reads when buf() is empty,
+  // and returns what it contained.
+  std::string ReadAll(UploadDataStream* stream) {
+    QuitOnChunkAvailable callback;
+    stream->set_chunk_callback(&callback);
+    std::string data;
+    while (!stream->eof()) {
+      if (!stream->buf_len()) {
+        MessageLoop::current()->Run();
+        continue;
+      }
+      data.append(stream->buf()->data(), stream->buf_len());
+      stream->MarkConsumedAndFillBuffer(stream->buf_len());
+    }
+    stream->set_chunk_callback(NULL);
+    return data;
+  }
+
+  MessageLoop message_loop_;
+  scoped_refptr<UploadData> upload_data_;
+};
+
+TEST_F(UploadDataStreamTest, EmptyUploadData) {
+  upload_data_->AppendBytes(kTestData, 0);
+  scoped_ptr<UploadDataStream> stream(
+      UploadDataStream::Create(upload_data_, NULL));
+  ASSERT_TRUE(stream.get());
+  EXPECT_EQ(0u, stream->buf_len());
+  EXPECT_TRUE(stream->eof());
+}
+
+TEST_F(UploadDataStreamTest, ConsumeAll) {
+  upload_data_->AppendBytes(kTestData, kTestDataSize);
+  scoped_ptr<UploadDataStream> stream(
+      UploadDataStream::Create(upload_data_, NULL));
+  ASSERT_TRUE(stream.get());
+  EXPECT_EQ(kTestDataSize, stream->buf_len());
+  EXPECT_EQ(kTestData, ReadAll(stream.get()));
+  EXPECT_EQ(kTestDataSize, stream->position());
+}
+
+// Tests that a large element is sent from its own memory, and that partial
+// writes drain the same buffer until the end of the element is copied.
+TEST_F(UploadDataStreamTest, ExposesLargeElementInPlace) {
+  const size_t kBufferSize = UploadDataStream::GetBufferSize();
+  const size_t kTailSize = 100;
+  std::string contents(2 * kBufferSize + kTailSize, 'a');
+  for (size_t i = 0; i < contents.size(); ++i)
+    contents[i] = static_cast<char>(i % 251);
+  upload_data_->AppendBytes(contents.data(), contents.size());
+  const char* element = &(*upload_data_->elements())[0].bytes()[0];
+
+  scoped_ptr<UploadDataStream> stream(
+      UploadDataStream::Create(upload_data_, NULL));
+  ASSERT_TRUE(stream.get());
+  ASSERT_EQ(kBufferSize, stream->buf_len());
+  EXPECT_EQ(element, stream->buf()->data());
+
+  // A partial write drains the buffer in place instead of moving the rest.
+  IOBuffer* buf = stream->buf();
+  stream->MarkConsumedAndFillBuffer(kTailSize);
+  EXPECT_EQ(buf, stream->buf());
+  EXPECT_EQ(kBufferSize - kTailSize, stream->buf_len());
+  EXPECT_EQ(element + kTailSize, stream->buf()->data());
+
+  stream->MarkConsumedAndFillBuffer(kBufferSize - kTailSize);
+  ASSERT_EQ(kBufferSize, stream->buf_len());
+  EXPECT_EQ(element + kBufferSize, stream->buf()->data());
+
+  // The end of the element is shorter than a buffer, and is copied.
+  stream->MarkConsumedAndFillBuffer(kBufferSize);
+  ASSERT_EQ(kTailSize, stream->buf_len());
+  EXPECT_NE(element + 2 * kBufferSize, stream->buf()->data());
+  EXPECT_EQ(contents.substr(2 * kBufferSize),
+            std::string(stream->buf()->data(), stream->buf_len()));
+  EXPECT_FALSE(stream->eof());
+
+  stream->MarkConsumedAndFillBuffer(kTailSize);
+  EXPECT_TRUE(stream->eof());
+  EXPECT_EQ(contents.size(), stream->position());
+}
+
+// Tests that the stream has no data and is not at its end while a file is
+// being read, and calls the chunk callback once the data has been read.
+TEST_F(UploadDataStreamTest, WaitsForFileRead) {
+  FilePath temp_file_path;
+  ASSERT_TRUE(file_util::CreateTemporaryFile(&temp_file_path));
+  ASSERT_EQ(static_cast<int>(kTestDataSize),
+            file_util::WriteFile(temp_file_path, kTestData, kTestDataSize));
+  upload_data_->AppendFileRange(temp_file_path, 0, kuint64max, base::Time());
+
+  scoped_ptr<UploadDataStream> stream(
+      UploadDataStream::Create(upload_data_, NULL));
+  ASSERT_TRUE(stream.get());
+  EXPECT_EQ(0u, stream->buf_len());
+  EXPECT_FALSE(stream->eof());
+
+  QuitOnChunkAvailable callback;
+  stream->set_chunk_callback(&callback);
+  MessageLoop::current()->Run();
+  ASSERT_EQ(kTestDataSize, stream->buf_len());
+  EXPECT_EQ(kTestData, std::string(stream->buf()->data(), kTestDataSize));
+  stream->MarkConsumedAndFillBuffer(kTestDataSize);
+  EXPECT_TRUE(stream->eof());
+  stream->set_chunk_callback(NULL);
+
+  file_util::Delete(temp_file_path, false);
+}
+
+// Tests that a file that is shorter than the length that was reported for it,
+// e.g. because it was truncated, is padded with zeros to that length.
+TEST_F(UploadDataStreamTest, FileSmallerThanLength) {
+  FilePath temp_file_path;
+  ASSERT_TRUE(file_util::CreateTemporaryFile(&temp_file_path));
+  ASSERT_EQ(static_cast<int>(kTestDataSize),
+            file_util::WriteFile(temp_file_path, kTestData, kTestDataSize));
+  const uint64 kFakeSize = kTestDataSize + UploadDataStream::GetBufferSize();
+
+  std::vector<UploadData::Element> elements;
+  UploadData::Element element;
+  element.SetToFilePath(temp_file_path);
+  element.SetContentLength(kFakeSize);
+  elements.push_back(element);
+  upload_data_->SetElements(elements);
+  EXPECT_EQ(kFakeSize, upload_data_->GetContentLength());
+
+  scoped_ptr<UploadDataStream> stream(
+      UploadDataStream::Create(upload_data_, NULL));
+  ASSERT_TRUE(stream.get());
+  EXPECT_FALSE(stream->eof());
+  std::string data = ReadAll(stream.get());
+  ASSERT_EQ(kFakeSize, data.size());
+  EXPECT_EQ(kTestData, data.substr(0, kTestDataSize));
+  EXPECT_EQ(std::string(kFakeSize - kTestDataSize, '\0'),
+            data.substr(kTestDataSize));
+  EXPECT_EQ(kFakeSize, stream->position());
+
+  file_util::Delete(temp_file_path, false);
+}
+
+}  // namespace net
@@ -104,7 +104,9 @@ HttpCache::ActiveEntry::ActiveEntry(disk_cache::Entry* entry)
     : disk_entry(entry),
       writer(NULL),
       will_process_pending_queue(false),
-      doomed(false) {
+      doomed(false),
+      streaming(false),
+      stream_truncated(false) {
 }
 
 HttpCache::ActiveEntry::~ActiveEntry() {
@@ -312,6 +314,7 @@ HttpCache::HttpCache(HostResolver* host_resolver,
       backend_factory_(backend_factory),
       building_backend_(false),
       mode_(NORMAL),
+      readers_follow_writer_(false),
       ssl_host_info_factory_(new SSLHostInfoFactoryAdaptor(
           cert_verifier,
           ALLOW_THIS_IN_INITIALIZER_LIST(this))),
@@ -339,6 +342,7 @@ HttpCache::HttpCache(HttpNetworkSession* session,
       backend_factory_(backend_factory),
       building_backend_(false),
       mode_(NORMAL),
+      readers_follow_writer_(false),
       ssl_host_info_factory_(new SSLHostInfoFactoryAdaptor(
           session->cert_verifier(),
           ALLOW_THIS_IN_INITIALIZER_LIST(this))),
@@ -352,6 +356,7 @@ HttpCache::HttpCache(HttpTransactionFactory* network_layer,
       backend_factory_(backend_factory),
       building_backend_(false),
       mode_(NORMAL),
+      readers_follow_writer_(false),
       network_layer_(network_layer) {
 }
 
@@ -365,6 +370,7 @@ HttpCache::~HttpCache() {
     entry->will_process_pending_queue = false;
     entry->pending_queue.clear();
     entry->readers.clear();
+    entry->waiting_readers.clear();
     entry->writer = NULL;
     DeactivateEntry(entry);
   }
@@ -613,7 +619,8 @@ int HttpCache::DoomEntry(const std::string& key, Transaction* trans) {
   entry->disk_entry->Doom();
   entry->doomed = true;
 
-  DCHECK(entry->writer || !entry->readers.empty());
+  DCHECK(entry->writer || !entry->readers.empty() ||
+         entry->will_process_pending_queue);
   return OK;
 }
 
@@ -811,9 +818,14 @@ int HttpCache::AddTransactionToEntry(ActiveEntry* entry, Transaction* trans) {
   //
   // NOTE: If the transaction can only write, then the entry should not be in
   // use (since any existing entry should have already been doomed).
+  //
+  // While a streaming writer stores the response body, readers that can use
+  // that response are let in from the pending queue (see StartStreaming).
 
   if (entry->writer || entry->will_process_pending_queue) {
     entry->pending_queue.push_back(trans);
+    if (entry->streaming)
+      ProcessPendingQueue(entry);
     return ERR_IO_PENDING;
   }
 
@@ -843,16 +855,18 @@ void HttpCache::DoneWithEntry(ActiveEntry* entry, Transaction* trans,
                               bool cancel) {
   // If we already posted a task to move on to the next transaction and this was
   // the writer, there is nothing to cancel.
-  if (entry->will_process_pending_queue && entry->readers.empty())
+  if (entry->will_process_pending_queue && entry->readers.empty() &&
+      entry->writer != trans)
     return;
 
-  if (entry->writer) {
-    DCHECK(trans == entry->writer);
-
+  if (entry->writer == trans) {
     // Assume there was a failure.
     bool success = false;
     if (cancel) {
       DCHECK(entry->disk_entry);
+      // Readers following the writer may not get the whole body; they check
+      // what they read against the response length.
+      entry->stream_truncated = true;
       // This is a successful operation in the sense that we want to keep the
       // entry.
       success = trans->AddTruncatedFlag();
@@ -867,21 +881,34 @@ void HttpCache::DoneWithEntry(ActiveEntry* entry, Transaction* trans,
 }
 
 void HttpCache::DoneWritingToEntry(ActiveEntry* entry, bool success) {
-  DCHECK(entry->readers.empty());
+  // Only readers following a streaming writer share the entry with it.
+  DCHECK(entry->readers.empty() || entry->streaming);
 
   entry->writer = NULL;
 
+  if (entry->streaming) {
+    // Let the readers that caught up with the writer finish.
+    entry->streaming = false;
+    if (!success)
+      entry->stream_truncated = true;
+    ResumeWaitingReaders(entry);
+  }
+
   if (success) {
     ProcessPendingQueue(entry);
   } else {
-    DCHECK(!entry->will_process_pending_queue);
-
     // We failed to create this entry.
     TransactionList pending_queue;
     pending_queue.swap(entry->pending_queue);
 
-    entry->disk_entry->Doom();
-    DestroyEntry(entry);
+    if (entry->readers.empty() && !entry->will_process_pending_queue) {
+      entry->disk_entry->Doom();
+      DestroyEntry(entry);
+    } else if (!entry->doomed) {
+      // Readers that were following the writer, or a pending queue task,
+      // still use the entry; it goes away once they are done with it.
+      DoomActiveEntry(entry->disk_entry->GetKey());
+    }
 
     // We need to do something about these pending entries, which now need to
     // be added to a new entry.
@@ -894,13 +921,14 @@ void HttpCache::DoneWritingToEntry(ActiveEntry* entry, bool success) {
 }
 
 void HttpCache::DoneReadingFromEntry(ActiveEntry* entry, Transaction* trans) {
-  DCHECK(!entry->writer);
+  DCHECK(!entry->writer || entry->streaming);
 
   TransactionList::iterator it =
       std::find(entry->readers.begin(), entry->readers.end(), trans);
   DCHECK(it != entry->readers.end());
 
   entry->readers.erase(it);
+  entry->waiting_readers.remove(trans);
 
   ProcessPendingQueue(entry);
 }
@@ -918,6 +946,38 @@ void HttpCache::ConvertWriterToReader(ActiveEntry* entry) {
   ProcessPendingQueue(entry);
 }
 
+void HttpCache::StartStreaming(ActiveEntry* entry) {
+  DCHECK(entry->writer);
+  if (!readers_follow_writer_)
+    return;
+
+  entry->streaming = true;
+  entry->stream_truncated = false;
+  if (!entry->pending_queue.empty())
+    ProcessPendingQueue(entry);
+}
+
+int HttpCache::WaitForEntryData(ActiveEntry* entry, Transaction* trans) {
+  if (!entry->streaming)
+    return OK;
+
+  entry->waiting_readers.push_back(trans);
+  return ERR_IO_PENDING;
+}
+
+void HttpCache::ResumeWaitingReaders(ActiveEntry* entry) {
+  // The notifications are posted so that readers never run from within the
+  // writer's IO completion.  The callbacks are bound to weak pointers, so a
+  // reader that goes away in the meantime is simply not notified.
+  TransactionList waiting_readers;
+  waiting_readers.swap(entry->waiting_readers);
+  for (TransactionList::iterator it = waiting_readers.begin();
+       it != waiting_readers.end(); ++it) {
+    MessageLoop::current()->PostTask(FROM_HERE,
+                                     base::Bind((*it)->io_callback(), OK));
+  }
+}
+
 LoadState HttpCache::GetLoadStateForPendingTransaction(
       const Transaction* trans) {
   ActiveEntriesMap::const_iterator i = active_entries_.find(trans->key());
@@ -1013,7 +1073,23 @@ void HttpCache::ProcessPendingQueue(ActiveEntry* entry) {
 
 void HttpCache::OnProcessPendingQueue(ActiveEntry* entry) {
   entry->will_process_pending_queue = false;
-  DCHECK(!entry->writer);
+
+  if (entry->writer) {
+    // A streaming writer lets in the transactions at the head of the queue
+    // that can read the response it is storing; the rest wait for it to
+    // finish.
+    if (!entry->streaming || entry->pending_queue.empty())
+      return;
+    Transaction* next = entry->pending_queue.front();
+    if (!next->FollowWriter(entry->writer))
+      return;
+    entry->pending_queue.erase(entry->pending_queue.begin());
+    entry->readers.push_back(next);
+    if (!entry->pending_queue.empty())
+      ProcessPendingQueue(entry);
+    next->io_callback().Run(OK);
+    return;
+  }
 
   // If no one is interested in this entry, then we can deactivate it.
   if (entry->pending_queue.empty()) {
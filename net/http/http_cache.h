@@ -178,6 +178,11 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   void set_mode(Mode value) { mode_ = value; }
   Mode mode() { return mode_; }
 
+  // When enabled, transactions that find their entry being written read the
+  // response as it is stored, instead of waiting for the writer to finish.
+  // Disabled by default.
+  void set_readers_follow_writer(bool value) { readers_follow_writer_ = value; }
+
   // Close currently active sockets so that fresh page loads will not use any
   // recycled connections.  For sockets currently in use, they may not close
   // immediately, but they will not be reusable. This is for debugging.
@@ -228,8 +233,16 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
     Transaction*       writer;
     TransactionList    readers;
     TransactionList    pending_queue;
+    // Readers that have read everything |writer| has stored so far.
+    TransactionList    waiting_readers;
     bool               will_process_pending_queue;
     bool               doomed;
+    // Set while |writer| stores a response body that |readers| may read
+    // before it is complete.
+    bool               streaming;
+    // Set if the streaming writer may have stopped before it stored the
+    // whole response.
+    bool               stream_truncated;
   };
 
   typedef base::hash_map<std::string, ActiveEntry*> ActiveEntriesMap;
@@ -329,6 +342,21 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   // transactions can start reading from this entry.
   void ConvertWriterToReader(ActiveEntry* entry);
 
+  // Called by the writer of |entry| once the response headers are stored and
+  // only the body remains to be written.  If readers may follow the writer,
+  // pending transactions that can use the response start reading it.
+  void StartStreaming(ActiveEntry* entry);
+
+  // Called by |trans|, a reader of |entry|, when it has read everything that
+  // is stored.  Returns ERR_IO_PENDING if the writer is still streaming, in
+  // which case |trans| will be notified via its IO callback when there is
+  // more data.  Otherwise returns OK.
+  int WaitForEntryData(ActiveEntry* entry, Transaction* trans);
+
+  // Notifies the readers waiting on |entry| that the writer stored more data
+  // or stopped writing.
+  void ResumeWaitingReaders(ActiveEntry* entry);
+
   // Returns the LoadState of the provided pending transaction.
   LoadState GetLoadStateForPendingTransaction(const Transaction* trans);
 
@@ -379,6 +407,8 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
 
   Mode mode_;
 
+  bool readers_follow_writer_;
+
   const scoped_ptr<SSLHostInfoFactoryAdaptor> ssl_host_info_factory_;
 
   const scoped_ptr<HttpTransactionFactory> network_layer_;
@@ -0,0 +1,289 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+
+#include "base/bind.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/io_buffer.h"
+#include "net/base/load_flags.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/http/http_cache.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_response_info.h"
+#include "net/http/http_transaction.h"
+#include "net/http/http_transaction_factory.h"
+#include "net/http/http_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// The resource every consumer asks for.  The network delivers it in chunks
+// at a steady pace, as a slow link would.
+const int kBodySize = 512 * 1024;
+const int kChunkSize = 16 * 1024;
+const int kResponseDelayMs = 20;
+const int kChunkDelayMs = 5;
+const int kReadSize = 32 * 1024;
+const char kUrl[] = "http://www.example.com/popular.js";
+
+// A network transaction that returns a cacheable 200 response for any
+// request, with delays before the headers and before each chunk of body.
+class PacedNetworkTransaction : public HttpTransaction {
+ public:
+  PacedNetworkTransaction() : body_offset_(0), weak_factory_(this) {}
+  virtual ~PacedNetworkTransaction() {}
+
+  virtual int Start(const HttpRequestInfo* request_info,
+                    const CompletionCallback& callback,
+                    const BoundNetLog& net_log) OVERRIDE {
+    std::string headers = base::StringPrintf(
+        "HTTP/1.1 200 OK\n"
+        "Cache-Control: max-age=3600\n"
+        "Content-Length: %d\n", kBodySize);
+    response_.request_time = base::Time::Now();
+    response_.response_time = base::Time::Now();
+    response_.headers = new HttpResponseHeaders(
+        HttpUtil::AssembleRawHeaders(headers.data(), headers.size()));
+    PostCallback(callback, OK, kResponseDelayMs);
+    return ERR_IO_PENDING;
+  }
+
+  virtual int RestartIgnoringLastError(
+      const CompletionCallback& callback) OVERRIDE {
+    return ERR_FAILED;
+  }
+
+  virtual int RestartWithCertificate(
+      X509Certificate* client_cert,
+      const CompletionCallback& callback) OVERRIDE {
+    return ERR_FAILED;
+  }
+
+  virtual int RestartWithAuth(const AuthCredentials& credentials,
+                              const CompletionCallback& callback) OVERRIDE {
+    return ERR_FAILED;
+  }
+
+  virtual bool IsReadyToRestartForAuth() OVERRIDE { return false; }
+
+  virtual int Read(IOBuffer* buf, int buf_len,
+                   const CompletionCallback& callback) OVERRIDE {
+    int length = std::min(std::min(buf_len, kChunkSize),
+                          kBodySize - body_offset_);
+    if (!length)
+      return 0;
+    memset(buf->data(), 'x', length);
+    body_offset_ += length;
+    PostCallback(callback, length, kChunkDelayMs);
+    return ERR_IO_PENDING;
+  }
+
+  virtual void StopCaching() OVERRIDE {}
+  virtual void DoneReading() OVERRIDE {}
+
+  virtual const HttpResponseInfo* GetResponseInfo() const OVERRIDE {
+    return &response_;
+  }
+
+  virtual LoadState GetLoadState() const OVERRIDE {
+    return LOAD_STATE_READING_RESPONSE;
+  }
+
+  virtual uint64 GetUploadProgress() const OVERRIDE { return 0; }
+
+ private:
+  void PostCallback(const CompletionCallback& callback, int result,
+                    int delay_ms) {
+    MessageLoop::current()->PostDelayedTask(
+        FROM_HERE,
+        base::Bind(&PacedNetworkTransaction::RunCallback,
+                   weak_factory_.GetWeakPtr(), callback, result),
+        base::TimeDelta::FromMilliseconds(delay_ms));
+  }
+
+  void RunCallback(const CompletionCallback& callback, int result) {
+    callback.Run(result);
+  }
+
+  HttpResponseInfo response_;
+  int body_offset_;
+  base::WeakPtrFactory<PacedNetworkTransaction> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(PacedNetworkTransaction);
+};
+
+class PacedNetworkLayer : public HttpTransactionFactory {
+ public:
+  PacedNetworkLayer() : transaction_count_(0) {}
+  virtual ~PacedNetworkLayer() {}
+
+  int transaction_count() const { return transaction_count_; }
+
+  virtual int CreateTransaction(scoped_ptr<HttpTransaction>* trans) OVERRIDE {
+    ++transaction_count_;
+    trans->reset(new PacedNetworkTransaction);
+    return OK;
+  }
+
+  virtual HttpCache* GetCache() OVERRIDE { return NULL; }
+  virtual HttpNetworkSession* GetSession() OVERRIDE { return NULL; }
+
+ private:
+  int transaction_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(PacedNetworkLayer);
+};
+
+// Fetches the resource through the cache and records when the headers and
+// the end of the body arrive.
+class Consumer {
+ public:
+  Consumer(HttpCache* cache, const HttpRequestInfo* request, int* remaining)
+      : cache_(cache),
+        request_(request),
+        remaining_(remaining),
+        buffer_(new IOBuffer(kReadSize)),
+        bytes_read_(0) {
+  }
+
+  void Start() {
+    start_time_ = base::TimeTicks::Now();
+    ASSERT_EQ(OK, cache_->CreateTransaction(&transaction_));
+    int rv = transaction_->Start(
+        request_, base::Bind(&Consumer::OnStarted, base::Unretained(this)),
+        BoundNetLog());
+    if (rv != ERR_IO_PENDING)
+      OnStarted(rv);
+  }
+
+  base::TimeDelta headers_latency() const {
+    return headers_time_ - start_time_;
+  }
+  base::TimeDelta body_latency() const { return done_time_ - start_time_; }
+  int bytes_read() const { return bytes_read_; }
+
+ private:
+  void OnStarted(int result) {
+    ASSERT_EQ(OK, result);
+    headers_time_ = base::TimeTicks::Now();
+    ReadMore();
+  }
+
+  void ReadMore() {
+    int rv;
+    do {
+      rv = transaction_->Read(
+          buffer_, kReadSize,
+          base::Bind(&Consumer::OnRead, base::Unretained(this)));
+      if (rv > 0)
+        bytes_read_ += rv;
+    } while (rv > 0);
+    if (rv != ERR_IO_PENDING)
+      Done(rv);
+  }
+
+  void OnRead(int result) {
+    if (result <= 0) {
+      Done(result);
+      return;
+    }
+    bytes_read_ += result;
+    ReadMore();
+  }
+
+  void Done(int result) {
+    EXPECT_EQ(OK, result);
+    done_time_ = base::TimeTicks::Now();
+    transaction_.reset();
+    if (--*remaining_ == 0)
+      MessageLoop::current()->Quit();
+  }
+
+  HttpCache* cache_;
+  const HttpRequestInfo* request_;
+  int* remaining_;
+  scoped_ptr<HttpTransaction> transaction_;
+  scoped_refptr<IOBuffer> buffer_;
+  int bytes_read_;
+  base::TimeTicks start_time_;
+  base::TimeTicks headers_time_;
+  base::TimeTicks done_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(Consumer);
+};
+
+class HttpCachePerfTest : public testing::Test {
+ protected:
+  HttpCachePerfTest() : message_loop_(new MessageLoopForIO()) {}
+
+  // Starts |count| identical requests at once against an empty cache and logs
+  // the mean time to headers, the mean and worst time to the end of the body,
+  // and how many network transactions were needed.
+  void RunConcurrentRequests(int count, bool readers_follow_writer) {
+    PacedNetworkLayer* network_layer = new PacedNetworkLayer;
+    HttpCache cache(network_layer, NULL,
+                    HttpCache::DefaultBackend::InMemory(0));
+    cache.set_readers_follow_writer(readers_follow_writer);
+
+    HttpRequestInfo request;
+    request.url = GURL(kUrl);
+    request.method = "GET";
+    request.load_flags = LOAD_NORMAL;
+
+    int remaining = count;
+    ScopedVector<Consumer> consumers;
+    for (int i = 0; i < count; ++i)
+      consumers.push_back(new Consumer(&cache, &request, &remaining));
+    for (int i = 0; i < count; ++i)
+      consumers[i]->Start();
+    MessageLoop::current()->Run();
+
+    double headers_ms = 0;
+    double body_ms = 0;
+    double worst_body_ms = 0;
+    for (int i = 0; i < count; ++i) {
+      EXPECT_EQ(kBodySize, consumers[i]->bytes_read());
+      headers_ms += consumers[i]->headers_latency().InMillisecondsF();
+      double latency = consumers[i]->body_latency().InMillisecondsF();
+      body_ms += latency;
+      worst_body_ms = std::max(worst_body_ms, latency);
+    }
+
+    std::string name = base::StringPrintf(
+        "HttpCache_%d_concurrent_%s", count,
+        readers_follow_writer ? "follow_writer" : "serialized");
+    LogPerfResult((name + "_headers").c_str(), headers_ms / count, "ms");
+    LogPerfResult((name + "_body").c_str(), body_ms / count, "ms");
+    LogPerfResult((name + "_worst_body").c_str(), worst_body_ms, "ms");
+    LogPerfResult((name + "_network_transactions").c_str(),
+                  network_layer->transaction_count(), "count");
+  }
+
+  scoped_ptr<MessageLoop> message_loop_;
+};
+
+}  // namespace
+
+TEST_F(HttpCachePerfTest, ConcurrentIdenticalRequests) {
+  const int kCounts[] = { 1, 4, 16, 64 };
+  for (size_t i = 0; i < arraysize(kCounts); ++i) {
+    RunConcurrentRequests(kCounts[i], false);
+    RunConcurrentRequests(kCounts[i], true);
+  }
+}
+
+}  // namespace net
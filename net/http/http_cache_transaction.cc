@@ -118,6 +118,7 @@ HttpCache::Transaction::Transaction(HttpCache* cache)
       handling_206_(false),
       cache_pending_(false),
       done_reading_(false),
+      following_writer_(false),
       read_offset_(0),
       effective_load_flags_(0),
       write_len_(0),
@@ -199,6 +200,22 @@ bool HttpCache::Transaction::AddTruncatedFlag() {
   return true;
 }
 
+bool HttpCache::Transaction::FollowWriter(const Transaction* writer) {
+  if (partial_.get() || (mode_ != READ && mode_ != READ_WRITE))
+    return false;
+
+  // A READ_WRITE transaction would otherwise become the writer, only to find
+  // out that it may use the entry as is.  The writer's response is what is
+  // being stored, so that check can be made up front.
+  if (mode_ == READ_WRITE && !(effective_load_flags_ & LOAD_PREFERRING_CACHE) &&
+      RequiresValidation(writer->response_))
+    return false;
+
+  mode_ = READ;
+  following_writer_ = true;
+  return true;
+}
+
 LoadState HttpCache::Transaction::GetWriterLoadState() const {
   if (network_trans_.get())
     return network_trans_->GetLoadState();
@@ -366,9 +383,14 @@ void HttpCache::Transaction::StopCaching() {
   // entry how it is (it will be marked as truncated at destruction), and let
   // the next piece of code that executes know that we are now reading directly
   // from the net.
+  //
+  // Readers following this transaction need the rest of the body, so in that
+  // case we keep writing.
   if (cache_ && entry_ && (mode_ & WRITE) && network_trans_.get() &&
-      !is_sparse_ && !range_requested_)
+      !is_sparse_ && !range_requested_ && entry_->readers.empty()) {
+    entry_->streaming = false;
     mode_ = NONE;
+  }
 }
 
 void HttpCache::Transaction::DoneReading() {
@@ -1147,8 +1169,13 @@ int HttpCache::Transaction::DoTruncateCachedMetadataComplete(int result) {
 
   // If this response is a redirect, then we can stop writing now.  (We don't
   // need to cache the response body of a redirect.)
-  if (response_.headers->IsRedirect(NULL))
+  if (response_.headers->IsRedirect(NULL)) {
     DoneWritingToEntry(true);
+  } else if (entry_ && mode_ == WRITE && !partial_.get() && !truncated_ &&
+             response_.headers->response_code() == 200) {
+    // Only the body is left to write, so others may start reading it.
+    cache_->StartStreaming(entry_);
+  }
   next_state_ = STATE_PARTIAL_HEADERS_RECEIVED;
   return OK;
 }
@@ -1329,6 +1356,17 @@ int HttpCache::Transaction::DoCacheReadDataComplete(int result) {
   if (result > 0) {
     read_offset_ += result;
   } else if (result == 0) {  // End of file.
+    if (following_writer_) {
+      // We may have caught up with the writer rather than reached the end.
+      if (cache_->WaitForEntryData(entry_, this) == ERR_IO_PENDING) {
+        next_state_ = STATE_CACHE_READ_DATA;
+        return ERR_IO_PENDING;
+      }
+      if (entry_->stream_truncated &&
+          response_.headers->GetContentLength() != read_offset_) {
+        return ERR_CACHE_READ_FAILURE;
+      }
+    }
     cache_->DoneReadingFromEntry(entry_, this);
     entry_ = NULL;
   } else {
@@ -1362,11 +1400,16 @@ int HttpCache::Transaction::DoCacheWriteDataComplete(int result) {
     // We want to ignore errors writing to disk and just keep reading from
     // the network.
     result = write_len_;
-  } else if (!done_reading_ && entry_) {
-    int current_size = entry_->disk_entry->GetDataSize(kResponseContentIndex);
-    int64 body_size = response_.headers->GetContentLength();
-    if (body_size >= 0 && body_size <= current_size)
-      done_reading_ = true;
+  } else if (entry_) {
+    if (!done_reading_) {
+      int current_size =
+          entry_->disk_entry->GetDataSize(kResponseContentIndex);
+      int64 body_size = response_.headers->GetContentLength();
+      if (body_size >= 0 && body_size <= current_size)
+        done_reading_ = true;
+    }
+    if (result > 0)
+      cache_->ResumeWaitingReaders(entry_);
   }
 
   if (partial_.get()) {
@@ -1539,7 +1582,7 @@ int HttpCache::Transaction::BeginCacheValidation() {
   DCHECK(mode_ == READ_WRITE);
 
   bool skip_validation = effective_load_flags_ & LOAD_PREFERRING_CACHE ||
-                         !RequiresValidation();
+                         !RequiresValidation(response_);
 
   if (truncated_)
     skip_validation = !partial_->initial_validation();
@@ -1687,7 +1730,8 @@ int HttpCache::Transaction::RestartNetworkRequestWithAuth(
   return rv;
 }
 
-bool HttpCache::Transaction::RequiresValidation() {
+bool HttpCache::Transaction::RequiresValidation(
+    const HttpResponseInfo& response) {
   // TODO(darin): need to do more work here:
   //  - make sure we have a matching request method
   //  - watch out for cached responses that depend on authentication
@@ -1698,13 +1742,13 @@ bool HttpCache::Transaction::RequiresValidation() {
   if (effective_load_flags_ & LOAD_VALIDATE_CACHE)
     return true;
 
-  if (response_.headers->RequiresValidation(
-          response_.request_time, response_.response_time, Time::Now()))
+  if (response.headers->RequiresValidation(
+          response.request_time, response.response_time, Time::Now()))
     return true;
 
   // Since Vary header computation is fairly expensive, we save it for last.
-  if (response_.vary_data.is_valid() &&
-      !response_.vary_data.MatchesRequest(*request_, *response_.headers))
+  if (response.vary_data.is_valid() &&
+      !response.vary_data.MatchesRequest(*request_, *response.headers))
     return true;
 
   return false;
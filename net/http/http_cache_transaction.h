@@ -89,6 +89,11 @@ class HttpCache::Transaction : public HttpTransaction {
   // deleting the active entry.
   bool AddTruncatedFlag();
 
+  // Called while this transaction waits for the entry that |writer| is
+  // storing.  If this transaction can use that response without validating
+  // it, switches to reading the entry as it is written and returns true.
+  bool FollowWriter(const Transaction* writer);
+
   HttpCache::ActiveEntry* entry() { return entry_; }
 
   // Returns the LoadState of the writer transaction of a given ActiveEntry. In
@@ -267,8 +272,9 @@ class HttpCache::Transaction : public HttpTransaction {
   // Returns network error code.
   int RestartNetworkRequestWithAuth(const AuthCredentials& credentials);
 
-  // Called to determine if we need to validate the cache entry before using it.
-  bool RequiresValidation();
+  // Called to determine if we need to validate the cache entry that stores
+  // |response| before using it.
+  bool RequiresValidation(const HttpResponseInfo& response);
 
   // Called to make the request conditional (to ask the server if the cached
   // copy is valid).  Returns true if able to make the request conditional.
@@ -363,6 +369,7 @@ class HttpCache::Transaction : public HttpTransaction {
   bool handling_206_;  // We must deal with this 206 response.
   bool cache_pending_;  // We are waiting for the HttpCache.
   bool done_reading_;
+  bool following_writer_;  // We read the entry while it is being written.
   scoped_refptr<IOBuffer> read_buf_;
   int io_buf_len_;
   int read_offset_;
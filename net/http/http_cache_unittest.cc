@@ -0,0 +1,400 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_cache.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/compiler_specific.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/io_buffer.h"
+#include "net/base/load_flags.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/http/http_request_info.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_response_info.h"
+#include "net/http/http_transaction.h"
+#include "net/http/http_transaction_factory.h"
+#include "net/http/http_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const char kUrl[] = "http://www.example.com/shared.js";
+const char kBody[] = "0123456789";
+const char kFirstHalf[] = "01234";
+const char kSecondHalf[] = "56789";
+
+// A network transaction that returns a cacheable 200 response for kBody,
+// where the test decides when the headers and each part of the body arrive.
+class ManualNetworkTransaction : public HttpTransaction {
+ public:
+  ManualNetworkTransaction() : read_buf_len_(0) {}
+  virtual ~ManualNetworkTransaction() {}
+
+  virtual int Start(const HttpRequestInfo* request_info,
+                    const CompletionCallback& callback,
+                    const BoundNetLog& net_log) OVERRIDE {
+    std::string headers = base::StringPrintf(
+        "HTTP/1.1 200 OK\n"
+        "Cache-Control: max-age=3600\n"
+        "Content-Length: %d\n", static_cast<int>(strlen(kBody)));
+    response_.request_time = base::Time::Now();
+    response_.response_time = base::Time::Now();
+    response_.headers = new HttpResponseHeaders(
+        HttpUtil::AssembleRawHeaders(headers.data(), headers.size()));
+    callback_ = callback;
+    return ERR_IO_PENDING;
+  }
+
+  virtual int RestartIgnoringLastError(
+      const CompletionCallback& callback) OVERRIDE {
+    return ERR_FAILED;
+  }
+
+  virtual int RestartWithCertificate(
+      X509Certificate* client_cert,
+      const CompletionCallback& callback) OVERRIDE {
+    return ERR_FAILED;
+  }
+
+  virtual int RestartWithAuth(const AuthCredentials& credentials,
+                              const CompletionCallback& callback) OVERRIDE {
+    return ERR_FAILED;
+  }
+
+  virtual bool IsReadyToRestartForAuth() OVERRIDE { return false; }
+
+  virtual int Read(IOBuffer* buf, int buf_len,
+                   const CompletionCallback& callback) OVERRIDE {
+    read_buf_ = buf;
+    read_buf_len_ = buf_len;
+    callback_ = callback;
+    return ERR_IO_PENDING;
+  }
+
+  virtual void StopCaching() OVERRIDE {}
+  virtual void DoneReading() OVERRIDE {}
+
+  virtual const HttpResponseInfo* GetResponseInfo() const OVERRIDE {
+    return &response_;
+  }
+
+  virtual LoadState GetLoadState() const OVERRIDE {
+    return LOAD_STATE_READING_RESPONSE;
+  }
+
+  virtual uint64 GetUploadProgress() const OVERRIDE { return 0; }
+
+  // Completes Start().
+  void SendHeaders() {
+    RunCallback(OK);
+  }
+
+  // Completes the pending Read() with |data|.
+  void SendBody(const std::string& data) {
+    ASSERT_TRUE(read_buf_);
+    ASSERT_LE(static_cast<int>(data.size()), read_buf_len_);
+    memcpy(read_buf_->data(), data.data(), data.size());
+    read_buf_ = NULL;
+    RunCallback(static_cast<int>(data.size()));
+  }
+
+  // Completes the pending Read() with the end of the body.
+  void Finish() {
+    ASSERT_TRUE(read_buf_);
+    read_buf_ = NULL;
+    RunCallback(0);
+  }
+
+  // Completes the pending Read() with |error|.
+  void Fail(int error) {
+    ASSERT_TRUE(read_buf_);
+    read_buf_ = NULL;
+    RunCallback(error);
+  }
+
+ private:
+  void RunCallback(int result) {
+    ASSERT_FALSE(callback_.is_null());
+    CompletionCallback callback = callback_;
+    callback_.Reset();
+    callback.Run(result);
+  }
+
+  HttpResponseInfo response_;
+  CompletionCallback callback_;
+  scoped_refptr<IOBuffer> read_buf_;
+  int read_buf_len_;
+
+  DISALLOW_COPY_AND_ASSIGN(ManualNetworkTransaction);
+};
+
+class ManualNetworkLayer : public HttpTransactionFactory {
+ public:
+  ManualNetworkLayer() {}
+  virtual ~ManualNetworkLayer() {}
+
+  int transaction_count() const {
+    return static_cast<int>(transactions_.size());
+  }
+
+  // The most recent network transaction, which the cache owns.
+  ManualNetworkTransaction* last_transaction() const {
+    return transactions_.back();
+  }
+
+  virtual int CreateTransaction(scoped_ptr<HttpTransaction>* trans) OVERRIDE {
+    ManualNetworkTransaction* transaction = new ManualNetworkTransaction;
+    transactions_.push_back(transaction);
+    trans->reset(transaction);
+    return OK;
+  }
+
+  virtual HttpCache* GetCache() OVERRIDE { return NULL; }
+  virtual HttpNetworkSession* GetSession() OVERRIDE { return NULL; }
+
+ private:
+  std::vector<ManualNetworkTransaction*> transactions_;
+
+  DISALLOW_COPY_AND_ASSIGN(ManualNetworkLayer);
+};
+
+// Fetches kUrl through the cache and reads the body as it becomes available.
+class Consumer {
+ public:
+  explicit Consumer(HttpCache* cache)
+      : cache_(cache),
+        buffer_(new IOBuffer(1024)),
+        started_(false),
+        done_(false),
+        result_(ERR_IO_PENDING) {
+  }
+
+  void Start(const HttpRequestInfo* request) {
+    ASSERT_EQ(OK, cache_->CreateTransaction(&transaction_));
+    int rv = transaction_->Start(
+        request, base::Bind(&Consumer::OnStarted, base::Unretained(this)),
+        BoundNetLog());
+    if (rv != ERR_IO_PENDING)
+      OnStarted(rv);
+  }
+
+  // Destroys the transaction, wherever it is.
+  void Cancel() { transaction_.reset(); }
+
+  HttpTransaction* transaction() { return transaction_.get(); }
+  bool started() const { return started_; }
+  bool done() const { return done_; }
+  int result() const { return result_; }
+  const std::string& content() const { return content_; }
+
+ private:
+  void OnStarted(int result) {
+    if (result != OK) {
+      Done(result);
+      return;
+    }
+    started_ = true;
+    ReadMore();
+  }
+
+  void ReadMore() {
+    int rv;
+    do {
+      rv = transaction_->Read(
+          buffer_, 1024, base::Bind(&Consumer::OnRead, base::Unretained(this)));
+      if (rv > 0)
+        content_.append(buffer_->data(), rv);
+    } while (rv > 0);
+    if (rv != ERR_IO_PENDING)
+      Done(rv);
+  }
+
+  void OnRead(int result) {
+    if (result <= 0) {
+      Done(result);
+      return;
+    }
+    content_.append(buffer_->data(), result);
+    ReadMore();
+  }
+
+  void Done(int result) {
+    done_ = true;
+    result_ = result;
+  }
+
+  HttpCache* cache_;
+  scoped_ptr<HttpTransaction> transaction_;
+  scoped_refptr<IOBuffer> buffer_;
+  bool started_;
+  bool done_;
+  int result_;
+  std::string content_;
+
+  DISALLOW_COPY_AND_ASSIGN(Consumer);
+};
+
+}  // namespace
+
+// Tests HttpCache with set_readers_follow_writer(true), where requests for an
+// entry that is being written read the body as it is stored.
+class HttpCacheFollowWriterTest : public testing::Test {
+ protected:
+  HttpCacheFollowWriterTest()
+      : network_(new ManualNetworkLayer),
+        cache_(network_, NULL, HttpCache::DefaultBackend::InMemory(0)) {
+    cache_.set_readers_follow_writer(true);
+    request_.url = GURL(kUrl);
+    request_.method = "GET";
+    request_.load_flags = LOAD_NORMAL;
+  }
+
+  void RunAllPending() { MessageLoop::current()->RunAllPending(); }
+
+  // The network transaction of the writer.
+  ManualNetworkTransaction* network() { return network_->last_transaction(); }
+
+  MessageLoop message_loop_;
+  ManualNetworkLayer* network_;  // Owned by |cache_|.
+  HttpCache cache_;
+  HttpRequestInfo request_;
+};
+
+TEST_F(HttpCacheFollowWriterTest, FollowersReadBodyAsItIsWritten) {
+  Consumer writer(&cache_);
+  Consumer follower1(&cache_);
+  Consumer follower2(&cache_);
+  writer.Start(&request_);
+  follower1.Start(&request_);
+  follower2.Start(&request_);
+  RunAllPending();
+  ASSERT_EQ(1, network_->transaction_count());
+  EXPECT_FALSE(follower1.started());
+
+  // The followers get the headers as soon as the writer has stored them.
+  network()->SendHeaders();
+  RunAllPending();
+  EXPECT_TRUE(writer.started());
+  EXPECT_TRUE(follower1.started());
+  EXPECT_TRUE(follower2.started());
+
+  network()->SendBody(kFirstHalf);
+  RunAllPending();
+  EXPECT_EQ(kFirstHalf, writer.content());
+  EXPECT_EQ(kFirstHalf, follower1.content());
+  EXPECT_EQ(kFirstHalf, follower2.content());
+  EXPECT_FALSE(follower1.done());
+
+  network()->SendBody(kSecondHalf);
+  network()->Finish();
+  RunAllPending();
+  EXPECT_TRUE(writer.done());
+  EXPECT_TRUE(follower1.done());
+  EXPECT_TRUE(follower2.done());
+  EXPECT_EQ(OK, writer.result());
+  EXPECT_EQ(OK, follower1.result());
+  EXPECT_EQ(OK, follower2.result());
+  EXPECT_EQ(kBody, writer.content());
+  EXPECT_EQ(kBody, follower1.content());
+  EXPECT_EQ(kBody, follower2.content());
+  EXPECT_EQ(1, network_->transaction_count());
+}
+
+// Tests that followers that didn't get the whole body fail when the writer
+// does.
+TEST_F(HttpCacheFollowWriterTest, WriterFailureFailsFollowers) {
+  Consumer writer(&cache_);
+  Consumer follower(&cache_);
+  writer.Start(&request_);
+  follower.Start(&request_);
+  RunAllPending();
+  network()->SendHeaders();
+  RunAllPending();
+  network()->SendBody(kFirstHalf);
+  RunAllPending();
+  EXPECT_EQ(kFirstHalf, follower.content());
+
+  network()->Fail(ERR_CONNECTION_RESET);
+  RunAllPending();
+  EXPECT_TRUE(writer.done());
+  EXPECT_EQ(ERR_CONNECTION_RESET, writer.result());
+  EXPECT_FALSE(follower.done());
+
+  // The entry is released when the writer goes away.
+  writer.Cancel();
+  RunAllPending();
+  EXPECT_TRUE(follower.done());
+  EXPECT_EQ(ERR_CACHE_READ_FAILURE, follower.result());
+  EXPECT_EQ(kFirstHalf, follower.content());
+}
+
+// Tests that the writer keeps storing the body after StopCaching() while
+// followers need it.
+TEST_F(HttpCacheFollowWriterTest, StopCachingWithFollowers) {
+  Consumer writer(&cache_);
+  Consumer follower(&cache_);
+  writer.Start(&request_);
+  follower.Start(&request_);
+  RunAllPending();
+  network()->SendHeaders();
+  RunAllPending();
+  ASSERT_TRUE(follower.started());
+
+  writer.transaction()->StopCaching();
+  network()->SendBody(kFirstHalf);
+  RunAllPending();
+  EXPECT_EQ(kFirstHalf, follower.content());
+
+  network()->SendBody(kSecondHalf);
+  network()->Finish();
+  RunAllPending();
+  EXPECT_EQ(OK, writer.result());
+  EXPECT_EQ(OK, follower.result());
+  EXPECT_EQ(kBody, writer.content());
+  EXPECT_EQ(kBody, follower.content());
+}
+
+// Tests that a follower waiting for more of the body can be cancelled
+// without disturbing the writer or the other followers.
+TEST_F(HttpCacheFollowWriterTest, CancelWaitingFollower) {
+  Consumer writer(&cache_);
+  Consumer cancelled(&cache_);
+  Consumer follower(&cache_);
+  writer.Start(&request_);
+  cancelled.Start(&request_);
+  follower.Start(&request_);
+  RunAllPending();
+  network()->SendHeaders();
+  RunAllPending();
+  network()->SendBody(kFirstHalf);
+  RunAllPending();
+  EXPECT_EQ(kFirstHalf, cancelled.content());
+  EXPECT_FALSE(cancelled.done());
+
+  cancelled.Cancel();
+  network()->SendBody(kSecondHalf);
+  RunAllPending();
+  network()->Finish();
+  RunAllPending();
+  EXPECT_EQ(OK, writer.result());
+  EXPECT_EQ(OK, follower.result());
+  EXPECT_EQ(kBody, writer.content());
+  EXPECT_EQ(kBody, follower.content());
+  EXPECT_EQ(1, network_->transaction_count());
+}
+
+}  // namespace net
@@ -0,0 +1,16 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_pipelined_connection.h"
+
+namespace net {
+
+HttpPipelinedConnection::Stats::Stats()
+    : num_responses(0),
+      response_size(0),
+      bytes_per_second(0),
+      head_of_line_blocked(false) {
+}
+
+}  // namespace net
@@ -6,6 +6,8 @@
 #define NET_HTTP_HTTP_PIPELINED_CONNECTION_H_
 #pragma once
 
+#include "base/basictypes.h"
+#include "base/time.h"
 #include "net/base/net_export.h"
 #include "net/base/net_log.h"
 #include "net/socket/ssl_client_socket.h"
@@ -29,6 +31,31 @@ class NET_EXPORT_PRIVATE HttpPipelinedConnection {
     AUTHENTICATION_REQUIRED,
   };
 
+  // Measurements of a pipeline's recent responses. HttpPipelinedHost uses
+  // these to pick the pipeline for a new request and to size the pipeline.
+  struct NET_EXPORT_PRIVATE Stats {
+    Stats();
+
+    // Number of complete responses the smoothed values are based on.
+    int num_responses;
+
+    // Smoothed time between a request reaching the head of the pipeline and
+    // its response headers arriving. Zero until the first response.
+    base::TimeDelta rtt;
+
+    // Smoothed size of response bodies, in bytes.
+    int64 response_size;
+
+    // Smoothed rate at which response bodies were read, in bytes per second.
+    // Zero until a response large enough to measure has been read.
+    int64 bytes_per_second;
+
+    // True if the response at the head of the pipeline is large, or is taking
+    // much longer than |rtt| to start, so that a request added behind it would
+    // wait on it.
+    bool head_of_line_blocked;
+  };
+
   class Delegate {
    public:
     // Called when a pipeline has newly available capacity. This may be because
@@ -73,6 +100,9 @@ class NET_EXPORT_PRIVATE HttpPipelinedConnection {
   // requests.
   virtual bool active() const = 0;
 
+  // Measurements of this pipeline's responses.
+  virtual const Stats& stats() const = 0;
+
   // The SSLConfig used to establish this connection.
   virtual const SSLConfig& used_ssl_config() const = 0;
 
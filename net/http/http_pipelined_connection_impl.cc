@@ -4,6 +4,8 @@
 
 #include "net/http/http_pipelined_connection_impl.h"
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/message_loop.h"
@@ -25,6 +27,30 @@ namespace net {
 
 namespace {
 
+// A response body at least this large holds up the requests behind it for
+// long enough that new requests are better off elsewhere.
+const int64 kLargeResponseSize = 256 * 1024;
+
+// Bodies smaller than this arrive too quickly to measure the read rate.
+const int64 kMinRateSampleSize = 16 * 1024;
+
+// A response whose headers haven't arrived this many RTTs after it reached the
+// head of the pipeline is treated as slow, though never sooner than
+// kMinSlowResponseMs. Before an RTT has been measured, kInitialSlowResponseMs
+// is used.
+const int kSlowResponseRttMultiple = 4;
+const int kMinSlowResponseMs = 100;
+const int kInitialSlowResponseMs = 1000;
+
+// Each new sample moves a smoothed value 1/kSmoothingDivisor of the way.
+const int kSmoothingDivisor = 4;
+
+int64 Smooth(int64 average, int64 sample, int num_samples) {
+  if (!num_samples)
+    return sample;
+  return average + (sample - average) / kSmoothingDivisor;
+}
+
 class ReceivedHeadersParameters : public NetLog::EventParameters {
  public:
   ReceivedHeadersParameters(const NetLog::Source& source,
@@ -285,6 +311,8 @@ int HttpPipelinedConnectionImpl::DoSendComplete(int result) {
 
   request_order_.push(active_send_request_->pipeline_id);
   stream_info_map_[active_send_request_->pipeline_id].state = STREAM_SENT;
+  stream_info_map_[active_send_request_->pipeline_id].send_time =
+      base::TimeTicks::Now();
   net_log_.AddEvent(
       NetLog::TYPE_HTTP_PIPELINED_CONNECTION_SENT_REQUEST,
       make_scoped_refptr(new NetLogSourceParameter(
@@ -459,6 +487,7 @@ int HttpPipelinedConnectionImpl::DoReadHeaders(int result) {
   CHECK(ContainsKey(stream_info_map_, active_read_id_));
   CHECK_EQ(STREAM_READ_PENDING, stream_info_map_[active_read_id_].state);
   stream_info_map_[active_read_id_].state = STREAM_ACTIVE;
+  StartTimingHeadResponse();
   int rv = stream_info_map_[active_read_id_].parser->ReadResponseHeaders(
       base::Bind(&HttpPipelinedConnectionImpl::OnReadIOCallback,
                  base::Unretained(this)));
@@ -482,6 +511,8 @@ int HttpPipelinedConnectionImpl::DoReadHeadersComplete(int result) {
       result = ERR_PIPELINE_EVICTION;
     }
     usable_ = false;
+  } else {
+    OnHeadResponseHeadersReceived();
   }
 
   CheckHeadersForPipelineCompatibility(active_read_id_, result);
@@ -495,6 +526,90 @@ int HttpPipelinedConnectionImpl::DoReadHeadersComplete(int result) {
   return result;
 }
 
+void HttpPipelinedConnectionImpl::StartTimingHeadResponse() {
+  StreamInfo& info = stream_info_map_[active_read_id_];
+  base::TimeTicks now = base::TimeTicks::Now();
+  // A request sent while an earlier response was being read has only been
+  // waiting on the server since that response finished.
+  info.head_time = std::max(info.send_time, last_response_end_time_);
+
+  base::TimeDelta slow_response_time;
+  if (stats_.rtt > base::TimeDelta()) {
+    slow_response_time = std::max(
+        stats_.rtt * kSlowResponseRttMultiple,
+        base::TimeDelta::FromMilliseconds(kMinSlowResponseMs));
+  } else {
+    slow_response_time =
+        base::TimeDelta::FromMilliseconds(kInitialSlowResponseMs);
+  }
+  base::TimeDelta delay = info.head_time + slow_response_time - now;
+  if (delay <= base::TimeDelta()) {
+    stats_.head_of_line_blocked = true;
+    return;
+  }
+  slow_response_timer_.Start(
+      FROM_HERE, delay, this,
+      &HttpPipelinedConnectionImpl::OnHeadResponseSlow);
+}
+
+void HttpPipelinedConnectionImpl::OnHeadResponseHeadersReceived() {
+  slow_response_timer_.Stop();
+  StreamInfo& info = stream_info_map_[active_read_id_];
+  info.headers_time = base::TimeTicks::Now();
+
+  // Only requests that had nothing ahead of them when they were sent measure
+  // the round trip. For the others, the headers were likely buffered already.
+  if (info.send_time >= last_response_end_time_) {
+    stats_.rtt = base::TimeDelta::FromInternalValue(Smooth(
+        stats_.rtt.ToInternalValue(),
+        (info.headers_time - info.head_time).ToInternalValue(),
+        stats_.rtt.ToInternalValue() ? 1 : 0));
+  }
+  bool was_blocked = stats_.head_of_line_blocked;
+  stats_.head_of_line_blocked =
+      info.parser->response_body_length() >= kLargeResponseSize;
+  if (was_blocked && !stats_.head_of_line_blocked) {
+    // The late response turned out to be small, so requests can be added
+    // again. The delegate may add them to this pipeline, so it is told in a
+    // new task.
+    MessageLoop::current()->PostTask(
+        FROM_HERE,
+        base::Bind(&HttpPipelinedConnectionImpl::OnHeadOfLineUnblocked,
+                   weak_factory_.GetWeakPtr()));
+  }
+}
+
+void HttpPipelinedConnectionImpl::OnHeadResponseComplete() {
+  slow_response_timer_.Stop();
+  stats_.head_of_line_blocked = false;
+  StreamInfo& info = stream_info_map_[active_read_id_];
+  if (info.headers_time.is_null() || !info.parser->IsResponseBodyComplete())
+    return;
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  last_response_end_time_ = now;
+  int64 size = info.parser->response_body_read();
+  base::TimeDelta read_time = now - info.headers_time;
+  if (size >= kMinRateSampleSize && read_time > base::TimeDelta()) {
+    int64 rate = size * base::Time::kMicrosecondsPerSecond /
+        read_time.InMicroseconds();
+    stats_.bytes_per_second = Smooth(stats_.bytes_per_second, rate,
+                                     stats_.bytes_per_second ? 1 : 0);
+  }
+  stats_.response_size = Smooth(stats_.response_size, size,
+                                stats_.num_responses);
+  ++stats_.num_responses;
+}
+
+void HttpPipelinedConnectionImpl::OnHeadResponseSlow() {
+  stats_.head_of_line_blocked = true;
+}
+
+void HttpPipelinedConnectionImpl::OnHeadOfLineUnblocked() {
+  if (!stats_.head_of_line_blocked)
+    delegate_->OnPipelineHasCapacity(this);
+}
+
 int HttpPipelinedConnectionImpl::DoReadWaitForClose(int result) {
   read_next_state_ = READ_STATE_WAITING_FOR_CLOSE;
   return result;
@@ -573,6 +688,7 @@ void HttpPipelinedConnectionImpl::Close(int pipeline_id,
       break;
 
     case STREAM_ACTIVE:
+      OnHeadResponseComplete();
       stream_info_map_[pipeline_id].state = STREAM_CLOSED;
       if (not_reusable) {
         usable_ = false;
@@ -793,6 +909,11 @@ bool HttpPipelinedConnectionImpl::active() const {
   return active_;
 }
 
+const HttpPipelinedConnection::Stats&
+HttpPipelinedConnectionImpl::stats() const {
+  return stats_;
+}
+
 const SSLConfig& HttpPipelinedConnectionImpl::used_ssl_config() const {
   return used_ssl_config_;
 }
@@ -14,6 +14,8 @@
 #include "base/location.h"
 #include "base/memory/linked_ptr.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time.h"
+#include "base/timer.h"
 #include "net/base/completion_callback.h"
 #include "net/base/net_export.h"
 #include "net/base/net_log.h"
@@ -65,6 +67,7 @@ class NET_EXPORT_PRIVATE HttpPipelinedConnectionImpl
   virtual int depth() const OVERRIDE;
   virtual bool usable() const OVERRIDE;
   virtual bool active() const OVERRIDE;
+  virtual const Stats& stats() const OVERRIDE;
 
   // Used by HttpStreamFactoryImpl.
   virtual const SSLConfig& used_ssl_config() const OVERRIDE;
@@ -178,6 +181,11 @@ class NET_EXPORT_PRIVATE HttpPipelinedConnectionImpl
     CompletionCallback pending_user_callback;
     StreamState state;
     NetLog::Source source;
+    // When the request finished sending, when its response reached the head
+    // of the pipeline and when its headers arrived.
+    base::TimeTicks send_time;
+    base::TimeTicks head_time;
+    base::TimeTicks headers_time;
   };
 
   typedef std::map<int, StreamInfo> StreamInfoMap;
@@ -248,6 +256,22 @@ class NET_EXPORT_PRIVATE HttpPipelinedConnectionImpl
   // Otherwise, it is called in response to OnReadIOCallback().
   int DoReadHeadersComplete(int result);
 
+  // Starts timing the active response, now at the head of the pipeline.
+  void StartTimingHeadResponse();
+
+  // Updates |stats_| when the active response's headers arrive, and again
+  // when the response completes.
+  void OnHeadResponseHeadersReceived();
+  void OnHeadResponseComplete();
+
+  // Called by |slow_response_timer_| when the active response is late enough
+  // to block the requests behind it.
+  void OnHeadResponseSlow();
+
+  // Tells |delegate_| that the pipeline can take requests again, if it is
+  // still not blocked.
+  void OnHeadOfLineUnblocked();
+
   // Halts the read loop until Close() is called by the active stream.
   int DoReadWaitForClose(int result);
 
@@ -295,6 +319,9 @@ class NET_EXPORT_PRIVATE HttpPipelinedConnectionImpl
   bool active_;
   bool usable_;
   bool completed_one_request_;
+  Stats stats_;
+  base::TimeTicks last_response_end_time_;
+  base::OneShotTimer<HttpPipelinedConnectionImpl> slow_response_timer_;
   base::WeakPtrFactory<HttpPipelinedConnectionImpl> weak_factory_;
 
   StreamInfoMap stream_info_map_;
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "net/base/net_export.h"
+#include "net/base/request_priority.h"
 #include "net/http/http_pipelined_connection.h"
 #include "net/http/http_pipelined_host_capability.h"
 
@@ -58,22 +59,25 @@ class NET_EXPORT_PRIVATE HttpPipelinedHost {
   virtual ~HttpPipelinedHost() {}
 
   // Constructs a new pipeline on |connection| and returns a new
-  // HttpPipelinedStream that uses it.
+  // HttpPipelinedStream that uses it, for a request of |priority|.
   virtual HttpPipelinedStream* CreateStreamOnNewPipeline(
       ClientSocketHandle* connection,
       const SSLConfig& used_ssl_config,
       const ProxyInfo& used_proxy_info,
       const BoundNetLog& net_log,
       bool was_npn_negotiated,
-      SSLClientSocket::NextProto protocol_negotiated) = 0;
-
-  // Tries to find an existing pipeline with capacity for a new request. If
-  // successful, returns a new stream on that pipeline. Otherwise, returns NULL.
-  virtual HttpPipelinedStream* CreateStreamOnExistingPipeline() = 0;
-
-  // Returns true if we have a pipelined connection that can accept new
-  // requests.
-  virtual bool IsExistingPipelineAvailable() const = 0;
+      SSLClientSocket::NextProto protocol_negotiated,
+      RequestPriority priority) = 0;
+
+  // Tries to find an existing pipeline that can take a new request of
+  // |priority|. If successful, returns a new stream on that pipeline.
+  // Otherwise, returns NULL.
+  virtual HttpPipelinedStream* CreateStreamOnExistingPipeline(
+      RequestPriority priority) = 0;
+
+  // Returns true if we have a pipelined connection that can accept a new
+  // request of |priority|. If not, the request will use a new connection.
+  virtual bool IsExistingPipelineAvailable(RequestPriority priority) const = 0;
 
   // Returns the host and port associated with this class.
   virtual const HostPortPair& origin() const = 0;
@@ -4,7 +4,11 @@
 
 #include "net/http/http_pipelined_host_impl.h"
 
+#include <algorithm>
+
+#include "base/metrics/histogram.h"
 #include "base/stl_util.h"
+#include "base/time.h"
 #include "base/values.h"
 #include "net/http/http_pipelined_connection_impl.h"
 #include "net/http/http_pipelined_stream.h"
@@ -19,6 +23,17 @@ namespace net {
 // costing too much performance. Until then, this is just a bad guess.
 static const int kNumKnownSuccessesThreshold = 3;
 
+// The depth of a capable pipeline that hasn't measured its responses yet, and
+// the bounds of the depth once it has.
+static const int kDefaultPipelineDepth = 3;
+static const int kMinPipelineDepth = 2;
+static const int kMaxPipelineDepth = 6;
+
+// Requests of at least this priority are not queued behind more than
+// kMaxRequestsAheadOfHighPriority other requests.
+static const RequestPriority kHighPriority = MEDIUM;
+static const int kMaxRequestsAheadOfHighPriority = 1;
+
 class HttpPipelinedConnectionImplFactory :
     public HttpPipelinedConnection::Factory {
  public:
@@ -62,10 +77,18 @@ HttpPipelinedStream* HttpPipelinedHostImpl::CreateStreamOnNewPipeline(
     const ProxyInfo& used_proxy_info,
     const BoundNetLog& net_log,
     bool was_npn_negotiated,
-    SSLClientSocket::NextProto protocol_negotiated) {
+    SSLClientSocket::NextProto protocol_negotiated,
+    RequestPriority priority) {
   if (capability_ == PIPELINE_INCAPABLE) {
     return NULL;
   }
+  // The request fell back to a new connection. The existing pipelines are
+  // asked again why, since they may have changed while it connected. If one
+  // has room by now, the reason is gone and nothing is recorded.
+  SchedulingDecision decision;
+  if (!ChoosePipeline(priority, &decision)) {
+    RecordSchedulingDecision(decision);
+  }
   HttpPipelinedConnection* pipeline = factory_->CreateNewPipeline(
       connection, this, origin_, used_ssl_config, used_proxy_info, net_log,
       was_npn_negotiated, protocol_negotiated);
@@ -74,30 +97,21 @@ HttpPipelinedStream* HttpPipelinedHostImpl::CreateStreamOnNewPipeline(
   return pipeline->CreateNewStream();
 }
 
-HttpPipelinedStream* HttpPipelinedHostImpl::CreateStreamOnExistingPipeline() {
-  HttpPipelinedConnection* available_pipeline = NULL;
-  for (PipelineInfoMap::iterator it = pipelines_.begin();
-       it != pipelines_.end(); ++it) {
-    if (CanPipelineAcceptRequests(it->first) &&
-        (!available_pipeline ||
-         it->first->depth() < available_pipeline->depth())) {
-      available_pipeline = it->first;
-    }
-  }
-  if (!available_pipeline) {
+HttpPipelinedStream* HttpPipelinedHostImpl::CreateStreamOnExistingPipeline(
+    RequestPriority priority) {
+  SchedulingDecision decision;
+  HttpPipelinedConnection* pipeline = ChoosePipeline(priority, &decision);
+  if (!pipeline) {
     return NULL;
   }
-  return available_pipeline->CreateNewStream();
+  RecordSchedulingDecision(decision);
+  return pipeline->CreateNewStream();
 }
 
-bool HttpPipelinedHostImpl::IsExistingPipelineAvailable() const {
-  for (PipelineInfoMap::const_iterator it = pipelines_.begin();
-       it != pipelines_.end(); ++it) {
-    if (CanPipelineAcceptRequests(it->first)) {
-      return true;
-    }
-  }
-  return false;
+bool HttpPipelinedHostImpl::IsExistingPipelineAvailable(
+    RequestPriority priority) const {
+  SchedulingDecision decision;
+  return ChoosePipeline(priority, &decision) != NULL;
 }
 
 const HostPortPair& HttpPipelinedHostImpl::origin() const {
@@ -168,13 +182,28 @@ void HttpPipelinedHostImpl::OnPipelineFeedback(
   }
 }
 
-int HttpPipelinedHostImpl::GetPipelineCapacity() const {
+int HttpPipelinedHostImpl::GetPipelineCapacity(
+    const HttpPipelinedConnection* pipeline) const {
   int capacity = 0;
   switch (capability_) {
     case PIPELINE_CAPABLE:
-    case PIPELINE_PROBABLY_CAPABLE:
-      capacity = max_pipeline_depth();
+    case PIPELINE_PROBABLY_CAPABLE: {
+      // Keep about a round trip's worth of responses in flight. Deeper
+      // pipelines don't fetch any faster, and they put more requests behind
+      // each response.
+      const HttpPipelinedConnection::Stats& stats = pipeline->stats();
+      if (stats.rtt == base::TimeDelta() || stats.bytes_per_second <= 0 ||
+          stats.response_size <= 0) {
+        capacity = kDefaultPipelineDepth;
+        break;
+      }
+      int64 bytes_per_rtt = stats.bytes_per_second *
+          stats.rtt.InMicroseconds() / base::Time::kMicrosecondsPerSecond;
+      int64 depth = 1 + bytes_per_rtt / stats.response_size;
+      capacity = static_cast<int>(std::max<int64>(
+          kMinPipelineDepth, std::min<int64>(depth, kMaxPipelineDepth)));
       break;
+    }
 
     case PIPELINE_INCAPABLE:
       CHECK(false);
@@ -189,12 +218,77 @@ int HttpPipelinedHostImpl::GetPipelineCapacity() const {
   return capacity;
 }
 
+int64 HttpPipelinedHostImpl::GetExpectedWait(
+    const HttpPipelinedConnection* pipeline) const {
+  const HttpPipelinedConnection::Stats& stats = pipeline->stats();
+  int64 per_request = stats.rtt.InMicroseconds();
+  if (stats.bytes_per_second > 0) {
+    per_request += stats.response_size * base::Time::kMicrosecondsPerSecond /
+        stats.bytes_per_second;
+  }
+  return pipeline->depth() * per_request;
+}
+
+HttpPipelinedHostImpl::SchedulingDecision
+HttpPipelinedHostImpl::EvaluatePipeline(HttpPipelinedConnection* pipeline,
+                                        RequestPriority priority) const {
+  if (capability_ == PIPELINE_INCAPABLE ||
+      !pipeline->usable() ||
+      !pipeline->active()) {
+    return FALLBACK_NO_USABLE_PIPELINE;
+  }
+  if (pipeline->depth() >= GetPipelineCapacity(pipeline)) {
+    return FALLBACK_PIPELINES_FULL;
+  }
+  if (pipeline->stats().head_of_line_blocked) {
+    return FALLBACK_HEAD_OF_LINE_BLOCKED;
+  }
+  if (priority <= kHighPriority &&
+      pipeline->depth() > kMaxRequestsAheadOfHighPriority) {
+    return FALLBACK_HIGH_PRIORITY;
+  }
+  return SCHEDULED_ON_EXISTING_PIPELINE;
+}
+
+HttpPipelinedConnection* HttpPipelinedHostImpl::ChoosePipeline(
+    RequestPriority priority,
+    SchedulingDecision* decision) const {
+  HttpPipelinedConnection* best_pipeline = NULL;
+  int64 best_wait = 0;
+  *decision = FALLBACK_NO_USABLE_PIPELINE;
+  for (PipelineInfoMap::const_iterator it = pipelines_.begin();
+       it != pipelines_.end(); ++it) {
+    HttpPipelinedConnection* pipeline = it->first;
+    SchedulingDecision pipeline_decision = EvaluatePipeline(pipeline, priority);
+    if (pipeline_decision != SCHEDULED_ON_EXISTING_PIPELINE) {
+      if (!best_pipeline) {
+        *decision = std::max(*decision, pipeline_decision);
+      }
+      continue;
+    }
+    int64 wait = GetExpectedWait(pipeline);
+    if (!best_pipeline || wait < best_wait ||
+        (wait == best_wait && pipeline->depth() < best_pipeline->depth())) {
+      best_pipeline = pipeline;
+      best_wait = wait;
+      *decision = SCHEDULED_ON_EXISTING_PIPELINE;
+    }
+  }
+  return best_pipeline;
+}
+
+void HttpPipelinedHostImpl::RecordSchedulingDecision(
+    SchedulingDecision decision) const {
+  // Requests to hosts that have no pipelines yet have nothing to choose from.
+  if (decision != FALLBACK_NO_USABLE_PIPELINE) {
+    UMA_HISTOGRAM_ENUMERATION("Net.Pipelining.SchedulingDecision", decision,
+                              NUM_SCHEDULING_DECISIONS);
+  }
+}
+
 bool HttpPipelinedHostImpl::CanPipelineAcceptRequests(
     HttpPipelinedConnection* pipeline) const {
-  return capability_ != PIPELINE_INCAPABLE &&
-      pipeline->usable() &&
-      pipeline->active() &&
-      pipeline->depth() < GetPipelineCapacity();
+  return EvaluatePipeline(pipeline, IDLE) == SCHEDULED_ON_EXISTING_PIPELINE;
 }
 
 void HttpPipelinedHostImpl::NotifyAllPipelinesHaveCapacity() {
@@ -216,9 +310,16 @@ Value* HttpPipelinedHostImpl::PipelineInfoToValue() const {
     DictionaryValue* pipeline_dict = new DictionaryValue;
     pipeline_dict->SetString("host", origin_.ToString());
     pipeline_dict->SetInteger("depth", it->first->depth());
-    pipeline_dict->SetInteger("capacity", GetPipelineCapacity());
+    pipeline_dict->SetInteger("capacity", GetPipelineCapacity(it->first));
     pipeline_dict->SetBoolean("usable", it->first->usable());
     pipeline_dict->SetBoolean("active", it->first->active());
+    const HttpPipelinedConnection::Stats& stats = it->first->stats();
+    pipeline_dict->SetInteger("rtt_ms",
+                              static_cast<int>(stats.rtt.InMilliseconds()));
+    pipeline_dict->SetInteger("response_size",
+                              static_cast<int>(stats.response_size));
+    pipeline_dict->SetBoolean("head_of_line_blocked",
+                              stats.head_of_line_blocked);
     pipeline_dict->SetInteger("source_id", it->first->net_log().source().id);
     list_value->Append(pipeline_dict);
   }
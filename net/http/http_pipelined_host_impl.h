@@ -31,7 +31,11 @@ struct SSLConfig;
 
 // Manages all of the pipelining state for specific host with active pipelined
 // HTTP requests. Manages connection jobs, constructs pipelined streams, and
-// assigns requests to the least loaded pipelined connection.
+// assigns each request to the pipeline expected to answer it soonest, based
+// on the RTT and response sizes each pipeline has measured. Pipelines stuck
+// behind a large or slow response and, for high priority requests, pipelines
+// with requests already queued are passed over, so that the request falls
+// back to a new connection.
 class NET_EXPORT_PRIVATE HttpPipelinedHostImpl
     : public HttpPipelinedHost,
       public HttpPipelinedConnection::Delegate {
@@ -49,11 +53,14 @@ class NET_EXPORT_PRIVATE HttpPipelinedHostImpl
       const ProxyInfo& used_proxy_info,
       const BoundNetLog& net_log,
       bool was_npn_negotiated,
-      SSLClientSocket::NextProto protocol_negotiated) OVERRIDE;
+      SSLClientSocket::NextProto protocol_negotiated,
+      RequestPriority priority) OVERRIDE;
 
-  virtual HttpPipelinedStream* CreateStreamOnExistingPipeline() OVERRIDE;
+  virtual HttpPipelinedStream* CreateStreamOnExistingPipeline(
+      RequestPriority priority) OVERRIDE;
 
-  virtual bool IsExistingPipelineAvailable() const OVERRIDE;
+  virtual bool IsExistingPipelineAvailable(
+      RequestPriority priority) const OVERRIDE;
 
   // HttpPipelinedConnection::Delegate interface
 
@@ -72,11 +79,28 @@ class NET_EXPORT_PRIVATE HttpPipelinedHostImpl
   // ownership of the returned Value.
   virtual base::Value* PipelineInfoToValue() const OVERRIDE;
 
-  // Returns the maximum number of in-flight pipelined requests we'll allow on a
-  // single connection.
-  static int max_pipeline_depth() { return 3; }
-
  private:
+  friend class HttpPipelinedHostImplTest;
+
+  // The outcome of looking for a pipeline for a request. Ordered so that a
+  // later reason is a nearer miss than an earlier one. These values are
+  // recorded in UMA, so only append new ones.
+  enum SchedulingDecision {
+    // The request can be added to an existing pipeline.
+    SCHEDULED_ON_EXISTING_PIPELINE,
+    // No pipeline is usable and active yet.
+    FALLBACK_NO_USABLE_PIPELINE,
+    // Every usable pipeline is at capacity.
+    FALLBACK_PIPELINES_FULL,
+    // The pipelines with capacity are blocked behind a large or slow
+    // response.
+    FALLBACK_HEAD_OF_LINE_BLOCKED,
+    // The pipelines with capacity have too many requests queued for a high
+    // priority request to wait behind.
+    FALLBACK_HIGH_PRIORITY,
+    NUM_SCHEDULING_DECISIONS,
+  };
+
   struct PipelineInfo {
     PipelineInfo();
 
@@ -91,13 +115,31 @@ class NET_EXPORT_PRIVATE HttpPipelinedHostImpl
   // Adds the next pending request to the pipeline if it's still usuable.
   void AddRequestToPipeline(HttpPipelinedConnection* pipeline);
 
-  // Returns the current pipeline capacity based on |capability_|. This should
+  // Returns the capacity of |pipeline| based on |capability_| and, once
+  // pipelining is known to work, on what |pipeline| has measured. This should
   // not be called if |capability_| is INCAPABLE.
-  int GetPipelineCapacity() const;
+  int GetPipelineCapacity(const HttpPipelinedConnection* pipeline) const;
+
+  // Returns the number of microseconds a request added to |pipeline| is
+  // expected to wait for the requests ahead of it.
+  int64 GetExpectedWait(const HttpPipelinedConnection* pipeline) const;
+
+  // Returns whether |pipeline| can take a new request of |priority|, or why
+  // not.
+  SchedulingDecision EvaluatePipeline(HttpPipelinedConnection* pipeline,
+                                      RequestPriority priority) const;
+
+  // Returns the pipeline that should take a new request of |priority|, or NULL
+  // if none should. Sets |decision| to the reason.
+  HttpPipelinedConnection* ChoosePipeline(RequestPriority priority,
+                                          SchedulingDecision* decision) const;
+
+  // Records in UMA how a request was scheduled, once its stream is created.
+  void RecordSchedulingDecision(SchedulingDecision decision) const;
 
-  // Returns true if |pipeline| can handle a new request. This is true if the
-  // |pipeline| is active, usable, has capacity, and |capability_| is
-  // sufficient.
+  // Returns true if |pipeline| can handle a new request of any priority. This
+  // is true if the |pipeline| is active, usable, has capacity, isn't blocked,
+  // and |capability_| is sufficient.
   bool CanPipelineAcceptRequests(HttpPipelinedConnection* pipeline) const;
 
   // Called when |this| moves from UNKNOWN |capability_| to PROBABLY_CAPABLE.
@@ -0,0 +1,273 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_pipelined_host_impl.h"
+
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/metrics/histogram.h"
+#include "base/time.h"
+#include "net/base/net_log.h"
+#include "net/base/ssl_config_service.h"
+#include "net/http/http_pipelined_stream.h"
+#include "net/proxy/proxy_info.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// A pipeline whose depth, state and measurements are set by the test.
+class FakePipeline : public HttpPipelinedConnection {
+ public:
+  FakePipeline()
+      : depth_(0),
+        usable_(true),
+        active_(true),
+        num_streams_created_(0) {
+  }
+
+  virtual HttpPipelinedStream* CreateNewStream() OVERRIDE {
+    ++depth_;
+    ++num_streams_created_;
+    return NULL;
+  }
+  virtual int depth() const OVERRIDE { return depth_; }
+  virtual bool usable() const OVERRIDE { return usable_; }
+  virtual bool active() const OVERRIDE { return active_; }
+  virtual const Stats& stats() const OVERRIDE { return stats_; }
+  virtual const SSLConfig& used_ssl_config() const OVERRIDE {
+    return ssl_config_;
+  }
+  virtual const ProxyInfo& used_proxy_info() const OVERRIDE {
+    return proxy_info_;
+  }
+  virtual const BoundNetLog& net_log() const OVERRIDE { return net_log_; }
+  virtual bool was_npn_negotiated() const OVERRIDE { return false; }
+  virtual SSLClientSocket::NextProto protocol_negotiated() const OVERRIDE {
+    return SSLClientSocket::kProtoUnknown;
+  }
+
+  void set_depth(int depth) { depth_ = depth; }
+  Stats* mutable_stats() { return &stats_; }
+  int num_streams_created() const { return num_streams_created_; }
+
+ private:
+  int depth_;
+  bool usable_;
+  bool active_;
+  int num_streams_created_;
+  Stats stats_;
+  SSLConfig ssl_config_;
+  ProxyInfo proxy_info_;
+  BoundNetLog net_log_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakePipeline);
+};
+
+class FakePipelineFactory : public HttpPipelinedConnection::Factory {
+ public:
+  FakePipelineFactory() {}
+
+  virtual HttpPipelinedConnection* CreateNewPipeline(
+      ClientSocketHandle* connection,
+      HttpPipelinedConnection::Delegate* delegate,
+      const HostPortPair& origin,
+      const SSLConfig& used_ssl_config,
+      const ProxyInfo& used_proxy_info,
+      const BoundNetLog& net_log,
+      bool was_npn_negotiated,
+      SSLClientSocket::NextProto protocol_negotiated) OVERRIDE {
+    FakePipeline* pipeline = new FakePipeline;
+    pipelines_.push_back(pipeline);
+    return pipeline;
+  }
+
+  // The pipelines created so far, which the host owns.
+  const std::vector<FakePipeline*>& pipelines() const { return pipelines_; }
+
+ private:
+  std::vector<FakePipeline*> pipelines_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakePipelineFactory);
+};
+
+class NullHostDelegate : public HttpPipelinedHost::Delegate {
+ public:
+  NullHostDelegate() {}
+
+  virtual void OnHostIdle(HttpPipelinedHost* host) OVERRIDE {}
+  virtual void OnHostHasAdditionalCapacity(HttpPipelinedHost* host) OVERRIDE {}
+  virtual void OnHostDeterminedCapability(
+      HttpPipelinedHost* host,
+      HttpPipelinedHostCapability capability) OVERRIDE {}
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(NullHostDelegate);
+};
+
+}  // namespace
+
+class HttpPipelinedHostImplTest : public testing::Test {
+ protected:
+  HttpPipelinedHostImplTest()
+      : factory_(new FakePipelineFactory),
+        host_(new HttpPipelinedHostImpl(&delegate_, HostPortPair("host", 80),
+                                        factory_, PIPELINE_CAPABLE)) {
+  }
+
+  virtual ~HttpPipelinedHostImplTest() {
+    // The host deletes each pipeline once it is empty.
+    std::vector<FakePipeline*> pipelines = factory_->pipelines();
+    for (size_t i = 0; i < pipelines.size(); ++i) {
+      pipelines[i]->set_depth(0);
+      host_->OnPipelineHasCapacity(pipelines[i]);
+    }
+  }
+
+  // Returns a new pipeline of |depth|, created for a request of |priority|.
+  FakePipeline* AddPipeline(int depth, RequestPriority priority) {
+    delete host_->CreateStreamOnNewPipeline(NULL, SSLConfig(), ProxyInfo(),
+                                            BoundNetLog(), false,
+                                            SSLClientSocket::kProtoUnknown,
+                                            priority);
+    FakePipeline* pipeline = factory_->pipelines().back();
+    pipeline->set_depth(depth);
+    return pipeline;
+  }
+
+  // Gives |pipeline| an RTT of |rtt_ms|, responses of |response_size| bytes
+  // and a read rate of |bytes_per_second|.
+  void SetStats(FakePipeline* pipeline, int rtt_ms, int64 response_size,
+                int64 bytes_per_second) {
+    HttpPipelinedConnection::Stats* stats = pipeline->mutable_stats();
+    stats->num_responses = 1;
+    stats->rtt = base::TimeDelta::FromMilliseconds(rtt_ms);
+    stats->response_size = response_size;
+    stats->bytes_per_second = bytes_per_second;
+  }
+
+  int Capacity(FakePipeline* pipeline) const {
+    return host_->GetPipelineCapacity(pipeline);
+  }
+
+  // Returns how many requests have been recorded as scheduled on an existing
+  // pipeline, or as having fallen back because the pipelines were full.
+  static int CountScheduled() {
+    return CountDecisions(
+        HttpPipelinedHostImpl::SCHEDULED_ON_EXISTING_PIPELINE);
+  }
+  static int CountPipelinesFull() {
+    return CountDecisions(HttpPipelinedHostImpl::FALLBACK_PIPELINES_FULL);
+  }
+
+  NullHostDelegate delegate_;
+  FakePipelineFactory* factory_;  // Owned by |host_|.
+  scoped_ptr<HttpPipelinedHostImpl> host_;
+
+ private:
+  static int CountDecisions(int decision) {
+    base::Histogram* histogram = NULL;
+    if (!base::StatisticsRecorder::FindHistogram(
+            "Net.Pipelining.SchedulingDecision", &histogram)) {
+      return 0;
+    }
+    base::Histogram::SampleSet samples;
+    histogram->SnapshotSample(&samples);
+    return samples.counts(decision);
+  }
+};
+
+TEST_F(HttpPipelinedHostImplTest, PicksShortestExpectedWait) {
+  FakePipeline* slow = AddPipeline(1, LOW);
+  FakePipeline* fast = AddPipeline(1, LOW);
+  SetStats(slow, 200, 1000, 100000);
+  SetStats(fast, 20, 1000, 100000);
+
+  EXPECT_TRUE(host_->IsExistingPipelineAvailable(LOW));
+  delete host_->CreateStreamOnExistingPipeline(LOW);
+  EXPECT_EQ(2, fast->num_streams_created());
+  EXPECT_EQ(1, slow->num_streams_created());
+
+  // Large responses on the fast pipeline outweigh its shorter RTT.
+  fast->set_depth(1);
+  SetStats(fast, 20, 1000000, 100000);
+  delete host_->CreateStreamOnExistingPipeline(LOW);
+  EXPECT_EQ(2, slow->num_streams_created());
+}
+
+TEST_F(HttpPipelinedHostImplTest, BreaksTiesByDepth) {
+  FakePipeline* deep = AddPipeline(2, LOW);
+  FakePipeline* shallow = AddPipeline(1, LOW);
+
+  delete host_->CreateStreamOnExistingPipeline(LOW);
+  EXPECT_EQ(2, shallow->num_streams_created());
+  EXPECT_EQ(1, deep->num_streams_created());
+}
+
+TEST_F(HttpPipelinedHostImplTest, CapacityFollowsMeasurements) {
+  FakePipeline* pipeline = AddPipeline(1, LOW);
+  EXPECT_EQ(3, Capacity(pipeline));
+
+  // One 100ms round trip at 100KB/s fetches one more 10KB response.
+  SetStats(pipeline, 100, 10000, 100000);
+  EXPECT_EQ(2, Capacity(pipeline));
+  pipeline->set_depth(2);
+  EXPECT_FALSE(host_->IsExistingPipelineAvailable(LOW));
+
+  SetStats(pipeline, 100, 1000, 100000);
+  EXPECT_EQ(6, Capacity(pipeline));
+  EXPECT_TRUE(host_->IsExistingPipelineAvailable(LOW));
+
+  SetStats(pipeline, 100, 1000000, 100000);
+  EXPECT_EQ(2, Capacity(pipeline));
+}
+
+TEST_F(HttpPipelinedHostImplTest, SkipsHeadOfLineBlockedPipeline) {
+  FakePipeline* blocked = AddPipeline(1, LOW);
+  FakePipeline* clear = AddPipeline(2, LOW);
+  blocked->mutable_stats()->head_of_line_blocked = true;
+
+  delete host_->CreateStreamOnExistingPipeline(LOW);
+  EXPECT_EQ(2, clear->num_streams_created());
+
+  clear->mutable_stats()->head_of_line_blocked = true;
+  EXPECT_FALSE(host_->IsExistingPipelineAvailable(LOW));
+}
+
+TEST_F(HttpPipelinedHostImplTest, HighPriorityAvoidsQueuedPipelines) {
+  FakePipeline* pipeline = AddPipeline(2, LOW);
+  EXPECT_TRUE(host_->IsExistingPipelineAvailable(LOW));
+  EXPECT_FALSE(host_->IsExistingPipelineAvailable(MEDIUM));
+  EXPECT_FALSE(host_->IsExistingPipelineAvailable(HIGHEST));
+
+  pipeline->set_depth(1);
+  EXPECT_TRUE(host_->IsExistingPipelineAvailable(HIGHEST));
+}
+
+// Tests that a request that fell back to a new pipeline is recorded with the
+// reason, and isn't recorded as scheduled on an existing pipeline if one has
+// room by the time its connection is ready.
+TEST_F(HttpPipelinedHostImplTest, NewPipelineRecordsOnlyFallbacks) {
+  AddPipeline(3, LOW);
+  int scheduled = CountScheduled();
+  int pipelines_full = CountPipelinesFull();
+
+  AddPipeline(1, LOW);
+  EXPECT_EQ(pipelines_full + 1, CountPipelinesFull());
+  EXPECT_EQ(scheduled, CountScheduled());
+
+  // The second pipeline has room for the next request.
+  AddPipeline(1, LOW);
+  EXPECT_EQ(pipelines_full + 1, CountPipelinesFull());
+  EXPECT_EQ(scheduled, CountScheduled());
+
+  delete host_->CreateStreamOnExistingPipeline(LOW);
+  EXPECT_EQ(scheduled + 1, CountScheduled());
+}
+
+}  // namespace net
@@ -56,7 +56,8 @@ HttpPipelinedStream* HttpPipelinedHostPool::CreateStreamOnNewPipeline(
     const ProxyInfo& used_proxy_info,
     const BoundNetLog& net_log,
     bool was_npn_negotiated,
-    SSLClientSocket::NextProto protocol_negotiated) {
+    SSLClientSocket::NextProto protocol_negotiated,
+    RequestPriority priority) {
   HttpPipelinedHost* host = GetPipelinedHost(origin, true);
   if (!host) {
     return NULL;
@@ -64,25 +65,27 @@ HttpPipelinedStream* HttpPipelinedHostPool::CreateStreamOnNewPipeline(
   return host->CreateStreamOnNewPipeline(connection, used_ssl_config,
                                          used_proxy_info, net_log,
                                          was_npn_negotiated,
-                                         protocol_negotiated);
+                                         protocol_negotiated, priority);
 }
 
 HttpPipelinedStream* HttpPipelinedHostPool::CreateStreamOnExistingPipeline(
-    const HostPortPair& origin) {
+    const HostPortPair& origin,
+    RequestPriority priority) {
   HttpPipelinedHost* host = GetPipelinedHost(origin, false);
   if (!host) {
     return NULL;
   }
-  return host->CreateStreamOnExistingPipeline();
+  return host->CreateStreamOnExistingPipeline(priority);
 }
 
 bool HttpPipelinedHostPool::IsExistingPipelineAvailableForOrigin(
-    const HostPortPair& origin) {
+    const HostPortPair& origin,
+    RequestPriority priority) {
   HttpPipelinedHost* host = GetPipelinedHost(origin, false);
   if (!host) {
     return false;
   }
-  return host->IsExistingPipelineAvailable();
+  return host->IsExistingPipelineAvailable(priority);
 }
 
 HttpPipelinedHost* HttpPipelinedHostPool::GetPipelinedHost(
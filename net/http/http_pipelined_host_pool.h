@@ -48,7 +48,7 @@ class NET_EXPORT_PRIVATE HttpPipelinedHostPool
   bool IsHostEligibleForPipelining(const HostPortPair& origin);
 
   // Constructs a new pipeline on |connection| and returns a new
-  // HttpPipelinedStream that uses it.
+  // HttpPipelinedStream that uses it, for a request of |priority|.
   HttpPipelinedStream* CreateStreamOnNewPipeline(
       const HostPortPair& origin,
       ClientSocketHandle* connection,
@@ -56,16 +56,20 @@ class NET_EXPORT_PRIVATE HttpPipelinedHostPool
       const ProxyInfo& used_proxy_info,
       const BoundNetLog& net_log,
       bool was_npn_negotiated,
-      SSLClientSocket::NextProto protocol_negotiated);
+      SSLClientSocket::NextProto protocol_negotiated,
+      RequestPriority priority);
 
-  // Tries to find an existing pipeline with capacity for a new request. If
-  // successful, returns a new stream on that pipeline. Otherwise, returns NULL.
+  // Tries to find an existing pipeline that can take a new request of
+  // |priority|. If successful, returns a new stream on that pipeline.
+  // Otherwise, returns NULL.
   HttpPipelinedStream* CreateStreamOnExistingPipeline(
-      const HostPortPair& origin);
+      const HostPortPair& origin,
+      RequestPriority priority);
 
   // Returns true if a pipelined connection already exists for this origin and
-  // can accept new requests.
-  bool IsExistingPipelineAvailableForOrigin(const HostPortPair& origin);
+  // can accept a new request of |priority|.
+  bool IsExistingPipelineAvailableForOrigin(const HostPortPair& origin,
+                                            RequestPriority priority);
 
   // Callbacks for HttpPipelinedHost.
   virtual void OnHostIdle(HttpPipelinedHost* host) OVERRIDE;
@@ -0,0 +1,418 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "base/eintr_wrapper.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+#include "googleurl/src/gurl.h"
+#include "net/base/io_buffer.h"
+#include "net/base/load_flags.h"
+#include "net/base/request_priority.h"
+#include "net/http/http_stream_factory.h"
+#include "net/url_request/url_request.h"
+#include "net/url_request/url_request_test_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kLoadsPerConfiguration = 3;
+
+// A page like the ones pipelining has to cope with: a document, then a mix
+// of small subresources and one large, slowly generated download that should
+// not hold up the rest.
+struct Resource {
+  int size;
+  int think_time_ms;
+  RequestPriority priority;
+};
+
+const Resource kDocument = { 20000, 0, HIGHEST };
+
+const Resource kSubresources[] = {
+  { 1000000, 300, LOWEST },
+  { 15000, 0, MEDIUM },
+  { 15000, 0, MEDIUM },
+  { 30000, 0, MEDIUM },
+  { 8000, 0, MEDIUM },
+  { 40000, 0, LOW },
+  { 2000, 0, LOW },
+  { 6000, 0, LOW },
+  { 3000, 0, LOW },
+  { 12000, 0, LOW },
+  { 2000, 0, LOW },
+  { 25000, 0, LOW },
+  { 4000, 0, LOW },
+  { 2000, 0, LOW },
+  { 9000, 0, LOW },
+  { 2000, 0, LOW },
+  { 18000, 0, LOW },
+  { 3000, 0, LOW },
+  { 5000, 0, LOW },
+  { 2000, 0, LOW },
+  { 7000, 0, LOW },
+  { 2000, 0, LOW },
+  { 30000, 0, LOW },
+  { 4000, 0, LOW },
+};
+
+// Serves "GET /<body size>/<think time in ms>" as an HTTP/1.1 server on a link
+// with a round trip time of |rtt| would: the response is sent |rtt| plus its
+// think time after the request arrives, but never ahead of the response
+// before it on the same connection. Requests on a new connection are treated
+// as arriving one |rtt| after the connection was accepted, to account for the
+// handshake.
+class SimulatedLatencyServer : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit SimulatedLatencyServer(base::TimeDelta rtt)
+      : rtt_(rtt),
+        listen_fd_(-1),
+        port_(0) {
+    wake_fds_[0] = wake_fds_[1] = -1;
+  }
+
+  virtual ~SimulatedLatencyServer() {
+    Stop();
+  }
+
+  bool Start() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0)
+      return false;
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t addr_len = sizeof(addr);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr),
+             sizeof(addr)) != 0 ||
+        listen(listen_fd_, 64) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr),
+                    &addr_len) != 0 ||
+        pipe(wake_fds_) != 0) {
+      return false;
+    }
+    port_ = ntohs(addr.sin_port);
+    thread_.reset(new base::DelegateSimpleThread(this, "LatencyServer"));
+    thread_->Start();
+    return true;
+  }
+
+  void Stop() {
+    if (thread_.get()) {
+      char byte = 0;
+      HANDLE_EINTR(write(wake_fds_[1], &byte, 1));
+      thread_->Join();
+      thread_.reset();
+    }
+    for (size_t i = 0; i < connections_.size(); ++i)
+      close(connections_[i]->fd);
+    connections_.reset();
+    if (listen_fd_ >= 0)
+      close(listen_fd_);
+    listen_fd_ = -1;
+    for (int i = 0; i < 2; ++i) {
+      if (wake_fds_[i] >= 0)
+        close(wake_fds_[i]);
+      wake_fds_[i] = -1;
+    }
+  }
+
+  int port() const { return port_; }
+
+  // base::DelegateSimpleThread::Delegate implementation.
+  virtual void Run() OVERRIDE {
+    while (true) {
+      base::TimeTicks now = base::TimeTicks::Now();
+      int timeout_ms = -1;
+      std::vector<pollfd> poll_fds(connections_.size() + 2);
+      for (size_t i = 0; i < connections_.size(); ++i) {
+        Connection* connection = connections_[i];
+        SendDueResponses(connection, now);
+        poll_fds[i].fd = connection->fd;
+        poll_fds[i].events = POLLIN;
+        if (!connection->out.empty()) {
+          poll_fds[i].events |= POLLOUT;
+        } else if (!connection->responses.empty()) {
+          int wait_ms = std::max(0, static_cast<int>(
+              (connection->responses.front().due - now).InMilliseconds()) + 1);
+          if (timeout_ms < 0 || wait_ms < timeout_ms)
+            timeout_ms = wait_ms;
+        }
+      }
+      pollfd& listen_poll_fd = poll_fds[connections_.size()];
+      listen_poll_fd.fd = listen_fd_;
+      listen_poll_fd.events = POLLIN;
+      pollfd& wake_poll_fd = poll_fds[connections_.size() + 1];
+      wake_poll_fd.fd = wake_fds_[0];
+      wake_poll_fd.events = POLLIN;
+
+      if (HANDLE_EINTR(poll(&poll_fds[0], poll_fds.size(), timeout_ms)) < 0)
+        return;
+      if (wake_poll_fd.revents)
+        return;
+      now = base::TimeTicks::Now();
+
+      size_t num_polled = connections_.size();
+      if (listen_poll_fd.revents & POLLIN)
+        Accept(now);
+
+      // Iterate backwards, so that closed connections can be erased.
+      for (size_t i = num_polled; i-- > 0;) {
+        Connection* connection = connections_[i];
+        bool open = true;
+        if (poll_fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+          open = Read(connection, now);
+        if (open && (poll_fds[i].revents & POLLOUT))
+          open = Write(connection);
+        if (!open) {
+          close(connection->fd);
+          connections_.erase(connections_.begin() + i);
+        }
+      }
+    }
+  }
+
+ private:
+  struct PendingResponse {
+    base::TimeTicks due;
+    std::string data;
+  };
+
+  struct Connection {
+    Connection() : fd(-1) {}
+
+    int fd;
+    base::TimeTicks handshake_done;
+    std::string in;
+    std::deque<PendingResponse> responses;
+    std::string out;
+  };
+
+  void Accept(base::TimeTicks now) {
+    int fd = HANDLE_EINTR(accept(listen_fd_, NULL, NULL));
+    if (fd < 0)
+      return;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    Connection* connection = new Connection;
+    connection->fd = fd;
+    connection->handshake_done = now + rtt_;
+    connections_.push_back(connection);
+  }
+
+  // Returns false if the connection was closed.
+  bool Read(Connection* connection, base::TimeTicks now) {
+    char buf[4096];
+    ssize_t len = HANDLE_EINTR(read(connection->fd, buf, sizeof(buf)));
+    if (len < 0)
+      return errno == EAGAIN;
+    if (len == 0)
+      return false;
+    connection->in.append(buf, len);
+
+    size_t end;
+    while ((end = connection->in.find("\r\n\r\n")) != std::string::npos) {
+      int size = 0;
+      int think_time_ms = 0;
+      sscanf(connection->in.c_str(), "GET /%d/%d", &size, &think_time_ms);
+      connection->in.erase(0, end + 4);
+
+      PendingResponse response;
+      response.due = std::max(now, connection->handshake_done) + rtt_ +
+          base::TimeDelta::FromMilliseconds(think_time_ms);
+      if (!connection->responses.empty())
+        response.due = std::max(response.due, connection->responses.back().due);
+      response.data = base::StringPrintf(
+          "HTTP/1.1 200 OK\r\n"
+          "Content-Length: %d\r\n"
+          "Content-Type: application/octet-stream\r\n"
+          "Cache-Control: no-store\r\n"
+          "\r\n", size);
+      response.data.append(size, 'x');
+      connection->responses.push_back(response);
+    }
+    return true;
+  }
+
+  void SendDueResponses(Connection* connection, base::TimeTicks now) {
+    while (!connection->responses.empty() &&
+           connection->responses.front().due <= now) {
+      connection->out.append(connection->responses.front().data);
+      connection->responses.pop_front();
+    }
+  }
+
+  // Returns false if the connection was closed.
+  bool Write(Connection* connection) {
+    ssize_t len = HANDLE_EINTR(write(connection->fd, connection->out.data(),
+                                     connection->out.size()));
+    if (len < 0)
+      return errno == EAGAIN;
+    connection->out.erase(0, len);
+    return true;
+  }
+
+  const base::TimeDelta rtt_;
+  int listen_fd_;
+  int wake_fds_[2];
+  int port_;
+  ScopedVector<Connection> connections_;
+  scoped_ptr<base::DelegateSimpleThread> thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(SimulatedLatencyServer);
+};
+
+// Loads the document, then all of its subresources at once, as a renderer
+// would after parsing the document. Quits the message loop when every
+// resource has been read.
+class PageLoader : public URLRequest::Delegate {
+ public:
+  PageLoader(URLRequestContext* context, int port)
+      : context_(context),
+        port_(port),
+        buf_(new IOBuffer(kBufferSize)),
+        outstanding_(0),
+        failures_(0) {
+  }
+
+  void Start() {
+    Fetch(kDocument);
+  }
+
+  int failures() const { return failures_; }
+
+  // URLRequest::Delegate implementation.
+  virtual void OnResponseStarted(URLRequest* request) OVERRIDE {
+    if (!request->status().is_success()) {
+      OnRequestDone(request);
+      return;
+    }
+    ReadBody(request);
+  }
+
+  virtual void OnReadCompleted(URLRequest* request, int bytes_read) OVERRIDE {
+    if (bytes_read <= 0) {
+      OnRequestDone(request);
+      return;
+    }
+    ReadBody(request);
+  }
+
+ private:
+  // Every request reads into |buf_|, whose contents are discarded.
+  static const int kBufferSize = 32768;
+
+  void Fetch(const Resource& resource) {
+    GURL url(base::StringPrintf("http://127.0.0.1:%d/%d/%d", port_,
+                                resource.size, resource.think_time_ms));
+    URLRequest* request = new URLRequest(url, this);
+    request->set_context(context_);
+    request->set_priority(resource.priority);
+    request->set_load_flags(LOAD_DISABLE_CACHE);
+    requests_.push_back(request);
+    ++outstanding_;
+    request->Start();
+  }
+
+  void ReadBody(URLRequest* request) {
+    int bytes_read = 0;
+    while (request->Read(buf_, kBufferSize, &bytes_read)) {
+      if (bytes_read <= 0) {
+        OnRequestDone(request);
+        return;
+      }
+    }
+    if (!request->status().is_io_pending())
+      OnRequestDone(request);
+  }
+
+  void OnRequestDone(URLRequest* request) {
+    if (!request->status().is_success())
+      ++failures_;
+    if (request == requests_[0]) {
+      for (size_t i = 0; i < arraysize(kSubresources); ++i)
+        Fetch(kSubresources[i]);
+    }
+    if (!--outstanding_)
+      MessageLoop::current()->Quit();
+  }
+
+  URLRequestContext* context_;
+  const int port_;
+  scoped_refptr<IOBuffer> buf_;
+  ScopedVector<URLRequest> requests_;
+  int outstanding_;
+  int failures_;
+
+  DISALLOW_COPY_AND_ASSIGN(PageLoader);
+};
+
+class HttpPipeliningPerfTest : public testing::Test {
+ protected:
+  virtual void TearDown() {
+    HttpStreamFactory::set_http_pipelining_enabled(false);
+  }
+
+  // Loads the page from |server| with a fresh context, so that nothing is
+  // known about the server, and returns the time it took.
+  base::TimeDelta LoadPage(const SimulatedLatencyServer& server) {
+    scoped_refptr<TestURLRequestContext> context(new TestURLRequestContext);
+    base::TimeTicks start = base::TimeTicks::Now();
+    {
+      PageLoader loader(context, server.port());
+      loader.Start();
+      MessageLoop::current()->Run();
+      EXPECT_EQ(0, loader.failures());
+    }
+    return base::TimeTicks::Now() - start;
+  }
+
+  MessageLoopForIO message_loop_;
+};
+
+}  // namespace
+
+TEST_F(HttpPipeliningPerfTest, PageLoad) {
+  const int kRttMs[] = { 20, 100, 200 };
+  for (size_t i = 0; i < arraysize(kRttMs); ++i) {
+    SimulatedLatencyServer server(base::TimeDelta::FromMilliseconds(kRttMs[i]));
+    ASSERT_TRUE(server.Start());
+    for (int pipelining = 0; pipelining < 2; ++pipelining) {
+      HttpStreamFactory::set_http_pipelining_enabled(pipelining != 0);
+      base::TimeDelta total;
+      for (int j = 0; j < kLoadsPerConfiguration; ++j)
+        total += LoadPage(server);
+      LogPerfResult(
+          base::StringPrintf("HttpPipelining_page_load_%dms_rtt_%s", kRttMs[i],
+                             pipelining ? "pipelined" : "unpipelined").c_str(),
+          total.InMillisecondsF() / kLoadsPerConfiguration, "ms");
+    }
+    server.Stop();
+  }
+}
+
+}  // namespace net
@@ -11,6 +11,7 @@
 
 #include <algorithm>
 
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
 #include "base/pickle.h"
@@ -116,6 +117,100 @@ int MapHttpResponseCode(int code) {
   return 0;
 }
 
+// Header names that the network stack looks up on most responses.  Their
+// positions are recorded as headers are parsed, so looking them up does not
+// scan the header list.
+const char* const kKnownHeaders[] = {
+  "accept-ranges",
+  "age",
+  "alternate-protocol",
+  "cache-control",
+  "connection",
+  "content-disposition",
+  "content-encoding",
+  "content-length",
+  "content-location",
+  "content-md5",
+  "content-range",
+  "content-type",
+  "date",
+  "etag",
+  "expires",
+  "get-dictionary",
+  "keep-alive",
+  "last-modified",
+  "location",
+  "pragma",
+  "proxy-authenticate",
+  "proxy-connection",
+  "proxy-support",
+  "public-key-pins",
+  "retry-after",
+  "server",
+  "set-cookie",
+  "set-cookie2",
+  "strict-transport-security",
+  "trailer",
+  "transfer-encoding",
+  "upgrade",
+  "vary",
+  "www-authenticate",
+  "x-content-type-options",
+  "x-frame-options",
+  "x-sdch-encode"
+};
+
+const size_t kKnownHeaderSlots = 128;
+
+// A perfect hash of kKnownHeaders.  Adding a name may require new factors.
+size_t KnownHeaderSlot(std::string::const_iterator name_begin,
+                       std::string::const_iterator name_end) {
+  size_t length = name_end - name_begin;
+  return (base::ToLowerASCII(name_begin[0]) +
+          10 * base::ToLowerASCII(name_begin[length / 2]) +
+          base::ToLowerASCII(name_end[-1]) +
+          17 * length) % kKnownHeaderSlots;
+}
+
+// Maps hash slots back to indices in kKnownHeaders.
+class KnownHeaderTable {
+ public:
+  KnownHeaderTable() {
+    std::fill(slots_, slots_ + kKnownHeaderSlots, -1);
+    for (size_t i = 0; i < arraysize(kKnownHeaders); ++i) {
+      std::string name(kKnownHeaders[i]);
+      size_t slot = KnownHeaderSlot(name.begin(), name.end());
+      DCHECK_EQ(-1, slots_[slot]) << name << " collides with "
+                                  << kKnownHeaders[slots_[slot]];
+      slots_[slot] = static_cast<int8>(i);
+    }
+  }
+
+  // Returns the index in kKnownHeaders of the given name (case-insensitive),
+  // or -1 if it is not a well-known name.
+  int Find(std::string::const_iterator name_begin,
+           std::string::const_iterator name_end) const {
+    if (name_begin == name_end)
+      return -1;
+    int index = slots_[KnownHeaderSlot(name_begin, name_end)];
+    if (index < 0 ||
+        !LowerCaseEqualsASCII(name_begin, name_end, kKnownHeaders[index]))
+      return -1;
+    return index;
+  }
+
+ private:
+  int8 slots_[kKnownHeaderSlots];
+
+  DISALLOW_COPY_AND_ASSIGN(KnownHeaderTable);
+};
+
+base::LazyInstance<KnownHeaderTable>::Leaky g_known_headers =
+    LAZY_INSTANCE_INITIALIZER;
+
+// Marks a well-known header that does not occur.
+const uint32 kNotFound = kuint32max;
+
 void CheckDoesNotHaveEmbededNulls(const std::string& str) {
   // Care needs to be taken when adding values to the raw headers string to
   // make sure it does not contain embeded NULLs. Any embeded '\0' may be
@@ -136,6 +231,14 @@ struct HttpResponseHeaders::ParsedHeader {
   std::string::const_iterator value_end;
 };
 
+struct HttpResponseHeaders::KnownHeaderPosition {
+  KnownHeaderPosition() : first(kNotFound), last(kNotFound) {}
+
+  // Indices into parsed_.
+  uint32 first;
+  uint32 last;
+};
+
 //-----------------------------------------------------------------------------
 
 HttpResponseHeaders::HttpResponseHeaders(const std::string& raw_input)
@@ -380,6 +483,7 @@ void HttpResponseHeaders::ReplaceStatusLine(const std::string& new_status) {
 }
 
 void HttpResponseHeaders::Parse(const std::string& raw_input) {
+  known_headers_.clear();
   raw_headers_.reserve(raw_input.size());
 
   // ParseStatusLine adds a normalized status line to raw_headers_
@@ -722,6 +826,18 @@ void HttpResponseHeaders::ParseStatusLine(
 
 size_t HttpResponseHeaders::FindHeader(size_t from,
                                        const std::string& search) const {
+  int known = g_known_headers.Get().Find(search.begin(), search.end());
+  if (known >= 0) {
+    if (known_headers_.empty())
+      return std::string::npos;
+    const KnownHeaderPosition& position = known_headers_[known];
+    if (position.first == kNotFound || from > position.last)
+      return std::string::npos;
+    if (from <= position.first)
+      return position.first;
+    // The header is repeated; look for it from |from| on.
+  }
+
   for (size_t i = from; i < parsed_.size(); ++i) {
     if (parsed_[i].is_continuation())
       continue;
@@ -763,6 +879,17 @@ void HttpResponseHeaders::AddToParsed(std::string::const_iterator name_begin,
   header.name_end = name_end;
   header.value_begin = value_begin;
   header.value_end = value_end;
+
+  int known = g_known_headers.Get().Find(name_begin, name_end);
+  if (known >= 0) {
+    if (known_headers_.empty())
+      known_headers_.resize(arraysize(kKnownHeaders));
+    KnownHeaderPosition& position = known_headers_[known];
+    if (position.first == kNotFound)
+      position.first = parsed_.size();
+    position.last = parsed_.size();
+  }
+
   parsed_.push_back(header);
 }
 
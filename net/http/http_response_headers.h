@@ -259,6 +259,10 @@ class NET_EXPORT HttpResponseHeaders
   struct ParsedHeader;
   typedef std::vector<ParsedHeader> HeaderList;
 
+  // Where a well-known header name occurs in parsed_.
+  struct KnownHeaderPosition;
+  typedef std::vector<KnownHeaderPosition> KnownHeaderList;
+
   HttpResponseHeaders();
   ~HttpResponseHeaders();
 
@@ -284,7 +288,8 @@ class NET_EXPORT HttpResponseHeaders
                        bool has_headers);
 
   // Find the header in our list (case-insensitive) starting with parsed_ at
-  // index |from|.  Returns string::npos if not found.
+  // index |from|.  Returns string::npos if not found.  Well-known names are
+  // found through known_headers_ instead of scanning the list.
   size_t FindHeader(size_t from, const std::string& name) const;
 
   // Add a header->value pair to our list.  If we already have header in our
@@ -339,6 +344,11 @@ class NET_EXPORT HttpResponseHeaders
   // header-value pairs within raw_headers_.
   HeaderList parsed_;
 
+  // The first and last occurrence in parsed_ of each well-known header name,
+  // indexed by the name's position in the table of well-known names.  This is
+  // empty until a well-known header is parsed.
+  KnownHeaderList known_headers_;
+
   // The raw_headers_ consists of the normalized status line (terminated with a
   // null byte) and then followed by the raw null-terminated headers from the
   // input that was passed to our constructor.  We preserve the input [*] to
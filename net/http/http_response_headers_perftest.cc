@@ -0,0 +1,174 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kIterations = 20000;
+
+// Response headers captured from popular sites, lightly anonymized.
+const char* const kCorpus[] = {
+  "HTTP/1.1 200 OK\n"
+  "Date: Tue, 17 Apr 2012 18:23:11 GMT\n"
+  "Expires: -1\n"
+  "Cache-Control: private, max-age=0\n"
+  "Content-Type: text/html; charset=UTF-8\n"
+  "Set-Cookie: PREF=ID=0123456789abcdef:FF=0:TM=1334686991:LM=1334686991:"
+  "S=abcdefghijklmnop; expires=Thu, 17-Apr-2014 18:23:11 GMT; path=/; "
+  "domain=.example.com\n"
+  "Set-Cookie: NID=58=abcdefghijklmnopqrstuvwxyz; expires=Wed, 17-Oct-2012 "
+  "18:23:11 GMT; path=/; domain=.example.com; HttpOnly\n"
+  "P3P: CP=\"This is not a P3P policy!\"\n"
+  "Content-Encoding: gzip\n"
+  "Server: gws\n"
+  "Content-Length: 16384\n"
+  "X-XSS-Protection: 1; mode=block\n"
+  "X-Frame-Options: SAMEORIGIN\n",
+
+  "HTTP/1.1 200 OK\n"
+  "Server: Apache\n"
+  "Last-Modified: Mon, 16 Apr 2012 22:10:35 GMT\n"
+  "ETag: \"4f8c98fb-1e5c4\"\n"
+  "Accept-Ranges: bytes\n"
+  "Content-Type: application/javascript\n"
+  "Vary: Accept-Encoding\n"
+  "Content-Encoding: gzip\n"
+  "Cache-Control: public, max-age=31536000\n"
+  "Expires: Wed, 17 Apr 2013 18:23:12 GMT\n"
+  "Date: Tue, 17 Apr 2012 18:23:12 GMT\n"
+  "Content-Length: 41289\n"
+  "Connection: keep-alive\n",
+
+  "HTTP/1.1 304 Not Modified\n"
+  "Date: Tue, 17 Apr 2012 18:23:13 GMT\n"
+  "Server: nginx\n"
+  "Connection: keep-alive\n"
+  "ETag: \"a9c3e2f1\"\n"
+  "Expires: Tue, 17 Apr 2012 19:23:13 GMT\n"
+  "Cache-Control: max-age=3600\n"
+  "Age: 1242\n"
+  "X-Cache: HIT from cache.example.net\n"
+  "Via: 1.1 cache.example.net\n",
+
+  "HTTP/1.1 302 Found\n"
+  "Location: http://www.example.com/landing?ref=home\n"
+  "Cache-Control: private\n"
+  "Content-Type: text/html; charset=UTF-8\n"
+  "Date: Tue, 17 Apr 2012 18:23:14 GMT\n"
+  "Server: Microsoft-IIS/7.5\n"
+  "X-AspNet-Version: 4.0.30319\n"
+  "X-Powered-By: ASP.NET\n"
+  "Content-Length: 156\n",
+
+  "HTTP/1.1 200 OK\n"
+  "Content-Type: image/png\n"
+  "Content-Length: 3071\n"
+  "Connection: keep-alive\n"
+  "Date: Tue, 17 Apr 2012 18:23:15 GMT\n"
+  "Last-Modified: Fri, 02 Mar 2012 09:41:22 GMT\n"
+  "Cache-Control: max-age=604800, public\n"
+  "Accept-Ranges: bytes\n"
+  "Server: AmazonS3\n"
+  "Age: 86211\n"
+  "X-Cache: Hit from cloudfront\n"
+  "Via: 1.0 abcdef0123456789.cloudfront.net (CloudFront)\n"
+  "X-Amz-Cf-Id: 0123456789abcdefghijklmnopqrstuvwxyz==\n",
+
+  "HTTP/1.1 200 OK\n"
+  "Cache-Control: no-cache, no-store, must-revalidate\n"
+  "Pragma: no-cache\n"
+  "Content-Type: application/json; charset=utf-8\n"
+  "Transfer-Encoding: chunked\n"
+  "Strict-Transport-Security: max-age=2592000\n"
+  "X-Content-Type-Options: nosniff\n"
+  "Date: Tue, 17 Apr 2012 18:23:16 GMT\n"
+  "Server: tfe\n"
+  "Set-Cookie: guest_id=v1%3A133468699612345678; Domain=.example.com; "
+  "Path=/; Expires=Thu, 17-Apr-2014 18:23:16 UTC\n"
+  "Set-Cookie: _session=abcdef; Path=/; HttpOnly\n"
+  "X-Transaction: 0123456789abcdef\n"
+  "X-Runtime: 0.01234\n",
+};
+
+// Makes the lookups that the cache and network code make on a response.
+int LookUpHeaders(const HttpResponseHeaders* headers) {
+  int found = 0;
+  std::string value;
+  void* iter = NULL;
+  while (headers->EnumerateHeader(&iter, "cache-control", &value))
+    ++found;
+  found += headers->HasHeaderValue("cache-control", "no-store");
+  found += headers->HasHeaderValue("cache-control", "no-cache");
+  found += headers->HasHeaderValue("pragma", "no-cache");
+  found += headers->HasHeaderValue("connection", "close");
+  found += headers->HasHeaderValue("proxy-connection", "close");
+  found += headers->HasHeader("vary");
+  found += headers->HasHeader("content-range");
+  found += headers->GetNormalizedHeader("etag", &value);
+  found += headers->GetNormalizedHeader("last-modified", &value);
+  found += headers->GetNormalizedHeader("content-encoding", &value);
+  found += headers->GetNormalizedHeader("transfer-encoding", &value);
+  found += headers->GetNormalizedHeader("strict-transport-security", &value);
+  found += headers->GetNormalizedHeader("x-sdch-encode", &value);
+  found += headers->GetNormalizedHeader("get-dictionary", &value);
+  found += headers->GetContentLength() >= 0;
+  std::string mime_type;
+  found += headers->GetMimeType(&mime_type);
+  base::Time time;
+  found += headers->GetDateValue(&time);
+  found += headers->GetExpiresValue(&time);
+  base::TimeDelta delta;
+  found += headers->GetAgeValue(&delta);
+  found += headers->IsRedirect(NULL);
+  found += headers->IsKeepAlive();
+  return found;
+}
+
+}  // namespace
+
+TEST(HttpResponseHeadersPerfTest, ParseAndLookUp) {
+  std::string raw[arraysize(kCorpus)];
+  for (size_t i = 0; i < arraysize(kCorpus); ++i) {
+    raw[i] = HttpUtil::AssembleRawHeaders(kCorpus[i], strlen(kCorpus[i]));
+  }
+
+  int found = 0;
+  PerfTimeLogger parse_timer("HttpResponseHeaders_Parse");
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < arraysize(kCorpus); ++j) {
+      scoped_refptr<HttpResponseHeaders> headers(
+          new HttpResponseHeaders(raw[j]));
+      found += headers->response_code();
+    }
+  }
+  parse_timer.Done();
+
+  scoped_refptr<HttpResponseHeaders> parsed[arraysize(kCorpus)];
+  for (size_t i = 0; i < arraysize(kCorpus); ++i)
+    parsed[i] = new HttpResponseHeaders(raw[i]);
+
+  PerfTimeLogger lookup_timer("HttpResponseHeaders_LookUp");
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < arraysize(kCorpus); ++j)
+      found += LookUpHeaders(parsed[j]);
+  }
+  lookup_timer.Done();
+
+  // Keeps the work from being optimized away.
+  EXPECT_GT(found, 0);
+}
+
+}  // namespace net
@@ -61,7 +61,8 @@ HttpStreamRequest* HttpStreamFactoryImpl::RequestStream(
     const SSLConfig& proxy_ssl_config,
     HttpStreamRequest::Delegate* delegate,
     const BoundNetLog& net_log) {
-  Request* request = new Request(request_info.url, this, delegate, net_log);
+  Request* request = new Request(request_info.url, request_info.priority,
+                                 this, delegate, net_log);
 
   GURL alternate_url;
   bool has_alternate_protocol =
@@ -233,11 +234,13 @@ void HttpStreamFactoryImpl::OnPreconnectsComplete(const Job* job) {
 
 void HttpStreamFactoryImpl::OnHttpPipelinedHostHasAdditionalCapacity(
     const HostPortPair& origin) {
-  HttpPipelinedStream* stream;
-  while (ContainsKey(http_pipelining_request_map_, origin) &&
-         (stream = http_pipelined_host_pool_.CreateStreamOnExistingPipeline(
-             origin))) {
+  while (ContainsKey(http_pipelining_request_map_, origin)) {
     Request* request = *http_pipelining_request_map_[origin].begin();
+    HttpPipelinedStream* stream =
+        http_pipelined_host_pool_.CreateStreamOnExistingPipeline(
+            origin, request->priority());
+    if (!stream)
+      break;
     request->Complete(stream->was_npn_negotiated(),
                       stream->protocol_negotiated(),
                       false,  // not using_spdy
@@ -687,7 +687,7 @@ int HttpStreamFactoryImpl::Job::DoInitConnection() {
     // connections and thus should make fewer preconnections. Explore
     // preconnecting fewer than the requested num_connections.
     existing_available_pipeline_ = stream_factory_->http_pipelined_host_pool_.
-        IsExistingPipelineAvailableForOrigin(origin_);
+        IsExistingPipelineAvailableForOrigin(origin_, request_info_.priority);
     if (existing_available_pipeline_) {
       return OK;
     } else {
@@ -889,7 +889,8 @@ int HttpStreamFactoryImpl::Job::DoCreateStream() {
     // TODO(simonjam): Support proxies.
     if (existing_available_pipeline_) {
       stream_.reset(stream_factory_->http_pipelined_host_pool_.
-                    CreateStreamOnExistingPipeline(origin_));
+                    CreateStreamOnExistingPipeline(origin_,
+                                                   request_info_.priority));
       CHECK(stream_.get());
     } else if (!using_proxy && IsRequestEligibleForPipelining()) {
       stream_.reset(
@@ -900,7 +901,8 @@ int HttpStreamFactoryImpl::Job::DoCreateStream() {
               proxy_info_,
               net_log_,
               was_npn_negotiated_,
-              protocol_negotiated_));
+              protocol_negotiated_,
+              request_info_.priority));
       CHECK(stream_.get());
     } else {
       stream_.reset(new HttpBasicStream(connection_.release(), NULL,
@@ -13,10 +13,12 @@
 namespace net {
 
 HttpStreamFactoryImpl::Request::Request(const GURL& url,
+                                        RequestPriority priority,
                                         HttpStreamFactoryImpl* factory,
                                         HttpStreamRequest::Delegate* delegate,
                                         const BoundNetLog& net_log)
     : url_(url),
+      priority_(priority),
       factory_(factory),
       delegate_(delegate),
       net_log_(net_log),
@@ -95,7 +95,7 @@ HttpStreamParser::HttpStreamParser(ClientSocketHandle* connection,
 }
 
 HttpStreamParser::~HttpStreamParser() {
-  if (request_body_ != NULL && request_body_->is_chunked())
+  if (request_body_ != NULL)
     request_body_->set_chunk_callback(NULL);
 }
 
@@ -129,9 +129,10 @@ int HttpStreamParser::SendRequest(const std::string& request_line,
 
   std::string request = request_line + headers.ToString();
   request_body_.reset(request_body);
-  if (request_body_ != NULL && request_body_->is_chunked()) {
+  if (request_body_ != NULL) {
     request_body_->set_chunk_callback(this);
-    chunk_buf_ = new IOBuffer(chunk_buffer_size_);
+    if (request_body_->is_chunked())
+      chunk_buf_ = new IOBuffer(chunk_buffer_size_);
   }
 
   io_state_ = STATE_SENDING_HEADERS;
@@ -251,11 +252,15 @@ void HttpStreamParser::OnChunkAvailable() {
   // This method may get called while sending the headers or body, so check
   // before processing the new data. If we were still initializing or sending
   // headers, we will automatically start reading the chunks once we get into
-  // STATE_SENDING_CHUNKED_BODY so nothing to do here.
+  // STATE_SENDING_CHUNKED_BODY so nothing to do here.  A non-chunked body
+  // calls this when file data it was waiting for has been read.
   DCHECK(io_state_ == STATE_SENDING_HEADERS ||
-         io_state_ == STATE_SENDING_CHUNKED_BODY);
-  if (io_state_ == STATE_SENDING_CHUNKED_BODY)
+         io_state_ == STATE_SENDING_CHUNKED_BODY ||
+         io_state_ == STATE_SENDING_NON_CHUNKED_BODY);
+  if (io_state_ == STATE_SENDING_CHUNKED_BODY ||
+      io_state_ == STATE_SENDING_NON_CHUNKED_BODY) {
     OnIOComplete(0);
+  }
 }
 
 int HttpStreamParser::DoLoop(int result) {
@@ -395,6 +400,10 @@ int HttpStreamParser::DoSendNonChunkedBody(int result) {
 
   if (!request_body_->eof()) {
     int buf_len = static_cast<int>(request_body_->buf_len());
+    // Wait for OnChunkAvailable() if the next part of a file is still being
+    // read.
+    if (!buf_len)
+      return ERR_IO_PENDING;
     result = connection_->socket()->Write(request_body_->buf(), buf_len,
                                           io_callback_);
   } else {
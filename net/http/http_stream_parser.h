@@ -72,6 +72,11 @@ class NET_EXPORT_PRIVATE HttpStreamParser  : public ChunkCallback {
 
   bool IsConnectionReusable() const;
 
+  // The length of the response body, or -1 if it isn't known until the body
+  // ends, and the number of body bytes read so far.
+  int64 response_body_length() const { return response_body_length_; }
+  int64 response_body_read() const { return response_body_read_; }
+
   void GetSSLInfo(SSLInfo* ssl_info);
 
   void GetSSLCertRequestInfo(SSLCertRequestInfo* cert_request_info);
@@ -165,6 +165,8 @@
         'base/net_export.h',
         'base/net_log.cc',
         'base/net_log.h',
+        'base/net_log_binary_capture.cc',
+        'base/net_log_binary_capture.h',
         'base/net_log_event_type_list.h',
         'base/net_log_source_type_list.h',
         'base/net_module.cc',
@@ -443,6 +445,7 @@
         'http/http_network_session_peer.h',
         'http/http_network_transaction.cc',
         'http/http_network_transaction.h',
+        'http/http_pipelined_connection.cc',
         'http/http_pipelined_connection.h',
         'http/http_pipelined_connection_impl.cc',
         'http/http_pipelined_connection_impl.h',
@@ -752,6 +755,26 @@
       'export_dependent_settings': [
         '../base/base.gyp:base',
       ],
+      'actions': [
+        {
+          'action_name': 'effective_tld_names_dafsa',
+          'inputs': [
+            'tools/dafsa/make_dafsa.py',
+            'base/effective_tld_names.gperf',
+          ],
+          'outputs': [
+            '<(SHARED_INTERMEDIATE_DIR)/net/base/effective_tld_names_dafsa.cc',
+          ],
+          'action': [
+            'python',
+            'tools/dafsa/make_dafsa.py',
+            'base/effective_tld_names.gperf',
+            '<(SHARED_INTERMEDIATE_DIR)/net/base/effective_tld_names_dafsa.cc',
+          ],
+          'message': 'Generating effective TLD graph',
+          'process_outputs_as_sources': 1,
+        },
+      ],
       'conditions': [
         # Clank merge: This will attempt to build base.gyp:base for host, which
         # is not possible at the moment. Chromium revision 101378 requires this.
@@ -1329,6 +1352,15 @@
             ],
           },
         ],
+        [ 'OS != "win"', {
+            'dependencies': [
+              'http_server',
+            ],
+            'sources': [
+              'server/http_server_unittest.cc',
+            ],
+          },
+        ],
         [ 'OS != "win" and OS != "mac"', {
           'sources!': [
             'base/x509_cert_types_unittest.cc',
@@ -1347,10 +1379,17 @@
         '../base/base.gyp:test_support_perf',
         '../build/temp_gyp/googleurl.gyp:googleurl',
         '../testing/gtest.gyp:gtest',
+        '../third_party/zlib/zlib.gyp:zlib',
       ],
       'sources': [
         'base/cookie_monster_perftest.cc',
+        'base/filter_perftest.cc',
+        'base/net_log_perftest.cc',
+        'base/registry_controlled_domain_perftest.cc',
+        'base/upload_data_stream_perftest.cc',
         'disk_cache/disk_cache_perftest.cc',
+        'http/http_cache_perftest.cc',
+        'http/http_response_headers_perftest.cc',
         'proxy/proxy_resolver_perftest.cc',
       ],
       'conditions': [
@@ -1362,6 +1401,16 @@
             ],
           },
         ],
+        [ 'OS != "win"', {
+            'dependencies': [
+              'http_server',
+            ],
+            'sources': [
+              'http/http_pipelining_perftest.cc',
+              'server/http_server_perftest.cc',
+            ],
+          },
+        ],
       ],
     },
     {
@@ -1597,6 +1646,17 @@
         'tools/crl_set_dump/crl_set_dump.cc',
       ],
     },
+    {
+      'target_name': 'net_log_binary_to_json',
+      'type': 'executable',
+      'dependencies': [
+        'net',
+        '../base/base.gyp:base',
+      ],
+      'sources': [
+        'tools/net_log_binary_to_json/net_log_binary_to_json.cc',
+      ],
+    },
     {
       'target_name': 'ssl_false_start_blacklist_process',
       'type': 'executable',
@@ -64,8 +64,12 @@ void HttpConnection::Send500(const std::string& message) {
 
 HttpConnection::HttpConnection(HttpServer* server, ListenSocket* sock)
     : server_(server),
-      socket_(sock) {
+      socket_(sock),
+      awaiting_response_(false),
+      close_after_response_(false),
+      processing_(false) {
   id_ = last_id_++;
+  ResetRequestParser();
 }
 
 HttpConnection::~HttpConnection() {
@@ -78,7 +82,16 @@ void HttpConnection::DetachSocket() {
 }
 
 void HttpConnection::Shift(int num_bytes) {
-  recv_data_ = recv_data_.substr(num_bytes);
+  recv_data_.erase(0, num_bytes);
+}
+
+void HttpConnection::ResetRequestParser() {
+  parse_state_ = 0;  // Expecting the method.
+  parse_pos_ = 0;
+  parse_token_.clear();
+  parse_header_name_.clear();
+  parse_protocol_.clear();
+  parsed_request_ = HttpServerRequestInfo();
 }
 
 }  // namespace net
@@ -11,6 +11,7 @@
 #include "base/basictypes.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "net/server/http_server_request_info.h"
 
 namespace net {
 
@@ -40,11 +41,35 @@ class HttpConnection {
 
   void DetachSocket();
 
+  // Prepares to parse the next request in recv_data_.
+  void ResetRequestParser();
+
   HttpServer* server_;
   scoped_refptr<ListenSocket> socket_;
   scoped_ptr<WebSocket> web_socket_;
   std::string recv_data_;
   int id_;
+
+  // State of the request being parsed from the start of recv_data_, kept so
+  // that each read only parses the new data.  See HttpServer::ParseHeaders().
+  int parse_state_;
+  size_t parse_pos_;
+  std::string parse_token_;
+  std::string parse_header_name_;
+  std::string parse_protocol_;
+  HttpServerRequestInfo parsed_request_;
+
+  // True from when a request is passed to the delegate until something is
+  // sent in reply.  Pipelined requests wait in recv_data_ meanwhile, so that
+  // responses go out in order.
+  bool awaiting_response_;
+
+  // True if the client did not ask for the connection to be kept alive.
+  bool close_after_response_;
+
+  // True while HttpServer is processing recv_data_.
+  bool processing_;
+
   DISALLOW_COPY_AND_ASSIGN(HttpConnection);
 };
 
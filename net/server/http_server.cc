@@ -4,8 +4,11 @@
 
 #include "net/server/http_server.h"
 
+#include <algorithm>
+
 #include "base/compiler_specific.h"
 #include "base/logging.h"
+#include "base/string_tokenizer.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "base/sys_byteorder.h"
@@ -17,6 +20,37 @@
 
 namespace net {
 
+namespace {
+
+// Requests with larger headers are rejected.
+const size_t kMaxHeadersSize = 256 * 1024;
+
+// Connections that send more than this ahead of the responses are closed.
+// WebSocket messages must fit in it too.
+const size_t kMaxRecvBufferSize = 16 * 1024 * 1024;
+
+// Returns true if the Connection header of |request| lists |value|, ignoring
+// case. |value| must be lower case.
+bool HasConnectionHeader(const HttpServerRequestInfo& request,
+                         const char* value) {
+  for (HttpServerRequestInfo::HeadersMap::const_iterator it =
+           request.headers.begin(); it != request.headers.end(); ++it) {
+    if (!LowerCaseEqualsASCII(it->first, "connection"))
+      continue;
+    StringTokenizer tokens(it->second, ",");
+    while (tokens.GetNext()) {
+      std::string token;
+      TrimWhitespaceASCII(tokens.token(), TRIM_ALL, &token);
+      if (LowerCaseEqualsASCII(token, value))
+        return true;
+    }
+    return false;
+  }
+  return false;
+}
+
+}  // namespace
+
 HttpServer::HttpServer(const std::string& host,
                        int port,
                        HttpServer::Delegate* del)
@@ -63,6 +97,7 @@ void HttpServer::Send200(int connection_id,
   if (connection == NULL)
     return;
   connection->Send200(data, content_type);
+  DidSendResponse(connection);
 }
 
 void HttpServer::Send404(int connection_id) {
@@ -70,6 +105,7 @@ void HttpServer::Send404(int connection_id) {
   if (connection == NULL)
     return;
   connection->Send404();
+  DidSendResponse(connection);
 }
 
 void HttpServer::Send500(int connection_id, const std::string& message) {
@@ -77,6 +113,14 @@ void HttpServer::Send500(int connection_id, const std::string& message) {
   if (connection == NULL)
     return;
   connection->Send500(message);
+  DidSendResponse(connection);
+}
+
+void HttpServer::FinishResponse(int connection_id) {
+  HttpConnection* connection = FindConnection(connection_id);
+  if (connection == NULL)
+    return;
+  DidSendResponse(connection);
 }
 
 void HttpServer::Close(int connection_id)
@@ -152,15 +196,19 @@ int charToInput(char ch) {
   return INPUT_DEFAULT;
 }
 
-bool HttpServer::ParseHeaders(HttpConnection* connection,
-                              HttpServerRequestInfo* info,
-                              size_t* ppos) {
-  size_t& pos = *ppos;
+HttpServer::ParseResult HttpServer::ParseHeaders(HttpConnection* connection) {
+  // The headers may have been parsed already, when a WebSocket handshake is
+  // waiting for more data.  If the previous read ended between their final CR
+  // and LF though, the LF still has to be consumed below.
+  if (connection->parse_state_ == ST_DONE &&
+      connection->recv_data_[connection->parse_pos_ - 1] == '\n')
+    return PARSE_DONE;
+
+  size_t& pos = connection->parse_pos_;
   size_t data_len = connection->recv_data_.length();
-  int state = ST_METHOD;
-  std::string buffer;
-  std::string header_name;
-  std::string header_value;
+  int& state = connection->parse_state_;
+  std::string& buffer = connection->parse_token_;
+  HttpServerRequestInfo* info = &connection->parsed_request_;
   while (pos < data_len) {
     char ch = connection->recv_data_[pos++];
     int input = charToInput(ch);
@@ -179,19 +227,18 @@ bool HttpServer::ParseHeaders(HttpConnection* connection,
           buffer.clear();
           break;
         case ST_PROTO:
-          // TODO(mbelshe): Deal better with parsing protocol.
-          DCHECK(buffer == "HTTP/1.1");
+          connection->parse_protocol_ = buffer;
           buffer.clear();
           break;
         case ST_NAME:
-          header_name = buffer;
+          connection->parse_header_name_ = buffer;
           buffer.clear();
           break;
         case ST_VALUE:
-          header_value = buffer;
           // TODO(mbelshe): Deal better with duplicate headers
-          DCHECK(info->headers.find(header_name) == info->headers.end());
-          info->headers[header_name] = header_value;
+          DCHECK(info->headers.find(connection->parse_header_name_) ==
+                 info->headers.end());
+          info->headers[connection->parse_header_name_] = buffer;
           buffer.clear();
           break;
         case ST_SEPARATOR:
@@ -211,14 +258,16 @@ bool HttpServer::ParseHeaders(HttpConnection* connection,
           break;
         case ST_DONE:
           DCHECK(input == INPUT_LF);
-          return true;
+          return PARSE_DONE;
         case ST_ERR:
-          return false;
+          return PARSE_ERROR;
       }
     }
   }
   // No more characters, but we haven't finished parsing yet.
-  return false;
+  if (state == ST_ERR || pos > kMaxHeadersSize)
+    return PARSE_ERROR;
+  return PARSE_INCOMPLETE;
 }
 
 void HttpServer::DidAccept(ListenSocket* server,
@@ -236,8 +285,25 @@ void HttpServer::DidRead(ListenSocket* socket,
   if (connection == NULL)
     return;
 
+  if (connection->recv_data_.length() + len > kMaxRecvBufferSize) {
+    LOG(WARNING) << "Closing connection " << connection->id()
+                 << ", which sent too much data ahead";
+    Close(connection->id());
+    return;
+  }
   connection->recv_data_.append(data, len);
-  while (connection->recv_data_.length()) {
+  ProcessRecvData(connection);
+}
+
+void HttpServer::ProcessRecvData(HttpConnection* connection) {
+  if (connection->processing_)
+    return;
+  connection->processing_ = true;
+
+  // The delegate may close the connection, so it is looked up again after
+  // each call.
+  const int connection_id = connection->id();
+  while (connection->recv_data_.length() && !connection->awaiting_response_) {
     if (connection->web_socket_.get()) {
       std::string message;
       WebSocket::ParseResult result = connection->web_socket_->Read(&message);
@@ -246,34 +312,79 @@ void HttpServer::DidRead(ListenSocket* socket,
 
       if (result == WebSocket::FRAME_CLOSE ||
           result == WebSocket::FRAME_ERROR) {
-        Close(connection->id());
-        break;
+        Close(connection_id);
+        return;
       }
-      delegate_->OnWebSocketMessage(connection->id(), message);
+      delegate_->OnWebSocketMessage(connection_id, message);
+      connection = FindConnection(connection_id);
+      if (!connection)
+        return;
       continue;
     }
 
-    HttpServerRequestInfo request;
-    size_t pos = 0;
-    if (!ParseHeaders(connection, &request, &pos))
+    ParseResult result = ParseHeaders(connection);
+    if (result == PARSE_INCOMPLETE)
       break;
+    if (result == PARSE_ERROR) {
+      Close(connection_id);
+      return;
+    }
 
-    std::string connection_header = request.GetHeaderValue("Connection");
-    if (connection_header == "Upgrade") {
+    HttpServerRequestInfo request;
+    std::swap(request, connection->parsed_request_);
+    size_t pos = connection->parse_pos_;
+
+    if (HasConnectionHeader(request, "upgrade")) {
       connection->web_socket_.reset(WebSocket::CreateWebSocket(connection,
                                                                request,
                                                                &pos));
 
-      if (!connection->web_socket_.get())  // Not enought data was received.
+      if (!connection->web_socket_.get()) {
+        // Not enough data was received; try again after the next read.
+        std::swap(request, connection->parsed_request_);
         break;
-      delegate_->OnWebSocketRequest(connection->id(), request);
+      }
       connection->Shift(pos);
+      connection->ResetRequestParser();
+      delegate_->OnWebSocketRequest(connection_id, request);
+      connection = FindConnection(connection_id);
+      if (!connection)
+        return;
       continue;
     }
-    // Request body is not supported. It is always empty.
-    delegate_->OnHttpRequest(connection->id(), request);
+
+    if (connection->parse_protocol_ == "HTTP/1.1")
+      connection->close_after_response_ =
+          HasConnectionHeader(request, "close");
+    else
+      connection->close_after_response_ =
+          !HasConnectionHeader(request, "keep-alive");
+    connection->awaiting_response_ = true;
     connection->Shift(pos);
+    connection->ResetRequestParser();
+
+    // Request body is not supported. It is always empty.
+    delegate_->OnHttpRequest(connection_id, request);
+    connection = FindConnection(connection_id);
+    if (!connection)
+      return;
+  }
+  connection->processing_ = false;
+}
+
+void HttpServer::DidSendResponse(HttpConnection* connection) {
+  if (!connection->awaiting_response_)
+    return;
+  connection->awaiting_response_ = false;
+
+  if (connection->close_after_response_) {
+    Close(connection->id());
+    return;
   }
+  // Pick up requests that were pipelined behind this one.  When the response
+  // is sent from within OnHttpRequest, ProcessRecvData() is already running
+  // and continues by itself.
+  ProcessRecvData(connection);
 }
 
 void HttpServer::DidClose(ListenSocket* socket) {
@@ -49,18 +49,29 @@ class HttpServer : public ListenSocket::ListenSocketDelegate,
   void AcceptWebSocket(int connection_id,
                        const HttpServerRequestInfo& request);
   void SendOverWebSocket(int connection_id, const std::string& data);
+
+  // Sends part of a response. FinishResponse() must be called once all of it
+  // has been sent.
   void Send(int connection_id, const std::string& data);
   void Send(int connection_id, const char* bytes, int len);
+
+  // Sends a whole response.
   void Send200(int connection_id,
                const std::string& data,
                const std::string& mime_type);
   void Send404(int connection_id);
   void Send500(int connection_id, const std::string& message);
+
+  // Ends a response sent with Send(). The connection is closed if the client
+  // asked for that, otherwise the next request on it is handled.
+  void FinishResponse(int connection_id);
+
   void Close(int connection_id);
 
 private:
   friend class base::RefCountedThreadSafe<HttpServer>;
   friend class HttpConnection;
+  friend class HttpServerTest;
 
   // ListenSocketDelegate
   virtual void DidAccept(ListenSocket* server, ListenSocket* socket) OVERRIDE;
@@ -69,12 +80,23 @@ private:
                        int len) OVERRIDE;
   virtual void DidClose(ListenSocket* socket) OVERRIDE;
 
-  // Expects the raw data to be stored in recv_data_. If parsing is successful,
-  // will remove the data parsed from recv_data_, leaving only the unused
-  // recv data.
-  bool ParseHeaders(HttpConnection* connection,
-                    HttpServerRequestInfo* info,
-                    size_t* pos);
+  enum ParseResult {
+    PARSE_INCOMPLETE,
+    PARSE_DONE,
+    PARSE_ERROR,
+  };
+
+  // Parses the request at the start of |connection|'s recv_data_, resuming
+  // where the previous call stopped.  Once it returns PARSE_DONE, the request
+  // is in parsed_request_ and its headers end at parse_pos_.
+  ParseResult ParseHeaders(HttpConnection* connection);
+
+  // Handles the requests and WebSocket frames buffered in |connection|, as
+  // far as possible.
+  void ProcessRecvData(HttpConnection* connection);
+
+  // Called after the whole response to a request on |connection| is sent.
+  void DidSendResponse(HttpConnection* connection);
 
   HttpConnection* FindConnection(int connection_id);
   HttpConnection* FindConnection(ListenSocket* socket);
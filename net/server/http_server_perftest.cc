@@ -0,0 +1,240 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/eintr_wrapper.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "base/time.h"
+#include "net/server/http_server.h"
+#include "net/server/http_server_request_info.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kConnections = 1000;
+const int kRequestsPerConnection = 50;
+const char kRequest[] =
+    "GET /json/version HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "\r\n";
+const char kResponseBody[] = "{\"Browser\": \"Chrome\"}";
+
+// Answers every request at once, as the automation endpoints do.
+class ImmediateDelegate : public HttpServer::Delegate {
+ public:
+  ImmediateDelegate() : server_(NULL) {}
+  virtual ~ImmediateDelegate() {}
+
+  void set_server(HttpServer* server) { server_ = server; }
+
+  virtual void OnHttpRequest(int connection_id,
+                             const HttpServerRequestInfo& info) OVERRIDE {
+    server_->Send200(connection_id, kResponseBody, "application/json");
+  }
+  virtual void OnWebSocketRequest(int connection_id,
+                                  const HttpServerRequestInfo& info) OVERRIDE {}
+  virtual void OnWebSocketMessage(int connection_id,
+                                  const std::string& data) OVERRIDE {}
+  virtual void OnClose(int connection_id) OVERRIDE {}
+
+ private:
+  HttpServer* server_;
+};
+
+// Returns a loopback port that was free a moment ago.
+int PickPort() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  socklen_t addr_len = sizeof(addr);
+  int port = 0;
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+      getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0) {
+    port = ntohs(addr.sin_port);
+  }
+  close(fd);
+  return port;
+}
+
+// One client connection, sending its requests one after the other on a
+// kept-alive connection.
+struct Client {
+  Client() : fd(-1), sent(0), completed(0) {}
+
+  int fd;
+  int sent;
+  int completed;
+  base::TimeTicks request_time;
+  std::string response;
+};
+
+// Returns the length of the first complete response in |data|, or 0.
+size_t CompleteResponseLength(const std::string& data) {
+  size_t headers_end = data.find("\r\n\r\n");
+  if (headers_end == std::string::npos)
+    return 0;
+  size_t length_pos = data.find("Content-Length:");
+  if (length_pos == std::string::npos || length_pos > headers_end)
+    return 0;
+  size_t total = headers_end + 4 +
+      atoi(data.c_str() + length_pos + strlen("Content-Length:"));
+  return data.size() >= total ? total : 0;
+}
+
+class HttpServerPerfTest : public testing::Test {
+ protected:
+  HttpServerPerfTest() : server_thread_("HttpServerPerfTest") {}
+
+  virtual void SetUp() {
+    // Each connection needs a descriptor on both ends.
+    rlimit limit;
+    ASSERT_EQ(0, getrlimit(RLIMIT_NOFILE, &limit));
+    if (limit.rlim_cur < static_cast<rlim_t>(3 * kConnections)) {
+      limit.rlim_cur = std::min(limit.rlim_max,
+                                static_cast<rlim_t>(3 * kConnections));
+      setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    port_ = PickPort();
+    ASSERT_NE(0, port_);
+    base::Thread::Options options(MessageLoop::TYPE_IO, 0);
+    ASSERT_TRUE(server_thread_.StartWithOptions(options));
+    base::WaitableEvent started(false, false);
+    server_thread_.message_loop()->PostTask(
+        FROM_HERE, base::Bind(&HttpServerPerfTest::StartServer,
+                              base::Unretained(this), &started));
+    started.Wait();
+  }
+
+  virtual void TearDown() {
+    if (!server_thread_.IsRunning())
+      return;
+    server_thread_.message_loop()->PostTask(
+        FROM_HERE, base::Bind(&HttpServerPerfTest::StopServer,
+                              base::Unretained(this)));
+    server_thread_.Stop();
+  }
+
+  void StartServer(base::WaitableEvent* started) {
+    server_ = new HttpServer("127.0.0.1", port_, &delegate_);
+    delegate_.set_server(server_);
+    started->Signal();
+  }
+
+  void StopServer() {
+    server_ = NULL;
+  }
+
+  int port_;
+  base::Thread server_thread_;
+  ImmediateDelegate delegate_;
+  scoped_refptr<HttpServer> server_;
+};
+
+}  // namespace
+
+TEST_F(HttpServerPerfTest, ConcurrentKeepAliveClients) {
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port_);
+
+  std::vector<Client> clients(kConnections);
+  std::vector<pollfd> poll_fds(kConnections);
+  for (int i = 0; i < kConnections; ++i) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(fd, 0) << "Out of file descriptors";
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    int rv = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ASSERT_TRUE(rv == 0 || errno == EINPROGRESS);
+    clients[i].fd = fd;
+    poll_fds[i].fd = fd;
+    poll_fds[i].events = POLLOUT;
+  }
+
+  std::vector<double> latencies_ms;
+  latencies_ms.reserve(kConnections * kRequestsPerConnection);
+  int remaining = kConnections;
+  char buf[4096];
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  while (remaining > 0) {
+    int ready = HANDLE_EINTR(poll(&poll_fds[0], poll_fds.size(), 10000));
+    ASSERT_GT(ready, 0) << "Timed out waiting for the server";
+    for (int i = 0; i < kConnections; ++i) {
+      Client& client = clients[i];
+      pollfd& poll_fd = poll_fds[i];
+      if (!poll_fd.revents)
+        continue;
+      ASSERT_FALSE(poll_fd.revents & (POLLERR | POLLHUP | POLLNVAL));
+
+      if ((poll_fd.revents & POLLOUT) && client.sent == client.completed) {
+        client.request_time = base::TimeTicks::Now();
+        ASSERT_EQ(static_cast<ssize_t>(arraysize(kRequest) - 1),
+                  HANDLE_EINTR(write(client.fd, kRequest,
+                                     arraysize(kRequest) - 1)));
+        ++client.sent;
+        poll_fd.events = POLLIN;
+        continue;
+      }
+
+      if (!(poll_fd.revents & POLLIN))
+        continue;
+      ssize_t len = HANDLE_EINTR(read(client.fd, buf, sizeof(buf)));
+      ASSERT_GT(len, 0) << "The server closed a kept-alive connection";
+      client.response.append(buf, len);
+      size_t response_length = CompleteResponseLength(client.response);
+      if (!response_length)
+        continue;
+      client.response.erase(0, response_length);
+      latencies_ms.push_back(
+          (base::TimeTicks::Now() - client.request_time).InMillisecondsF());
+      if (++client.completed == kRequestsPerConnection) {
+        close(client.fd);
+        poll_fd.fd = -1;
+        --remaining;
+      } else {
+        poll_fd.events = POLLOUT;
+      }
+    }
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  ASSERT_EQ(static_cast<size_t>(kConnections * kRequestsPerConnection),
+            latencies_ms.size());
+  LogPerfResult("HttpServer_requests_per_second",
+                latencies_ms.size() / elapsed.InSecondsF(), "requests/s");
+  LogPerfResult("HttpServer_p50_latency",
+                latencies_ms[latencies_ms.size() / 2], "ms");
+  LogPerfResult("HttpServer_p99_latency",
+                latencies_ms[latencies_ms.size() * 99 / 100], "ms");
+}
+
+}  // namespace net
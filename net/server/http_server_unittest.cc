@@ -0,0 +1,223 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop.h"
+#include "net/base/listen_socket.h"
+#include "net/server/http_server.h"
+#include "net/server/http_server_request_info.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const char kRequest[] =
+    "GET /json HTTP/1.1\r\n"
+    "Host: 127.0.0.1\r\n"
+    "\r\n";
+
+// Records what the server sends to a connection.
+class FakeSocket : public ListenSocket {
+ public:
+  FakeSocket() : ListenSocket(NULL) {}
+
+  const std::string& sent() const { return sent_; }
+
+ protected:
+  virtual void SendInternal(const char* bytes, int len) OVERRIDE {
+    sent_.append(bytes, len);
+  }
+
+ private:
+  virtual ~FakeSocket() {}
+
+  std::string sent_;
+};
+
+class RecordingDelegate : public HttpServer::Delegate {
+ public:
+  RecordingDelegate() {}
+
+  virtual void OnHttpRequest(int connection_id,
+                             const HttpServerRequestInfo& info) OVERRIDE {
+    connection_ids_.push_back(connection_id);
+    requests_.push_back(info);
+  }
+  virtual void OnWebSocketRequest(int connection_id,
+                                  const HttpServerRequestInfo& info) OVERRIDE {}
+  virtual void OnWebSocketMessage(int connection_id,
+                                  const std::string& data) OVERRIDE {}
+  virtual void OnClose(int connection_id) OVERRIDE {
+    closed_ids_.push_back(connection_id);
+  }
+
+  const std::vector<int>& connection_ids() const { return connection_ids_; }
+  const std::vector<HttpServerRequestInfo>& requests() const {
+    return requests_;
+  }
+  const std::vector<int>& closed_ids() const { return closed_ids_; }
+
+ private:
+  std::vector<int> connection_ids_;
+  std::vector<HttpServerRequestInfo> requests_;
+  std::vector<int> closed_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingDelegate);
+};
+
+}  // namespace
+
+// Feeds data to HttpServer as if it had been read from |socket_|, so that
+// the tests control how requests are split between reads.
+class HttpServerTest : public testing::Test {
+ protected:
+  HttpServerTest() : socket_(new FakeSocket) {}
+
+  virtual void SetUp() OVERRIDE {
+    server_ = new HttpServer("127.0.0.1", 0, &delegate_);
+    server_->DidAccept(NULL, socket_);
+  }
+
+  void Read(const std::string& data) {
+    server_->DidRead(socket_, data.data(), static_cast<int>(data.size()));
+  }
+
+  bool IsClosed() const { return !delegate_.closed_ids().empty(); }
+
+  int last_connection_id() const {
+    return delegate_.connection_ids().back();
+  }
+
+  MessageLoopForIO message_loop_;
+  RecordingDelegate delegate_;
+  scoped_refptr<FakeSocket> socket_;
+  scoped_refptr<HttpServer> server_;
+};
+
+TEST_F(HttpServerTest, ParsesRequestSplitAcrossReads) {
+  std::string request(kRequest);
+  for (size_t i = 0; i + 1 < request.size(); ++i) {
+    Read(request.substr(i, 1));
+    EXPECT_TRUE(delegate_.requests().empty()) << "after byte " << i;
+  }
+  Read(request.substr(request.size() - 1));
+
+  ASSERT_EQ(1u, delegate_.requests().size());
+  EXPECT_EQ("GET", delegate_.requests()[0].method);
+  EXPECT_EQ("/json", delegate_.requests()[0].path);
+  EXPECT_EQ("127.0.0.1", delegate_.requests()[0].headers["Host"]);
+  EXPECT_FALSE(IsClosed());
+}
+
+// Tests that a read ending between the CR and LF that end the headers
+// doesn't leave the LF in front of the next request.
+TEST_F(HttpServerTest, ReadEndsBeforeFinalLineFeed) {
+  std::string request(kRequest);
+  Read(request.substr(0, request.size() - 1));
+  EXPECT_TRUE(delegate_.requests().empty());
+  Read(request.substr(request.size() - 1) + kRequest);
+  ASSERT_EQ(1u, delegate_.requests().size());
+
+  server_->Send200(last_connection_id(), "first", "text/plain");
+  ASSERT_EQ(2u, delegate_.requests().size());
+  EXPECT_EQ("/json", delegate_.requests()[1].path);
+  EXPECT_FALSE(IsClosed());
+}
+
+TEST_F(HttpServerTest, KeepsHttp11ConnectionAlive) {
+  Read(kRequest);
+  ASSERT_EQ(1u, delegate_.requests().size());
+  server_->Send200(last_connection_id(), "first", "text/plain");
+  EXPECT_FALSE(IsClosed());
+
+  Read(kRequest);
+  ASSERT_EQ(2u, delegate_.requests().size());
+  EXPECT_EQ(delegate_.connection_ids()[0], delegate_.connection_ids()[1]);
+  server_->Send200(last_connection_id(), "second", "text/plain");
+  EXPECT_FALSE(IsClosed());
+}
+
+TEST_F(HttpServerTest, ClosesWhenAskedTo) {
+  Read("GET / HTTP/1.1\r\n"
+       "Connection: keep-alive, Close\r\n"
+       "\r\n");
+  ASSERT_EQ(1u, delegate_.requests().size());
+  EXPECT_FALSE(IsClosed());
+  server_->Send404(last_connection_id());
+  EXPECT_TRUE(IsClosed());
+}
+
+TEST_F(HttpServerTest, ClosesHttp10ConnectionUnlessKeptAlive) {
+  Read("GET / HTTP/1.0\r\n"
+       "Connection: Keep-Alive\r\n"
+       "\r\n");
+  ASSERT_EQ(1u, delegate_.requests().size());
+  server_->Send200(last_connection_id(), "kept", "text/plain");
+  EXPECT_FALSE(IsClosed());
+
+  Read("GET / HTTP/1.0\r\n"
+       "\r\n");
+  ASSERT_EQ(2u, delegate_.requests().size());
+  server_->Send200(last_connection_id(), "closed", "text/plain");
+  EXPECT_TRUE(IsClosed());
+}
+
+TEST_F(HttpServerTest, AnswersPipelinedRequestsInOrder) {
+  Read(std::string(kRequest) +
+       "GET /second HTTP/1.1\r\n"
+       "\r\n");
+  // The second request waits until the first is answered.
+  ASSERT_EQ(1u, delegate_.requests().size());
+
+  int connection_id = last_connection_id();
+  server_->Send(connection_id, "HTTP/1.1 200 OK\r\n");
+  EXPECT_EQ(1u, delegate_.requests().size());
+  server_->Send(connection_id, "Content-Length: 0\r\n\r\n");
+  server_->FinishResponse(connection_id);
+  ASSERT_EQ(2u, delegate_.requests().size());
+  EXPECT_EQ("/second", delegate_.requests()[1].path);
+
+  server_->Send404(connection_id);
+  EXPECT_EQ("HTTP/1.1 200 OK\r\n"
+            "Content-Length: 0\r\n"
+            "\r\n"
+            "HTTP/1.1 404 Not Found\r\n"
+            "Content-Length: 0\r\n"
+            "\r\n",
+            socket_->sent());
+  EXPECT_FALSE(IsClosed());
+}
+
+TEST_F(HttpServerTest, ClosesOnMalformedRequest) {
+  Read("GET\r\n\r\n");
+  EXPECT_TRUE(delegate_.requests().empty());
+  EXPECT_TRUE(IsClosed());
+}
+
+TEST_F(HttpServerTest, ClosesOnOversizedHeaders) {
+  // The server accepts up to 256KB of headers.
+  Read("GET / HTTP/1.1\r\n"
+       "X-Padding: " + std::string(256 * 1024, 'a'));
+  EXPECT_TRUE(delegate_.requests().empty());
+  EXPECT_TRUE(IsClosed());
+}
+
+TEST_F(HttpServerTest, ClosesWhenTooMuchIsSentAhead) {
+  // Requests pipelined behind an unanswered one are buffered up to 16MB.
+  Read(kRequest);
+  ASSERT_EQ(1u, delegate_.requests().size());
+  std::string requests;
+  while (requests.size() <= 16 * 1024 * 1024)
+    requests += kRequest;
+  Read(requests);
+  EXPECT_EQ(1u, delegate_.requests().size());
+  EXPECT_TRUE(IsClosed());
+}
+
+}  // namespace net
@@ -296,9 +296,8 @@ int SpdyHttpStream::OnSendBodyComplete(int status, bool* eof) {
 
   request_body_stream_->MarkConsumedAndFillBuffer(status);
   *eof = request_body_stream_->eof();
-  if (!*eof &&
-      request_body_stream_->is_chunked() &&
-      !request_body_stream_->buf_len())
+  // Wait for more chunks, or for file data that is still being read.
+  if (!*eof && !request_body_stream_->buf_len())
     return ERR_IO_PENDING;
 
   return OK;
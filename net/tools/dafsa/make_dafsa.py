@@ -0,0 +1,259 @@
+#!/usr/bin/env python
+# Copyright (c) 2012 The Chromium Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Converts effective_tld_names.gperf into a DAFSA for registry lookups.
+
+The rules are reversed ("co.uk" becomes "ku.oc") and stored in a
+deterministic acyclic finite state automaton, so that a host can be matched
+from its last character towards its first, finding every rule that is a
+suffix of the host in a single pass.
+
+The graph is emitted as a byte array of nodes of two kinds:
+
+  branch  one byte holding the rule type + 1 of the rule ending here (the
+          type is 0 for a plain rule, 1 for an exception and 2 for a
+          wildcard; 0 means that no rule ends here), a 40-bit little-endian
+          bitmap of the characters leading to children, indexed by
+          ALPHABET, and then the offset of each child as a little-endian
+          uint16, in the order of the bitmap.  A lookup finds its child by
+          counting the bits below the one for its character.
+  chain   a run of nodes that each have a single child, one parent and no
+          rule, folded together: 0x80, the characters leading through the
+          run (the last with its high bit set) and the uint16 offset of the
+          node at its end.
+
+Offsets are relative to the start of the node that holds them, and the
+array ends with padding so that a bitmap can be read as a uint64.  Nodes are
+laid out breadth first, so the top levels of the graph that every lookup
+visits share a few cache lines, and every offset points forward.
+"""
+
+import sys
+
+# Must match CharIndex() in net/base/registry_controlled_domain.cc.
+ALPHABET = 'abcdefghijklmnopqrstuvwxyz0123456789-.'
+BITMAP_BYTES = 5
+
+
+class Node(object):
+  def __init__(self):
+    self.type = -1
+    self.children = {}
+
+
+def ParseGperf(lines):
+  """Returns (name, type) for each rule between the %% markers."""
+  rules = []
+  in_rules = False
+  for line in lines:
+    line = line.strip()
+    if line == '%%':
+      if in_rules:
+        break
+      in_rules = True
+      continue
+    if not in_rules or not line:
+      continue
+    name, rule_type = line.split(',')
+    rule_type = int(rule_type)
+    if rule_type not in (0, 1, 2):
+      raise ValueError('Unknown rule type in: ' + line)
+    name = name.strip()
+    for char in name:
+      if char not in ALPHABET:
+        raise ValueError('Unexpected character in: ' + line)
+    rules.append((name, rule_type))
+  return rules
+
+
+def BuildTrie(rules):
+  root = Node()
+  for name, rule_type in rules:
+    node = root
+    for char in reversed(name):
+      node = node.children.setdefault(char, Node())
+    node.type = rule_type
+  return root
+
+
+def Minimize(root):
+  """Merges equivalent subtrees, turning the trie into a DAFSA."""
+  registry = {}
+
+  def Visit(node):
+    for char in node.children:
+      node.children[char] = Visit(node.children[char])
+    key = (node.type, tuple(sorted(
+        (char, id(child)) for char, child in node.children.items())))
+    return registry.setdefault(key, node)
+
+  return Visit(root)
+
+
+def CountParents(root):
+  in_degree = {id(root): 0}
+  seen = set()
+  stack = [root]
+  while stack:
+    node = stack.pop()
+    if id(node) in seen:
+      continue
+    seen.add(id(node))
+    for child in node.children.values():
+      in_degree[id(child)] = in_degree.get(id(child), 0) + 1
+      stack.append(child)
+  return in_degree
+
+
+class Chain(object):
+  def __init__(self, label, target):
+    self.label = label
+    self.target = target
+
+
+def Compress(root):
+  """Replaces each run of single-child nodes with a Chain."""
+  in_degree = CountParents(root)
+
+  def IsLink(node):
+    return (node.type == -1 and len(node.children) == 1 and
+            in_degree[id(node)] == 1)
+
+  done = set()
+  stack = [root]
+  while stack:
+    node = stack.pop()
+    if id(node) in done:
+      continue
+    done.add(id(node))
+    for char in sorted(node.children):
+      child = node.children[char]
+      if IsLink(child):
+        label = ''
+        while IsLink(child):
+          next_char = list(child.children.keys())[0]
+          label += next_char
+          child = child.children[next_char]
+        node.children[char] = Chain(label, child)
+      stack.append(child)
+  return root
+
+
+def SortedChars(node):
+  return sorted(node.children, key=ALPHABET.index)
+
+
+def Successors(node):
+  if isinstance(node, Chain):
+    return [node.target]
+  return [node.children[char] for char in SortedChars(node)]
+
+
+def Layout(root):
+  """Orders nodes breadth first, keeping every offset pointing forward."""
+  in_degree = {}
+  seen = set()
+  stack = [root]
+  while stack:
+    node = stack.pop()
+    if id(node) in seen:
+      continue
+    seen.add(id(node))
+    for child in Successors(node):
+      in_degree[id(child)] = in_degree.get(id(child), 0) + 1
+      stack.append(child)
+  order = []
+  queue = [root]
+  while queue:
+    node = queue.pop(0)
+    order.append(node)
+    for child in Successors(node):
+      in_degree[id(child)] -= 1
+      if not in_degree[id(child)]:
+        queue.append(child)
+  return order
+
+
+def Size(node):
+  if isinstance(node, Chain):
+    return 1 + len(node.label) + 2
+  return 1 + BITMAP_BYTES + 2 * len(node.children)
+
+
+def Encode(order):
+  positions = {}
+  position = 0
+  for node in order:
+    positions[id(node)] = position
+    position += Size(node)
+
+  def Offset(node, child):
+    offset = positions[id(child)] - positions[id(node)]
+    if not 0 < offset < 0x10000:
+      raise ValueError('Graph is too large for 16-bit offsets')
+    return [offset & 0xff, offset >> 8]
+
+  output = []
+  for node in order:
+    if isinstance(node, Chain):
+      output.append(0x80)
+      output.extend(ord(char) for char in node.label[:-1])
+      output.append(ord(node.label[-1]) | 0x80)
+      output.extend(Offset(node, node.target))
+      continue
+    chars = SortedChars(node)
+    bitmap = 0
+    for char in chars:
+      bitmap |= 1 << ALPHABET.index(char)
+    output.append(node.type + 1)
+    output.extend((bitmap >> (8 * i)) & 0xff for i in range(BITMAP_BYTES))
+    for char in chars:
+      output.extend(Offset(node, node.children[char]))
+  # The lookup reads each bitmap as a uint64.
+  output.extend([0] * (8 - BITMAP_BYTES))
+  return output
+
+
+def WriteSource(graph, output):
+  output.write(
+      '// Copyright (c) 2012 The Chromium Authors. All rights reserved.\n'
+      '// Use of this source code is governed by a BSD-style license that '
+      'can be\n'
+      '// found in the LICENSE file.\n'
+      '\n'
+      '// This file is generated by net/tools/dafsa/make_dafsa.py.\n'
+      '// DO NOT MANUALLY EDIT!\n'
+      '\n'
+      '#include "net/base/registry_controlled_domain.h"\n'
+      '\n'
+      'namespace net {\n'
+      '\n'
+      'const unsigned char RegistryControlledDomainService::kGraph[] = {\n')
+  for i in range(0, len(graph), 12):
+    output.write('  ' + ' '.join(
+        '0x%02x,' % byte for byte in graph[i:i + 12]) + '\n')
+  output.write(
+      '};\n'
+      '\n'
+      'const size_t RegistryControlledDomainService::kGraphSize = %d;\n'
+      '\n'
+      '}  // namespace net\n' % len(graph))
+
+
+def main(argv):
+  if len(argv) != 3:
+    sys.stderr.write('Usage: %s <gperf file> <output .cc file>\n' % argv[0])
+    return 1
+  with open(argv[1]) as gperf:
+    rules = ParseGperf(gperf.readlines())
+  root = Compress(Minimize(BuildTrie(rules)))
+  graph = Encode(Layout(root))
+  with open(argv[2], 'w') as output:
+    WriteSource(graph, output)
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main(sys.argv))
@@ -0,0 +1,182 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This utility converts a capture written by net::NetLogBinaryCapture into
+// the JSON log format that chrome://net-internals can load.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+#include "base/string_number_conversions.h"
+#include "base/values.h"
+#include "net/base/address_family.h"
+#include "net/base/net_log.h"
+#include "net/base/net_log_binary_capture.h"
+
+namespace {
+
+// The subset of the net-internals constants that describes a log.
+Value* GetConstants(int64 tick_to_unix_time_ms) {
+  DictionaryValue* constants = new DictionaryValue();
+
+  DictionaryValue* event_types = new DictionaryValue();
+  std::vector<net::NetLog::EventType> all_event_types =
+      net::NetLog::GetAllEventTypes();
+  for (size_t i = 0; i < all_event_types.size(); ++i) {
+    event_types->SetInteger(
+        net::NetLog::EventTypeToString(all_event_types[i]),
+        static_cast<int>(all_event_types[i]));
+  }
+  constants->Set("logEventTypes", event_types);
+
+  DictionaryValue* load_flags = new DictionaryValue();
+#define LOAD_FLAG(label, value) \
+  load_flags->SetInteger(# label, static_cast<int>(value));
+#include "net/base/load_flags_list.h"
+#undef LOAD_FLAG
+  constants->Set("loadFlag", load_flags);
+
+  DictionaryValue* net_errors = new DictionaryValue();
+#define NET_ERROR(label, value) \
+  net_errors->SetInteger(# label, static_cast<int>(value));
+#include "net/base/net_error_list.h"
+#undef NET_ERROR
+  constants->Set("netError", net_errors);
+
+  DictionaryValue* phases = new DictionaryValue();
+  phases->SetInteger("PHASE_BEGIN", net::NetLog::PHASE_BEGIN);
+  phases->SetInteger("PHASE_END", net::NetLog::PHASE_END);
+  phases->SetInteger("PHASE_NONE", net::NetLog::PHASE_NONE);
+  constants->Set("logEventPhase", phases);
+
+  DictionaryValue* source_types = new DictionaryValue();
+#define SOURCE_TYPE(label, value) source_types->SetInteger(# label, value);
+#include "net/base/net_log_source_type_list.h"
+#undef SOURCE_TYPE
+  constants->Set("logSourceType", source_types);
+
+  DictionaryValue* log_levels = new DictionaryValue();
+  log_levels->SetInteger("LOG_ALL", net::NetLog::LOG_ALL);
+  log_levels->SetInteger("LOG_ALL_BUT_BYTES", net::NetLog::LOG_ALL_BUT_BYTES);
+  log_levels->SetInteger("LOG_BASIC", net::NetLog::LOG_BASIC);
+  constants->Set("logLevelType", log_levels);
+
+  DictionaryValue* address_families = new DictionaryValue();
+  address_families->SetInteger("ADDRESS_FAMILY_UNSPECIFIED",
+                               net::ADDRESS_FAMILY_UNSPECIFIED);
+  address_families->SetInteger("ADDRESS_FAMILY_IPV4",
+                               net::ADDRESS_FAMILY_IPV4);
+  address_families->SetInteger("ADDRESS_FAMILY_IPV6",
+                               net::ADDRESS_FAMILY_IPV6);
+  constants->Set("addressFamily", address_families);
+
+  // Pass it as a string, since it may be too large to fit in an integer.
+  constants->SetString("timeTickOffset",
+                       base::Int64ToString(tick_to_unix_time_ms));
+  return constants;
+}
+
+// Converts the capture in |input| to JSON.  Returns false if it is malformed.
+bool Convert(const std::string& input, std::string* output) {
+  Pickle pickle(input.data(), input.size());
+  void* iter = NULL;
+  uint32 magic;
+  int version;
+  int64 tick_to_unix_time_ms;
+  int count;
+  if (!pickle.ReadUInt32(&iter, &magic) ||
+      magic != net::NetLogBinaryCapture::kMagic ||
+      !pickle.ReadInt(&iter, &version) ||
+      version != net::NetLogBinaryCapture::kVersion ||
+      !pickle.ReadInt64(&iter, &tick_to_unix_time_ms) ||
+      !pickle.ReadInt(&iter, &count) || count < 0) {
+    return false;
+  }
+
+  scoped_ptr<Value> constants(GetConstants(tick_to_unix_time_ms));
+  std::string json;
+  base::JSONWriter::Write(constants.get(), false, &json);
+  output->assign("{\"constants\": ");
+  output->append(json);
+  output->append(",\n\"events\": [\n");
+
+  for (int i = 0; i < count; ++i) {
+    int type;
+    int phase;
+    int source_type;
+    uint32 source_id;
+    int64 time_us;
+    std::string params_json;
+    if (!pickle.ReadInt(&iter, &type) ||
+        !pickle.ReadInt(&iter, &phase) ||
+        !pickle.ReadInt(&iter, &source_type) ||
+        !pickle.ReadUInt32(&iter, &source_id) ||
+        !pickle.ReadInt64(&iter, &time_us) ||
+        !pickle.ReadString(&iter, &params_json)) {
+      return false;
+    }
+
+    // Same layout as NetLog::EntryToDictionaryValue() with numeric ids.
+    DictionaryValue entry;
+    entry.SetString("time", base::Int64ToString(time_us / 1000));
+    DictionaryValue* source = new DictionaryValue();
+    source->SetInteger("id", source_id);
+    source->SetInteger("type", source_type);
+    entry.Set("source", source);
+    entry.SetInteger("type", type);
+    entry.SetInteger("phase", phase);
+    if (!params_json.empty()) {
+      Value* params = base::JSONReader::Read(params_json, false);
+      if (!params)
+        return false;
+      entry.Set("params", params);
+    }
+
+    base::JSONWriter::Write(&entry, false, &json);
+    output->append(json);
+    output->append(i + 1 < count ? ",\n" : "\n");
+  }
+
+  output->append("]}\n");
+  return true;
+}
+
+}  // namespace
+
+#if defined(OS_WIN)
+int wmain(int argc, wchar_t* argv[], wchar_t* envp[]) {
+#elif defined(OS_POSIX)
+int main(int argc, char* argv[], char* envp[]) {
+#endif
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <binary capture> <output .json file>\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::string input;
+  if (!file_util::ReadFileToString(FilePath(argv[1]), &input)) {
+    fprintf(stderr, "Failed to read input file '%s'\n", argv[1]);
+    return 2;
+  }
+
+  std::string output;
+  if (!Convert(input, &output)) {
+    fprintf(stderr, "'%s' is not a valid NetLog capture\n", argv[1]);
+    return 3;
+  }
+
+  if (file_util::WriteFile(FilePath(argv[2]), output.data(),
+      output.size()) == static_cast<int>(output.size()))
+    return 0;
+  fprintf(stderr, "Failed to write output file '%s'\n", argv[2]);
+  return 4;
+}
@@ -22,10 +22,43 @@
 #include "logging.h"
 #include "rolling_hash.h"
 
+// SSE2 is part of the x86-64 baseline and of any x86 build that targets it,
+// so it can be used whenever the compiler says it is available.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VCDIFF_USE_SSE2 1
+#include <emmintrin.h>
+#endif  // __SSE2__ || _M_X64 || _M_IX86_FP >= 2
+
 namespace open_vcdiff {
 
 typedef unsigned long uword_t;  // a machine word                         NOLINT
 
+// Match extension compares this many bytes at a time before falling back to
+// a byte loop to locate the first mismatch.
+#ifdef VCDIFF_USE_SSE2
+static const int kCompareChunkSize = 16;
+#else
+static const int kCompareChunkSize = sizeof(uword_t);
+#endif  // VCDIFF_USE_SSE2
+
+// Returns true if the kCompareChunkSize bytes at chunk1 and chunk2 are equal.
+// Either pointer may be unaligned.
+static inline bool ChunksMatch(const char* chunk1, const char* chunk2) {
+#ifdef VCDIFF_USE_SSE2
+  const __m128i value1 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk1));
+  const __m128i value2 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk2));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(value1, value2)) == 0xFFFF;
+#else
+  uword_t word1, word2;
+  memcpy(&word1, chunk1, sizeof(word1));
+  memcpy(&word2, chunk2, sizeof(word2));
+  return word1 == word2;
+#endif  // VCDIFF_USE_SSE2
+}
+
 BlockHash::BlockHash(const char* source_data,
                      size_t source_size,
                      int starting_offset)
@@ -284,9 +317,14 @@ inline bool BlockContentsMatchInline(const char* block1, const char* block2) {
   if (*block1 != *block2) {
     return false;
   }
-#ifdef VCDIFF_USE_BLOCK_COMPARE_WORDS
+#if defined(VCDIFF_USE_SSE2)
+  // A whole block is exactly one SSE2 compare.
+  VCD_COMPILE_ASSERT(BlockHash::kBlockSize == kCompareChunkSize,
+                     kBlockSize_must_match_SSE2_register_width);
+  return ChunksMatch(block1, block2);
+#elif defined(VCDIFF_USE_BLOCK_COMPARE_WORDS)
   return BlockCompareWordsInline(block1, block2);
-#else  // !VCDIFF_USE_BLOCK_COMPARE_WORDS
+#else  // !VCDIFF_USE_SSE2 && !VCDIFF_USE_BLOCK_COMPARE_WORDS
   return memcmp(block1, block2, BlockHash::kBlockSize) == 0;
 #endif  // VCDIFF_USE_BLOCK_COMPARE_WORDS
 }
@@ -353,6 +391,14 @@ int BlockHash::MatchingBytesToLeft(const char* source_match_start,
   const char* source_ptr = source_match_start;
   const char* target_ptr = target_match_start;
   int bytes_found = 0;
+  // Skip over whole chunks that match, then find the mismatch bytewise.
+  while ((max_bytes - bytes_found >= kCompareChunkSize) &&
+         ChunksMatch(source_ptr - kCompareChunkSize,
+                     target_ptr - kCompareChunkSize)) {
+    source_ptr -= kCompareChunkSize;
+    target_ptr -= kCompareChunkSize;
+    bytes_found += kCompareChunkSize;
+  }
   while (bytes_found < max_bytes) {
     --source_ptr;
     --target_ptr;
@@ -374,6 +420,13 @@ int BlockHash::MatchingBytesToRight(const char* source_match_end,
   const char* source_ptr = source_match_end;
   const char* target_ptr = target_match_end;
   int bytes_found = 0;
+  // Skip over whole chunks that match, then find the mismatch bytewise.
+  while ((max_bytes - bytes_found >= kCompareChunkSize) &&
+         ChunksMatch(source_ptr, target_ptr)) {
+    source_ptr += kCompareChunkSize;
+    target_ptr += kCompareChunkSize;
+    bytes_found += kCompareChunkSize;
+  }
   while ((bytes_found < max_bytes) && (*source_ptr == *target_ptr)) {
     ++bytes_found;
     ++source_ptr;
@@ -62,5 +62,45 @@
         [ 'OS == "win"', { 'include_dirs': [ 'open-vcdiff/vsprojects' ] } ],
       ],
     },
+    {
+      # The encoder front end. Chrome only decodes, so only the benchmark
+      # links it.
+      'target_name': 'sdch_encoder',
+      'type': 'static_library',
+      'dependencies': [
+        'sdch',
+      ],
+      'export_dependent_settings': [
+        'sdch',
+      ],
+      'sources': [
+        'open-vcdiff/src/codetablewriter_interface.h',
+        'open-vcdiff/src/google/format_extension_flags.h',
+        'open-vcdiff/src/google/vcencoder.h',
+        'open-vcdiff/src/jsonwriter.cc',
+        'open-vcdiff/src/jsonwriter.h',
+        'open-vcdiff/src/vcencoder.cc',
+      ],
+      'conditions': [
+        [ 'OS == "linux" or OS == "android"', { 'include_dirs': [ 'linux' ] } ],
+        # Matches the zlib function names prefixed in sdch.
+        [ 'OS == "android"', { 'defines': [ 'Z_PREFIX' ] } ],
+        [ 'os_bsd==1 or OS=="solaris"', { 'include_dirs': [ 'bsd' ] } ],
+        [ 'OS == "mac"', { 'include_dirs': [ 'mac' ] } ],
+        [ 'OS == "win"', { 'include_dirs': [ 'open-vcdiff/vsprojects' ] } ],
+      ],
+    },
+    {
+      # Reports encode and decode throughput on large dictionaries.
+      'target_name': 'vcdiff_benchmark',
+      'type': 'executable',
+      'dependencies': [
+        'sdch_encoder',
+        '../base/base.gyp:base',
+      ],
+      'sources': [
+        'vcdiff_benchmark.cc',
+      ],
+    },
   ],
 }
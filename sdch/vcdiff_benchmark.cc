@@ -0,0 +1,162 @@
+// Copyright (c) 2012 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Reports open-vcdiff encode and decode throughput for large dictionaries.
+//
+//   vcdiff_benchmark [dictionary_megabytes...]
+//
+// For each dictionary size (default 1, 4 and 16MB) the target is the
+// dictionary with scattered edits, which is the shape of an SDCH response
+// against a dictionary built from an earlier version of the same pages.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/time.h"
+#include "google/vcdecoder.h"
+#include "google/vcencoder.h"
+
+namespace {
+
+const int kIterations = 5;
+const size_t kMegabyte = 1024 * 1024;
+
+// Deterministic generator so that runs are comparable.
+class Random {
+ public:
+  explicit Random(uint32 seed) : state_(seed) {}
+  uint32 Next() {
+    state_ = state_ * 1103515245 + 12345;
+    return state_ >> 8;
+  }
+ private:
+  uint32 state_;
+};
+
+// Text-like data: words from a small vocabulary, so that it has the internal
+// repetition of markup.
+std::string MakeDictionary(size_t size, Random* random) {
+  static const char* const kWords[] = {
+    "<div>", "</div>", "<a href=\"", "\">", "</a>", "<p>", "the", "of",
+    "and", "content", "search", "result", "page", " ", " ", "\n",
+  };
+  std::string dictionary;
+  dictionary.reserve(size);
+  while (dictionary.size() < size) {
+    dictionary.append(kWords[random->Next() % arraysize(kWords)]);
+    if (random->Next() % 8 == 0)
+      dictionary.push_back('a' + random->Next() % 26);
+  }
+  dictionary.resize(size);
+  return dictionary;
+}
+
+// Applies a small edit roughly every 2KB.
+std::string MakeTarget(const std::string& dictionary, Random* random) {
+  std::string target;
+  target.reserve(dictionary.size() + dictionary.size() / 64);
+  size_t pos = 0;
+  while (pos < dictionary.size()) {
+    size_t keep = std::min(dictionary.size() - pos,
+                           static_cast<size_t>(random->Next() % 4096));
+    target.append(dictionary, pos, keep);
+    pos += keep;
+    for (uint32 i = random->Next() % 16; i > 0; --i)
+      target.push_back('A' + random->Next() % 26);
+    pos += random->Next() % 16;
+  }
+  return target;
+}
+
+double MegabytesPerSecond(size_t bytes, base::TimeDelta elapsed) {
+  return bytes * kIterations / (elapsed.InSecondsF() * kMegabyte);
+}
+
+bool RunBenchmark(int dictionary_megabytes) {
+  Random random(dictionary_megabytes);
+  std::string dictionary = MakeDictionary(dictionary_megabytes * kMegabyte,
+                                          &random);
+  std::string target = MakeTarget(dictionary, &random);
+
+  // Hashing the dictionary is part of encoding; SDCH servers do it once per
+  // dictionary, so it is timed separately.
+  base::TimeTicks start = base::TimeTicks::Now();
+  open_vcdiff::HashedDictionary hashed_dictionary(dictionary.data(),
+                                                  dictionary.size());
+  if (!hashed_dictionary.Init()) {
+    fprintf(stderr, "Could not hash dictionary\n");
+    return false;
+  }
+  base::TimeDelta hash_time = base::TimeTicks::Now() - start;
+
+  std::string delta;
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    delta.clear();
+    open_vcdiff::VCDiffStreamingEncoder encoder(
+        &hashed_dictionary, open_vcdiff::VCD_STANDARD_FORMAT, false);
+    if (!encoder.StartEncoding(&delta) ||
+        !encoder.EncodeChunk(target.data(), target.size(), &delta) ||
+        !encoder.FinishEncoding(&delta)) {
+      fprintf(stderr, "Encoding failed\n");
+      return false;
+    }
+  }
+  base::TimeDelta encode_time = base::TimeTicks::Now() - start;
+
+  std::string decoded;
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    decoded.clear();
+    open_vcdiff::VCDiffStreamingDecoder decoder;
+    decoder.StartDecoding(dictionary.data(), dictionary.size());
+    if (!decoder.DecodeChunk(delta.data(), delta.size(), &decoded) ||
+        !decoder.FinishDecoding()) {
+      fprintf(stderr, "Decoding failed\n");
+      return false;
+    }
+  }
+  base::TimeDelta decode_time = base::TimeTicks::Now() - start;
+
+  if (decoded != target) {
+    fprintf(stderr, "Round trip mismatch\n");
+    return false;
+  }
+
+  printf("%3dMB dictionary: hash %7.1fms  encode %7.1fMB/s  "
+         "decode %7.1fMB/s  delta %u bytes\n",
+         dictionary_megabytes, hash_time.InMillisecondsF(),
+         MegabytesPerSecond(target.size(), encode_time),
+         MegabytesPerSecond(target.size(), decode_time),
+         static_cast<unsigned>(delta.size()));
+  fflush(stdout);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::vector<int> sizes;
+  for (int i = 1; i < argc; ++i)
+    sizes.push_back(atoi(argv[i]));
+  if (sizes.empty()) {
+    sizes.push_back(1);
+    sizes.push_back(4);
+    sizes.push_back(16);
+  }
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    if (sizes[i] <= 0) {
+      fprintf(stderr, "Bad dictionary size\n");
+      return 1;
+    }
+    if (!RunBenchmark(sizes[i]))
+      return 1;
+  }
+  return 0;
+}
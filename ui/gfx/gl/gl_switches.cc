@@ -20,6 +20,10 @@ namespace switches {
 // Stop the GPU from synchronizing on the vsync before presenting.
 const char kDisableGpuVsync[]               = "disable-gpu-vsync";
 
+// Counts the commands the GPU process executes and the time spent in them,
+// and logs the counters when each context is destroyed.
+const char kEnableGPUCommandStats[]         = "enable-gpu-command-stats";
+
 // Turns on GPU logging (debug build only).
 const char kEnableGPUServiceLogging[]       = "enable-gpu-service-logging";
 const char kEnableGPUClientLogging[]        = "enable-gpu-client-logging";
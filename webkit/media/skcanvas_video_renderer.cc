@@ -215,16 +215,17 @@ static void ConvertVideoFrameToBitmap(
   media::YUVType yuv_type =
       (video_frame->format() == media::VideoFrame::YV12) ?
       media::YV12 : media::YV16;
-  media::ConvertYUVToRGB32(video_frame->data(media::VideoFrame::kYPlane),
-                           video_frame->data(media::VideoFrame::kUPlane),
-                           video_frame->data(media::VideoFrame::kVPlane),
-                           static_cast<uint8*>(bitmap->getPixels()),
-                           video_frame->width(),
-                           video_frame->height(),
-                           video_frame->stride(media::VideoFrame::kYPlane),
-                           video_frame->stride(media::VideoFrame::kUPlane),
-                           bitmap->rowBytes(),
-                           yuv_type);
+  media::ConvertYUVToRGB32Parallel(
+      video_frame->data(media::VideoFrame::kYPlane),
+      video_frame->data(media::VideoFrame::kUPlane),
+      video_frame->data(media::VideoFrame::kVPlane),
+      static_cast<uint8*>(bitmap->getPixels()),
+      video_frame->width(),
+      video_frame->height(),
+      video_frame->stride(media::VideoFrame::kYPlane),
+      video_frame->stride(media::VideoFrame::kUPlane),
+      bitmap->rowBytes(),
+      yuv_type);
   bitmap->notifyPixelsChanged();
   bitmap->unlockPixels();
 }